@@ -2,10 +2,106 @@
 out vec4 FragColor;
 
 in vec2 TexCoords;
+in vec3 Normal;
+in vec3 Position;
 
 uniform sampler2D texture_diffuse1;
 
+// irradiance volume baked from the room (see irradiance_volume.h): 9 RGB SH coefficients per probe,
+// packed into 7 RGBA slabs stacked along z
+uniform sampler3D irradianceVolume;
+uniform bool volumeEnabled;
+uniform vec3 volumeMin;
+uniform vec3 volumeMax;
+uniform ivec3 volumeResolution;
+
+vec3 irradiance(vec3 n)
+{
+    // probe grid coordinates, kept half a probe inside so filtering never blends two slabs
+    vec3 resolution = vec3(volumeResolution);
+    vec3 cell = clamp((Position - volumeMin) / (volumeMax - volumeMin) * resolution, vec3(0.5), resolution - 0.5);
+    vec4 s[7];
+    for (int k = 0; k < 7; ++k)
+        s[k] = texture(irradianceVolume, vec3(cell.xy / resolution.xy, (cell.z + float(k) * resolution.z) / (resolution.z * 7.0)));
+
+    vec3 result = s[0].rgb * 0.282095
+        + vec3(s[0].a, s[1].rg) * 0.488603 * n.y
+        + vec3(s[1].ba, s[2].r) * 0.488603 * n.z
+        + s[2].gba * 0.488603 * n.x
+        + s[3].rgb * 1.092548 * n.x * n.y
+        + vec3(s[3].a, s[4].rg) * 1.092548 * n.y * n.z
+        + vec3(s[4].ba, s[5].r) * 0.315392 * (3.0 * n.z * n.z - 1.0)
+        + s[5].gba * 1.092548 * n.x * n.z
+        + s[6].rgb * 0.546274 * (n.x * n.x - n.y * n.y);
+    return max(result, vec3(0.0));
+}
+
+// shadows (see shadow_maps.h): this frame's maps and the cached ones with the static room alone
+uniform samplerCube pointShadowMap;
+uniform samplerCube staticPointShadowMap;
+uniform int shadowLightIndex;
+uniform float pointShadowFar;
+uniform vec4 shadowLight;           // position, radius
+uniform vec3 shadowLightColor;
+uniform sampler2DShadow sunShadowMap;
+uniform sampler2DShadow staticSunShadowMap;
+uniform mat4 sunMatrix;
+uniform bool sunEnabled;
+uniform vec3 sunDirection;
+uniform vec3 sunColor;
+
+float pointShadow(samplerCube shadowMap, float distance)
+{
+    // the same taps as the room's shadows in Fragment.fs
+    const vec3 offsets[4] = vec3[](vec3(1, 1, 1), vec3(-1, -1, 1), vec3(-1, 1, -1), vec3(1, -1, -1));
+    vec3 fragToLight = Position - shadowLight.xyz;
+    float bias = 0.05;
+    float radius = 0.02 * distance;
+    float lit = 0.0;
+    for (int i = 0; i < 4; ++i)
+    {
+        float closest = texture(shadowMap, fragToLight + offsets[i] * radius).r * pointShadowFar;
+        lit += distance - bias > closest ? 0.0 : 1.0;
+    }
+    return lit * 0.25;
+}
+
+float sunShadow(sampler2DShadow shadowMap, vec3 n)
+{
+    vec4 lightSpace = sunMatrix * vec4(Position + n * 0.02, 1.0);
+    vec3 coords = lightSpace.xyz / lightSpace.w * 0.5 + 0.5;
+    return texture(shadowMap, vec3(coords.xy, coords.z - 0.001));
+}
+
+// The direct light the moving casters (the model itself, among them) block here. The probes already saw the
+// light the static room lets through, so what's blocked is the light that reaches past the static maps but not
+// past this frame's, subtracted from the baked irradiance the way baked lighting takes realtime shadows.
+vec3 blockedLight(vec3 n)
+{
+    vec3 blocked = vec3(0.0);
+    if (shadowLightIndex >= 0)
+    {
+        vec3 toLight = shadowLight.xyz - Position;
+        float distance = length(toLight);
+        float window = clamp(1.0 - pow(distance / shadowLight.w, 4.0), 0.0, 1.0);
+        float attenuation = window * window / (1.0 + distance * distance);
+        float diff = max(dot(n, toLight / distance), 0.0);
+        if (diff * attenuation > 0.0)
+            blocked += diff * attenuation * max(pointShadow(staticPointShadowMap, distance) - pointShadow(pointShadowMap, distance), 0.0) * shadowLightColor;
+    }
+    if (sunEnabled)
+    {
+        float diff = max(dot(n, -sunDirection), 0.0);
+        if (diff > 0.0)
+            blocked += diff * max(sunShadow(staticSunShadowMap, n) - sunShadow(sunShadowMap, n), 0.0) * sunColor;
+    }
+    return blocked;
+}
+
 void main()
 {    
-    FragColor = texture(texture_diffuse1, TexCoords);
+    vec4 albedo = texture(texture_diffuse1, TexCoords);
+    vec3 n = normalize(Normal);
+    vec3 lighting = volumeEnabled ? irradiance(n) : vec3(1.0);
+    FragColor = vec4(albedo.rgb * max(lighting - blockedLight(n), vec3(0.0)), albedo.a);
 }
\ No newline at end of file
@@ -2,15 +2,41 @@
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoords;
+layout (location = 5) in ivec4 aBoneIDs;
+layout (location = 6) in vec4 aWeights;
 
 out vec2 TexCoords;
+out vec3 Normal;
+out vec3 Position;
 
 uniform mat4 model;
+uniform mat3 normalMatrix;
 uniform mat4 view;
 uniform mat4 projection;
 
+// skin matrices as three row texels per bone, see BoneBuffer in skeletal_animation.h
+uniform bool gpuSkinning;
+uniform samplerBuffer boneMatrices;
+
+mat4 boneMatrix(int bone)
+{
+    return transpose(mat4(texelFetch(boneMatrices, bone * 3), texelFetch(boneMatrices, bone * 3 + 1),
+        texelFetch(boneMatrices, bone * 3 + 2), vec4(0.0, 0.0, 0.0, 1.0)));
+}
+
 void main()
 {
+    vec4 position = vec4(aPos, 1.0);
+    vec3 normal = aNormal;
+    if (gpuSkinning && aWeights.x > 0.0)
+    {
+        mat4 skin = aWeights.x * boneMatrix(aBoneIDs.x) + aWeights.y * boneMatrix(aBoneIDs.y)
+            + aWeights.z * boneMatrix(aBoneIDs.z) + aWeights.w * boneMatrix(aBoneIDs.w);
+        position = skin * position;
+        normal = mat3(skin) * normal;
+    }
     TexCoords = aTexCoords;    
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    Normal = normalMatrix * normal;
+    Position = vec3(model * position);
+    gl_Position = projection * view * vec4(Position, 1.0);
 }
\ No newline at end of file
@@ -4,10 +4,114 @@ out vec4 FragColor;
 in vec3 Normal;
 in vec3 Position;
 in vec2 TexCoord;
+in vec2 LightmapUV;
+in float Layer;
 
-uniform sampler2D ourTexture;
+// the room's textures, Layer picks the one this surface uses
+uniform sampler2DArray roomTextures;
+
+uniform mat4 view;
+uniform vec3 viewPos;
+uniform float ambientStrength;
+
+// clustered point lights, binned on the CPU (see clustered_lighting.h)
+uniform samplerBuffer clusterLights;        // 2 texels per light: (position, radius), (color, 0)
+uniform usamplerBuffer clusterRanges;       // per cluster: (first index, light count)
+uniform usamplerBuffer clusterLightIndices; // light indices of all clusters
+uniform ivec3 clusterDims;
+uniform float clusterZScale;
+uniform float clusterZBias;
+uniform vec2 clusterRenderSize;
+
+// shadows (see shadow_maps.h)
+uniform samplerCube pointShadowMap;
+uniform int shadowLightIndex;
+uniform float pointShadowFar;
+uniform sampler2DShadow sunShadowMap;
+uniform mat4 sunMatrix;
+uniform bool sunEnabled;
+uniform vec3 sunDirection;
+uniform vec3 sunColor;
+
+// baked lighting (see lightmap_baker.h): ambient, indirect light and the diffuse light of the first
+// bakedLightCount lights (and the sun if bakedSun is set) in one texel
+uniform sampler2D lightmap;
+uniform bool useLightmap;
+uniform int bakedLightCount;
+uniform bool bakedSun;
+
+float pointShadow(vec3 lightPosition, float distance)
+{
+    // a few taps around the lookup direction soften the edge
+    const vec3 offsets[4] = vec3[](vec3(1, 1, 1), vec3(-1, -1, 1), vec3(-1, 1, -1), vec3(1, -1, -1));
+    vec3 fragToLight = Position - lightPosition;
+    float bias = 0.05;
+    float radius = 0.02 * distance;
+    float lit = 0.0;
+    for (int i = 0; i < 4; ++i)
+    {
+        float closest = texture(pointShadowMap, fragToLight + offsets[i] * radius).r * pointShadowFar;
+        lit += distance - bias > closest ? 0.0 : 1.0;
+    }
+    return lit * 0.25;
+}
+
+float sunShadow(vec3 norm)
+{
+    vec4 lightSpace = sunMatrix * vec4(Position + norm * 0.02, 1.0);
+    vec3 coords = lightSpace.xyz / lightSpace.w * 0.5 + 0.5;
+    return texture(sunShadowMap, vec3(coords.xy, coords.z - 0.001));
+}
 
 void main()
 {             
-    FragColor = texture(ourTexture, TexCoord);
+    vec3 albedo = texture(roomTextures, vec3(TexCoord, Layer)).rgb;
+
+    // the room's triangles don't have a consistent winding, light whichever side faces the viewer
+    vec3 viewDir = normalize(viewPos - Position);
+    vec3 norm = normalize(Normal);
+    if (dot(norm, viewDir) < 0.0)
+        norm = -norm;
+
+    // find the cluster of this fragment
+    float depth = -(view * vec4(Position, 1.0)).z;
+    ivec3 cluster;
+    cluster.xy = ivec2(gl_FragCoord.xy / clusterRenderSize * vec2(clusterDims.xy));
+    cluster.z = int(log(depth) * clusterZScale + clusterZBias);
+    cluster = clamp(cluster, ivec3(0), clusterDims - 1);
+    int clusterIndex = (cluster.z * clusterDims.y + cluster.y) * clusterDims.x + cluster.x;
+    uvec2 range = texelFetch(clusterRanges, clusterIndex).xy;
+
+    vec3 lighting = useLightmap ? texture(lightmap, LightmapUV).rgb : vec3(ambientStrength);
+    for (uint i = 0u; i < range.y; i++)
+    {
+        int light = int(texelFetch(clusterLightIndices, int(range.x + i)).r);
+        if (useLightmap && light < bakedLightCount)
+            continue;
+        vec4 positionRadius = texelFetch(clusterLights, light * 2);
+        vec3 color = texelFetch(clusterLights, light * 2 + 1).rgb;
+
+        vec3 toLight = positionRadius.xyz - Position;
+        float distance = length(toLight);
+        vec3 lightDir = toLight / distance;
+        // smooth window so the light reaches exactly zero at its radius, which is what the clusters were culled with
+        float window = clamp(1.0 - pow(distance / positionRadius.w, 4.0), 0.0, 1.0);
+        float attenuation = window * window / (1.0 + distance * distance);
+
+        float diff = max(dot(norm, lightDir), 0.0);
+        vec3 halfway = normalize(lightDir + viewDir);
+        float spec = pow(max(dot(norm, halfway), 0.0), 32.0) * 0.25;
+        float shadow = light == shadowLightIndex ? pointShadow(positionRadius.xyz, distance) : 1.0;
+        lighting += (diff + spec) * attenuation * shadow * color;
+    }
+
+    if (sunEnabled && !(useLightmap && bakedSun))
+    {
+        vec3 lightDir = -sunDirection;
+        float diff = max(dot(norm, lightDir), 0.0);
+        if (diff > 0.0)
+            lighting += diff * sunShadow(norm) * sunColor;
+    }
+
+    FragColor = vec4(albedo * lighting, 1.0);
 }
\ No newline at end of file
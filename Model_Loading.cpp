@@ -10,18 +10,47 @@
 #include <shader.h>
 #include <camera.h>
 #include <model.h>
+#include <frame_pacer.h>
+#include <gl_handles.h>
+#include <dynamic_resolution.h>
+#include <clustered_lighting.h>
+#include <shadow_maps.h>
+#include <lightmap_baker.h>
+#include <irradiance_volume.h>
+#include <cubemap_loader.h>
+#include <environment_map.h>
+#include <portal_visibility.h>
+#include <scene_graph.h>
+#include <skeletal_animation.h>
+#include <scene_collision.h>
+#include <texture_array.h>
+#include <render_thread.h>
+#include <software_rasterizer.h>
+#include <render_device.h>
+#include <vulkan_device.h>
+#include <regression.h>
+#include <microbenchmark.h>
 
 #include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
 #include <FreeImage.h>
 
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
-void processInput(GLFWwindow* window);
+void processInput(GLFWwindow* window, const SceneCollision* collision);
 unsigned int loadTexture(const char* path);
-unsigned int loadCubemap(vector<std::string> faces);
-void loadTextures();
+void loadTextures(TextureArray& textures);
+void computeFlatNormals(float* vertices, size_t floatCount);
+void setupRoomVertexArray(unsigned int vertexArray, unsigned int buffer, const float* vertices, size_t size);
+void addModelBenchmarks(BenchmarkSuite& suite);
+void addSceneBenchmarks(BenchmarkSuite& suite);
 
 // settings
 const unsigned int SCR_WIDTH = 800;
@@ -37,14 +66,234 @@ bool firstMouse = true;
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
 
-const int numTextures = 6;
+// simulation
+// the main thread polls input and updates the scene at this rate, independent of how fast the render thread presents
+const double SIMULATION_HZ = 240.0;
+
+// projection planes, shared with the light clusters
+const float NEAR_PLANE = 0.1f;
+const float FAR_PLANE = 100.0f;
+
+// baked lighting of the static room, written by --bake-lightmap and --bake-probes
+const char* LIGHTMAP_PATH = "room.lightmap";
+const char* IRRADIANCE_VOLUME_PATH = "room.probes";
+// prefiltered sky for rough reflections, baked from the skybox faces the first time it is needed
+const char* ENVIRONMENT_PATH = "skybox.environment";
+
+// framebuffer size, written by the resize callback on the main thread and read when building snapshots
+std::atomic<int> framebufferWidth(SCR_WIDTH);
+std::atomic<int> framebufferHeight(SCR_HEIGHT);
+
+// Ends GLFW when main() returns. Declared once the context exists, it goes last: every GL object owned by a
+// handle declared after it is deleted first, while the context is still current, and any that survived is reported.
+struct GlfwSession {
+    ~GlfwSession()
+    {
+        reportGlLeaks();
+        glfwTerminate();
+    }
+};
 
-GLuint texID[numTextures];
+const int numTextures = 6;
 
 const char* textureFileNames[numTextures];
 
-int main()
+int main(int argc, char** argv)
 {
+    // frame pacing, tunable from the command line:
+    //   --swap-interval N     0 = no vsync, 1 = vsync (default), -1 = adaptive vsync
+    //   --fps N               frame rate limit, 0 = unlimited (default)
+    //   --frames-in-flight N  1 (lowest latency) to 3 (highest throughput), default 2
+    // and dynamic resolution:
+    //   --gpu-frame-ms N      GPU frame time the render scale is adjusted to hold, default 14
+    //   --min-scale N         lower bound of the render scale, default 0.5
+    //   --max-scale N         upper bound of the render scale, default 1.0
+    // and lighting:
+    //   --lamps N             scatter N extra point lights through the room
+    //   --no-sun              disable the directional light shining through the windows
+    //   --bake-lightmap       path trace the static room's lighting into room.lightmap and exit
+    //   --bake-samples N      indirect paths per lightmap texel, default 128
+    //   --no-lightmap         ignore room.lightmap and light everything at runtime
+    //   --bake-probes         bake the irradiance volume that lights imported models into room.probes and exit
+    //   --bake-environment    prefilter the skybox into skybox.environment and exit
+    // and the sky:
+    //   --skybox PATH         equirectangular panorama (8 bit or .hdr) to use instead of resources/skybox
+    //   --mirror-cube N       put a metal cube with roughness N (0 to 1) in the room, reflecting the prefiltered sky
+    // and an imported model, lit by the irradiance volume:
+    //   --model PATH          load a model with assimp (.blend files are read natively) and put it on the table, turning slowly
+    //   --model-scale N       uniform scale of the model, default 1
+    //   --lod-pixels N        screen space error in pixels the model's simplified levels may show, default 1
+    //   --no-portal-culling   draw every cell instead of only those seen through the door and windows
+    //   --no-meshlet-culling  draw the model's meshes whole instead of culling their meshlets every frame
+    //   --check-dna PATH      compare the struct layout of the .blend at PATH with dna.txt and exit
+    //   --list-blend PATH     list the objects, meshes, materials and images in the .blend at PATH and exit
+    //   --cpu-skinning        skin an animated model on the CPU (SIMD) instead of in the vertex shader
+    //   --bench-animation N   time posing and CPU skinning N synthetic characters and exit
+    // and collision:
+    //   --no-collision        let the camera fly through walls and furniture
+    //   --bench-queries N     time N rays, sphere sweeps and box overlaps against the room and model, and exit
+    // and rendering on the CPU:
+    //   --software-render PATH  rasterize the starting view on the CPU into a PPM image at PATH and exit
+    //   --bench-software N      render N views turning on the spot on the CPU and with GL, time both and exit
+    // and the Vulkan backend (built with RENDER_VULKAN):
+    //   --vulkan-render PATH    render the room's starting view offscreen with Vulkan into a PPM image at PATH and exit
+    //   --bench-vulkan N        time the room pass over N views turning on the spot with Vulkan and GL, and exit
+    //   --vulkan-threads N      threads recording Vulkan command buffers, default one per core
+    //   --vulkan-cpu            prefer a CPU Vulkan driver (Mesa's lavapipe) over the GPU
+    // and regression testing:
+    //   --regression PATH       render the scenes listed in PATH, compare them with their golden images, budgets and
+    //                           baseline, and exit with 1 if any of them fails
+    //   --regression-update     write the golden images and the baseline from this run instead of comparing with them
+    // and microbenchmarks of the loaders and the camera:
+    //   --bench-suite PATH      run the microbenchmarks, print their times and write them to PATH as JSON, and exit
+    //   --bench-filter REGEX    only run the microbenchmarks whose name matches
+    //   --bench-size N          run every microbenchmark with an input of size N instead of its own range of sizes
+    //   --bench-min-time N      seconds each microbenchmark runs for at least, default 0.5
+    // --------------------------------------------------------------------------------
+    int extraLamps = 0;
+    bool bakeLightmap = false;
+    bool bakeProbes = false;
+    bool bakeEnvironment = false;
+    float mirrorCubeRoughness = -1.0f;
+    std::string skyboxPath;
+    bool useLightmap = true;
+    LightmapBakeSettings bakeSettings;
+    std::string modelPath;
+    float modelScale = 1.0f;
+    float lodPixels = 1.0f;
+    bool meshletCulling = true;
+    bool portalCulling = true;
+    bool cameraCollision = true;
+    int benchQueries = 0;
+    bool cpuSkinning = false;
+    int benchAnimation = 0;
+    std::string softwareRenderPath;
+    int benchSoftware = 0;
+    std::string vulkanRenderPath;
+    int benchVulkan = 0;
+    VulkanDeviceSettings vulkanSettings;
+    std::string regressionPath;
+    bool regressionUpdate = false;
+    BenchmarkSettings benchSettings;
+    std::string dnaCheckPath;
+    std::string blendListPath;
+    FramePacingSettings pacingSettings;
+    ResolutionGovernorSettings resolutionSettings;
+    ShadowSettings shadowSettings;
+    for (int i = 1; i < argc; i++)
+    {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--no-sun") == 0)
+            shadowSettings.sunEnabled = false;
+        else if (std::strcmp(argv[i], "--bake-lightmap") == 0)
+            bakeLightmap = true;
+        else if (std::strcmp(argv[i], "--no-lightmap") == 0)
+            useLightmap = false;
+        else if (std::strcmp(argv[i], "--bake-probes") == 0)
+            bakeProbes = true;
+        else if (std::strcmp(argv[i], "--no-portal-culling") == 0)
+            portalCulling = false;
+        else if (std::strcmp(argv[i], "--no-meshlet-culling") == 0)
+            meshletCulling = false;
+        else if (std::strcmp(argv[i], "--no-collision") == 0)
+            cameraCollision = false;
+        else if (std::strcmp(argv[i], "--bake-environment") == 0)
+            bakeEnvironment = true;
+        else if (std::strcmp(argv[i], "--cpu-skinning") == 0)
+            cpuSkinning = true;
+        else if (std::strcmp(argv[i], "--vulkan-cpu") == 0)
+            vulkanSettings.preferCpu = true;
+        else if (std::strcmp(argv[i], "--regression-update") == 0)
+            regressionUpdate = true;
+        else if (hasValue && std::strcmp(argv[i], "--mirror-cube") == 0)
+            mirrorCubeRoughness = glm::clamp((float)std::atof(argv[++i]), 0.0f, 1.0f);
+        else if (hasValue && std::strcmp(argv[i], "--skybox") == 0)
+            skyboxPath = argv[++i];
+        else if (hasValue && std::strcmp(argv[i], "--model") == 0)
+            modelPath = argv[++i];
+        else if (hasValue && std::strcmp(argv[i], "--model-scale") == 0)
+            modelScale = (float)std::atof(argv[++i]);
+        else if (hasValue && std::strcmp(argv[i], "--check-dna") == 0)
+            dnaCheckPath = argv[++i];
+        else if (hasValue && std::strcmp(argv[i], "--list-blend") == 0)
+            blendListPath = argv[++i];
+        else if (hasValue && std::strcmp(argv[i], "--bench-queries") == 0)
+            benchQueries = std::atoi(argv[++i]);
+        else if (hasValue && std::strcmp(argv[i], "--bench-animation") == 0)
+            benchAnimation = std::atoi(argv[++i]);
+        else if (hasValue && std::strcmp(argv[i], "--software-render") == 0)
+            softwareRenderPath = argv[++i];
+        else if (hasValue && std::strcmp(argv[i], "--bench-software") == 0)
+            benchSoftware = std::atoi(argv[++i]);
+        else if (hasValue && std::strcmp(argv[i], "--vulkan-render") == 0)
+            vulkanRenderPath = argv[++i];
+        else if (hasValue && std::strcmp(argv[i], "--bench-vulkan") == 0)
+            benchVulkan = std::atoi(argv[++i]);
+        else if (hasValue && std::strcmp(argv[i], "--vulkan-threads") == 0)
+            vulkanSettings.recordThreads = std::atoi(argv[++i]);
+        else if (hasValue && std::strcmp(argv[i], "--regression") == 0)
+            regressionPath = argv[++i];
+        else if (hasValue && std::strcmp(argv[i], "--bench-suite") == 0)
+            benchSettings.jsonPath = argv[++i];
+        else if (hasValue && std::strcmp(argv[i], "--bench-filter") == 0)
+            benchSettings.filter = argv[++i];
+        else if (hasValue && std::strcmp(argv[i], "--bench-size") == 0)
+            benchSettings.size = std::atoll(argv[++i]);
+        else if (hasValue && std::strcmp(argv[i], "--bench-min-time") == 0)
+            benchSettings.minSeconds = std::atof(argv[++i]);
+        else if (hasValue && std::strcmp(argv[i], "--lod-pixels") == 0)
+            lodPixels = (float)std::atof(argv[++i]);
+        else if (hasValue && std::strcmp(argv[i], "--bake-samples") == 0)
+            bakeSettings.samples = std::atoi(argv[++i]);
+        else if (hasValue && std::strcmp(argv[i], "--swap-interval") == 0)
+            pacingSettings.swapInterval = std::atoi(argv[++i]);
+        else if (hasValue && std::strcmp(argv[i], "--fps") == 0)
+            pacingSettings.targetFps = std::atof(argv[++i]);
+        else if (hasValue && std::strcmp(argv[i], "--frames-in-flight") == 0)
+            pacingSettings.maxFramesInFlight = std::atoi(argv[++i]);
+        else if (hasValue && std::strcmp(argv[i], "--gpu-frame-ms") == 0)
+            resolutionSettings.targetFrameMs = std::atof(argv[++i]);
+        else if (hasValue && std::strcmp(argv[i], "--min-scale") == 0)
+            resolutionSettings.minScale = (float)std::atof(argv[++i]);
+        else if (hasValue && std::strcmp(argv[i], "--max-scale") == 0)
+            resolutionSettings.maxScale = (float)std::atof(argv[++i]);
+        else if (hasValue && std::strcmp(argv[i], "--lamps") == 0)
+            extraLamps = std::atoi(argv[++i]);
+    }
+    const bool softwareRender = !softwareRenderPath.empty() || benchSoftware > 0;
+    const bool vulkanRender = !vulkanRenderPath.empty() || benchVulkan > 0;
+    const bool regression = !regressionPath.empty();
+    const bool benchSuite = !benchSettings.jsonPath.empty();
+    // the GL frames software rendering and the golden images are compared with stay at full resolution
+    if (softwareRender || regression)
+        resolutionSettings.minScale = resolutionSettings.maxScale;
+
+    if (!dnaCheckPath.empty())
+    {
+        BlendFile blend;
+        return blend.open(dnaCheckPath.c_str()) && blend.compareWithDump("dna.txt") == 0 ? 0 : 1;
+    }
+    if (benchAnimation > 0)
+    {
+        benchmarkAnimation(benchAnimation);
+        return 0;
+    }
+    if (!blendListPath.empty())
+    {
+        auto start = std::chrono::steady_clock::now();
+        BlendFile blend;
+        if (!blend.open(blendListPath.c_str()))
+            return 1;
+        std::vector<BlendFile::Datablock> datablocks = blend.inventory();
+        double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        for (const char* code : { "OB", "ME", "MA", "IM" })
+            for (const BlendFile::Datablock& datablock : datablocks)
+                if (std::strcmp(datablock.code, code) == 0)
+                    std::cout << datablock.code << " " << datablock.name << std::endl;
+        std::cout << "BLEND::INVENTORY:: " << blend.blocks().size() << " blocks, " << datablocks.size() << " datablocks in " << milliseconds << " ms" << std::endl;
+        return 0;
+    }
+
     // glfw: initialize and configure
     // ------------------------------
     glfwInit();
@@ -55,6 +304,8 @@ int main()
 #ifdef __APPLE__
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 #endif
+    if (bakeLightmap || bakeProbes || bakeEnvironment || benchQueries > 0 || softwareRender || vulkanRender || regression || benchSuite)
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
 
     // glfw window creation
     // --------------------
@@ -70,6 +321,10 @@ int main()
     glfwSetCursorPosCallback(window, mouse_callback);
     glfwSetScrollCallback(window, scroll_callback);
 
+    int initialWidth, initialHeight;
+    glfwGetFramebufferSize(window, &initialWidth, &initialHeight);
+    framebuffer_size_callback(window, initialWidth, initialHeight);
+
     // tell GLFW to capture our mouse
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 
@@ -80,6 +335,18 @@ int main()
         std::cout << "Failed to initialize GLAD" << std::endl;
         return -1;
     }
+    GlfwSession glfwSession;
+
+    // the microbenchmarks only need the context, they make their own input
+    if (benchSuite)
+    {
+        BenchmarkSuite suite;
+        addModelBenchmarks(suite);
+        addSceneBenchmarks(suite);
+        suite.addContext("gl_renderer", (const char*)glGetString(GL_RENDERER));
+        suite.addContext("gl_version", (const char*)glGetString(GL_VERSION));
+        return suite.run(benchSettings) ? 0 : 1;
+    }
 
     // configure global opengl state
     // -----------------------------
@@ -90,6 +357,11 @@ int main()
     Shader shader("cube.vs", "cube.fs");
     Shader skyboxShader("sky.vs", "sky.fs");
     Shader modelShader("Vertex.vs", "Fragment.fs");
+    Shader compositeShader("composite.vs", "composite.fs");
+    Shader lampShader("LampVert.vs", "LampFrag.fs");
+    Shader pointShadowShader("shadow_point.vs", "shadow_point.fs", "shadow_point.gs");
+    Shader sunShadowShader("shadow_sun.vs", "shadow_sun.fs");
+    Shader objectShader("1.model_loading.vs", "1.model_loading.fs");
 
     // set up vertex data (and buffer(s)) and configure vertex attributes
     // ------------------------------------------------------------------
@@ -761,10 +1033,23 @@ int main()
     };
 
 
+    // the room arrays carry placeholder normals, derive the real ones from the triangles before uploading
+    computeFlatNormals(floor, sizeof(floor) / sizeof(float));
+    computeFlatNormals(roof, sizeof(roof) / sizeof(float));
+    computeFlatNormals(wallLeft, sizeof(wallLeft) / sizeof(float));
+    computeFlatNormals(wallRight, sizeof(wallRight) / sizeof(float));
+    computeFlatNormals(windowRight, sizeof(windowRight) / sizeof(float));
+    computeFlatNormals(wallBack, sizeof(wallBack) / sizeof(float));
+    computeFlatNormals(windowBack, sizeof(windowBack) / sizeof(float));
+    computeFlatNormals(wallFront, sizeof(wallFront) / sizeof(float));
+    computeFlatNormals(door, sizeof(door) / sizeof(float));
+    computeFlatNormals(tableLegs, sizeof(tableLegs) / sizeof(float));
+    computeFlatNormals(chair, sizeof(chair) / sizeof(float));
+    computeFlatNormals(tableTop, sizeof(tableTop) / sizeof(float));
+
     // cube VAO
-    unsigned int cubeVAO, cubeVBO;
-    glGenVertexArrays(1, &cubeVAO);
-    glGenBuffers(1, &cubeVBO);
+    GlVertexArray cubeVAO = GlVertexArray::create();
+    GlBuffer cubeVBO = GlBuffer::create();
     glBindVertexArray(cubeVAO);
     glBindBuffer(GL_ARRAY_BUFFER, cubeVBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(cubeVertices), &cubeVertices, GL_STATIC_DRAW);
@@ -773,174 +1058,65 @@ int main()
     glEnableVertexAttribArray(1);
     glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
 
-    unsigned int floorVAO, floorVBO;
-    glGenVertexArrays(1, &floorVAO);
-    glGenBuffers(1, &floorVBO);
-    glBindVertexArray(floorVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, floorVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(floor), &floor, GL_STATIC_DRAW);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(2);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
+    GlVertexArray floorVAO = GlVertexArray::create();
+    GlBuffer floorVBO = GlBuffer::create();
+    setupRoomVertexArray(floorVAO, floorVBO, floor, sizeof(floor));
 
 
-    unsigned int leftWallVAO, leftWallVBO;
-    glGenVertexArrays(1, &leftWallVAO);
-    glGenBuffers(1, &leftWallVBO);
-    glBindVertexArray(leftWallVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, leftWallVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(wallLeft), &wallLeft, GL_STATIC_DRAW);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(2);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
+    GlVertexArray leftWallVAO = GlVertexArray::create();
+    GlBuffer leftWallVBO = GlBuffer::create();
+    setupRoomVertexArray(leftWallVAO, leftWallVBO, wallLeft, sizeof(wallLeft));
 
-    unsigned int rightWallVAO, rightWallVBO;
-    glGenVertexArrays(1, &rightWallVAO);
-    glGenBuffers(1, &rightWallVBO);
-    glBindVertexArray(rightWallVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, rightWallVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(wallRight), &wallRight, GL_STATIC_DRAW);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(2);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
+    GlVertexArray rightWallVAO = GlVertexArray::create();
+    GlBuffer rightWallVBO = GlBuffer::create();
+    setupRoomVertexArray(rightWallVAO, rightWallVBO, wallRight, sizeof(wallRight));
 
 
-    unsigned int backWallVAO, backWallVBO;
-    glGenVertexArrays(1, &backWallVAO);
-    glGenBuffers(1, &backWallVBO);
-    glBindVertexArray(backWallVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, backWallVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(wallBack), &wallBack, GL_STATIC_DRAW);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(2);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
+    GlVertexArray backWallVAO = GlVertexArray::create();
+    GlBuffer backWallVBO = GlBuffer::create();
+    setupRoomVertexArray(backWallVAO, backWallVBO, wallBack, sizeof(wallBack));
 
 
-    unsigned int frontWallVAO, frontWallVBO;
-    glGenVertexArrays(1, &frontWallVAO);
-    glGenBuffers(1, &frontWallVBO);
-    glBindVertexArray(frontWallVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, frontWallVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(wallFront), &wallFront, GL_STATIC_DRAW);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(2);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
+    GlVertexArray frontWallVAO = GlVertexArray::create();
+    GlBuffer frontWallVBO = GlBuffer::create();
+    setupRoomVertexArray(frontWallVAO, frontWallVBO, wallFront, sizeof(wallFront));
 
-    unsigned int roofWallVAO, roofWallVBO;
-    glGenVertexArrays(1, &roofWallVAO);
-    glGenBuffers(1, &roofWallVBO);
-    glBindVertexArray(roofWallVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, roofWallVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(roof), &roof, GL_STATIC_DRAW);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(2);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
+    GlVertexArray roofWallVAO = GlVertexArray::create();
+    GlBuffer roofWallVBO = GlBuffer::create();
+    setupRoomVertexArray(roofWallVAO, roofWallVBO, roof, sizeof(roof));
 
-    unsigned int chairVAO, chairVBO;
-    glGenVertexArrays(1, &chairVAO);
-    glGenBuffers(1, &chairVBO);
-    glBindVertexArray(chairVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, chairVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(chair), &chair, GL_STATIC_DRAW);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(2);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
+    GlVertexArray chairVAO = GlVertexArray::create();
+    GlBuffer chairVBO = GlBuffer::create();
+    setupRoomVertexArray(chairVAO, chairVBO, chair, sizeof(chair));
 
 
-    unsigned int tableLegVAO, tableLegVBO;
-    glGenVertexArrays(1, &tableLegVAO);
-    glGenBuffers(1, &tableLegVBO);
-    glBindVertexArray(tableLegVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, tableLegVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(tableLegs), &tableLegs, GL_STATIC_DRAW);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(2);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
+    GlVertexArray tableLegVAO = GlVertexArray::create();
+    GlBuffer tableLegVBO = GlBuffer::create();
+    setupRoomVertexArray(tableLegVAO, tableLegVBO, tableLegs, sizeof(tableLegs));
 
 
-    unsigned int tableTopVAO, tableTopVBO;
-    glGenVertexArrays(1, &tableTopVAO);
-    glGenBuffers(1, &tableTopVBO);
-    glBindVertexArray(tableTopVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, tableTopVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(tableTop), &tableTop, GL_STATIC_DRAW);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(2);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
+    GlVertexArray tableTopVAO = GlVertexArray::create();
+    GlBuffer tableTopVBO = GlBuffer::create();
+    setupRoomVertexArray(tableTopVAO, tableTopVBO, tableTop, sizeof(tableTop));
 
-    unsigned int doorVAO, doorVBO;
-    glGenVertexArrays(1, &doorVAO);
-    glGenBuffers(1, &doorVBO);
-    glBindVertexArray(doorVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, doorVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(door), &door, GL_STATIC_DRAW);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(2);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
+    GlVertexArray doorVAO = GlVertexArray::create();
+    GlBuffer doorVBO = GlBuffer::create();
+    setupRoomVertexArray(doorVAO, doorVBO, door, sizeof(door));
 
 
-    unsigned int windowRightVAO, windowRightVBO;
-    glGenVertexArrays(1, &windowRightVAO);
-    glGenBuffers(1, &windowRightVBO);
-    glBindVertexArray(windowRightVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, windowRightVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(windowRight), &windowRight, GL_STATIC_DRAW);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(2);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
+    GlVertexArray windowRightVAO = GlVertexArray::create();
+    GlBuffer windowRightVBO = GlBuffer::create();
+    setupRoomVertexArray(windowRightVAO, windowRightVBO, windowRight, sizeof(windowRight));
 
 
-    unsigned int windowBackVAO, windowBackVBO;
-    glGenVertexArrays(1, &windowBackVAO);
-    glGenBuffers(1, &windowBackVBO);
-    glBindVertexArray(windowBackVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, windowBackVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(windowBack), &windowBack, GL_STATIC_DRAW);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(2);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
+    GlVertexArray windowBackVAO = GlVertexArray::create();
+    GlBuffer windowBackVBO = GlBuffer::create();
+    setupRoomVertexArray(windowBackVAO, windowBackVBO, windowBack, sizeof(windowBack));
 
 
     // skybox VAO
-    unsigned int skyboxVAO, skyboxVBO;
-    glGenVertexArrays(1, &skyboxVAO);
-    glGenBuffers(1, &skyboxVBO);
+    GlVertexArray skyboxVAO = GlVertexArray::create();
+    GlBuffer skyboxVBO = GlBuffer::create();
     glBindVertexArray(skyboxVAO);
     glBindBuffer(GL_ARRAY_BUFFER, skyboxVBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(skyboxVertices), &skyboxVertices, GL_STATIC_DRAW);
@@ -960,15 +1136,31 @@ int main()
         "resources/skybox/back.jpg",
     };
 
-    unsigned int cubemapTexture = loadCubemap(faces);
+    if (!skyboxPath.empty())
+        faces.assign(1, skyboxPath);
 
+    // the faces are decoded in parallel and kept around only while the environment might need baking from them
+    CubemapImage skyboxImage = CubemapLoader().load(faces);
+    GlTexture cubemapTexture = CubemapLoader::upload(skyboxImage);
 
-    vector<std::string> windowRightTexPath
+    // a panorama gets its own prefiltered environment next to it
+    std::string environmentPath = skyboxPath.empty() ? std::string(ENVIRONMENT_PATH) : skyboxPath + ".environment";
+    EnvironmentMap environment;
+    EnvironmentTexture environmentTexture;
+    if (bakeEnvironment || (mirrorCubeRoughness >= 0.0f && !environment.load(environmentPath.c_str())))
     {
-       "resources/skybox/right.jpg"
-    };
-
-    unsigned int windowRightTex = loadCubemap(windowRightTexPath);
+        EnvironmentBaker baker;
+        environment = baker.bake(skyboxImage);
+        if (!environment.empty())
+            environment.save(environmentPath.c_str());
+    }
+    if (mirrorCubeRoughness >= 0.0f && !environment.empty())
+        environmentTexture.upload(environment);
+    // the CPU rasterizer samples a copy of the faces
+    SoftwareRasterizer softwareRasterizer;
+    if (softwareRender)
+        softwareRasterizer.setSky(skyboxImage);
+    skyboxImage = CubemapImage();
     
     textureFileNames[0] = "brick.jpg";
     textureFileNames[1] = "wallPaint.jpg";
@@ -977,7 +1169,9 @@ int main()
     textureFileNames[4] = "door.jpg";
     textureFileNames[5] = "windowTex.jpg";
 
-    loadTextures();
+    // the room's textures as the layers of one texture array, in textureFileNames order
+    TextureArray roomTextures;
+    loadTextures(roomTextures);
 
 
 
@@ -991,168 +1185,711 @@ int main()
     skyboxShader.use();
     skyboxShader.setInt("skybox", 0);
 
-    // render loop
-    // -----------
-    while (!glfwWindowShouldClose(window))
+    compositeShader.use();
+    compositeShader.setInt("screenTexture", 0);
+
+    // dynamic resolution: the scene is rendered offscreen at a scale picked from the measured GPU time, then upscaled
+    // -------------------------------------------------------------------------------------------------------------
+    GlVertexArray compositeVAO = GlVertexArray::create();
+    ScalableRenderTarget sceneTarget;
+    GpuFrameTimer gpuTimer;
+    ResolutionGovernor resolutionGovernor(resolutionSettings);
+
+    // lights: ceiling lamps and one over the table, plus any number of extra lamps for stress testing
+    // ---------------------------------------------------------------------------------------------
+    vector<PointLight> sceneLights
     {
-        // per-frame time logic
-        // --------------------
-        float currentFrame = glfwGetTime();
-        deltaTime = currentFrame - lastFrame;
-        lastFrame = currentFrame;
+        { glm::vec3(-5.0f, 4.6f, -6.0f), 12.0f, glm::vec3(1.0f, 0.95f, 0.85f), 20.0f },
+        { glm::vec3( 5.0f, 4.6f, -6.0f), 12.0f, glm::vec3(1.0f, 0.95f, 0.85f), 20.0f },
+        { glm::vec3(-5.0f, 4.6f,  1.5f), 12.0f, glm::vec3(1.0f, 0.95f, 0.85f), 20.0f },
+        { glm::vec3( 5.0f, 4.6f,  1.5f), 12.0f, glm::vec3(1.0f, 0.95f, 0.85f), 20.0f },
+        { glm::vec3( 2.1f, 1.5f, -5.1f),  4.0f, glm::vec3(1.0f, 0.7f, 0.4f),    3.0f },
+    };
+    // the extra lamps land in the same places on every run, so images of the stress scenes can be compared
+    const size_t fixedLightCount = sceneLights.size();
+    auto scatterLamps = [&](int count)
+    {
+        sceneLights.resize(fixedLightCount);
+        srand(1234);
+        for (int i = 0; i < count; i++)
+        {
+            PointLight lamp;
+            lamp.position = glm::vec3(-9.5f + 19.0f * rand() / RAND_MAX, -0.5f + 5.0f * rand() / RAND_MAX, -10.0f + 14.0f * rand() / RAND_MAX);
+            lamp.radius = 1.5f + 2.5f * rand() / RAND_MAX;
+            lamp.color = glm::vec3(0.3f + 0.7f * rand() / RAND_MAX, 0.3f + 0.7f * rand() / RAND_MAX, 0.3f + 0.7f * rand() / RAND_MAX);
+            lamp.intensity = 2.0f;
+            sceneLights.push_back(lamp);
+        }
+    };
+    scatterLamps(extraLamps);
+    ClusterGridSettings clusterSettings;
+    clusterSettings.nearPlane = NEAR_PLANE;
+    clusterSettings.farPlane = FAR_PLANE;
+    LightClusterer lightClusterer(clusterSettings);
+    ClusteredLightBuffers lightBuffers;
+
+    // shadows of the first ceiling lamp and the sun; the static room is rendered into them once and cached
+    ShadowMaps shadowMaps(shadowSettings);
+
+    // scene graph: the room is a static root node, the imported model hangs below a second one that turns
+    SceneGraph sceneGraph;
+
+    // cells and portals: the room, and the outside its door and windows open onto. The shell is seen from both
+    // sides, the furniture only from inside or through an opening
+    // -----------------------------------------------------------------------------------------------------------
+    PortalGraph portalGraph;
+    const int roomCell = portalGraph.addCell(glm::vec3(-10.0f, -1.0f, -10.5f), glm::vec3(10.0f, 5.0f, 4.5f));
+    const int outsideCell = portalGraph.addCell();
+    portalGraph.addPortal(roomCell, outsideCell, door, (int)(sizeof(door) / (8 * sizeof(float))), 8);
+    portalGraph.addPortal(roomCell, outsideCell, windowRight, (int)(sizeof(windowRight) / (8 * sizeof(float))), 8);
+    portalGraph.addPortal(roomCell, outsideCell, windowBack, (int)(sizeof(windowBack) / (8 * sizeof(float))), 8);
+    const unsigned int shellCells = (1u << roomCell) | (1u << outsideCell);
+    const unsigned int insideCells = 1u << roomCell;
+
+    // the room's parts, in the order they have always been drawn in. The draw list, the cells each item is seen
+    // from, the lightmap surfaces and the texture layers are all built from this one table, so they can't drift
+    // apart. The window panes stay lit at runtime and cast no shadows.
+    // ------------------------------------------------------------------------------------------------------------
+    struct RoomPart {
+        unsigned int VAO;
+        const float* vertices;
+        int vertexCount;
+        // layer of the room's texture array, in textureFileNames order
+        int layer;
+        unsigned int cells;
+        bool lightmapped;
+    };
+    const RoomPart roomParts[] =
+    {
+        { roofWallVAO,    roof,        (int)(sizeof(roof) / (8 * sizeof(float))),        0, shellCells,  true },
+        { floorVAO,       floor,       (int)(sizeof(floor) / (8 * sizeof(float))),       0, shellCells,  true },
+        { frontWallVAO,   wallFront,   (int)(sizeof(wallFront) / (8 * sizeof(float))),   1, shellCells,  true },
+        { leftWallVAO,    wallLeft,    (int)(sizeof(wallLeft) / (8 * sizeof(float))),    1, shellCells,  true },
+        { rightWallVAO,   wallRight,   (int)(sizeof(wallRight) / (8 * sizeof(float))),   1, shellCells,  true },
+        { backWallVAO,    wallBack,    (int)(sizeof(wallBack) / (8 * sizeof(float))),    1, shellCells,  true },
+        { chairVAO,       chair,       (int)(sizeof(chair) / (8 * sizeof(float))),       2, insideCells, true },
+        { tableLegVAO,    tableLegs,   (int)(sizeof(tableLegs) / (8 * sizeof(float))),   2, insideCells, true },
+        { tableTopVAO,    tableTop,    (int)(sizeof(tableTop) / (8 * sizeof(float))),    3, insideCells, true },
+        { doorVAO,        door,        (int)(sizeof(door) / (8 * sizeof(float))),        4, shellCells,  true },
+        { windowRightVAO, windowRight, (int)(sizeof(windowRight) / (8 * sizeof(float))), 5, shellCells,  false },
+        { windowBackVAO,  windowBack,  (int)(sizeof(windowBack) / (8 * sizeof(float))),  5, shellCells,  false },
+    };
 
-        // input
-        // -----
-        processInput(window);
+    const int roomTransform = sceneGraph.addNode(SceneGraph::NO_PARENT, glm::mat4(1.0f));
 
-        // render
-        // ------
-        glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    vector<DrawItem> roomDrawList;
+    vector<unsigned int> roomDrawCells;
+    vector<LightmapSurface> roomSurfaces;
+    vector<int> roomSurfaceTextures;
+    for (const RoomPart& part : roomParts)
+    {
+        roomDrawList.push_back(DrawItem{ part.VAO, roomTextures.texture, 0, part.vertexCount, roomTransform, part.lightmapped ? 0 : DRAW_NO_SHADOW });
+        roomDrawCells.push_back(part.cells);
+        // grey until a bake averages the part's texture into it
+        roomSurfaces.push_back(LightmapSurface{ part.vertices, part.vertexCount, glm::vec3(0.5f), part.lightmapped });
+        roomSurfaceTextures.push_back(part.layer);
+        roomTextures.attachLayer(part.VAO, part.vertexCount, part.layer);
+    }
 
-        //draw scene as normal
-        shader.use();
-        glm::mat4 model = glm::mat4(1.0f);
-        glm::mat4 view = camera.GetViewMatrix();
-        glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-        shader.setMat4("model", model);
-        shader.setMat4("view", view);
-        shader.setMat4("projection", projection);
-        shader.setVec3("cameraPos", camera.Position);
-        //// cubes
-        //glBindVertexArray(cubeVAO);
-        ////glActiveTexture(GL_TEXTURE0);
-        //glEnable(GL_TEXTURE_2D);
-        //glBindTexture(GL_TEXTURE_2D, cubemapTexture);
-        //glDrawArrays(GL_TRIANGLES, 0, 36);
-        //glDisable(GL_TEXTURE_2D);
-        //glBindVertexArray(0);
+    if (bakeLightmap || bakeProbes || bakeEnvironment)
+    {
+        for (size_t i = 0; i < roomSurfaces.size(); i++)
+            roomSurfaces[i].albedo = averageTextureColor(textureFileNames[roomSurfaceTextures[i]]);
+        BakeLights bakeLights;
+        bakeLights.points = sceneLights;
+        bakeLights.sunEnabled = shadowSettings.sunEnabled;
+        bakeLights.sunDirection = shadowSettings.sunDirection;
+        bakeLights.sunColor = shadowSettings.sunColor * shadowSettings.sunIntensity;
+        if (bakeLightmap)
+        {
+            LightmapBaker baker(bakeSettings);
+            baker.bake(roomSurfaces, bakeLights).save(LIGHTMAP_PATH);
+        }
+        if (bakeProbes)
+        {
+            IrradianceVolumeBaker baker;
+            baker.bake(roomSurfaces, bakeLights).save(IRRADIANCE_VOLUME_PATH);
+        }
+        return 0;
+    }
+
+    Lightmap lightmap;
+    LightmapResources lightmapResources;
+    if (useLightmap && lightmap.load(LIGHTMAP_PATH))
+    {
+        if (lightmap.matches(roomSurfaces))
+        {
+            lightmapResources.upload(lightmap);
+            for (size_t i = 0; i < roomSurfaces.size(); i++)
+            {
+                if (!roomSurfaces[i].lightmapped)
+                    continue;
+                lightmapResources.attach(roomDrawList[i].VAO, lightmap.uvs[i]);
+                roomDrawList[i].flags |= DRAW_LIGHTMAPPED;
+            }
+        }
+        else
+        {
+            std::cout << "ERROR::LIGHTMAP:: " << LIGHTMAP_PATH << " was baked for different geometry, rebake it with --bake-lightmap" << std::endl;
+            lightmap = Lightmap();
+        }
+    }
 
+    // imported model: it moves, so instead of the lightmap it takes its light from the probe volume
+    // -----------------------------------------------------------------------------------------------
+    std::unique_ptr<Model> sceneModel;
+    if (!modelPath.empty())
+        sceneModel.reset(new Model(modelPath));
+    const int modelTransform = sceneGraph.addNode(SceneGraph::NO_PARENT, glm::mat4(1.0f));
+    if (sceneModel)
+        sceneModel->attach(sceneGraph, modelTransform);
+    const glm::vec3 modelPosition(2.1f, 0.4f, -5.6f);
+    IrradianceVolume irradianceVolume;
+    IrradianceVolumeTexture irradianceTexture;
+    if (sceneModel && irradianceVolume.load(IRRADIANCE_VOLUME_PATH))
+        irradianceTexture.upload(irradianceVolume);
+    // a skinned or animated model plays its first clip (or holds its rest pose) through the animation system
+    AnimationSystem animation;
+    BoneBuffer boneBuffer;
+    int animationInstance = -1;
+    if (sceneModel && sceneModel->skeleton.boneCount() > 0)
+        animationInstance = animation.addInstance(&sceneModel->skeleton, sceneModel->skeleton.clips.empty() ? -1 : 0);
+    // the model's meshes at full detail, as dynamic casters the shadow maps draw over the cached room every frame
+    vector<DrawItem> modelDrawList;
+    for (unsigned int i = 0; sceneModel && i < sceneModel->meshes.size(); i++)
+    {
+        const MeshLod& level = sceneModel->meshes[i].lods[0];
+        modelDrawList.push_back(DrawItem{ sceneModel->meshes[i].VAO, 0, (int)level.firstIndex, (int)level.indexCount, sceneModel->meshTransform(i),
+            DRAW_DYNAMIC | DRAW_SHADOW_ONLY | DRAW_INDEXED });
+    }
 
+    // collision: the whole room (window panes included) as one static body, the model as a second one that turns
+    // ------------------------------------------------------------------------------------------------------------
+    SceneCollision sceneCollision;
+    vector<glm::vec3> collisionTriangles;
+    for (const LightmapSurface& surface : roomSurfaces)
+        for (int v = 0; v < surface.vertexCount; v++)
+            collisionTriangles.push_back(glm::vec3(surface.vertices[v * 8], surface.vertices[v * 8 + 1], surface.vertices[v * 8 + 2]));
+    sceneCollision.addBody(collisionTriangles);
+    int modelBody = -1;
+    if (sceneModel)
+    {
+        collisionTriangles.clear();
+        sceneModel->collisionTriangles(collisionTriangles);
+        modelBody = sceneCollision.addBody(collisionTriangles);
+    }
 
+    if (benchQueries > 0)
+    {
+        benchmarkSceneQueries(sceneCollision, glm::vec3(-10.0f, -1.0f, -10.5f), glm::vec3(10.0f, 5.0f, 4.5f), benchQueries);
+        return 0;
+    }
 
+    // the room pass goes through the GL render device, its lighting inputs are bound around it
+    GlRenderDevice glRoomDevice(modelShader);
+    auto bindRoomLighting = [&](const FrameSnapshot& frame, int renderWidth, int renderHeight)
+    {
         modelShader.use();
-        glm::mat4 model2 = glm::mat4(1.0f);
-        glm::mat4 view2 = camera.GetViewMatrix();
-        glm::mat4 projection2 = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-        modelShader.setMat4("model", model2);
-        modelShader.setMat4("view", view2);
-        modelShader.setMat4("projection", projection2);
-
-
-        glBindVertexArray(roofWallVAO);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, texID[0]);
-        glDrawArrays(GL_TRIANGLES, 0, 6);
-        glBindVertexArray(0);
+        lightBuffers.upload(frame.lighting);
+        lightBuffers.bind(modelShader, lightClusterer, 1, renderWidth, renderHeight);
+        shadowMaps.bind(modelShader, 4);
+        if (!lightmap.empty())
+            lightmapResources.bind(modelShader, 6, lightmap.bakedLightCount, lightmap.bakedSun);
+    };
 
-        glBindVertexArray(floorVAO);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, texID[0]);
-        glDrawArrays(GL_TRIANGLES, 0, 6);
-        glBindVertexArray(0);
+    // render thread: only submits GL work for the snapshots the main thread hands over
+    // ------------------------------------------------------------------------------
+    auto renderFrame = [&](const FrameSnapshot& frame)
+    {
+        if (gpuTimer.poll())
+            resolutionGovernor.update(gpuTimer.milliseconds());
+        gpuTimer.begin();
+
+        // the model is posed before the shadow maps, its meshes cast from the draw list
+        bool skinned = sceneModel && !frame.boneMatrices.empty();
+        if (skinned && cpuSkinning)
+            sceneModel->SkinOnCpu(&frame.boneMatrices[0]);
+        else if (skinned)
+            boneBuffer.upload(frame.boneMatrices);
+        // the bone sampler always gets its own unit, left at 0 it would alias the diffuse texture's
+        for (Shader* program : { &pointShadowShader, &sunShadowShader, &objectShader })
+        {
+            program->use();
+            program->setBool("gpuSkinning", skinned && !cpuSkinning);
+            boneBuffer.bind(*program, 9);
+        }
+        shadowMaps.update(frame, pointShadowShader, sunShadowShader);
 
-        glBindVertexArray(frontWallVAO);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, texID[1]);
-        glDrawArrays(GL_TRIANGLES, 0, 12);
-        glBindVertexArray(0);
+        sceneTarget.resize(frame.width, frame.height, resolutionSettings.maxScale);
+        sceneTarget.bind(frame.width, frame.height, resolutionGovernor.currentScale());
 
-        glBindVertexArray(leftWallVAO);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, texID[1]);
-        glDrawArrays(GL_TRIANGLES, 0, 6);
-        glBindVertexArray(0);
+        // render
+        // ------
+        glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        glBindVertexArray(rightWallVAO);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, texID[1]);
-        glDrawArrays(GL_TRIANGLES, 0, 24);
-        glBindVertexArray(0);
+        //draw scene as normal
+        bool roomVisible = frame.visibleCells.empty() || frame.visibleCells[roomCell];
+        bool outsideVisible = frame.visibleCells.empty() || frame.visibleCells[outsideCell];
+        // mirror cube: rough reflections from the prefiltered sky, or the plain skybox if that failed to bake
+        if (mirrorCubeRoughness >= 0.0f && roomVisible)
+        {
+            shader.use();
+            shader.setMat4("model", glm::translate(glm::mat4(1.0f), glm::vec3(-4.0f, -0.5f, -4.0f)));
+            shader.setMat3("normalMatrix", glm::mat3(1.0f));
+            shader.setMat4("view", frame.view);
+            shader.setMat4("projection", frame.projection);
+            shader.setVec3("cameraPos", frame.cameraPos);
+            shader.setFloat("roughness", mirrorCubeRoughness);
+            shader.setFloat("metallic", 1.0f);
+            shader.setVec3("baseColor", glm::vec3(0.95f, 0.93f, 0.88f));
+            environmentTexture.bind(shader, 0);
+            if (!environmentTexture.texture)
+            {
+                glActiveTexture(GL_TEXTURE0);
+                glBindTexture(GL_TEXTURE_CUBE_MAP, cubemapTexture);
+                shader.setInt("skybox", 0);
+            }
+            glBindVertexArray(cubeVAO);
+            glDrawArrays(GL_TRIANGLES, 0, 36);
+            glBindVertexArray(0);
+        }
 
-        glBindVertexArray(backWallVAO);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, texID[1]);
-        glDrawArrays(GL_TRIANGLES, 0, 24);
-        glBindVertexArray(0);
+        bindRoomLighting(frame, sceneTarget.renderWidth, sceneTarget.renderHeight);
+        glRoomDevice.drawRoom(frame);
 
-        glBindVertexArray(chairVAO);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, texID[2]);
-        glDrawArrays(GL_TRIANGLES, 0, 156);
-        glBindVertexArray(0);
+        if (sceneModel && roomVisible)
+        {
+            objectShader.use();
+            objectShader.setMat4("view", frame.view);
+            objectShader.setMat4("projection", frame.projection);
+            irradianceTexture.bind(objectShader, 8);
+            shadowMaps.bindForBakedLighting(objectShader, 10);
+            sceneModel->selectLod(frame.transforms[modelTransform], frame.cameraPos, frame.projection[1][1] * sceneTarget.renderHeight * 0.5f, lodPixels);
+            if (meshletCulling)
+                sceneModel->DrawCulled(objectShader, frame.transforms, frame.normalMatrices, frame.projection * frame.view, frame.cameraPos);
+            else
+                sceneModel->Draw(objectShader, frame.transforms, frame.normalMatrices);
+        }
 
-        glBindVertexArray(tableLegVAO);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, texID[2]);
-        glDrawArrays(GL_TRIANGLES, 0, 96);
+        // lamps
+        lampShader.use();
+        lampShader.setMat4("view", frame.view);
+        lampShader.setMat4("projection", frame.projection);
+        glBindVertexArray(cubeVAO);
+        for (int i = 0; roomVisible && i < frame.lighting.lightCount(); i++)
+        {
+            glm::mat4 lampModel = glm::translate(glm::mat4(1.0f), glm::vec3(frame.lighting.lights[i * 2]));
+            lampShader.setMat4("model", glm::scale(lampModel, glm::vec3(0.15f)));
+            glDrawArrays(GL_TRIANGLES, 0, 36);
+        }
         glBindVertexArray(0);
 
-        glBindVertexArray(tableTopVAO);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, texID[3]);
-        glDrawArrays(GL_TRIANGLES, 0, 102);
-        glBindVertexArray(0);
+        // draw skybox as last, unless no opening to the outside is in view
+        if (outsideVisible)
+        {
+            glDepthFunc(GL_LEQUAL);  // change depth function so depth test passes when values are equal to depth buffer's content
+            skyboxShader.use();
+            glm::mat4 view = glm::mat4(glm::mat3(frame.view)); // remove translation from the view matrix
+            skyboxShader.setMat4("view", view);
+            skyboxShader.setMat4("projection", frame.projection);
+            // skybox cube
+            glBindVertexArray(skyboxVAO);
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_CUBE_MAP, cubemapTexture);
+            glDrawArrays(GL_TRIANGLES, 0, 36);
+            glBindVertexArray(0);
+            glDepthFunc(GL_LESS); // set depth function back to default
+        }
 
-        glBindVertexArray(doorVAO);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, texID[4]);
-        glDrawArrays(GL_TRIANGLES, 0, 6);
-        glBindVertexArray(0);
+        // upscale onto the window
+        sceneTarget.composite(compositeShader, compositeVAO, frame.width, frame.height);
+        gpuTimer.end();
+    };
 
-         glBindVertexArray(windowRightVAO);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, texID[5]);
-        glDrawArrays(GL_TRIANGLES, 0, 6);
-        glBindVertexArray(0);
+    // scene updates and what the render thread gets to see of them, shared by the simulation loop and the benchmarks
+    // ----------------------------------------------------------------------------------------------------------------
+    auto poseScene = [&](float time)
+    {
+        glm::mat4 modelMatrix = glm::translate(glm::mat4(1.0f), modelPosition);
+        modelMatrix = glm::rotate(modelMatrix, time * 0.5f, glm::vec3(0.0f, 1.0f, 0.0f));
+        modelMatrix = glm::scale(modelMatrix, glm::vec3(modelScale));
+        if (modelBody >= 0)
+            sceneCollision.setTransform(modelBody, modelMatrix);
+        sceneGraph.setLocal(modelTransform, modelMatrix);
+        sceneGraph.update();
+        if (animationInstance >= 0)
+        {
+            animation.setTime(animationInstance, time);
+            animation.evaluate(std::max(1, (int)std::thread::hardware_concurrency()));
+        }
+    };
+    auto takeSnapshot = [&](FrameSnapshot& frame, int width, int height)
+    {
+        frame.view = camera.GetViewMatrix();
+        frame.projection = glm::perspective(glm::radians(camera.Zoom), (float)width / (float)height, NEAR_PLANE, FAR_PLANE);
+        frame.cameraPos = camera.Position;
+        frame.zoom = camera.Zoom;
+        frame.width = width;
+        frame.height = height;
+        sceneGraph.copyWorlds(frame.transforms, frame.normalMatrices);
+        frame.boneMatrices.assign(animation.skinMatrices().begin(), animation.skinMatrices().end());
+        frame.drawList.assign(roomDrawList.begin(), roomDrawList.end());
+        frame.visibleCells.clear();
+        if (portalCulling)
+        {
+            portalGraph.findVisibleCells(frame.cameraPos, frame.projection * frame.view, frame.visibleCells);
+            for (size_t i = 0; i < frame.drawList.size(); i++)
+                if (!PortalGraph::anyVisible(roomDrawCells[i], frame.visibleCells))
+                    frame.drawList[i].flags |= DRAW_NOT_VISIBLE;
+        }
+        frame.drawList.insert(frame.drawList.end(), modelDrawList.begin(), modelDrawList.end());
+        lightClusterer.build(sceneLights, frame.view, frame.projection, frame.lighting);
+    };
 
-        glBindVertexArray(windowBackVAO);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, texID[5]);
-        glDrawArrays(GL_TRIANGLES, 0, 6);
-        glBindVertexArray(0);
+    // rendering on the CPU: the room, the model (skinned meshes in their bind pose) and the sky, lit by the point
+    // lights without shadows or baked light. The benchmark renders the same views with GL on this thread, so run
+    // it with LIBGL_ALWAYS_SOFTWARE=1 to compare against Mesa's llvmpipe.
+    // ----------------------------------------------------------------------------------------------------------------
+    if (softwareRender)
+    {
+        for (int i = 0; i < numTextures; i++)
+        {
+            SoftwareTexture texture;
+            texture.load(textureFileNames[i], true);
+            softwareRasterizer.addTexture(texture);
+        }
+        for (size_t i = 0; i < roomSurfaces.size(); i++)
+            softwareRasterizer.addMesh(SoftwareMesh{ roomSurfaces[i].vertices, (size_t)roomSurfaces[i].vertexCount, 8, 3, 6, nullptr, 0, roomTransform, roomSurfaceTextures[i] });
+        if (sceneModel)
+        {
+            vector<std::string> loadedPaths;
+            for (unsigned int m = 0; m < sceneModel->meshes.size(); m++)
+            {
+                const Mesh& mesh = sceneModel->meshes[m];
+                if (mesh.indices.empty())
+                    continue;
+                // the first diffuse texture, shared between meshes like the model shares its GL textures
+                int texture = -1;
+                for (const Texture& meshTexture : mesh.textures)
+                {
+                    if (meshTexture.type != "texture_diffuse")
+                        continue;
+                    size_t loaded = std::find(loadedPaths.begin(), loadedPaths.end(), meshTexture.path) - loadedPaths.begin();
+                    if (loaded < loadedPaths.size())
+                        texture = numTextures + (int)loaded;
+                    else
+                    {
+                        SoftwareTexture image = SoftwareTexture::flat(glm::vec3(0.7f));
+                        if (meshTexture.path.compare(0, 6, "color:") != 0)
+                            image.load(sceneModel->directory + '/' + meshTexture.path, false);
+                        texture = softwareRasterizer.addTexture(image);
+                        loadedPaths.push_back(meshTexture.path);
+                    }
+                    break;
+                }
+                const MeshLod& level = mesh.lods[0];
+                softwareRasterizer.addMesh(SoftwareMesh{ &mesh.vertices[0].Position.x, mesh.vertices.size(), (int)(sizeof(Vertex) / sizeof(float)), 3, 6,
+                    &mesh.indices[level.firstIndex], level.indexCount, sceneModel->meshTransform(m), texture });
+            }
+        }
 
+        poseScene(0.0f);
+        FrameSnapshot frame;
+        int width = framebufferWidth.load();
+        int height = framebufferHeight.load();
+        if (!softwareRenderPath.empty())
+        {
+            takeSnapshot(frame, width, height);
+            softwareRasterizer.render(frame.view, frame.projection, frame.cameraPos, frame.transforms, frame.normalMatrices, sceneLights, width, height);
+            const SoftwareRasterizerStats& stats = softwareRasterizer.stats;
+            std::cout << "SOFTWARE::RENDER:: " << stats.triangles << " triangles, " << stats.rasterized << " set up into " << stats.binned << " tile bins, setup "
+                      << stats.setupMs << " ms, raster and shading " << stats.rasterMs << " ms" << std::endl;
+            softwareRasterizer.image.save(softwareRenderPath);
+        }
+        if (benchSoftware > 0)
+        {
+            double cpuMs = 0.0, glMs = 0.0;
+            // one untimed frame each first, for first use allocations and shader compiles
+            for (int i = -1; i < benchSoftware; i++)
+            {
+                takeSnapshot(frame, width, height);
+                auto start = std::chrono::steady_clock::now();
+                softwareRasterizer.render(frame.view, frame.projection, frame.cameraPos, frame.transforms, frame.normalMatrices, sceneLights, width, height);
+                auto cpuEnd = std::chrono::steady_clock::now();
+                renderFrame(frame);
+                glFinish();
+                auto glEnd = std::chrono::steady_clock::now();
+                if (i >= 0)
+                {
+                    cpuMs += std::chrono::duration<double, std::milli>(cpuEnd - start).count();
+                    glMs += std::chrono::duration<double, std::milli>(glEnd - cpuEnd).count();
+                    camera.ProcessMouseMovement(360.0f / benchSoftware / camera.MouseSensitivity, 0.0f);
+                }
+            }
+            std::cout << "SOFTWARE::BENCH:: " << benchSoftware << " views at " << width << "x" << height << ", " << softwareRasterizer.stats.triangles << " triangles: CPU rasterizer "
+                      << cpuMs / benchSoftware << " ms, GL (" << glGetString(GL_RENDERER) << ") " << glMs / benchSoftware << " ms a frame" << std::endl;
+        }
+        return 0;
+    }
 
+    // the room through the Vulkan backend, offscreen. The benchmark times the CPU side of the room pass on both
+    // APIs: Vulkan's multithreaded recording and submit, and GL's calls through glFinish on this thread.
+    // ----------------------------------------------------------------------------------------------------------------
+    if (vulkanRender)
+    {
+#ifdef RENDER_VULKAN
+        int width = framebufferWidth.load();
+        int height = framebufferHeight.load();
+        VulkanRenderDevice vulkan;
+        bool ready = vulkan.init(width, height, vulkanSettings);
+        if (ready)
+        {
+            for (size_t i = 0; i < roomSurfaces.size(); i++)
+                vulkan.addSurface(roomSurfaces[i].vertices, roomSurfaces[i].vertexCount, roomSurfaceTextures[i]);
+            for (int i = 0; i < numTextures; i++)
+            {
+                SoftwareTexture texture;
+                texture.load(textureFileNames[i], true);
+                vulkan.addTextureLayer(&texture.rgb[0], texture.width, texture.height);
+            }
+            ready = vulkan.upload();
+        }
+        if (!ready)
+            return 1;
 
+        poseScene(0.0f);
+        FrameSnapshot frame;
+        if (!vulkanRenderPath.empty())
+        {
+            takeSnapshot(frame, width, height);
+            vulkan.drawRoom(frame);
+            RgbImage image;
+            if (vulkan.readback(image))
+                image.save(vulkanRenderPath);
+        }
+        if (benchVulkan > 0)
+        {
+            takeSnapshot(frame, width, height);
+            shadowMaps.update(frame, pointShadowShader, sunShadowShader);
+            double recordMs = 0.0, vulkanMs = 0.0, glMs = 0.0;
+            for (int i = -1; i < benchVulkan; i++)
+            {
+                takeSnapshot(frame, width, height);
+                auto start = std::chrono::steady_clock::now();
+                vulkan.drawRoom(frame);
+                auto submitted = std::chrono::steady_clock::now();
+                vulkan.finish();
+                auto vulkanEnd = std::chrono::steady_clock::now();
+                bindRoomLighting(frame, width, height);
+                glRoomDevice.drawRoom(frame);
+                glFinish();
+                auto glEnd = std::chrono::steady_clock::now();
+                if (i >= 0)
+                {
+                    recordMs += vulkan.recordMs;
+                    vulkanMs += std::chrono::duration<double, std::milli>(submitted - start).count();
+                    glMs += std::chrono::duration<double, std::milli>(glEnd - vulkanEnd).count();
+                    camera.ProcessMouseMovement(360.0f / benchVulkan / camera.MouseSensitivity, 0.0f);
+                }
+            }
+            std::cout << "VULKAN::BENCH:: " << benchVulkan << " views at " << width << "x" << height << ": " << vulkan.name() << " records in " << recordMs / benchVulkan
+                      << " ms and submits in " << vulkanMs / benchVulkan << " ms, GL (" << glGetString(GL_RENDERER) << ") takes " << glMs / benchVulkan << " ms a frame" << std::endl;
+        }
+        vulkan.release();
+        return 0;
+#else
+        std::cout << "ERROR::VULKAN::NOT_BUILT: rebuild with RENDER_VULKAN defined and the Vulkan SDK installed" << std::endl;
+        return 1;
+#endif
+    }
 
-        // draw skybox as last
-        glDepthFunc(GL_LEQUAL);  // change depth function so depth test passes when values are equal to depth buffer's content
-        skyboxShader.use();
-        view = glm::mat4(glm::mat3(camera.GetViewMatrix())); // remove translation from the view matrix
-        skyboxShader.setMat4("view", view);
-        skyboxShader.setMat4("projection", projection);
-        // skybox cube
-        glBindVertexArray(skyboxVAO);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_CUBE_MAP, cubemapTexture);
-        glDrawArrays(GL_TRIANGLES, 0, 36);
-        glBindVertexArray(0);
-        glDepthFunc(GL_LESS); // set depth function back to default
+    // golden image regression: every scene is drawn through the full GL frame, a few untimed frames first so the
+    // GPU timer only reports frames of that scene, then the frame read back is compared with the golden image and
+    // the medians of the timed frames with the scene's budgets and the baseline
+    // ----------------------------------------------------------------------------------------------------------------
+    if (regression)
+    {
+        RegressionSettings settings;
+        if (!settings.load(regressionPath))
+            return 1;
+        const std::string baselinePath = settings.goldenDirectory + "/baseline.txt";
+        RegressionBaseline baseline;
+        if (!regressionUpdate)
+            baseline.load(baselinePath);
+
+        int width = framebufferWidth.load();
+        int height = framebufferHeight.load();
+        int failedScenes = 0;
+        FrameSnapshot frame;
+        for (const RegressionScene& scene : settings.scenes)
+        {
+            camera.Position = scene.position;
+            camera.Yaw = scene.yaw;
+            camera.Pitch = scene.pitch;
+            camera.Zoom = scene.zoom;
+            camera.ProcessMouseMovement(0.0f, 0.0f);
+            scatterLamps(scene.lamps >= 0 ? scene.lamps : extraLamps);
+            poseScene(scene.time);
+
+            std::vector<double> cpuTimes, gpuTimes;
+            for (int i = -GpuFrameTimer::QUERY_COUNT; i < settings.frames; i++)
+            {
+                auto start = std::chrono::steady_clock::now();
+                takeSnapshot(frame, width, height);
+                renderFrame(frame);
+                auto submitted = std::chrono::steady_clock::now();
+                glFinish();
+                if (i < 0)
+                    continue;
+                cpuTimes.push_back(std::chrono::duration<double, std::milli>(submitted - start).count());
+                if (gpuTimer.poll())
+                    gpuTimes.push_back(gpuTimer.milliseconds());
+            }
+            RegressionMeasurement measured;
+            measured.cpuMs = medianOf(cpuTimes);
+            measured.gpuMs = medianOf(gpuTimes);
+            measured.memoryMb = processMemoryMb();
+            measured.gpuMemoryMb = gpuMemoryMb();
+
+            RgbImage image;
+            glRoomDevice.readback(image);
+            const std::string goldenPath = settings.goldenDirectory + "/" + scene.name + ".ppm";
+            std::cout << "REGRESSION::SCENE:: " << scene.name << ": CPU " << measured.cpuMs << " ms, GPU " << measured.gpuMs << " ms, " << measured.memoryMb << " MB";
+            if (measured.gpuMemoryMb >= 0.0)
+                std::cout << ", " << measured.gpuMemoryMb << " MB of video memory";
+            if (sceneModel && meshletCulling)
+                std::cout << ", meshlet culling kept " << sceneModel->visibleTriangles() << " of " << sceneModel->submittedTriangles() << " model triangles";
+            std::cout << std::endl;
+            if (regressionUpdate)
+            {
+                image.save(goldenPath);
+                baseline.scenes[scene.name] = measured;
+                continue;
+            }
+
+            bool failed = false;
+            RgbImage golden;
+            if (!golden.load(goldenPath))
+            {
+                std::cout << "ERROR::REGRESSION::NO_GOLDEN_IMAGE: " << scene.name << ", write one with --regression-update" << std::endl;
+                failed = true;
+            }
+            else
+            {
+                ImageDifference difference = compareImages(image, golden, settings.tolerance);
+                if (difference.differentFraction > settings.maxDifferent)
+                {
+                    image.save(settings.goldenDirectory + "/" + scene.name + ".actual.ppm");
+                    if (difference.heatmap.width > 0)
+                        difference.heatmap.save(settings.goldenDirectory + "/" + scene.name + ".diff.ppm");
+                    std::cout << "ERROR::REGRESSION::IMAGE_MISMATCH: " << scene.name << ", " << difference.differentFraction * 100.0 << "% of the pixels differ (largest difference "
+                              << difference.maxDelta << "), see " << scene.name << ".actual.ppm and " << scene.name << ".diff.ppm" << std::endl;
+                    failed = true;
+                }
+            }
+
+            auto overBudget = [&](const char* what, double value, double budget, const char* unit)
+            {
+                if (budget <= 0.0 || value <= budget)
+                    return;
+                std::cout << "ERROR::REGRESSION::OVER_BUDGET: " << scene.name << ", " << what << " " << value << " " << unit << " over the budget of " << budget << " " << unit << std::endl;
+                failed = true;
+            };
+            overBudget("CPU", measured.cpuMs, scene.maxCpuMs, "ms");
+            overBudget("GPU", measured.gpuMs, scene.maxGpuMs, "ms");
+            overBudget("memory", measured.memoryMb, scene.maxMemoryMb, "MB");
+
+            auto accepted = baseline.scenes.find(scene.name);
+            if (accepted != baseline.scenes.end())
+            {
+                // frame times get an absolute allowance on top of the relative one, sub-millisecond frames are mostly noise
+                auto overBaseline = [&](const char* what, double value, double reference, double noise, const char* unit)
+                {
+                    if (reference < 0.0 || value <= reference * (1.0 + settings.slack) + noise)
+                        return;
+                    std::cout << "ERROR::REGRESSION::WORSE_THAN_BASELINE: " << scene.name << ", " << what << " " << value << " " << unit << " against " << reference << " " << unit << std::endl;
+                    failed = true;
+                };
+                overBaseline("CPU", measured.cpuMs, accepted->second.cpuMs, settings.slackMs, "ms");
+                overBaseline("GPU", measured.gpuMs, accepted->second.gpuMs, settings.slackMs, "ms");
+                overBaseline("memory", measured.memoryMb, accepted->second.memoryMb, 0.0, "MB");
+                if (measured.gpuMemoryMb >= 0.0)
+                    overBaseline("video memory", measured.gpuMemoryMb, accepted->second.gpuMemoryMb, 0.0, "MB");
+            }
+            if (failed)
+                failedScenes++;
+        }
+        if (regressionUpdate)
+            baseline.save(baselinePath);
+        std::cout << "REGRESSION::RESULT:: " << settings.scenes.size() - failedScenes << " of " << settings.scenes.size() << " scenes passed at " << width << "x" << height
+                  << " on " << glGetString(GL_RENDERER) << std::endl;
+        return failedScenes > 0 ? 1 : 0;
+    }
+
+    // hand the GL context over to the render thread
+    glfwMakeContextCurrent(NULL);
+    FramePacer framePacer(pacingSettings);
+    RenderThread renderThread;
+    renderThread.start(window, renderFrame, &framePacer);
+
+    // simulation loop: input and scene updates keep running while the render thread is blocked in swap or driver work
+    // ----------------------------------------------------------------------------------------------------------------
+    const std::chrono::duration<double> simulationStep(1.0 / SIMULATION_HZ);
+    std::chrono::steady_clock::time_point nextTick = std::chrono::steady_clock::now();
+    uint64_t frameIndex = 0;
+    while (!glfwWindowShouldClose(window))
+    {
+        // per-frame time logic
+        // --------------------
+        float currentFrame = glfwGetTime();
+        deltaTime = currentFrame - lastFrame;
+        lastFrame = currentFrame;
+        poseScene(currentFrame);
 
-        // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
-        // -------------------------------------------------------------------------------
-        glfwSwapBuffers(window);
+        // glfw: poll IO events (keys pressed/released, mouse moved etc.)
+        // -------------------------------------------------------------
         glfwPollEvents();
+        double inputSampleTime = pacingClock();
+
+        // input
+        // -----
+        processInput(window, cameraCollision ? &sceneCollision : nullptr);
+
+        // hand the current state of the scene to the render thread
+        // --------------------------------------------------------
+        int width = framebufferWidth.load();
+        int height = framebufferHeight.load();
+        if (width > 0 && height > 0) // minimized windows have nothing to present
+        {
+            FrameSnapshot& frame = renderThread.mailbox.writeBuffer();
+            frame.frameIndex = frameIndex++;
+            frame.inputSampleTime = inputSampleTime;
+            takeSnapshot(frame, width, height);
+            renderThread.mailbox.publish();
+        }
+
+        nextTick += std::chrono::duration_cast<std::chrono::steady_clock::duration>(simulationStep);
+        std::this_thread::sleep_until(nextTick);
     }
 
-    // optional: de-allocate all resources once they've outlived their purpose:
-    // ------------------------------------------------------------------------
-    glDeleteVertexArrays(1, &cubeVAO);
-    glDeleteVertexArrays(1, &skyboxVAO);
-    glDeleteBuffers(1, &cubeVBO);
-    glDeleteBuffers(1, &skyboxVAO);
+    renderThread.stop();
+    glfwMakeContextCurrent(window);
 
-    glfwTerminate();
+    // the model, shaders, vertex arrays, textures and buffers are deleted as main() returns, before glfwSession ends GLFW
     return 0;
 }
 
-// process all input: query GLFW whether relevant keys are pressed/released this frame and react accordingly
+// process all input: query GLFW whether relevant keys are pressed/released this frame and react accordingly.
+// collision, when given, keeps the camera's capsule out of the scene and slides it along what it walks into
 // ---------------------------------------------------------------------------------------------------------
-void processInput(GLFWwindow* window)
+void processInput(GLFWwindow* window, const SceneCollision* collision)
 {
     if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
         glfwSetWindowShouldClose(window, true);
 
+    glm::vec3 start = camera.Position;
+
     if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
         camera.ProcessKeyboard(FORWARD, deltaTime);
     if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
@@ -1161,6 +1898,8 @@ void processInput(GLFWwindow* window)
         camera.ProcessKeyboard(LEFT, deltaTime);
     if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
         camera.ProcessKeyboard(RIGHT, deltaTime);
+    if (collision)
+        camera.Position = collision->slide(CameraCapsule(), start, camera.Position - start);
 }
 
 // glfw: whenever the window size changed (by OS or user resize) this callback function executes
@@ -1169,7 +1908,9 @@ void framebuffer_size_callback(GLFWwindow* window, int width, int height)
 {
     // make sure the viewport matches the new window dimensions; note that width and 
     // height will be significantly larger than specified on retina displays.
-    glViewport(0, 0, width, height);
+    // the context lives on the render thread, which picks the size up with the next snapshot.
+    framebufferWidth.store(width);
+    framebufferHeight.store(height);
 }
 
 // glfw: whenever the mouse moves, this callback is called
@@ -1238,89 +1979,311 @@ unsigned int loadTexture(char const* path)
     return textureID;
 }
 
-// loads a cubemap texture from 6 individual texture faces
-// order:
-// +X (right)
-// -X (left)
-// +Y (top)
-// -Y (bottom)
-// +Z (front) 
-// -Z (back)
-// -------------------------------------------------------
-unsigned int loadCubemap(vector<std::string> faces)
+void loadTextures(TextureArray& textures)
 {
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
+    for (int i = 0; i < numTextures; i++) {
+        FREE_IMAGE_FORMAT format = FreeImage_GetFIFFromFilename(textureFileNames[i]);
+        FIBITMAP* bitmap = format == FIF_UNKNOWN ? NULL : FreeImage_Load(format, textureFileNames[i], 0);
+        if (!bitmap) {
+            printf("Failed to load image %s\n", textureFileNames[i]);
+            // a grey layer keeps the layers of the textures after it where the room expects them
+            textures.addColor(128, 128, 128);
+            continue;
+        }
+        FIBITMAP* bitmap2 = FreeImage_ConvertTo24Bits(bitmap);
+        FreeImage_Unload(bitmap);
+        int imgWidth = FreeImage_GetWidth(bitmap2);
+        int imgHeight = FreeImage_GetHeight(bitmap2);
+        printf("Texture image loaded from file %s, size %dx%d\n", textureFileNames[i], imgWidth, imgHeight);
+        // FreeImage rows are bottom up like GL's, with the channels in FI_RGBA order
+        textures.add(FreeImage_GetBits(bitmap2), imgWidth, imgHeight, FreeImage_GetPitch(bitmap2), FI_RGBA_RED != 0);
+        FreeImage_Unload(bitmap2);
+    }
+    textures.upload();
+}
 
-    int width, height, nrComponents;
-    for (unsigned int i = 0; i < faces.size(); i++)
+// replaces the normals of a position/normal/texcoord array (8 floats per vertex) with the normal of each triangle
+// -------------------------------------------------------------------------------------------------------------
+void computeFlatNormals(float* vertices, size_t floatCount)
+{
+    const size_t stride = 8;
+    for (size_t triangle = 0; triangle + 3 * stride <= floatCount; triangle += 3 * stride)
     {
-        unsigned char* data = stbi_load(faces[i].c_str(), &width, &height, &nrComponents, 0);
-        if (data)
+        glm::vec3 a = glm::make_vec3(vertices + triangle);
+        glm::vec3 b = glm::make_vec3(vertices + triangle + stride);
+        glm::vec3 c = glm::make_vec3(vertices + triangle + 2 * stride);
+        glm::vec3 normal = glm::cross(b - a, c - a);
+        float length = glm::length(normal);
+        normal = length > 0.0f ? normal / length : glm::vec3(0.0f, 1.0f, 0.0f);
+        for (size_t v = 0; v < 3; v++)
         {
-            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-            stbi_image_free(data);
-        }
-        else
-        {
-            std::cout << "Cubemap texture failed to load at path: " << faces[i] << std::endl;
-            stbi_image_free(data);
+            vertices[triangle + v * stride + 3] = normal.x;
+            vertices[triangle + v * stride + 4] = normal.y;
+            vertices[triangle + v * stride + 5] = normal.z;
         }
     }
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+}
 
-    return textureID;
+// uploads a position/normal/texcoord array (8 floats per vertex) into buffer and describes it in vertexArray
+// -------------------------------------------------------------------------------------------------------------
+void setupRoomVertexArray(unsigned int vertexArray, unsigned int buffer, const float* vertices, size_t size)
+{
+    glBindVertexArray(vertexArray);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    glBufferData(GL_ARRAY_BUFFER, size, vertices, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
 }
 
+// The steps of Model's loader the benchmarks time, which Model keeps private: an empty model with no file
+// behind it, reading an unskinned assimp mesh into vertices and indices, and finding a material's textures among
+// textures_loaded, loading the ones that aren't.
+struct ModelLoaderAccess {
+    typedef Model::MeshData MeshData;
+
+    static std::unique_ptr<Model> emptyModel() { return std::unique_ptr<Model>(new Model()); }
+
+    static MeshData readMesh(Model& model, aiMesh* mesh, const aiScene* scene) { return model.processMesh(mesh, scene, 0); }
+
+    static vector<Texture> findMaterialTextures(Model& model, aiMaterial* material, aiTextureType type, const string& typeName)
+    {
+        return model.loadMaterialTextures(material, type, typeName);
+    }
+};
 
-void loadTextures()
+// The per-file hot paths of loading a model: turning an assimp mesh of range() vertices (a grid, with normals,
+// texture coordinates and tangents) into vertices and indices, and finding a material's textures among range()
+// already loaded ones, which is a linear search by path.
+// -------------------------------------------------------------------------------------------------------------
+void addModelBenchmarks(BenchmarkSuite& suite)
 {
-    int i;
-    glGenTextures(numTextures, texID);  // Get the texture object IDs.
-    for (i = 0; i < numTextures; i++) {
-        void* imgData;  // Pointer to image color data read from the file.
-        int imgWidth;   // The width of the image that was read.
-        int imgHeight;  // The height.
-        FREE_IMAGE_FORMAT format = FreeImage_GetFIFFromFilename(textureFileNames[i]);
-        if (format == FIF_UNKNOWN) {
-            printf("Unknown file type for texture image file %s\n", textureFileNames);
-            continue;
+    suite.add("Model::processMesh", [](BenchmarkState& state) {
+        unsigned int side = std::max(2u, (unsigned int)std::sqrt((double)state.range()));
+        aiMesh* mesh = new aiMesh();
+        mesh->mPrimitiveTypes = aiPrimitiveType_TRIANGLE;
+        mesh->mNumVertices = side * side;
+        mesh->mVertices = new aiVector3D[mesh->mNumVertices];
+        mesh->mNormals = new aiVector3D[mesh->mNumVertices];
+        mesh->mTangents = new aiVector3D[mesh->mNumVertices];
+        mesh->mBitangents = new aiVector3D[mesh->mNumVertices];
+        mesh->mTextureCoords[0] = new aiVector3D[mesh->mNumVertices];
+        mesh->mNumUVComponents[0] = 2;
+        for (unsigned int y = 0; y < side; y++)
+        {
+            for (unsigned int x = 0; x < side; x++)
+            {
+                unsigned int v = y * side + x;
+                mesh->mVertices[v] = aiVector3D((float)x, 0.0f, (float)y);
+                mesh->mNormals[v] = aiVector3D(0.0f, 1.0f, 0.0f);
+                mesh->mTangents[v] = aiVector3D(1.0f, 0.0f, 0.0f);
+                mesh->mBitangents[v] = aiVector3D(0.0f, 0.0f, 1.0f);
+                mesh->mTextureCoords[0][v] = aiVector3D((float)x / side, (float)y / side, 0.0f);
+            }
         }
-        FIBITMAP* bitmap = FreeImage_Load(format, textureFileNames[i], 0);
-        if (!bitmap) {
-            printf("Failed to load image %s\n", textureFileNames[i]);
-            continue;
+        mesh->mNumFaces = (side - 1) * (side - 1) * 2;
+        mesh->mFaces = new aiFace[mesh->mNumFaces];
+        for (unsigned int y = 0, f = 0; y + 1 < side; y++)
+        {
+            for (unsigned int x = 0; x + 1 < side; x++, f += 2)
+            {
+                unsigned int v = y * side + x;
+                unsigned int quad[2][3] = { { v, v + side, v + 1 }, { v + 1, v + side, v + side + 1 } };
+                for (int t = 0; t < 2; t++)
+                {
+                    mesh->mFaces[f + t].mNumIndices = 3;
+                    mesh->mFaces[f + t].mIndices = new unsigned int[3]{ quad[t][0], quad[t][1], quad[t][2] };
+                }
+            }
         }
-        FIBITMAP* bitmap2 = FreeImage_ConvertTo24Bits(bitmap);
-        FreeImage_Unload(bitmap);
-        imgData = FreeImage_GetBits(bitmap2);
-        imgWidth = FreeImage_GetWidth(bitmap2);
-        imgHeight = FreeImage_GetHeight(bitmap2);
-        if (imgData) {
-            printf("Texture image loaded from file %s, size %dx%d\n",
-                textureFileNames[i], imgWidth, imgHeight);
-            int format;
-            if (FI_RGBA_RED == 0)
-                format = GL_RGB;
-            else
-                format = GL_BGR;
-            glBindTexture(GL_TEXTURE_2D, texID[i]);  // Will load image data into texture object #i
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, imgWidth, imgHeight, 0, format,
-                GL_UNSIGNED_BYTE, imgData);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR); // Required since there are no mipmaps.
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);  // (Actually, this one is the default)
-            //stbi_image_free(imgData);
+        aiScene scene;
+        scene.mNumMeshes = 1;
+        scene.mMeshes = new aiMesh*[1]{ mesh };
+        scene.mNumMaterials = 1;
+        scene.mMaterials = new aiMaterial*[1]{ new aiMaterial() };
+
+        std::unique_ptr<Model> model = ModelLoaderAccess::emptyModel();
+        while (state.keepRunning())
+        {
+            ModelLoaderAccess::MeshData data = ModelLoaderAccess::readMesh(*model, mesh, &scene);
+            doNotOptimize(data.indices.back());
+        }
+        state.setItemsProcessed(state.iterations() * mesh->mNumVertices);
+    }).range(64, 262144);
+
+    suite.add("Model::loadMaterialTextures", [](BenchmarkState& state) {
+        std::unique_ptr<Model> model = ModelLoaderAccess::emptyModel();
+        for (int64_t i = 0; i < state.range(); i++)
+        {
+            Texture texture;
+            texture.id = 0;
+            texture.type = "texture_diffuse";
+            texture.path = "textures/synthetic_" + std::to_string(i) + ".png";
+            model->textures_loaded.push_back(texture);
         }
-        else {
-            printf("Failed to get texture data from %s\n", textureFileNames[i]);
+        // the last few loaded, the longest searches
+        aiMaterial material;
+        const int materialTextures = 4;
+        for (int i = 0; i < materialTextures; i++)
+        {
+            aiString path(model->textures_loaded[(size_t)std::max<int64_t>(0, state.range() - 1 - i)].path);
+            material.AddProperty(&path, AI_MATKEY_TEXTURE_DIFFUSE(i));
+        }
+        while (state.keepRunning())
+        {
+            vector<Texture> textures = ModelLoaderAccess::findMaterialTextures(*model, &material, aiTextureType_DIFFUSE, "texture_diffuse");
+            doNotOptimize(textures.back().id);
+        }
+        state.setItemsProcessed(state.iterations() * materialTextures);
+    }).range(8, 4096);
+}
+
+
+// a size x size JPEG of gradients under noise, which compresses and decodes about like the room's photos
+// -------------------------------------------------------------------------------------------------------------
+bool writeSyntheticJpeg(const std::string& path, int size)
+{
+    FIBITMAP* bitmap = FreeImage_Allocate(size, size, 24);
+    if (!bitmap)
+        return false;
+    srand(size);
+    for (int y = 0; y < size; y++)
+    {
+        BYTE* row = FreeImage_GetScanLine(bitmap, y);
+        for (int x = 0; x < size; x++)
+        {
+            row[x * 3 + FI_RGBA_RED] = (BYTE)(x * 223 / size + rand() % 32);
+            row[x * 3 + FI_RGBA_GREEN] = (BYTE)(y * 223 / size + rand() % 32);
+            row[x * 3 + FI_RGBA_BLUE] = (BYTE)((x + y) * 111 / size + rand() % 32);
         }
-        
     }
+    bool saved = FreeImage_Save(FIF_JPEG, bitmap, path.c_str(), JPEG_QUALITYGOOD) != 0;
+    FreeImage_Unload(bitmap);
+    return saved;
+}
+
+// The GL side of loading and the camera math of every frame, on input of range() size: JPEGs range() texels
+// square, fragment shaders of range() statements, room surfaces of range() triangles. The texture and vertex
+// array benchmarks wait for the driver with glFinish, so the upload is in their time.
+// -------------------------------------------------------------------------------------------------------------
+void addSceneBenchmarks(BenchmarkSuite& suite)
+{
+    suite.add("TextureFromFile", [](BenchmarkState& state) {
+        std::string path = "microbenchmark_" + std::to_string(state.range()) + ".jpg";
+        if (!writeSyntheticJpeg(path, (int)state.range()))
+        {
+            state.skipWithError("could not write " + path);
+            return;
+        }
+        while (state.keepRunning())
+        {
+            GlTexture texture = GlTexture::adopt(TextureFromFile(path.c_str(), "."));
+            glFinish();
+        }
+        std::remove(path.c_str());
+        state.setBytesProcessed(state.iterations() * state.range() * state.range() * 3);
+    }).range(64, 4096, 4);
+
+    suite.add("loadTexture", [](BenchmarkState& state) {
+        std::string path = "microbenchmark_" + std::to_string(state.range()) + ".jpg";
+        if (!writeSyntheticJpeg(path, (int)state.range()))
+        {
+            state.skipWithError("could not write " + path);
+            return;
+        }
+        while (state.keepRunning())
+        {
+            GlTexture texture = GlTexture::adopt(loadTexture(path.c_str()));
+            glFinish();
+        }
+        std::remove(path.c_str());
+        state.setBytesProcessed(state.iterations() * state.range() * state.range() * 3);
+    }).range(64, 4096, 4);
+
+    // six faces decoded on their own threads, then uploaded
+    suite.add("CubemapLoader::load", [](BenchmarkState& state) {
+        std::string path = "microbenchmark_" + std::to_string(state.range()) + ".jpg";
+        if (!writeSyntheticJpeg(path, (int)state.range()))
+        {
+            state.skipWithError("could not write " + path);
+            return;
+        }
+        vector<std::string> faces(CubemapImage::FACES, path);
+        CubemapLoader loader;
+        while (state.keepRunning())
+        {
+            GlTexture texture = CubemapLoader::upload(loader.load(faces));
+            glFinish();
+        }
+        std::remove(path.c_str());
+        state.setBytesProcessed(state.iterations() * CubemapImage::FACES * state.range() * state.range() * 3);
+    }).range(64, 2048, 4);
+
+    suite.add("Shader", [](BenchmarkState& state) {
+        const char* vertexPath = "microbenchmark.vs";
+        const char* fragmentPath = "microbenchmark.fs";
+        std::ofstream(vertexPath) << "#version 330 core\nlayout (location = 0) in vec3 aPos;\nvoid main()\n{\n    gl_Position = vec4(aPos, 1.0);\n}\n";
+        int64_t iteration = 0;
+        while (state.keepRunning())
+        {
+            // a new source every time, drivers keep the programs they compiled before
+            state.pauseTiming();
+            {
+                std::ofstream fragment(fragmentPath);
+                fragment << "#version 330 core\nout vec4 FragColor;\nuniform vec4 seed;\nvoid main()\n{\n    vec4 v = seed + " << iteration++ << ".0;\n";
+                for (int64_t i = 0; i < state.range(); i++)
+                    fragment << "    v = sin(v * " << 1.0 + i * 0.001 << ") + v.yzwx;\n";
+                fragment << "    FragColor = v;\n}\n";
+            }
+            state.resumeTiming();
+            Shader program(vertexPath, fragmentPath);
+            doNotOptimize(program.ID.id());
+        }
+        std::remove(vertexPath);
+        std::remove(fragmentPath);
+        state.setItemsProcessed(state.iterations() * state.range());
+    }).range(16, 4096);
+
+    suite.add("Camera::ProcessMouseMovement", [](BenchmarkState& state) {
+        Camera view(glm::vec3(0.0f, 0.0f, 3.0f));
+        float offset = 1.0f;
+        while (state.keepRunning())
+        {
+            view.ProcessMouseMovement(offset, -0.5f * offset);
+            offset = -offset;
+            doNotOptimize(view.Front);
+        }
+    });
+
+    suite.add("Camera::GetViewMatrix", [](BenchmarkState& state) {
+        Camera view(glm::vec3(0.0f, 0.0f, 3.0f));
+        while (state.keepRunning())
+        {
+            glm::mat4 matrix = view.GetViewMatrix();
+            doNotOptimize(matrix);
+            view.Position.x += 1e-6f;
+        }
+    });
+
+    // what every surface of the room goes through at startup: flat normals, then a vertex array over its buffer
+    suite.add("setupRoomVertexArray", [](BenchmarkState& state) {
+        vector<float> vertices((size_t)state.range() * 3 * 8);
+        srand(7);
+        for (float& value : vertices)
+            value = -10.0f + 20.0f * rand() / RAND_MAX;
+        while (state.keepRunning())
+        {
+            computeFlatNormals(&vertices[0], vertices.size());
+            GlVertexArray vertexArray = GlVertexArray::create();
+            GlBuffer buffer = GlBuffer::create();
+            setupRoomVertexArray(vertexArray, buffer, &vertices[0], vertices.size() * sizeof(float));
+            glFinish();
+        }
+        glBindVertexArray(0);
+        state.setItemsProcessed(state.iterations() * state.range());
+        state.setBytesProcessed(state.iterations() * (int64_t)(vertices.size() * sizeof(float)));
+    }).range(8, 65536);
 }
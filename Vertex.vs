@@ -2,19 +2,27 @@
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoord;
+layout (location = 3) in vec2 aLightmapUV;
+layout (location = 4) in float aLayer;
 
 out vec3 Normal;
 out vec3 Position;
 out vec2 TexCoord;
+out vec2 LightmapUV;
+out float Layer;
 
 uniform mat4 model;
+// transpose(inverse(mat3(model))), computed once per node by the scene graph
+uniform mat3 normalMatrix;
 uniform mat4 view;
 uniform mat4 projection;
 
 void main()
 {
-    Normal = mat3(transpose(inverse(model))) * aNormal;
+    Normal = normalMatrix * aNormal;
     Position = vec3(model * vec4(aPos, 1.0));
     gl_Position = projection * view * vec4(Position, 1.0);
     TexCoord = aTexCoord;
+    LightmapUV = aLightmapUV;
+    Layer = aLayer;
 }
\ No newline at end of file
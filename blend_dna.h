@@ -0,0 +1,2075 @@
+// Generated by tools/sdna_bindings.cpp from dna.txt, do not edit. Regenerate with
+//   sdna_bindings dna.txt blend_dna.h Object Mesh MVert MPoly MLoop MLoopUV MFace MTFace
+//
+// Layouts of a 64 bit .blend. Before reading a file through these, check that the file agrees with them
+// (BlendFile::matches<dna::Mesh>() and so on); files from other versions need the runtime offsets instead.
+#ifndef BLEND_DNA_H
+#define BLEND_DNA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace dna
+{
+struct Field {
+    const char* name;
+    int offset;
+    int size;
+};
+
+// a scalar field, or element `index` of an array field, of the struct at base: one unaligned load
+template <class F>
+inline typename F::TYPE get(const char* base, int index = 0)
+{
+    typename F::TYPE value;
+    std::memcpy(&value, base + F::OFFSET + index * sizeof(value), sizeof(value));
+    return value;
+}
+
+// where a field starts, to step into an embedded struct or walk an array
+template <class F>
+inline const char* at(const char* base)
+{
+    return base + F::OFFSET;
+}
+
+// the struct at `index` in a block of S
+template <class S>
+inline const char* element(const char* block, size_t index)
+{
+    return block + index * S::SIZE;
+}
+
+struct Mesh {
+    static constexpr int SIZE = 1416;
+    static constexpr int FIELD_COUNT = 49;
+    static const char* TYPE_NAME() { return "Mesh"; }
+    static const Field* FIELDS()
+    {
+        static const Field fields[] = {
+            { "id", 0, 120 },
+            { "adt", 120, 8 },
+            { "bb", 128, 8 },
+            { "ipo", 136, 8 },
+            { "key", 144, 8 },
+            { "mat", 152, 8 },
+            { "mselect", 160, 8 },
+            { "mpoly", 168, 8 },
+            { "mtpoly", 176, 8 },
+            { "mloop", 184, 8 },
+            { "mloopuv", 192, 8 },
+            { "mloopcol", 200, 8 },
+            { "mface", 208, 8 },
+            { "mtface", 216, 8 },
+            { "tface", 224, 8 },
+            { "mvert", 232, 8 },
+            { "medge", 240, 8 },
+            { "dvert", 248, 8 },
+            { "mcol", 256, 8 },
+            { "texcomesh", 264, 8 },
+            { "edit_btmesh", 272, 8 },
+            { "vdata", 280, 208 },
+            { "edata", 488, 208 },
+            { "fdata", 696, 208 },
+            { "pdata", 904, 208 },
+            { "ldata", 1112, 208 },
+            { "totvert", 1320, 4 },
+            { "totedge", 1324, 4 },
+            { "totface", 1328, 4 },
+            { "totselect", 1332, 4 },
+            { "totpoly", 1336, 4 },
+            { "totloop", 1340, 4 },
+            { "act_face", 1344, 4 },
+            { "loc", 1348, 12 },
+            { "size", 1360, 12 },
+            { "rot", 1372, 12 },
+            { "drawflag", 1384, 4 },
+            { "texflag", 1388, 2 },
+            { "flag", 1390, 2 },
+            { "smoothresh", 1392, 4 },
+            { "pad2", 1396, 4 },
+            { "cd_flag", 1400, 1 },
+            { "pad", 1401, 1 },
+            { "subdiv", 1402, 1 },
+            { "subdivr", 1403, 1 },
+            { "subsurftype", 1404, 1 },
+            { "editflag", 1405, 1 },
+            { "totcol", 1406, 2 },
+            { "mr", 1408, 8 },
+        };
+        return fields;
+    }
+    // ID id
+    struct id {
+        typedef char TYPE;
+        static constexpr int OFFSET = 0;
+        static constexpr int SIZE = 120;
+        static constexpr int COUNT = 120;
+        static constexpr bool POINTER = false;
+    };
+    // AnimData *adt
+    struct adt {
+        typedef uint64_t TYPE;
+        static constexpr int OFFSET = 120;
+        static constexpr int SIZE = 8;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = true;
+    };
+    // BoundBox *bb
+    struct bb {
+        typedef uint64_t TYPE;
+        static constexpr int OFFSET = 128;
+        static constexpr int SIZE = 8;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = true;
+    };
+    // Ipo *ipo
+    struct ipo {
+        typedef uint64_t TYPE;
+        static constexpr int OFFSET = 136;
+        static constexpr int SIZE = 8;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = true;
+    };
+    // Key *key
+    struct key {
+        typedef uint64_t TYPE;
+        static constexpr int OFFSET = 144;
+        static constexpr int SIZE = 8;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = true;
+    };
+    // Material **mat
+    struct mat {
+        typedef uint64_t TYPE;
+        static constexpr int OFFSET = 152;
+        static constexpr int SIZE = 8;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = true;
+    };
+    // MSelect *mselect
+    struct mselect {
+        typedef uint64_t TYPE;
+        static constexpr int OFFSET = 160;
+        static constexpr int SIZE = 8;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = true;
+    };
+    // MPoly *mpoly
+    struct mpoly {
+        typedef uint64_t TYPE;
+        static constexpr int OFFSET = 168;
+        static constexpr int SIZE = 8;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = true;
+    };
+    // MTexPoly *mtpoly
+    struct mtpoly {
+        typedef uint64_t TYPE;
+        static constexpr int OFFSET = 176;
+        static constexpr int SIZE = 8;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = true;
+    };
+    // MLoop *mloop
+    struct mloop {
+        typedef uint64_t TYPE;
+        static constexpr int OFFSET = 184;
+        static constexpr int SIZE = 8;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = true;
+    };
+    // MLoopUV *mloopuv
+    struct mloopuv {
+        typedef uint64_t TYPE;
+        static constexpr int OFFSET = 192;
+        static constexpr int SIZE = 8;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = true;
+    };
+    // MLoopCol *mloopcol
+    struct mloopcol {
+        typedef uint64_t TYPE;
+        static constexpr int OFFSET = 200;
+        static constexpr int SIZE = 8;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = true;
+    };
+    // MFace *mface
+    struct mface {
+        typedef uint64_t TYPE;
+        static constexpr int OFFSET = 208;
+        static constexpr int SIZE = 8;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = true;
+    };
+    // MTFace *mtface
+    struct mtface {
+        typedef uint64_t TYPE;
+        static constexpr int OFFSET = 216;
+        static constexpr int SIZE = 8;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = true;
+    };
+    // TFace *tface
+    struct tface {
+        typedef uint64_t TYPE;
+        static constexpr int OFFSET = 224;
+        static constexpr int SIZE = 8;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = true;
+    };
+    // MVert *mvert
+    struct mvert {
+        typedef uint64_t TYPE;
+        static constexpr int OFFSET = 232;
+        static constexpr int SIZE = 8;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = true;
+    };
+    // MEdge *medge
+    struct medge {
+        typedef uint64_t TYPE;
+        static constexpr int OFFSET = 240;
+        static constexpr int SIZE = 8;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = true;
+    };
+    // MDeformVert *dvert
+    struct dvert {
+        typedef uint64_t TYPE;
+        static constexpr int OFFSET = 248;
+        static constexpr int SIZE = 8;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = true;
+    };
+    // MCol *mcol
+    struct mcol {
+        typedef uint64_t TYPE;
+        static constexpr int OFFSET = 256;
+        static constexpr int SIZE = 8;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = true;
+    };
+    // Mesh *texcomesh
+    struct texcomesh {
+        typedef uint64_t TYPE;
+        static constexpr int OFFSET = 264;
+        static constexpr int SIZE = 8;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = true;
+    };
+    // BMEditMesh *edit_btmesh
+    struct edit_btmesh {
+        typedef uint64_t TYPE;
+        static constexpr int OFFSET = 272;
+        static constexpr int SIZE = 8;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = true;
+    };
+    // CustomData vdata
+    struct vdata {
+        typedef char TYPE;
+        static constexpr int OFFSET = 280;
+        static constexpr int SIZE = 208;
+        static constexpr int COUNT = 208;
+        static constexpr bool POINTER = false;
+    };
+    // CustomData edata
+    struct edata {
+        typedef char TYPE;
+        static constexpr int OFFSET = 488;
+        static constexpr int SIZE = 208;
+        static constexpr int COUNT = 208;
+        static constexpr bool POINTER = false;
+    };
+    // CustomData fdata
+    struct fdata {
+        typedef char TYPE;
+        static constexpr int OFFSET = 696;
+        static constexpr int SIZE = 208;
+        static constexpr int COUNT = 208;
+        static constexpr bool POINTER = false;
+    };
+    // CustomData pdata
+    struct pdata {
+        typedef char TYPE;
+        static constexpr int OFFSET = 904;
+        static constexpr int SIZE = 208;
+        static constexpr int COUNT = 208;
+        static constexpr bool POINTER = false;
+    };
+    // CustomData ldata
+    struct ldata {
+        typedef char TYPE;
+        static constexpr int OFFSET = 1112;
+        static constexpr int SIZE = 208;
+        static constexpr int COUNT = 208;
+        static constexpr bool POINTER = false;
+    };
+    // int totvert
+    struct totvert {
+        typedef int32_t TYPE;
+        static constexpr int OFFSET = 1320;
+        static constexpr int SIZE = 4;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // int totedge
+    struct totedge {
+        typedef int32_t TYPE;
+        static constexpr int OFFSET = 1324;
+        static constexpr int SIZE = 4;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // int totface
+    struct totface {
+        typedef int32_t TYPE;
+        static constexpr int OFFSET = 1328;
+        static constexpr int SIZE = 4;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // int totselect
+    struct totselect {
+        typedef int32_t TYPE;
+        static constexpr int OFFSET = 1332;
+        static constexpr int SIZE = 4;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // int totpoly
+    struct totpoly {
+        typedef int32_t TYPE;
+        static constexpr int OFFSET = 1336;
+        static constexpr int SIZE = 4;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // int totloop
+    struct totloop {
+        typedef int32_t TYPE;
+        static constexpr int OFFSET = 1340;
+        static constexpr int SIZE = 4;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // int act_face
+    struct act_face {
+        typedef int32_t TYPE;
+        static constexpr int OFFSET = 1344;
+        static constexpr int SIZE = 4;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // float loc
+    struct loc {
+        typedef float TYPE;
+        static constexpr int OFFSET = 1348;
+        static constexpr int SIZE = 12;
+        static constexpr int COUNT = 3;
+        static constexpr bool POINTER = false;
+    };
+    // float size
+    struct size {
+        typedef float TYPE;
+        static constexpr int OFFSET = 1360;
+        static constexpr int SIZE = 12;
+        static constexpr int COUNT = 3;
+        static constexpr bool POINTER = false;
+    };
+    // float rot
+    struct rot {
+        typedef float TYPE;
+        static constexpr int OFFSET = 1372;
+        static constexpr int SIZE = 12;
+        static constexpr int COUNT = 3;
+        static constexpr bool POINTER = false;
+    };
+    // int drawflag
+    struct drawflag {
+        typedef int32_t TYPE;
+        static constexpr int OFFSET = 1384;
+        static constexpr int SIZE = 4;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // short texflag
+    struct texflag {
+        typedef int16_t TYPE;
+        static constexpr int OFFSET = 1388;
+        static constexpr int SIZE = 2;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // short flag
+    struct flag {
+        typedef int16_t TYPE;
+        static constexpr int OFFSET = 1390;
+        static constexpr int SIZE = 2;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // float smoothresh
+    struct smoothresh {
+        typedef float TYPE;
+        static constexpr int OFFSET = 1392;
+        static constexpr int SIZE = 4;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // int pad2
+    struct pad2 {
+        typedef int32_t TYPE;
+        static constexpr int OFFSET = 1396;
+        static constexpr int SIZE = 4;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // char cd_flag
+    struct cd_flag {
+        typedef char TYPE;
+        static constexpr int OFFSET = 1400;
+        static constexpr int SIZE = 1;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // char pad
+    struct pad {
+        typedef char TYPE;
+        static constexpr int OFFSET = 1401;
+        static constexpr int SIZE = 1;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // char subdiv
+    struct subdiv {
+        typedef char TYPE;
+        static constexpr int OFFSET = 1402;
+        static constexpr int SIZE = 1;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // char subdivr
+    struct subdivr {
+        typedef char TYPE;
+        static constexpr int OFFSET = 1403;
+        static constexpr int SIZE = 1;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // char subsurftype
+    struct subsurftype {
+        typedef char TYPE;
+        static constexpr int OFFSET = 1404;
+        static constexpr int SIZE = 1;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // char editflag
+    struct editflag {
+        typedef char TYPE;
+        static constexpr int OFFSET = 1405;
+        static constexpr int SIZE = 1;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // short totcol
+    struct totcol {
+        typedef int16_t TYPE;
+        static constexpr int OFFSET = 1406;
+        static constexpr int SIZE = 2;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // Multires *mr
+    struct mr {
+        typedef uint64_t TYPE;
+        static constexpr int OFFSET = 1408;
+        static constexpr int SIZE = 8;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = true;
+    };
+};
+
+struct MFace {
+    static constexpr int SIZE = 20;
+    static constexpr int FIELD_COUNT = 7;
+    static const char* TYPE_NAME() { return "MFace"; }
+    static const Field* FIELDS()
+    {
+        static const Field fields[] = {
+            { "v1", 0, 4 },
+            { "v2", 4, 4 },
+            { "v3", 8, 4 },
+            { "v4", 12, 4 },
+            { "mat_nr", 16, 2 },
+            { "edcode", 18, 1 },
+            { "flag", 19, 1 },
+        };
+        return fields;
+    }
+    // int v1
+    struct v1 {
+        typedef int32_t TYPE;
+        static constexpr int OFFSET = 0;
+        static constexpr int SIZE = 4;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // int v2
+    struct v2 {
+        typedef int32_t TYPE;
+        static constexpr int OFFSET = 4;
+        static constexpr int SIZE = 4;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // int v3
+    struct v3 {
+        typedef int32_t TYPE;
+        static constexpr int OFFSET = 8;
+        static constexpr int SIZE = 4;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // int v4
+    struct v4 {
+        typedef int32_t TYPE;
+        static constexpr int OFFSET = 12;
+        static constexpr int SIZE = 4;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // short mat_nr
+    struct mat_nr {
+        typedef int16_t TYPE;
+        static constexpr int OFFSET = 16;
+        static constexpr int SIZE = 2;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // char edcode
+    struct edcode {
+        typedef char TYPE;
+        static constexpr int OFFSET = 18;
+        static constexpr int SIZE = 1;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // char flag
+    struct flag {
+        typedef char TYPE;
+        static constexpr int OFFSET = 19;
+        static constexpr int SIZE = 1;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+};
+
+struct MVert {
+    static constexpr int SIZE = 20;
+    static constexpr int FIELD_COUNT = 4;
+    static const char* TYPE_NAME() { return "MVert"; }
+    static const Field* FIELDS()
+    {
+        static const Field fields[] = {
+            { "co", 0, 12 },
+            { "no", 12, 6 },
+            { "flag", 18, 1 },
+            { "bweight", 19, 1 },
+        };
+        return fields;
+    }
+    // float co
+    struct co {
+        typedef float TYPE;
+        static constexpr int OFFSET = 0;
+        static constexpr int SIZE = 12;
+        static constexpr int COUNT = 3;
+        static constexpr bool POINTER = false;
+    };
+    // short no
+    struct no {
+        typedef int16_t TYPE;
+        static constexpr int OFFSET = 12;
+        static constexpr int SIZE = 6;
+        static constexpr int COUNT = 3;
+        static constexpr bool POINTER = false;
+    };
+    // char flag
+    struct flag {
+        typedef char TYPE;
+        static constexpr int OFFSET = 18;
+        static constexpr int SIZE = 1;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // char bweight
+    struct bweight {
+        typedef char TYPE;
+        static constexpr int OFFSET = 19;
+        static constexpr int SIZE = 1;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+};
+
+struct MPoly {
+    static constexpr int SIZE = 12;
+    static constexpr int FIELD_COUNT = 5;
+    static const char* TYPE_NAME() { return "MPoly"; }
+    static const Field* FIELDS()
+    {
+        static const Field fields[] = {
+            { "loopstart", 0, 4 },
+            { "totloop", 4, 4 },
+            { "mat_nr", 8, 2 },
+            { "flag", 10, 1 },
+            { "pad", 11, 1 },
+        };
+        return fields;
+    }
+    // int loopstart
+    struct loopstart {
+        typedef int32_t TYPE;
+        static constexpr int OFFSET = 0;
+        static constexpr int SIZE = 4;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // int totloop
+    struct totloop {
+        typedef int32_t TYPE;
+        static constexpr int OFFSET = 4;
+        static constexpr int SIZE = 4;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // short mat_nr
+    struct mat_nr {
+        typedef int16_t TYPE;
+        static constexpr int OFFSET = 8;
+        static constexpr int SIZE = 2;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // char flag
+    struct flag {
+        typedef char TYPE;
+        static constexpr int OFFSET = 10;
+        static constexpr int SIZE = 1;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // char pad
+    struct pad {
+        typedef char TYPE;
+        static constexpr int OFFSET = 11;
+        static constexpr int SIZE = 1;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+};
+
+struct MLoop {
+    static constexpr int SIZE = 8;
+    static constexpr int FIELD_COUNT = 2;
+    static const char* TYPE_NAME() { return "MLoop"; }
+    static const Field* FIELDS()
+    {
+        static const Field fields[] = {
+            { "v", 0, 4 },
+            { "e", 4, 4 },
+        };
+        return fields;
+    }
+    // int v
+    struct v {
+        typedef int32_t TYPE;
+        static constexpr int OFFSET = 0;
+        static constexpr int SIZE = 4;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // int e
+    struct e {
+        typedef int32_t TYPE;
+        static constexpr int OFFSET = 4;
+        static constexpr int SIZE = 4;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+};
+
+struct MLoopUV {
+    static constexpr int SIZE = 12;
+    static constexpr int FIELD_COUNT = 2;
+    static const char* TYPE_NAME() { return "MLoopUV"; }
+    static const Field* FIELDS()
+    {
+        static const Field fields[] = {
+            { "uv", 0, 8 },
+            { "flag", 8, 4 },
+        };
+        return fields;
+    }
+    // float uv
+    struct uv {
+        typedef float TYPE;
+        static constexpr int OFFSET = 0;
+        static constexpr int SIZE = 8;
+        static constexpr int COUNT = 2;
+        static constexpr bool POINTER = false;
+    };
+    // int flag
+    struct flag {
+        typedef int32_t TYPE;
+        static constexpr int OFFSET = 8;
+        static constexpr int SIZE = 4;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+};
+
+struct MTFace {
+    static constexpr int SIZE = 48;
+    static constexpr int FIELD_COUNT = 7;
+    static const char* TYPE_NAME() { return "MTFace"; }
+    static const Field* FIELDS()
+    {
+        static const Field fields[] = {
+            { "uv", 0, 32 },
+            { "tpage", 32, 8 },
+            { "flag", 40, 1 },
+            { "transp", 41, 1 },
+            { "mode", 42, 2 },
+            { "tile", 44, 2 },
+            { "unwrap", 46, 2 },
+        };
+        return fields;
+    }
+    // float uv
+    struct uv {
+        typedef float TYPE;
+        static constexpr int OFFSET = 0;
+        static constexpr int SIZE = 32;
+        static constexpr int COUNT = 8;
+        static constexpr bool POINTER = false;
+    };
+    // Image *tpage
+    struct tpage {
+        typedef uint64_t TYPE;
+        static constexpr int OFFSET = 32;
+        static constexpr int SIZE = 8;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = true;
+    };
+    // char flag
+    struct flag {
+        typedef char TYPE;
+        static constexpr int OFFSET = 40;
+        static constexpr int SIZE = 1;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // char transp
+    struct transp {
+        typedef char TYPE;
+        static constexpr int OFFSET = 41;
+        static constexpr int SIZE = 1;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // short mode
+    struct mode {
+        typedef int16_t TYPE;
+        static constexpr int OFFSET = 42;
+        static constexpr int SIZE = 2;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // short tile
+    struct tile {
+        typedef int16_t TYPE;
+        static constexpr int OFFSET = 44;
+        static constexpr int SIZE = 2;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // short unwrap
+    struct unwrap {
+        typedef int16_t TYPE;
+        static constexpr int OFFSET = 46;
+        static constexpr int SIZE = 2;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+};
+
+struct Object {
+    static constexpr int SIZE = 1440;
+    static constexpr int FIELD_COUNT = 139;
+    static const char* TYPE_NAME() { return "Object"; }
+    static const Field* FIELDS()
+    {
+        static const Field fields[] = {
+            { "id", 0, 120 },
+            { "adt", 120, 8 },
+            { "sculpt", 128, 8 },
+            { "type", 136, 2 },
+            { "partype", 138, 2 },
+            { "par1", 140, 4 },
+            { "par2", 144, 4 },
+            { "par3", 148, 4 },
+            { "parsubstr", 152, 64 },
+            { "parent", 216, 8 },
+            { "track", 224, 8 },
+            { "proxy", 232, 8 },
+            { "proxy_group", 240, 8 },
+            { "proxy_from", 248, 8 },
+            { "ipo", 256, 8 },
+            { "bb", 264, 8 },
+            { "action", 272, 8 },
+            { "poselib", 280, 8 },
+            { "pose", 288, 8 },
+            { "data", 296, 8 },
+            { "gpd", 304, 8 },
+            { "avs", 312, 48 },
+            { "mpath", 360, 8 },
+            { "constraintChannels", 368, 16 },
+            { "effect", 384, 16 },
+            { "defbase", 400, 16 },
+            { "modifiers", 416, 16 },
+            { "mode", 432, 4 },
+            { "restore_mode", 436, 4 },
+            { "mat", 440, 8 },
+            { "matbits", 448, 8 },
+            { "totcol", 456, 4 },
+            { "actcol", 460, 4 },
+            { "loc", 464, 12 },
+            { "dloc", 476, 12 },
+            { "orig", 488, 12 },
+            { "size", 500, 12 },
+            { "dsize", 512, 12 },
+            { "dscale", 524, 12 },
+            { "rot", 536, 12 },
+            { "drot", 548, 12 },
+            { "quat", 560, 16 },
+            { "dquat", 576, 16 },
+            { "rotAxis", 592, 12 },
+            { "drotAxis", 604, 12 },
+            { "rotAngle", 616, 4 },
+            { "drotAngle", 620, 4 },
+            { "obmat", 624, 64 },
+            { "parentinv", 688, 64 },
+            { "constinv", 752, 64 },
+            { "imat", 816, 64 },
+            { "imat_ren", 880, 64 },
+            { "lay", 944, 4 },
+            { "flag", 948, 2 },
+            { "colbits", 950, 2 },
+            { "transflag", 952, 2 },
+            { "protectflag", 954, 2 },
+            { "trackflag", 956, 2 },
+            { "upflag", 958, 2 },
+            { "nlaflag", 960, 2 },
+            { "scaflag", 962, 2 },
+            { "scavisflag", 964, 1 },
+            { "depsflag", 965, 1 },
+            { "lastNeedMapping", 966, 1 },
+            { "pad", 967, 1 },
+            { "dupon", 968, 4 },
+            { "dupoff", 972, 4 },
+            { "dupsta", 976, 4 },
+            { "dupend", 980, 4 },
+            { "mass", 984, 4 },
+            { "damping", 988, 4 },
+            { "inertia", 992, 4 },
+            { "formfactor", 996, 4 },
+            { "rdamping", 1000, 4 },
+            { "margin", 1004, 4 },
+            { "max_vel", 1008, 4 },
+            { "min_vel", 1012, 4 },
+            { "max_angvel", 1016, 4 },
+            { "min_angvel", 1020, 4 },
+            { "obstacleRad", 1024, 4 },
+            { "step_height", 1028, 4 },
+            { "jump_speed", 1032, 4 },
+            { "fall_speed", 1036, 4 },
+            { "max_jumps", 1040, 1 },
+            { "pad2", 1041, 3 },
+            { "col_group", 1044, 2 },
+            { "col_mask", 1046, 2 },
+            { "rotmode", 1048, 2 },
+            { "boundtype", 1050, 1 },
+            { "collision_boundtype", 1051, 1 },
+            { "dtx", 1052, 2 },
+            { "dt", 1054, 1 },
+            { "empty_drawtype", 1055, 1 },
+            { "empty_drawsize", 1056, 4 },
+            { "dupfacesca", 1060, 4 },
+            { "prop", 1064, 16 },
+            { "sensors", 1080, 16 },
+            { "controllers", 1096, 16 },
+            { "actuators", 1112, 16 },
+            { "sf", 1128, 4 },
+            { "index", 1132, 2 },
+            { "actdef", 1134, 2 },
+            { "col", 1136, 16 },
+            { "gameflag", 1152, 4 },
+            { "gameflag2", 1156, 4 },
+            { "bsoft", 1160, 8 },
+            { "restrictflag", 1168, 1 },
+            { "recalc", 1169, 1 },
+            { "softflag", 1170, 2 },
+            { "anisotropicFriction", 1172, 12 },
+            { "constraints", 1184, 16 },
+            { "nlastrips", 1200, 16 },
+            { "hooks", 1216, 16 },
+            { "particlesystem", 1232, 16 },
+            { "pd", 1248, 8 },
+            { "soft", 1256, 8 },
+            { "dup_group", 1264, 8 },
+            { "body_type", 1272, 1 },
+            { "shapeflag", 1273, 1 },
+            { "shapenr", 1274, 2 },
+            { "smoothresh", 1276, 4 },
+            { "fluidsimSettings", 1280, 8 },
+            { "curve_cache", 1288, 8 },
+            { "derivedDeform", 1296, 8 },
+            { "derivedFinal", 1304, 8 },
+            { "lastDataMask", 1312, 8 },
+            { "customdata_mask", 1320, 8 },
+            { "state", 1328, 4 },
+            { "init_state", 1332, 4 },
+            { "gpulamp", 1336, 16 },
+            { "pc_ids", 1352, 16 },
+            { "duplilist", 1368, 8 },
+            { "rigidbody_object", 1376, 8 },
+            { "rigidbody_constraint", 1384, 8 },
+            { "ima_ofs", 1392, 8 },
+            { "iuser", 1400, 8 },
+            { "lodlevels", 1408, 16 },
+            { "currentlod", 1424, 8 },
+            { "preview", 1432, 8 },
+        };
+        return fields;
+    }
+    // ID id
+    struct id {
+        typedef char TYPE;
+        static constexpr int OFFSET = 0;
+        static constexpr int SIZE = 120;
+        static constexpr int COUNT = 120;
+        static constexpr bool POINTER = false;
+    };
+    // AnimData *adt
+    struct adt {
+        typedef uint64_t TYPE;
+        static constexpr int OFFSET = 120;
+        static constexpr int SIZE = 8;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = true;
+    };
+    // SculptSession *sculpt
+    struct sculpt {
+        typedef uint64_t TYPE;
+        static constexpr int OFFSET = 128;
+        static constexpr int SIZE = 8;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = true;
+    };
+    // short type
+    struct type {
+        typedef int16_t TYPE;
+        static constexpr int OFFSET = 136;
+        static constexpr int SIZE = 2;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // short partype
+    struct partype {
+        typedef int16_t TYPE;
+        static constexpr int OFFSET = 138;
+        static constexpr int SIZE = 2;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // int par1
+    struct par1 {
+        typedef int32_t TYPE;
+        static constexpr int OFFSET = 140;
+        static constexpr int SIZE = 4;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // int par2
+    struct par2 {
+        typedef int32_t TYPE;
+        static constexpr int OFFSET = 144;
+        static constexpr int SIZE = 4;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // int par3
+    struct par3 {
+        typedef int32_t TYPE;
+        static constexpr int OFFSET = 148;
+        static constexpr int SIZE = 4;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // char parsubstr
+    struct parsubstr {
+        typedef char TYPE;
+        static constexpr int OFFSET = 152;
+        static constexpr int SIZE = 64;
+        static constexpr int COUNT = 64;
+        static constexpr bool POINTER = false;
+    };
+    // Object *parent
+    struct parent {
+        typedef uint64_t TYPE;
+        static constexpr int OFFSET = 216;
+        static constexpr int SIZE = 8;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = true;
+    };
+    // Object *track
+    struct track {
+        typedef uint64_t TYPE;
+        static constexpr int OFFSET = 224;
+        static constexpr int SIZE = 8;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = true;
+    };
+    // Object *proxy
+    struct proxy {
+        typedef uint64_t TYPE;
+        static constexpr int OFFSET = 232;
+        static constexpr int SIZE = 8;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = true;
+    };
+    // Object *proxy_group
+    struct proxy_group {
+        typedef uint64_t TYPE;
+        static constexpr int OFFSET = 240;
+        static constexpr int SIZE = 8;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = true;
+    };
+    // Object *proxy_from
+    struct proxy_from {
+        typedef uint64_t TYPE;
+        static constexpr int OFFSET = 248;
+        static constexpr int SIZE = 8;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = true;
+    };
+    // Ipo *ipo
+    struct ipo {
+        typedef uint64_t TYPE;
+        static constexpr int OFFSET = 256;
+        static constexpr int SIZE = 8;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = true;
+    };
+    // BoundBox *bb
+    struct bb {
+        typedef uint64_t TYPE;
+        static constexpr int OFFSET = 264;
+        static constexpr int SIZE = 8;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = true;
+    };
+    // bAction *action
+    struct action {
+        typedef uint64_t TYPE;
+        static constexpr int OFFSET = 272;
+        static constexpr int SIZE = 8;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = true;
+    };
+    // bAction *poselib
+    struct poselib {
+        typedef uint64_t TYPE;
+        static constexpr int OFFSET = 280;
+        static constexpr int SIZE = 8;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = true;
+    };
+    // bPose *pose
+    struct pose {
+        typedef uint64_t TYPE;
+        static constexpr int OFFSET = 288;
+        static constexpr int SIZE = 8;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = true;
+    };
+    // void *data
+    struct data {
+        typedef uint64_t TYPE;
+        static constexpr int OFFSET = 296;
+        static constexpr int SIZE = 8;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = true;
+    };
+    // bGPdata *gpd
+    struct gpd {
+        typedef uint64_t TYPE;
+        static constexpr int OFFSET = 304;
+        static constexpr int SIZE = 8;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = true;
+    };
+    // bAnimVizSettings avs
+    struct avs {
+        typedef char TYPE;
+        static constexpr int OFFSET = 312;
+        static constexpr int SIZE = 48;
+        static constexpr int COUNT = 48;
+        static constexpr bool POINTER = false;
+    };
+    // bMotionPath *mpath
+    struct mpath {
+        typedef uint64_t TYPE;
+        static constexpr int OFFSET = 360;
+        static constexpr int SIZE = 8;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = true;
+    };
+    // ListBase constraintChannels
+    struct constraintChannels {
+        typedef char TYPE;
+        static constexpr int OFFSET = 368;
+        static constexpr int SIZE = 16;
+        static constexpr int COUNT = 16;
+        static constexpr bool POINTER = false;
+    };
+    // ListBase effect
+    struct effect {
+        typedef char TYPE;
+        static constexpr int OFFSET = 384;
+        static constexpr int SIZE = 16;
+        static constexpr int COUNT = 16;
+        static constexpr bool POINTER = false;
+    };
+    // ListBase defbase
+    struct defbase {
+        typedef char TYPE;
+        static constexpr int OFFSET = 400;
+        static constexpr int SIZE = 16;
+        static constexpr int COUNT = 16;
+        static constexpr bool POINTER = false;
+    };
+    // ListBase modifiers
+    struct modifiers {
+        typedef char TYPE;
+        static constexpr int OFFSET = 416;
+        static constexpr int SIZE = 16;
+        static constexpr int COUNT = 16;
+        static constexpr bool POINTER = false;
+    };
+    // int mode
+    struct mode {
+        typedef int32_t TYPE;
+        static constexpr int OFFSET = 432;
+        static constexpr int SIZE = 4;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // int restore_mode
+    struct restore_mode {
+        typedef int32_t TYPE;
+        static constexpr int OFFSET = 436;
+        static constexpr int SIZE = 4;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // Material **mat
+    struct mat {
+        typedef uint64_t TYPE;
+        static constexpr int OFFSET = 440;
+        static constexpr int SIZE = 8;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = true;
+    };
+    // char *matbits
+    struct matbits {
+        typedef uint64_t TYPE;
+        static constexpr int OFFSET = 448;
+        static constexpr int SIZE = 8;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = true;
+    };
+    // int totcol
+    struct totcol {
+        typedef int32_t TYPE;
+        static constexpr int OFFSET = 456;
+        static constexpr int SIZE = 4;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // int actcol
+    struct actcol {
+        typedef int32_t TYPE;
+        static constexpr int OFFSET = 460;
+        static constexpr int SIZE = 4;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // float loc
+    struct loc {
+        typedef float TYPE;
+        static constexpr int OFFSET = 464;
+        static constexpr int SIZE = 12;
+        static constexpr int COUNT = 3;
+        static constexpr bool POINTER = false;
+    };
+    // float dloc
+    struct dloc {
+        typedef float TYPE;
+        static constexpr int OFFSET = 476;
+        static constexpr int SIZE = 12;
+        static constexpr int COUNT = 3;
+        static constexpr bool POINTER = false;
+    };
+    // float orig
+    struct orig {
+        typedef float TYPE;
+        static constexpr int OFFSET = 488;
+        static constexpr int SIZE = 12;
+        static constexpr int COUNT = 3;
+        static constexpr bool POINTER = false;
+    };
+    // float size
+    struct size {
+        typedef float TYPE;
+        static constexpr int OFFSET = 500;
+        static constexpr int SIZE = 12;
+        static constexpr int COUNT = 3;
+        static constexpr bool POINTER = false;
+    };
+    // float dsize
+    struct dsize {
+        typedef float TYPE;
+        static constexpr int OFFSET = 512;
+        static constexpr int SIZE = 12;
+        static constexpr int COUNT = 3;
+        static constexpr bool POINTER = false;
+    };
+    // float dscale
+    struct dscale {
+        typedef float TYPE;
+        static constexpr int OFFSET = 524;
+        static constexpr int SIZE = 12;
+        static constexpr int COUNT = 3;
+        static constexpr bool POINTER = false;
+    };
+    // float rot
+    struct rot {
+        typedef float TYPE;
+        static constexpr int OFFSET = 536;
+        static constexpr int SIZE = 12;
+        static constexpr int COUNT = 3;
+        static constexpr bool POINTER = false;
+    };
+    // float drot
+    struct drot {
+        typedef float TYPE;
+        static constexpr int OFFSET = 548;
+        static constexpr int SIZE = 12;
+        static constexpr int COUNT = 3;
+        static constexpr bool POINTER = false;
+    };
+    // float quat
+    struct quat {
+        typedef float TYPE;
+        static constexpr int OFFSET = 560;
+        static constexpr int SIZE = 16;
+        static constexpr int COUNT = 4;
+        static constexpr bool POINTER = false;
+    };
+    // float dquat
+    struct dquat {
+        typedef float TYPE;
+        static constexpr int OFFSET = 576;
+        static constexpr int SIZE = 16;
+        static constexpr int COUNT = 4;
+        static constexpr bool POINTER = false;
+    };
+    // float rotAxis
+    struct rotAxis {
+        typedef float TYPE;
+        static constexpr int OFFSET = 592;
+        static constexpr int SIZE = 12;
+        static constexpr int COUNT = 3;
+        static constexpr bool POINTER = false;
+    };
+    // float drotAxis
+    struct drotAxis {
+        typedef float TYPE;
+        static constexpr int OFFSET = 604;
+        static constexpr int SIZE = 12;
+        static constexpr int COUNT = 3;
+        static constexpr bool POINTER = false;
+    };
+    // float rotAngle
+    struct rotAngle {
+        typedef float TYPE;
+        static constexpr int OFFSET = 616;
+        static constexpr int SIZE = 4;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // float drotAngle
+    struct drotAngle {
+        typedef float TYPE;
+        static constexpr int OFFSET = 620;
+        static constexpr int SIZE = 4;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // float obmat
+    struct obmat {
+        typedef float TYPE;
+        static constexpr int OFFSET = 624;
+        static constexpr int SIZE = 64;
+        static constexpr int COUNT = 16;
+        static constexpr bool POINTER = false;
+    };
+    // float parentinv
+    struct parentinv {
+        typedef float TYPE;
+        static constexpr int OFFSET = 688;
+        static constexpr int SIZE = 64;
+        static constexpr int COUNT = 16;
+        static constexpr bool POINTER = false;
+    };
+    // float constinv
+    struct constinv {
+        typedef float TYPE;
+        static constexpr int OFFSET = 752;
+        static constexpr int SIZE = 64;
+        static constexpr int COUNT = 16;
+        static constexpr bool POINTER = false;
+    };
+    // float imat
+    struct imat {
+        typedef float TYPE;
+        static constexpr int OFFSET = 816;
+        static constexpr int SIZE = 64;
+        static constexpr int COUNT = 16;
+        static constexpr bool POINTER = false;
+    };
+    // float imat_ren
+    struct imat_ren {
+        typedef float TYPE;
+        static constexpr int OFFSET = 880;
+        static constexpr int SIZE = 64;
+        static constexpr int COUNT = 16;
+        static constexpr bool POINTER = false;
+    };
+    // int lay
+    struct lay {
+        typedef int32_t TYPE;
+        static constexpr int OFFSET = 944;
+        static constexpr int SIZE = 4;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // short flag
+    struct flag {
+        typedef int16_t TYPE;
+        static constexpr int OFFSET = 948;
+        static constexpr int SIZE = 2;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // short colbits
+    struct colbits {
+        typedef int16_t TYPE;
+        static constexpr int OFFSET = 950;
+        static constexpr int SIZE = 2;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // short transflag
+    struct transflag {
+        typedef int16_t TYPE;
+        static constexpr int OFFSET = 952;
+        static constexpr int SIZE = 2;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // short protectflag
+    struct protectflag {
+        typedef int16_t TYPE;
+        static constexpr int OFFSET = 954;
+        static constexpr int SIZE = 2;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // short trackflag
+    struct trackflag {
+        typedef int16_t TYPE;
+        static constexpr int OFFSET = 956;
+        static constexpr int SIZE = 2;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // short upflag
+    struct upflag {
+        typedef int16_t TYPE;
+        static constexpr int OFFSET = 958;
+        static constexpr int SIZE = 2;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // short nlaflag
+    struct nlaflag {
+        typedef int16_t TYPE;
+        static constexpr int OFFSET = 960;
+        static constexpr int SIZE = 2;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // short scaflag
+    struct scaflag {
+        typedef int16_t TYPE;
+        static constexpr int OFFSET = 962;
+        static constexpr int SIZE = 2;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // char scavisflag
+    struct scavisflag {
+        typedef char TYPE;
+        static constexpr int OFFSET = 964;
+        static constexpr int SIZE = 1;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // char depsflag
+    struct depsflag {
+        typedef char TYPE;
+        static constexpr int OFFSET = 965;
+        static constexpr int SIZE = 1;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // char lastNeedMapping
+    struct lastNeedMapping {
+        typedef char TYPE;
+        static constexpr int OFFSET = 966;
+        static constexpr int SIZE = 1;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // char pad
+    struct pad {
+        typedef char TYPE;
+        static constexpr int OFFSET = 967;
+        static constexpr int SIZE = 1;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // int dupon
+    struct dupon {
+        typedef int32_t TYPE;
+        static constexpr int OFFSET = 968;
+        static constexpr int SIZE = 4;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // int dupoff
+    struct dupoff {
+        typedef int32_t TYPE;
+        static constexpr int OFFSET = 972;
+        static constexpr int SIZE = 4;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // int dupsta
+    struct dupsta {
+        typedef int32_t TYPE;
+        static constexpr int OFFSET = 976;
+        static constexpr int SIZE = 4;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // int dupend
+    struct dupend {
+        typedef int32_t TYPE;
+        static constexpr int OFFSET = 980;
+        static constexpr int SIZE = 4;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // float mass
+    struct mass {
+        typedef float TYPE;
+        static constexpr int OFFSET = 984;
+        static constexpr int SIZE = 4;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // float damping
+    struct damping {
+        typedef float TYPE;
+        static constexpr int OFFSET = 988;
+        static constexpr int SIZE = 4;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // float inertia
+    struct inertia {
+        typedef float TYPE;
+        static constexpr int OFFSET = 992;
+        static constexpr int SIZE = 4;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // float formfactor
+    struct formfactor {
+        typedef float TYPE;
+        static constexpr int OFFSET = 996;
+        static constexpr int SIZE = 4;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // float rdamping
+    struct rdamping {
+        typedef float TYPE;
+        static constexpr int OFFSET = 1000;
+        static constexpr int SIZE = 4;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // float margin
+    struct margin {
+        typedef float TYPE;
+        static constexpr int OFFSET = 1004;
+        static constexpr int SIZE = 4;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // float max_vel
+    struct max_vel {
+        typedef float TYPE;
+        static constexpr int OFFSET = 1008;
+        static constexpr int SIZE = 4;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // float min_vel
+    struct min_vel {
+        typedef float TYPE;
+        static constexpr int OFFSET = 1012;
+        static constexpr int SIZE = 4;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // float max_angvel
+    struct max_angvel {
+        typedef float TYPE;
+        static constexpr int OFFSET = 1016;
+        static constexpr int SIZE = 4;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // float min_angvel
+    struct min_angvel {
+        typedef float TYPE;
+        static constexpr int OFFSET = 1020;
+        static constexpr int SIZE = 4;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // float obstacleRad
+    struct obstacleRad {
+        typedef float TYPE;
+        static constexpr int OFFSET = 1024;
+        static constexpr int SIZE = 4;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // float step_height
+    struct step_height {
+        typedef float TYPE;
+        static constexpr int OFFSET = 1028;
+        static constexpr int SIZE = 4;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // float jump_speed
+    struct jump_speed {
+        typedef float TYPE;
+        static constexpr int OFFSET = 1032;
+        static constexpr int SIZE = 4;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // float fall_speed
+    struct fall_speed {
+        typedef float TYPE;
+        static constexpr int OFFSET = 1036;
+        static constexpr int SIZE = 4;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // char max_jumps
+    struct max_jumps {
+        typedef char TYPE;
+        static constexpr int OFFSET = 1040;
+        static constexpr int SIZE = 1;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // char pad2
+    struct pad2 {
+        typedef char TYPE;
+        static constexpr int OFFSET = 1041;
+        static constexpr int SIZE = 3;
+        static constexpr int COUNT = 3;
+        static constexpr bool POINTER = false;
+    };
+    // short col_group
+    struct col_group {
+        typedef int16_t TYPE;
+        static constexpr int OFFSET = 1044;
+        static constexpr int SIZE = 2;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // short col_mask
+    struct col_mask {
+        typedef int16_t TYPE;
+        static constexpr int OFFSET = 1046;
+        static constexpr int SIZE = 2;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // short rotmode
+    struct rotmode {
+        typedef int16_t TYPE;
+        static constexpr int OFFSET = 1048;
+        static constexpr int SIZE = 2;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // char boundtype
+    struct boundtype {
+        typedef char TYPE;
+        static constexpr int OFFSET = 1050;
+        static constexpr int SIZE = 1;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // char collision_boundtype
+    struct collision_boundtype {
+        typedef char TYPE;
+        static constexpr int OFFSET = 1051;
+        static constexpr int SIZE = 1;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // short dtx
+    struct dtx {
+        typedef int16_t TYPE;
+        static constexpr int OFFSET = 1052;
+        static constexpr int SIZE = 2;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // char dt
+    struct dt {
+        typedef char TYPE;
+        static constexpr int OFFSET = 1054;
+        static constexpr int SIZE = 1;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // char empty_drawtype
+    struct empty_drawtype {
+        typedef char TYPE;
+        static constexpr int OFFSET = 1055;
+        static constexpr int SIZE = 1;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // float empty_drawsize
+    struct empty_drawsize {
+        typedef float TYPE;
+        static constexpr int OFFSET = 1056;
+        static constexpr int SIZE = 4;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // float dupfacesca
+    struct dupfacesca {
+        typedef float TYPE;
+        static constexpr int OFFSET = 1060;
+        static constexpr int SIZE = 4;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // ListBase prop
+    struct prop {
+        typedef char TYPE;
+        static constexpr int OFFSET = 1064;
+        static constexpr int SIZE = 16;
+        static constexpr int COUNT = 16;
+        static constexpr bool POINTER = false;
+    };
+    // ListBase sensors
+    struct sensors {
+        typedef char TYPE;
+        static constexpr int OFFSET = 1080;
+        static constexpr int SIZE = 16;
+        static constexpr int COUNT = 16;
+        static constexpr bool POINTER = false;
+    };
+    // ListBase controllers
+    struct controllers {
+        typedef char TYPE;
+        static constexpr int OFFSET = 1096;
+        static constexpr int SIZE = 16;
+        static constexpr int COUNT = 16;
+        static constexpr bool POINTER = false;
+    };
+    // ListBase actuators
+    struct actuators {
+        typedef char TYPE;
+        static constexpr int OFFSET = 1112;
+        static constexpr int SIZE = 16;
+        static constexpr int COUNT = 16;
+        static constexpr bool POINTER = false;
+    };
+    // float sf
+    struct sf {
+        typedef float TYPE;
+        static constexpr int OFFSET = 1128;
+        static constexpr int SIZE = 4;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // short index
+    struct index {
+        typedef int16_t TYPE;
+        static constexpr int OFFSET = 1132;
+        static constexpr int SIZE = 2;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // short actdef
+    struct actdef {
+        typedef int16_t TYPE;
+        static constexpr int OFFSET = 1134;
+        static constexpr int SIZE = 2;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // float col
+    struct col {
+        typedef float TYPE;
+        static constexpr int OFFSET = 1136;
+        static constexpr int SIZE = 16;
+        static constexpr int COUNT = 4;
+        static constexpr bool POINTER = false;
+    };
+    // int gameflag
+    struct gameflag {
+        typedef int32_t TYPE;
+        static constexpr int OFFSET = 1152;
+        static constexpr int SIZE = 4;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // int gameflag2
+    struct gameflag2 {
+        typedef int32_t TYPE;
+        static constexpr int OFFSET = 1156;
+        static constexpr int SIZE = 4;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // BulletSoftBody *bsoft
+    struct bsoft {
+        typedef uint64_t TYPE;
+        static constexpr int OFFSET = 1160;
+        static constexpr int SIZE = 8;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = true;
+    };
+    // char restrictflag
+    struct restrictflag {
+        typedef char TYPE;
+        static constexpr int OFFSET = 1168;
+        static constexpr int SIZE = 1;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // char recalc
+    struct recalc {
+        typedef char TYPE;
+        static constexpr int OFFSET = 1169;
+        static constexpr int SIZE = 1;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // short softflag
+    struct softflag {
+        typedef int16_t TYPE;
+        static constexpr int OFFSET = 1170;
+        static constexpr int SIZE = 2;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // float anisotropicFriction
+    struct anisotropicFriction {
+        typedef float TYPE;
+        static constexpr int OFFSET = 1172;
+        static constexpr int SIZE = 12;
+        static constexpr int COUNT = 3;
+        static constexpr bool POINTER = false;
+    };
+    // ListBase constraints
+    struct constraints {
+        typedef char TYPE;
+        static constexpr int OFFSET = 1184;
+        static constexpr int SIZE = 16;
+        static constexpr int COUNT = 16;
+        static constexpr bool POINTER = false;
+    };
+    // ListBase nlastrips
+    struct nlastrips {
+        typedef char TYPE;
+        static constexpr int OFFSET = 1200;
+        static constexpr int SIZE = 16;
+        static constexpr int COUNT = 16;
+        static constexpr bool POINTER = false;
+    };
+    // ListBase hooks
+    struct hooks {
+        typedef char TYPE;
+        static constexpr int OFFSET = 1216;
+        static constexpr int SIZE = 16;
+        static constexpr int COUNT = 16;
+        static constexpr bool POINTER = false;
+    };
+    // ListBase particlesystem
+    struct particlesystem {
+        typedef char TYPE;
+        static constexpr int OFFSET = 1232;
+        static constexpr int SIZE = 16;
+        static constexpr int COUNT = 16;
+        static constexpr bool POINTER = false;
+    };
+    // PartDeflect *pd
+    struct pd {
+        typedef uint64_t TYPE;
+        static constexpr int OFFSET = 1248;
+        static constexpr int SIZE = 8;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = true;
+    };
+    // SoftBody *soft
+    struct soft {
+        typedef uint64_t TYPE;
+        static constexpr int OFFSET = 1256;
+        static constexpr int SIZE = 8;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = true;
+    };
+    // Group *dup_group
+    struct dup_group {
+        typedef uint64_t TYPE;
+        static constexpr int OFFSET = 1264;
+        static constexpr int SIZE = 8;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = true;
+    };
+    // char body_type
+    struct body_type {
+        typedef char TYPE;
+        static constexpr int OFFSET = 1272;
+        static constexpr int SIZE = 1;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // char shapeflag
+    struct shapeflag {
+        typedef char TYPE;
+        static constexpr int OFFSET = 1273;
+        static constexpr int SIZE = 1;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // short shapenr
+    struct shapenr {
+        typedef int16_t TYPE;
+        static constexpr int OFFSET = 1274;
+        static constexpr int SIZE = 2;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // float smoothresh
+    struct smoothresh {
+        typedef float TYPE;
+        static constexpr int OFFSET = 1276;
+        static constexpr int SIZE = 4;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // FluidsimSettings *fluidsimSettings
+    struct fluidsimSettings {
+        typedef uint64_t TYPE;
+        static constexpr int OFFSET = 1280;
+        static constexpr int SIZE = 8;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = true;
+    };
+    // CurveCache *curve_cache
+    struct curve_cache {
+        typedef uint64_t TYPE;
+        static constexpr int OFFSET = 1288;
+        static constexpr int SIZE = 8;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = true;
+    };
+    // DerivedMesh *derivedDeform
+    struct derivedDeform {
+        typedef uint64_t TYPE;
+        static constexpr int OFFSET = 1296;
+        static constexpr int SIZE = 8;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = true;
+    };
+    // DerivedMesh *derivedFinal
+    struct derivedFinal {
+        typedef uint64_t TYPE;
+        static constexpr int OFFSET = 1304;
+        static constexpr int SIZE = 8;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = true;
+    };
+    // uint64_t lastDataMask
+    struct lastDataMask {
+        typedef uint64_t TYPE;
+        static constexpr int OFFSET = 1312;
+        static constexpr int SIZE = 8;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // uint64_t customdata_mask
+    struct customdata_mask {
+        typedef uint64_t TYPE;
+        static constexpr int OFFSET = 1320;
+        static constexpr int SIZE = 8;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // int state
+    struct state {
+        typedef int32_t TYPE;
+        static constexpr int OFFSET = 1328;
+        static constexpr int SIZE = 4;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // int init_state
+    struct init_state {
+        typedef int32_t TYPE;
+        static constexpr int OFFSET = 1332;
+        static constexpr int SIZE = 4;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = false;
+    };
+    // ListBase gpulamp
+    struct gpulamp {
+        typedef char TYPE;
+        static constexpr int OFFSET = 1336;
+        static constexpr int SIZE = 16;
+        static constexpr int COUNT = 16;
+        static constexpr bool POINTER = false;
+    };
+    // ListBase pc_ids
+    struct pc_ids {
+        typedef char TYPE;
+        static constexpr int OFFSET = 1352;
+        static constexpr int SIZE = 16;
+        static constexpr int COUNT = 16;
+        static constexpr bool POINTER = false;
+    };
+    // ListBase *duplilist
+    struct duplilist {
+        typedef uint64_t TYPE;
+        static constexpr int OFFSET = 1368;
+        static constexpr int SIZE = 8;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = true;
+    };
+    // RigidBodyOb *rigidbody_object
+    struct rigidbody_object {
+        typedef uint64_t TYPE;
+        static constexpr int OFFSET = 1376;
+        static constexpr int SIZE = 8;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = true;
+    };
+    // RigidBodyCon *rigidbody_constraint
+    struct rigidbody_constraint {
+        typedef uint64_t TYPE;
+        static constexpr int OFFSET = 1384;
+        static constexpr int SIZE = 8;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = true;
+    };
+    // float ima_ofs
+    struct ima_ofs {
+        typedef float TYPE;
+        static constexpr int OFFSET = 1392;
+        static constexpr int SIZE = 8;
+        static constexpr int COUNT = 2;
+        static constexpr bool POINTER = false;
+    };
+    // ImageUser *iuser
+    struct iuser {
+        typedef uint64_t TYPE;
+        static constexpr int OFFSET = 1400;
+        static constexpr int SIZE = 8;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = true;
+    };
+    // ListBase lodlevels
+    struct lodlevels {
+        typedef char TYPE;
+        static constexpr int OFFSET = 1408;
+        static constexpr int SIZE = 16;
+        static constexpr int COUNT = 16;
+        static constexpr bool POINTER = false;
+    };
+    // LodLevel *currentlod
+    struct currentlod {
+        typedef uint64_t TYPE;
+        static constexpr int OFFSET = 1424;
+        static constexpr int SIZE = 8;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = true;
+    };
+    // PreviewImage *preview
+    struct preview {
+        typedef uint64_t TYPE;
+        static constexpr int OFFSET = 1432;
+        static constexpr int SIZE = 8;
+        static constexpr int COUNT = 1;
+        static constexpr bool POINTER = true;
+    };
+};
+}
+#endif
@@ -0,0 +1,1052 @@
+#ifndef BLEND_FILE_H
+#define BLEND_FILE_H
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <glm/glm.hpp>
+
+#include "blend_dna.h"
+#include "mesh.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// A whole file mapped read-only into memory. Nothing is read until it is touched, and nothing is copied.
+class MappedFile
+{
+public:
+    MappedFile() : bytes(nullptr), length(0) {}
+    ~MappedFile() { close(); }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const char* path)
+    {
+        close();
+#ifdef _WIN32
+        file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (file == INVALID_HANDLE_VALUE)
+            return false;
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+        {
+            close();
+            return false;
+        }
+        mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mapping == NULL)
+        {
+            close();
+            return false;
+        }
+        bytes = (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        length = (size_t)fileSize.QuadPart;
+#else
+        int descriptor = ::open(path, O_RDONLY);
+        if (descriptor < 0)
+            return false;
+        struct stat status;
+        if (fstat(descriptor, &status) != 0 || status.st_size == 0)
+        {
+            ::close(descriptor);
+            return false;
+        }
+        void* view = mmap(nullptr, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+        ::close(descriptor);
+        bytes = view == MAP_FAILED ? nullptr : (const char*)view;
+        length = (size_t)status.st_size;
+#endif
+        if (!bytes)
+        {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    void close()
+    {
+#ifdef _WIN32
+        if (bytes)
+            UnmapViewOfFile(bytes);
+        if (mapping != NULL)
+            CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE)
+            CloseHandle(file);
+        mapping = NULL;
+        file = INVALID_HANDLE_VALUE;
+#else
+        if (bytes)
+            munmap((void*)bytes, length);
+#endif
+        bytes = nullptr;
+        length = 0;
+    }
+
+    const char* data() const { return bytes; }
+    size_t size() const { return length; }
+
+private:
+    const char* bytes;
+    size_t length;
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = NULL;
+#endif
+};
+
+// one file block: a run of `count` structs of one SDNA type, as Blender had them in memory
+struct BlendBlock {
+    char code[4];
+    uint32_t length;
+    // where the block lived when the file was written; pointers stored in other blocks refer to it
+    uint64_t address;
+    int sdnaStruct;
+    int count;
+    const char* data;
+};
+
+// A .blend file read in place. The file describes its own struct layouts in the SDNA block (type names and
+// sizes, and every struct's fields), so offsets come from the file rather than from headers of one Blender
+// version: fields are looked up by name once and then read straight out of the mapping. Opening only hops
+// from block header to block header, indexing every block by its old address on the way, and parses the SDNA;
+// block contents are paged in when something decodes them. Little endian files only, which is every platform
+// Blender has shipped on for years.
+class BlendFile
+{
+public:
+    struct Field {
+        int type;
+        // as written in the SDNA, e.g. "*mvert", "co[3]" or "(*bindfunc)()"
+        const char* name;
+        // bare identifier for lookups: "mvert", "co", "bindfunc"
+        std::string key;
+        int offset;
+        int size;
+        int arrayLength;
+        bool pointer;
+    };
+
+    struct Struct {
+        int type;
+        int size;
+        std::vector<Field> fields;
+    };
+
+    int version = 0;
+    int pointerSize = 8;
+
+    bool open(const char* path)
+    {
+        blockList.clear();
+        structs.clear();
+        structByName.clear();
+        blockByAddress.clear();
+        if (!file.open(path))
+        {
+            std::cout << "ERROR::BLEND::FILE_NOT_READ: " << path << std::endl;
+            return false;
+        }
+        const char* data = file.data();
+        size_t size = file.size();
+        if (size < 12 || std::memcmp(data, "BLENDER", 7) != 0 || (data[7] != '_' && data[7] != '-'))
+        {
+            std::cout << "ERROR::BLEND::NOT_A_BLEND_FILE: " << path << " (compressed files need unpacking first)" << std::endl;
+            return false;
+        }
+        if (data[8] != 'v')
+        {
+            std::cout << "ERROR::BLEND::BIG_ENDIAN_NOT_SUPPORTED: " << path << std::endl;
+            return false;
+        }
+        pointerSize = data[7] == '_' ? 4 : 8;
+        version = (data[9] - '0') * 100 + (data[10] - '0') * 10 + (data[11] - '0');
+
+        size_t headerSize = 16 + pointerSize;
+        size_t offset = 12;
+        const BlendBlock* dna = nullptr;
+        while (offset + headerSize <= size)
+        {
+            BlendBlock block;
+            const char* header = data + offset;
+            std::memcpy(block.code, header, 4);
+            block.length = read<uint32_t>(header + 4);
+            block.address = readPointer(header + 8);
+            block.sdnaStruct = read<int32_t>(header + 8 + pointerSize);
+            block.count = read<int32_t>(header + 12 + pointerSize);
+            block.data = header + headerSize;
+            if (std::memcmp(block.code, "ENDB", 4) == 0)
+                break;
+            if (offset + headerSize + block.length > size)
+            {
+                std::cout << "ERROR::BLEND::FILE_TRUNCATED: " << path << std::endl;
+                return false;
+            }
+            blockList.push_back(block);
+            offset += headerSize + block.length;
+        }
+        blockByAddress.reserve(blockList.size());
+        for (size_t i = 0; i < blockList.size(); i++)
+        {
+            if (blockList[i].address)
+                blockByAddress.emplace(blockList[i].address, (int)i);
+            if (std::memcmp(blockList[i].code, "DNA1", 4) == 0)
+                dna = &blockList[i];
+        }
+        if (!dna || !parseSdna(dna->data, dna->length))
+        {
+            std::cout << "ERROR::BLEND::SDNA_NOT_VALID: " << path << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    const std::vector<BlendBlock>& blocks() const { return blockList; }
+
+    // -1 when the file has no struct of that name
+    int findStruct(const char* name) const
+    {
+        auto found = structByName.find(name);
+        return found == structByName.end() ? -1 : found->second;
+    }
+
+    const Struct& structAt(int index) const { return structs[index]; }
+    size_t structCount() const { return structs.size(); }
+    const char* typeName(int type) const { return typeNames[type]; }
+
+    // field by its bare identifier, nullptr when the struct doesn't have it (in this file's version)
+    const Field* findField(const char* structName, const char* key) const
+    {
+        int index = findStruct(structName);
+        if (index < 0)
+            return nullptr;
+        for (const Field& field : structs[index].fields)
+            if (field.key == key)
+                return &field;
+        return nullptr;
+    }
+
+    int fieldOffset(const char* structName, const char* key) const
+    {
+        const Field* field = findField(structName, key);
+        return field ? field->offset : -1;
+    }
+
+    int structSize(const char* structName) const
+    {
+        int index = findStruct(structName);
+        return index < 0 ? 0 : structs[index].size;
+    }
+
+    // whether this file lays S out exactly as the generated bindings in blend_dna.h do, field by field, so that
+    // reads through them at fixed offsets are safe
+    template <class S>
+    bool matches() const
+    {
+        int index = findStruct(S::TYPE_NAME());
+        if (pointerSize != 8 || index < 0 || structs[index].size != S::SIZE || structs[index].fields.size() != (size_t)S::FIELD_COUNT)
+            return false;
+        const dna::Field* expected = S::FIELDS();
+        for (int i = 0; i < S::FIELD_COUNT; i++)
+        {
+            const Field& field = structs[index].fields[i];
+            if (field.key != expected[i].name || field.offset != expected[i].offset || field.size != expected[i].size)
+                return false;
+        }
+        return true;
+    }
+
+    // the block starting at an old address (which is where every pointer written to a .blend points), nullptr
+    // for null or dangling pointers
+    const BlendBlock* findBlock(uint64_t address) const
+    {
+        auto found = blockByAddress.find(address);
+        return found == blockByAddress.end() ? nullptr : &blockList[found->second];
+    }
+
+    // where an old address points to in the mapping, provided `bytes` bytes are there
+    const char* resolve(uint64_t address, size_t bytes = 1) const
+    {
+        const BlendBlock* block = findBlock(address);
+        if (!block || address - block->address + bytes > block->length)
+            return nullptr;
+        return block->data + (address - block->address);
+    }
+
+    uint64_t readPointer(const char* p) const
+    {
+        return pointerSize == 8 ? read<uint64_t>(p) : read<uint32_t>(p);
+    }
+
+    template <class T>
+    static T read(const char* p)
+    {
+        T value;
+        std::memcpy(&value, p, sizeof(T));
+        return value;
+    }
+
+    // a datablock: a block whose struct starts with an ID, named by its two letter code ("OB", "ME", "MA", "IM")
+    struct Datablock {
+        char code[3];
+        // without the code Blender puts in front of every ID name
+        std::string name;
+        int block;
+    };
+
+    // Lists the datablocks (all of them, or those with one code) by reading no more than the name of each:
+    // the struct table says where ID.name sits, so only the page holding it is touched.
+    std::vector<Datablock> inventory(const char* code = nullptr) const
+    {
+        std::vector<Datablock> result;
+        const Field* idName = findField("ID", "name");
+        if (!idName)
+            return result;
+        std::vector<char> startsWithId(structs.size());
+        for (size_t i = 0; i < structs.size(); i++)
+            startsWithId[i] = !structs[i].fields.empty() && std::strcmp(typeNames[structs[i].fields[0].type], "ID") == 0;
+        for (size_t i = 0; i < blockList.size(); i++)
+        {
+            const BlendBlock& block = blockList[i];
+            // ID codes are two letters and two zero bytes, data blocks are "DATA", file level ones four letters
+            if (block.code[2] != 0 || block.code[0] < 'A' || block.code[0] > 'Z' || (code && std::strncmp(block.code, code, 2) != 0))
+                continue;
+            if (block.sdnaStruct < 0 || block.sdnaStruct >= (int)structs.size() || !startsWithId[block.sdnaStruct] || block.length < (uint32_t)(idName->offset + idName->size))
+                continue;
+            Datablock datablock;
+            datablock.code[0] = block.code[0];
+            datablock.code[1] = block.code[1];
+            datablock.code[2] = 0;
+            const char* name = block.data + idName->offset;
+            size_t length = strnlen(name, idName->size);
+            datablock.name = length > 2 ? std::string(name + 2, length - 2) : std::string();
+            datablock.block = (int)i;
+            result.push_back(datablock);
+        }
+        return result;
+    }
+
+    // Writes the struct table in the format of dna.txt ("name size" per struct, then "type name offset size"
+    // per field with the array brackets left out of the names).
+    void writeLayout(std::ostream& out) const
+    {
+        out << "Field format: type name offset size\nStructure format: name size\n";
+        for (const Struct& s : structs)
+        {
+            out << typeNames[s.type] << " " << s.size << "\n\n";
+            for (const Field& field : s.fields)
+                out << "\t" << typeNames[field.type] << " " << dumpName(field.name) << " " << field.offset << " " << field.size << "\n";
+            out << "\n";
+        }
+    }
+
+    // Compares the struct table against a dump like dna.txt and prints where they part ways. Returns the number
+    // of structs that differ, -1 if the dump can't be read. The dump sizes "(*name)()" pointers by the type they
+    // point to rather than as pointers; they are taken as the file's pointers, and the dump's layout moved to
+    // match, the way tools/sdna_bindings.cpp does, so only real differences count.
+    int compareWithDump(const char* dumpPath) const
+    {
+        std::ifstream dump(dumpPath);
+        if (!dump)
+        {
+            std::cout << "ERROR::BLEND::SDNA_DUMP_NOT_READ: " << dumpPath << std::endl;
+            return -1;
+        }
+        struct DumpField {
+            std::string type, name;
+            int offset, size;
+        };
+        std::vector<std::pair<std::string, int>> dumpStructs;
+        std::vector<std::vector<DumpField>> dumpFields;
+        std::string line;
+        while (std::getline(dump, line))
+        {
+            if (!line.empty() && line.back() == '\r')
+                line.pop_back();
+            if (line.empty() || line.compare(0, 6, "Field ") == 0 || line.compare(0, 10, "Structure ") == 0)
+                continue;
+            std::istringstream words(line);
+            if (line[0] == '\t')
+            {
+                std::vector<std::string> parts;
+                std::string word;
+                while (words >> word)
+                    parts.push_back(word);
+                if (parts.size() < 4 || dumpFields.empty())
+                    continue;
+                DumpField field;
+                field.type = parts[0];
+                field.name = parts[1];
+                field.offset = std::atoi(parts[parts.size() - 2].c_str());
+                field.size = std::atoi(parts[parts.size() - 1].c_str());
+                dumpFields.back().push_back(field);
+            }
+            else
+            {
+                std::string name;
+                int size = 0;
+                words >> name >> size;
+                dumpStructs.push_back(std::make_pair(name, size));
+                dumpFields.push_back(std::vector<DumpField>());
+            }
+        }
+
+        // offsets behind a function pointer, and the sizes of structs embedding one, follow until they settle
+        auto isFunctionPointer = [](const std::string& name) { return name.compare(0, 2, "(*") == 0; };
+        for (bool changed = true; changed;)
+        {
+            changed = false;
+            for (size_t i = 0; i < dumpStructs.size(); i++)
+            {
+                int offset = 0;
+                for (DumpField& field : dumpFields[i])
+                {
+                    int size = isFunctionPointer(field.name) ? pointerSize : field.size;
+                    changed = changed || field.offset != offset || field.size != size;
+                    field.offset = offset;
+                    field.size = size;
+                    offset += size;
+                }
+                if (offset == dumpStructs[i].second)
+                    continue;
+                for (std::vector<DumpField>& fields : dumpFields)
+                    for (DumpField& field : fields)
+                        if (field.type == dumpStructs[i].first && field.name[0] != '*' && !isFunctionPointer(field.name) && dumpStructs[i].second > 0)
+                            field.size = field.size / dumpStructs[i].second * offset;
+                dumpStructs[i].second = offset;
+                changed = true;
+            }
+        }
+
+        int differing = 0, reported = 0;
+        for (size_t i = 0; i < dumpStructs.size(); i++)
+        {
+            std::ostringstream problem;
+            int index = findStruct(dumpStructs[i].first.c_str());
+            if (index < 0)
+                problem << "missing from the file";
+            else
+            {
+                const Struct& s = structs[index];
+                if (s.size != dumpStructs[i].second)
+                    problem << "size " << s.size << " vs " << dumpStructs[i].second << "; ";
+                if (s.fields.size() != dumpFields[i].size())
+                    problem << s.fields.size() << " fields vs " << dumpFields[i].size() << "; ";
+                for (size_t f = 0; f < std::min(s.fields.size(), dumpFields[i].size()); f++)
+                {
+                    const Field& field = s.fields[f];
+                    const DumpField& expected = dumpFields[i][f];
+                    if (expected.type != typeNames[field.type] || expected.name != dumpName(field.name) || expected.offset != field.offset || expected.size != field.size)
+                    {
+                        problem << typeNames[field.type] << " " << dumpName(field.name) << " " << field.offset << " " << field.size
+                            << " vs " << expected.type << " " << expected.name << " " << expected.offset << " " << expected.size;
+                        break;
+                    }
+                }
+            }
+            if (problem.str().empty())
+                continue;
+            differing++;
+            if (reported++ < 8)
+                std::cout << "BLEND::SDNA:: " << dumpStructs[i].first << ": " << problem.str() << std::endl;
+        }
+        std::cout << "BLEND::SDNA:: " << (dumpStructs.size() - differing) << " of " << dumpStructs.size() << " structs in " << dumpPath
+            << " match the file (version " << version << ", " << structs.size() << " structs)" << std::endl;
+        return differing;
+    }
+
+private:
+    MappedFile file;
+    std::vector<BlendBlock> blockList;
+    std::vector<const char*> names;
+    std::vector<const char*> typeNames;
+    std::vector<int> typeSizes;
+    std::vector<Struct> structs;
+    std::unordered_map<std::string, int> structByName;
+    std::unordered_map<uint64_t, int> blockByAddress;
+
+    // SDNA: "SDNA", then "NAME", "TYPE", "TLEN" and "STRC" sections, each 4 byte aligned
+    bool parseSdna(const char* data, size_t length)
+    {
+        size_t offset = 0;
+        auto align = [&]() { offset = (offset + 3) & ~(size_t)3; };
+        auto tag = [&](const char* expected) {
+            align();
+            if (offset + 4 > length || std::memcmp(data + offset, expected, 4) != 0)
+                return false;
+            offset += 4;
+            return true;
+        };
+        auto strings = [&](std::vector<const char*>& out) {
+            if (offset + 4 > length)
+                return false;
+            int count = read<int32_t>(data + offset);
+            offset += 4;
+            out.clear();
+            for (int i = 0; i < count; i++)
+            {
+                const char* start = data + offset;
+                const void* end = std::memchr(start, 0, length - offset);
+                if (!end)
+                    return false;
+                out.push_back(start);
+                offset = (const char*)end - data + 1;
+            }
+            return true;
+        };
+
+        if (!tag("SDNA") || !tag("NAME") || !strings(names) || !tag("TYPE") || !strings(typeNames) || !tag("TLEN"))
+            return false;
+        if (offset + typeNames.size() * 2 > length)
+            return false;
+        typeSizes.resize(typeNames.size());
+        for (size_t i = 0; i < typeNames.size(); i++)
+            typeSizes[i] = read<uint16_t>(data + offset + i * 2);
+        offset += typeNames.size() * 2;
+        if (!tag("STRC") || offset + 4 > length)
+            return false;
+        int structCount = read<int32_t>(data + offset);
+        offset += 4;
+
+        structs.resize(structCount);
+        for (int i = 0; i < structCount; i++)
+        {
+            if (offset + 4 > length)
+                return false;
+            Struct& s = structs[i];
+            s.type = read<int16_t>(data + offset);
+            int fieldCount = read<int16_t>(data + offset + 2);
+            offset += 4;
+            if (s.type < 0 || s.type >= (int)typeNames.size() || offset + fieldCount * 4 > length)
+                return false;
+            s.size = typeSizes[s.type];
+            int fieldOffset = 0;
+            for (int f = 0; f < fieldCount; f++)
+            {
+                Field field;
+                field.type = read<int16_t>(data + offset);
+                int name = read<int16_t>(data + offset + 2);
+                offset += 4;
+                if (field.type < 0 || field.type >= (int)typeNames.size() || name < 0 || name >= (int)names.size())
+                    return false;
+                field.name = names[name];
+                field.pointer = field.name[0] == '*' || (field.name[0] == '(' && field.name[1] == '*');
+                field.arrayLength = 1;
+                for (const char* c = std::strchr(field.name, '['); c; c = std::strchr(c + 1, '['))
+                    field.arrayLength *= std::max(1, std::atoi(c + 1));
+                for (const char* c = field.name; *c && *c != '[' && *c != ')'; c++)
+                    if (*c != '*' && *c != '(')
+                        field.key += *c;
+                field.offset = fieldOffset;
+                field.size = (field.pointer ? pointerSize : typeSizes[field.type]) * field.arrayLength;
+                fieldOffset += field.size;
+                s.fields.push_back(field);
+            }
+            structByName[typeNames[s.type]] = i;
+        }
+        return true;
+    }
+
+    static std::string dumpName(const char* name)
+    {
+        std::string result;
+        for (const char* c = name; *c; c++)
+        {
+            if (*c == '[')
+                c = std::strchr(c, ']');
+            else
+                result += *c;
+            if (!c)
+                break;
+        }
+        return result;
+    }
+};
+
+// one material slot as the importer found it: a flat color, and the image of its first image texture if any
+struct BlendMaterial {
+    std::string name;
+    glm::vec3 color;
+    // as stored in the file: "//" starts a path relative to the .blend
+    std::string image;
+};
+
+// triangles of one object using one material, already in the room's space (y up)
+struct BlendMesh {
+    std::vector<Vertex> vertices;
+    std::vector<unsigned int> indices;
+    int material;
+};
+
+// Pulls every mesh object out of a BlendFile: polygons (or the legacy faces of old files) are fanned into
+// triangles per material slot, split into one vertex per distinct corner (position, normal, uv), and moved by
+// the object's world matrix from Blender's z up to y up. Reads the 2.6x-2.7x mesh layout (mvert, mpoly, mloop,
+// mloopuv) that dna.txt describes, with fields located through the file's SDNA.
+class BlendImporter
+{
+public:
+    std::vector<BlendMaterial> materials;
+    std::vector<BlendMesh> meshes;
+    size_t objectCount = 0;
+    // whether the file matched blend_dna.h, so meshes were read at offsets fixed at compile time
+    bool fixedLayout = false;
+
+    bool import(const BlendFile& blend)
+    {
+        materials.clear();
+        meshes.clear();
+        materialByAddress.clear();
+        objectCount = 0;
+        if (!resolveLayout(blend))
+        {
+            std::cout << "ERROR::BLEND::MESH_LAYOUT_NOT_SUPPORTED: file version " << blend.version << std::endl;
+            return false;
+        }
+        // checked once per file; a file from the version the bindings were generated from then reads every vertex,
+        // loop and polygon with constant offsets and strides instead of ones looked up at run time
+        fixedLayout = blend.matches<dna::Object>() && blend.matches<dna::Mesh>() && blend.matches<dna::MVert>() && blend.matches<dna::MPoly>()
+            && blend.matches<dna::MLoop>() && blend.matches<dna::MLoopUV>() && blend.matches<dna::MFace>() && blend.matches<dna::MTFace>();
+        if (fixedLayout)
+            importObjects(blend, FixedLayout());
+        else
+            importObjects(blend, layout);
+        return true;
+    }
+
+private:
+    // field offsets of everything the importer touches, -1 for fields this file doesn't have
+    struct Layout {
+        int objectSize, obType, obData, obMatrix, obMat, obMatbits, obTotcol;
+        int meshSize, meTotvert, meTotpoly, meTotface, meMvert, meMpoly, meMloop, meMloopuv, meMface, meMtface, meMat, meTotcol;
+        int mvertSize, mvCo, mvNo;
+        int mpolySize, mpLoopstart, mpTotloop, mpMatnr, mpFlag;
+        int mloopSize, mlV;
+        int mloopuvSize, uvUv;
+        int mfaceSize, mfV1, mfV2, mfV3, mfV4, mfMatnr, mfFlag;
+        int mtfaceSize, tfUv;
+        int idName, maR, maG, maB, maMtex, maMtexCount, mtexTex, texIma, imaName;
+    };
+
+    // the same fields as blend_dna.h's field types, read with its accessors at compile time offsets
+    struct FixedLayout {
+        enum {
+            objectSize = dna::Object::SIZE, meshSize = dna::Mesh::SIZE, mvertSize = dna::MVert::SIZE, mpolySize = dna::MPoly::SIZE,
+            mloopSize = dna::MLoop::SIZE, mloopuvSize = dna::MLoopUV::SIZE, mfaceSize = dna::MFace::SIZE, mtfaceSize = dna::MTFace::SIZE,
+        };
+        dna::Object::type obType;
+        dna::Object::data obData;
+        dna::Object::obmat obMatrix;
+        dna::Mesh::totvert meTotvert;
+        dna::Mesh::totpoly meTotpoly;
+        dna::Mesh::totface meTotface;
+        dna::Mesh::mvert meMvert;
+        dna::Mesh::mpoly meMpoly;
+        dna::Mesh::mloop meMloop;
+        dna::Mesh::mloopuv meMloopuv;
+        dna::Mesh::mface meMface;
+        dna::Mesh::mtface meMtface;
+        dna::MVert::co mvCo;
+        dna::MVert::no mvNo;
+        dna::MPoly::loopstart mpLoopstart;
+        dna::MPoly::totloop mpTotloop;
+        dna::MPoly::mat_nr mpMatnr;
+        dna::MPoly::flag mpFlag;
+        dna::MLoop::v mlV;
+        dna::MLoopUV::uv uvUv;
+        dna::MFace::v1 mfV1;
+        dna::MFace::v2 mfV2;
+        dna::MFace::v3 mfV3;
+        dna::MFace::v4 mfV4;
+        dna::MFace::mat_nr mfMatnr;
+        dna::MFace::flag mfFlag;
+        dna::MTFace::uv tfUv;
+    };
+
+    // importObject reads every field through these: a Layout field is an offset looked up in the file's SDNA,
+    // a FixedLayout field one of blend_dna.h's types, read with dna::get
+    template <class T>
+    static T field(const char* base, int offset, int index = 0)
+    {
+        return BlendFile::read<T>(base + offset + index * sizeof(T));
+    }
+
+    template <class T, class F>
+    static T field(const char* base, F, int index = 0)
+    {
+        static_assert(std::is_same<T, typename F::TYPE>::value, "field read as another type than blend_dna.h gives it");
+        return dna::get<F>(base, index);
+    }
+
+    static uint64_t pointer(const BlendFile& blend, const char* base, int offset) { return blend.readPointer(base + offset); }
+
+    // blend_dna.h describes 64 bit files, the only ones matches() accepts
+    template <class F>
+    static uint64_t pointer(const BlendFile&, const char* base, F)
+    {
+        static_assert(F::POINTER, "not a pointer field");
+        return dna::get<F>(base);
+    }
+
+    static const char* fieldAddress(const char* base, int offset) { return base + offset; }
+
+    template <class F>
+    static const char* fieldAddress(const char* base, F) { return dna::at<F>(base); }
+
+    // whether the file has the field; blend_dna.h's always does
+    static bool has(int offset) { return offset >= 0; }
+
+    template <class F>
+    static bool has(F) { return true; }
+
+    Layout layout;
+    std::unordered_map<uint64_t, int> materialByAddress;
+
+    bool resolveLayout(const BlendFile& blend)
+    {
+        Layout& l = layout;
+        l.objectSize = blend.structSize("Object");
+        l.obType = blend.fieldOffset("Object", "type");
+        l.obData = blend.fieldOffset("Object", "data");
+        l.obMatrix = blend.fieldOffset("Object", "obmat");
+        l.obMat = blend.fieldOffset("Object", "mat");
+        l.obMatbits = blend.fieldOffset("Object", "matbits");
+        l.obTotcol = blend.fieldOffset("Object", "totcol");
+        l.meshSize = blend.structSize("Mesh");
+        l.meTotvert = blend.fieldOffset("Mesh", "totvert");
+        l.meTotpoly = blend.fieldOffset("Mesh", "totpoly");
+        l.meTotface = blend.fieldOffset("Mesh", "totface");
+        l.meMvert = blend.fieldOffset("Mesh", "mvert");
+        l.meMpoly = blend.fieldOffset("Mesh", "mpoly");
+        l.meMloop = blend.fieldOffset("Mesh", "mloop");
+        l.meMloopuv = blend.fieldOffset("Mesh", "mloopuv");
+        l.meMface = blend.fieldOffset("Mesh", "mface");
+        l.meMtface = blend.fieldOffset("Mesh", "mtface");
+        l.meMat = blend.fieldOffset("Mesh", "mat");
+        l.meTotcol = blend.fieldOffset("Mesh", "totcol");
+        l.mvertSize = blend.structSize("MVert");
+        l.mvCo = blend.fieldOffset("MVert", "co");
+        l.mvNo = blend.fieldOffset("MVert", "no");
+        l.mpolySize = blend.structSize("MPoly");
+        l.mpLoopstart = blend.fieldOffset("MPoly", "loopstart");
+        l.mpTotloop = blend.fieldOffset("MPoly", "totloop");
+        l.mpMatnr = blend.fieldOffset("MPoly", "mat_nr");
+        l.mpFlag = blend.fieldOffset("MPoly", "flag");
+        l.mloopSize = blend.structSize("MLoop");
+        l.mlV = blend.fieldOffset("MLoop", "v");
+        l.mloopuvSize = blend.structSize("MLoopUV");
+        l.uvUv = blend.fieldOffset("MLoopUV", "uv");
+        l.mfaceSize = blend.structSize("MFace");
+        l.mfV1 = blend.fieldOffset("MFace", "v1");
+        l.mfV2 = blend.fieldOffset("MFace", "v2");
+        l.mfV3 = blend.fieldOffset("MFace", "v3");
+        l.mfV4 = blend.fieldOffset("MFace", "v4");
+        l.mfMatnr = blend.fieldOffset("MFace", "mat_nr");
+        l.mfFlag = blend.fieldOffset("MFace", "flag");
+        l.mtfaceSize = blend.structSize("MTFace");
+        l.tfUv = blend.fieldOffset("MTFace", "uv");
+        l.idName = blend.fieldOffset("ID", "name");
+        l.maR = blend.fieldOffset("Material", "r");
+        l.maG = blend.fieldOffset("Material", "g");
+        l.maB = blend.fieldOffset("Material", "b");
+        const BlendFile::Field* mtex = blend.findField("Material", "mtex");
+        l.maMtex = mtex ? mtex->offset : -1;
+        l.maMtexCount = mtex ? mtex->arrayLength : 0;
+        l.mtexTex = blend.fieldOffset("MTex", "tex");
+        l.texIma = blend.fieldOffset("Tex", "ima");
+        l.imaName = blend.fieldOffset("Image", "name");
+
+        bool polygons = l.meMpoly >= 0 && l.meMloop >= 0 && l.meTotpoly >= 0 && l.mpLoopstart >= 0 && l.mpTotloop >= 0 && l.mlV >= 0;
+        bool faces = l.meMface >= 0 && l.meTotface >= 0 && l.mfV1 >= 0;
+        return l.obType >= 0 && l.obData >= 0 && l.obMatrix >= 0 && l.meTotvert >= 0 && l.meMvert >= 0 && l.mvCo >= 0 && (polygons || faces);
+    }
+
+    int material(const BlendFile& blend, uint64_t address)
+    {
+        auto found = materialByAddress.find(address);
+        if (found != materialByAddress.end())
+            return found->second;
+        BlendMaterial result;
+        result.color = glm::vec3(0.8f);
+        const char* data = blend.resolve(address, blend.structSize("Material"));
+        if (data)
+        {
+            if (layout.idName >= 0)
+                result.name = std::string(data + layout.idName + 2, strnlen(data + layout.idName + 2, 64));
+            if (layout.maR >= 0 && layout.maG >= 0 && layout.maB >= 0)
+                result.color = glm::vec3(BlendFile::read<float>(data + layout.maR), BlendFile::read<float>(data + layout.maG), BlendFile::read<float>(data + layout.maB));
+            // the first texture slot with an image behind it
+            for (int slot = 0; slot < layout.maMtexCount && layout.mtexTex >= 0 && layout.texIma >= 0 && layout.imaName >= 0 && result.image.empty(); slot++)
+            {
+                const char* mtex = blend.resolve(blend.readPointer(data + layout.maMtex + slot * blend.pointerSize), blend.structSize("MTex"));
+                const char* tex = mtex ? blend.resolve(blend.readPointer(mtex + layout.mtexTex), blend.structSize("Tex")) : nullptr;
+                const char* image = tex ? blend.resolve(blend.readPointer(tex + layout.texIma), blend.structSize("Image")) : nullptr;
+                if (image)
+                    result.image = std::string(image + layout.imaName, strnlen(image + layout.imaName, 1024));
+            }
+        }
+        materials.push_back(result);
+        materialByAddress[address] = (int)materials.size() - 1;
+        return (int)materials.size() - 1;
+    }
+
+    // material of every slot: the object's own where its matbits say so, the mesh's otherwise
+    std::vector<int> slotMaterials(const BlendFile& blend, const char* object, const char* mesh)
+    {
+        int meshSlots = layout.meTotcol >= 0 ? BlendFile::read<int16_t>(mesh + layout.meTotcol) : 0;
+        int objectSlots = layout.obTotcol >= 0 ? BlendFile::read<int32_t>(object + layout.obTotcol) : 0;
+        const char* meshMaterials = layout.meMat >= 0 ? blend.resolve(blend.readPointer(mesh + layout.meMat), meshSlots * blend.pointerSize) : nullptr;
+        const char* objectMaterials = layout.obMat >= 0 ? blend.resolve(blend.readPointer(object + layout.obMat), objectSlots * blend.pointerSize) : nullptr;
+        const char* objectBits = layout.obMatbits >= 0 ? blend.resolve(blend.readPointer(object + layout.obMatbits), objectSlots) : nullptr;
+
+        std::vector<int> slots(std::max(1, std::max(meshSlots, objectSlots)), -1);
+        for (int i = 0; i < (int)slots.size(); i++)
+        {
+            uint64_t address = 0;
+            if (objectMaterials && objectBits && i < objectSlots && objectBits[i])
+                address = blend.readPointer(objectMaterials + i * blend.pointerSize);
+            else if (meshMaterials && i < meshSlots)
+                address = blend.readPointer(meshMaterials + i * blend.pointerSize);
+            slots[i] = material(blend, address);
+        }
+        return slots;
+    }
+
+    // L is Layout or FixedLayout
+    template <class L>
+    void importObjects(const BlendFile& blend, const L& l)
+    {
+        for (const BlendBlock& block : blend.blocks())
+        {
+            if (block.code[0] != 'O' || block.code[1] != 'B' || block.code[2] != 0 || block.length < (uint32_t)l.objectSize)
+                continue;
+            // OB_MESH
+            if (field<int16_t>(block.data, l.obType) != 1)
+                continue;
+            const char* mesh = blend.resolve(pointer(blend, block.data, l.obData), l.meshSize);
+            if (!mesh)
+                continue;
+            objectCount++;
+            importObject(blend, block.data, mesh, l);
+        }
+    }
+
+    template <class L>
+    void importObject(const BlendFile& blend, const char* object, const char* mesh, const L& l)
+    {
+        int vertexCount = field<int32_t>(mesh, l.meTotvert);
+        const char* mvert = blend.resolve(pointer(blend, mesh, l.meMvert), (size_t)vertexCount * l.mvertSize);
+        if (vertexCount <= 0 || !mvert)
+            return;
+
+        // corners of every triangle: source vertex, uv, polygon, and whether the polygon is smooth
+        struct Corner {
+            int vertex;
+            glm::vec2 uv;
+            int face;
+            bool smooth;
+        };
+        std::vector<Corner> corners;
+        std::vector<int> faceMaterial;
+
+        int polyCount = has(l.meTotpoly) ? field<int32_t>(mesh, l.meTotpoly) : 0;
+        const char* mpoly = polyCount > 0 && has(l.meMpoly) ? blend.resolve(pointer(blend, mesh, l.meMpoly), (size_t)polyCount * l.mpolySize) : nullptr;
+        if (mpoly)
+        {
+            const BlendBlock* loops = blend.findBlock(pointer(blend, mesh, l.meMloop));
+            const char* mloop = loops ? loops->data : nullptr;
+            int loopCount = mloop ? (int)(loops->length / l.mloopSize) : 0;
+            const char* mloopuv = nullptr;
+            if (has(l.meMloopuv) && has(l.uvUv))
+                mloopuv = blend.resolve(pointer(blend, mesh, l.meMloopuv), (size_t)loopCount * l.mloopuvSize);
+            faceMaterial.resize(polyCount);
+            for (int p = 0; p < polyCount; p++)
+            {
+                const char* poly = mpoly + (size_t)p * l.mpolySize;
+                int first = field<int32_t>(poly, l.mpLoopstart), count = field<int32_t>(poly, l.mpTotloop);
+                faceMaterial[p] = has(l.mpMatnr) ? field<int16_t>(poly, l.mpMatnr) : 0;
+                bool smooth = has(l.mpFlag) && (field<char>(poly, l.mpFlag) & 1);
+                if (first < 0 || count < 3 || first + count > loopCount)
+                    continue;
+                for (int k = 1; k + 1 < count; k++)
+                {
+                    int loop[3] = { first, first + k, first + k + 1 };
+                    for (int c = 0; c < 3; c++)
+                    {
+                        Corner corner;
+                        corner.vertex = field<int32_t>(mloop + (size_t)loop[c] * l.mloopSize, l.mlV);
+                        const char* uv = mloopuv ? mloopuv + (size_t)loop[c] * l.mloopuvSize : nullptr;
+                        corner.uv = uv ? glm::vec2(field<float>(uv, l.uvUv, 0), field<float>(uv, l.uvUv, 1)) : glm::vec2(0.0f);
+                        corner.face = p;
+                        corner.smooth = smooth;
+                        corners.push_back(corner);
+                    }
+                }
+            }
+        }
+        else if (has(l.meMface) && has(l.meTotface))
+        {
+            // files from before polygons (2.62 and older) only have triangles and quads
+            int faceCount = field<int32_t>(mesh, l.meTotface);
+            const char* mface = faceCount > 0 ? blend.resolve(pointer(blend, mesh, l.meMface), (size_t)faceCount * l.mfaceSize) : nullptr;
+            const char* mtface = mface && has(l.meMtface) && has(l.tfUv) ? blend.resolve(pointer(blend, mesh, l.meMtface), (size_t)faceCount * l.mtfaceSize) : nullptr;
+            faceMaterial.resize(mface ? faceCount : 0);
+            for (int f = 0; mface && f < faceCount; f++)
+            {
+                const char* face = mface + (size_t)f * l.mfaceSize;
+                int v[4] = { field<int32_t>(face, l.mfV1), field<int32_t>(face, l.mfV2), field<int32_t>(face, l.mfV3), field<int32_t>(face, l.mfV4) };
+                faceMaterial[f] = has(l.mfMatnr) ? field<int16_t>(face, l.mfMatnr) : 0;
+                bool smooth = has(l.mfFlag) && (field<char>(face, l.mfFlag) & 1);
+                int count = v[3] ? 4 : 3;
+                for (int k = 1; k + 1 < count; k++)
+                {
+                    int corner3[3] = { 0, k, k + 1 };
+                    for (int c = 0; c < 3; c++)
+                    {
+                        Corner corner;
+                        corner.vertex = v[corner3[c]];
+                        const char* uv = mtface ? mtface + (size_t)f * l.mtfaceSize : nullptr;
+                        corner.uv = uv ? glm::vec2(field<float>(uv, l.tfUv, corner3[c] * 2), field<float>(uv, l.tfUv, corner3[c] * 2 + 1)) : glm::vec2(0.0f);
+                        corner.face = f;
+                        corner.smooth = smooth;
+                        corners.push_back(corner);
+                    }
+                }
+            }
+        }
+        if (corners.empty())
+            return;
+
+        // world matrix, then Blender's z up turned into y up
+        float matrix[16];
+        std::memcpy(matrix, fieldAddress(object, l.obMatrix), sizeof(matrix));
+        glm::mat4 zUpToYUp(glm::vec4(1.0f, 0.0f, 0.0f, 0.0f), glm::vec4(0.0f, 0.0f, -1.0f, 0.0f), glm::vec4(0.0f, 1.0f, 0.0f, 0.0f), glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+        glm::mat4 transform = zUpToYUp * glm::mat4(glm::vec4(matrix[0], matrix[1], matrix[2], matrix[3]), glm::vec4(matrix[4], matrix[5], matrix[6], matrix[7]),
+            glm::vec4(matrix[8], matrix[9], matrix[10], matrix[11]), glm::vec4(matrix[12], matrix[13], matrix[14], matrix[15]));
+        glm::mat3 normalTransform = glm::transpose(glm::inverse(glm::mat3(transform)));
+        bool mirrored = glm::determinant(glm::mat3(transform)) < 0.0f;
+
+        std::vector<glm::vec3> positions(vertexCount), normals(vertexCount);
+        for (int v = 0; v < vertexCount; v++)
+        {
+            const char* vertex = mvert + (size_t)v * l.mvertSize;
+            glm::vec3 co(field<float>(vertex, l.mvCo, 0), field<float>(vertex, l.mvCo, 1), field<float>(vertex, l.mvCo, 2));
+            positions[v] = glm::vec3(transform * glm::vec4(co, 1.0f));
+            if (has(l.mvNo))
+            {
+                glm::vec3 no(field<int16_t>(vertex, l.mvNo, 0), field<int16_t>(vertex, l.mvNo, 1), field<int16_t>(vertex, l.mvNo, 2));
+                normals[v] = glm::normalize(normalTransform * no);
+            }
+        }
+
+        std::vector<int> slots = slotMaterials(blend, object, mesh);
+        std::vector<int> variants(vertexCount, -1);
+        for (size_t slot = 0; slot < slots.size(); slot++)
+        {
+            BlendMesh out;
+            out.material = slots[slot];
+            // output vertices made from each source vertex are chained, so a corner finds its twin in a few steps
+            std::vector<int> nextVariant;
+            std::vector<int> touched;
+            for (size_t c = 0; c + 2 < corners.size(); c += 3)
+            {
+                int face = corners[c].face;
+                if (std::min(std::max(faceMaterial[face], 0), (int)slots.size() - 1) != (int)slot)
+                    continue;
+                bool valid = true;
+                for (int k = 0; k < 3; k++)
+                    valid = valid && corners[c + k].vertex >= 0 && corners[c + k].vertex < vertexCount;
+                if (!valid)
+                    continue;
+                glm::vec3 a = positions[corners[c].vertex], b = positions[corners[c + 1].vertex], d = positions[corners[c + 2].vertex];
+                glm::vec3 faceNormal = glm::cross(b - a, d - a);
+                float length = glm::length(faceNormal);
+                faceNormal = length > 0.0f ? faceNormal / length * (mirrored ? -1.0f : 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+
+                unsigned int triangle[3];
+                for (int k = 0; k < 3; k++)
+                {
+                    const Corner& corner = corners[c + k];
+                    Vertex vertex;
+                    vertex.Position = positions[corner.vertex];
+                    vertex.Normal = corner.smooth && has(l.mvNo) ? normals[corner.vertex] : faceNormal;
+                    // flipped like assimp's loader does (aiProcess_FlipUVs), so both feed the shaders the same way
+                    vertex.TexCoords = glm::vec2(corner.uv.x, 1.0f - corner.uv.y);
+                    vertex.Tangent = vertex.Bitangent = glm::vec3(0.0f);
+                    int found = variants[corner.vertex];
+                    while (found >= 0 && (out.vertices[found].Normal != vertex.Normal || out.vertices[found].TexCoords != vertex.TexCoords))
+                        found = nextVariant[found];
+                    if (found < 0)
+                    {
+                        if (variants[corner.vertex] < 0)
+                            touched.push_back(corner.vertex);
+                        found = (int)out.vertices.size();
+                        out.vertices.push_back(vertex);
+                        nextVariant.push_back(variants[corner.vertex]);
+                        variants[corner.vertex] = found;
+                    }
+                    triangle[k] = (unsigned int)found;
+                }
+                // mirroring transforms turn the winding around
+                if (mirrored)
+                    std::swap(triangle[1], triangle[2]);
+                out.indices.insert(out.indices.end(), triangle, triangle + 3);
+            }
+            for (int vertex : touched)
+                variants[vertex] = -1;
+            if (out.indices.empty())
+                continue;
+            computeTangents(out);
+            meshes.push_back(std::move(out));
+        }
+    }
+
+    static void computeTangents(BlendMesh& mesh)
+    {
+        for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+        {
+            Vertex& a = mesh.vertices[mesh.indices[i]];
+            Vertex& b = mesh.vertices[mesh.indices[i + 1]];
+            Vertex& c = mesh.vertices[mesh.indices[i + 2]];
+            glm::vec3 e1 = b.Position - a.Position, e2 = c.Position - a.Position;
+            glm::vec2 d1 = b.TexCoords - a.TexCoords, d2 = c.TexCoords - a.TexCoords;
+            float det = d1.x * d2.y - d2.x * d1.y;
+            if (std::abs(det) < 1e-12f)
+                continue;
+            glm::vec3 tangent = (e1 * d2.y - e2 * d1.y) / det;
+            glm::vec3 bitangent = (e2 * d1.x - e1 * d2.x) / det;
+            a.Tangent += tangent; b.Tangent += tangent; c.Tangent += tangent;
+            a.Bitangent += bitangent; b.Bitangent += bitangent; c.Bitangent += bitangent;
+        }
+        for (Vertex& vertex : mesh.vertices)
+        {
+            if (glm::dot(vertex.Tangent, vertex.Tangent) > 0.0f)
+                vertex.Tangent = glm::normalize(vertex.Tangent);
+            if (glm::dot(vertex.Bitangent, vertex.Bitangent) > 0.0f)
+                vertex.Bitangent = glm::normalize(vertex.Bitangent);
+        }
+    }
+};
+#endif
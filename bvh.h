@@ -0,0 +1,666 @@
+#ifndef BVH_H
+#define BVH_H
+
+#include <glm/glm.hpp>
+
+#include <emmintrin.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// Static triangle BVH. Built top-down with binned SAH into a binary tree, then collapsed into a flattened
+// 4-wide tree: every node stores the boxes of its four children in structure-of-arrays form, so one node is
+// two cache lines and a ray tests all four children with a handful of SSE instructions. Besides rays it answers
+// sphere sweeps (a ray against the child boxes grown by the radius) and box overlap queries.
+class Bvh
+{
+public:
+    static const int MAX_LEAF_TRIANGLES = 4;
+
+    struct Hit {
+        float t;
+        // barycentric coordinates of the hit on the triangle
+        float u, v;
+        // index of the triangle in the order it was passed to build()
+        int triangle;
+    };
+
+    struct SweepHit {
+        // distance the sphere travels before it touches
+        float t;
+        // where it touches, and the direction from there to the sphere's center at that moment
+        glm::vec3 point, normal;
+        int triangle;
+    };
+
+    // builds the tree over a triangle soup: three consecutive positions per triangle
+    void build(const std::vector<glm::vec3>& positions)
+    {
+        int count = (int)(positions.size() / 3);
+        nodes.clear();
+        triangles.clear();
+        triangleIds.clear();
+        maxDepth = 0;
+        if (count == 0)
+            return;
+
+        std::vector<BuildTriangle> build(count);
+        for (int i = 0; i < count; i++)
+        {
+            glm::vec3 a = positions[i * 3], b = positions[i * 3 + 1], c = positions[i * 3 + 2];
+            build[i].bmin = glm::min(a, glm::min(b, c));
+            build[i].bmax = glm::max(a, glm::max(b, c));
+            build[i].centroid = (build[i].bmin + build[i].bmax) * 0.5f;
+            build[i].id = i;
+        }
+
+        std::vector<BinaryNode> binary;
+        binary.reserve(count * 2);
+        buildBinary(build, 0, count, binary);
+
+        // triangles are stored in leaf order, so every leaf is a contiguous run
+        triangles.resize(count);
+        triangleIds.resize(count);
+        for (int i = 0; i < count; i++)
+        {
+            int id = build[i].id;
+            glm::vec3 a = positions[id * 3], b = positions[id * 3 + 1], c = positions[id * 3 + 2];
+            triangles[i].v0 = a;
+            triangles[i].e1 = b - a;
+            triangles[i].e2 = c - a;
+            triangleIds[i] = id;
+        }
+
+        nodes.reserve(binary.size() / 2 + 1);
+        collapse(binary, 0, 0);
+    }
+
+    bool empty() const { return nodes.empty(); }
+    size_t nodeCount() const { return nodes.size(); }
+    size_t triangleCount() const { return triangles.size(); }
+
+    // closest hit along the ray within (0, tMax)
+    bool intersect(const glm::vec3& origin, const glm::vec3& direction, float tMax, Hit& hit) const
+    {
+        return traverse(origin, direction, tMax, hit, false);
+    }
+
+    // true if anything lies on the segment (0, tMax); stops at the first hit
+    bool occluded(const glm::vec3& origin, const glm::vec3& direction, float tMax) const
+    {
+        Hit hit;
+        return traverse(origin, direction, tMax, hit, true);
+    }
+
+    // first contact of a sphere moving from center along the unit direction within [0, tMax). A triangle the
+    // sphere already overlaps only stops it from moving further in, so it can still slide along or leave it.
+    bool sweepSphere(const glm::vec3& center, float radius, const glm::vec3& direction, float tMax, SweepHit& hit) const
+    {
+        bool found = false;
+        float closest = tMax;
+        walkRay(center, direction, radius, closest, [&](int first, int count, float& limit) {
+            for (int t = first; t < first + count; t++)
+            {
+                if (sweepTriangle(t, center, radius, direction, limit, hit))
+                {
+                    found = true;
+                    limit = hit.t;
+                    if (limit <= 0.0f)
+                        return true;
+                }
+            }
+            return false;
+        });
+        return found;
+    }
+
+    // appends the index (in build() order) of every triangle touching the box
+    void overlapBox(const glm::vec3& boxMin, const glm::vec3& boxMax, std::vector<int>& result) const
+    {
+        if (nodes.empty())
+            return;
+        const __m128 qMinX = _mm_set1_ps(boxMin.x), qMinY = _mm_set1_ps(boxMin.y), qMinZ = _mm_set1_ps(boxMin.z);
+        const __m128 qMaxX = _mm_set1_ps(boxMax.x), qMaxY = _mm_set1_ps(boxMax.y), qMaxZ = _mm_set1_ps(boxMax.z);
+        glm::vec3 center = (boxMin + boxMax) * 0.5f, halfSize = (boxMax - boxMin) * 0.5f;
+
+        NodeStack stack(3 * maxDepth + 4);
+        stack.push(0);
+        while (!stack.empty())
+        {
+            const Node4& node = nodes[stack.pop()];
+            __m128 inside = _mm_and_ps(
+                _mm_and_ps(_mm_cmple_ps(_mm_loadu_ps(node.minX), qMaxX), _mm_cmpge_ps(_mm_loadu_ps(node.maxX), qMinX)),
+                _mm_and_ps(_mm_and_ps(_mm_cmple_ps(_mm_loadu_ps(node.minY), qMaxY), _mm_cmpge_ps(_mm_loadu_ps(node.maxY), qMinY)),
+                    _mm_and_ps(_mm_cmple_ps(_mm_loadu_ps(node.minZ), qMaxZ), _mm_cmpge_ps(_mm_loadu_ps(node.maxZ), qMinZ))));
+            int mask = _mm_movemask_ps(inside);
+            for (int i = 0; i < 4; i++)
+            {
+                if (!(mask & (1 << i)) || node.count[i] < 0)
+                    continue;
+                if (node.count[i] == 0)
+                {
+                    stack.push(node.child[i]);
+                    continue;
+                }
+                for (int t = node.child[i]; t < node.child[i] + node.count[i]; t++)
+                    if (triangleOverlapsBox(t, center, halfSize))
+                        result.push_back(triangleIds[t]);
+            }
+        }
+    }
+
+    // closest point to p on the triangle abc (Ericson, Real-Time Collision Detection 5.1.5)
+    static glm::vec3 closestPointOnTriangle(const glm::vec3& p, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c)
+    {
+        glm::vec3 ab = b - a, ac = c - a, ap = p - a;
+        float d1 = glm::dot(ab, ap), d2 = glm::dot(ac, ap);
+        if (d1 <= 0.0f && d2 <= 0.0f)
+            return a;
+        glm::vec3 bp = p - b;
+        float d3 = glm::dot(ab, bp), d4 = glm::dot(ac, bp);
+        if (d3 >= 0.0f && d4 <= d3)
+            return b;
+        float vc = d1 * d4 - d3 * d2;
+        if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+            return a + ab * (d1 / (d1 - d3));
+        glm::vec3 cp = p - c;
+        float d5 = glm::dot(ab, cp), d6 = glm::dot(ac, cp);
+        if (d6 >= 0.0f && d5 <= d6)
+            return c;
+        float vb = d5 * d2 - d1 * d6;
+        if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+            return a + ac * (d2 / (d2 - d6));
+        float va = d3 * d6 - d5 * d4;
+        if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f)
+            return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+        float denom = 1.0f / (va + vb + vc);
+        return a + ab * (vb * denom) + ac * (vc * denom);
+    }
+
+private:
+    // four children per node: count > 0 is a leaf with `count` triangles starting at `child`,
+    // count == 0 an inner node at index `child`, count < 0 an unused slot
+    struct Node4 {
+        float minX[4], minY[4], minZ[4];
+        float maxX[4], maxY[4], maxZ[4];
+        int32_t child[4];
+        int32_t count[4];
+    };
+
+    // Moller-Trumbore friendly layout
+    struct Triangle {
+        glm::vec3 v0, e1, e2;
+    };
+
+    struct BuildTriangle {
+        glm::vec3 bmin, bmax, centroid;
+        int id;
+    };
+
+    struct BinaryNode {
+        glm::vec3 bmin, bmax;
+        int left, right;
+        int first, count;
+    };
+
+    // Nodes still to visit. Popping a node and pushing its inner children leaves at most three of them behind
+    // per level, so 3 * maxDepth + 4 entries always suffice; they live on the caller's stack unless the tree is
+    // too deep for that.
+    class NodeStack
+    {
+    public:
+        explicit NodeStack(int capacity) : entries(local), size(0)
+        {
+            if (capacity > LOCAL_CAPACITY)
+            {
+                heap.resize(capacity);
+                entries = heap.data();
+            }
+        }
+
+        void push(int node) { entries[size++] = node; }
+        int pop() { return entries[--size]; }
+        bool empty() const { return size == 0; }
+
+    private:
+        static const int LOCAL_CAPACITY = 64;
+        int local[LOCAL_CAPACITY];
+        std::vector<int> heap;
+        int* entries;
+        int size;
+    };
+
+    std::vector<Node4> nodes;
+    std::vector<Triangle> triangles;
+    std::vector<int> triangleIds;
+    // depth of the deepest inner node, the root being 0
+    int maxDepth = 0;
+
+    static float area(const glm::vec3& bmin, const glm::vec3& bmax)
+    {
+        glm::vec3 d = glm::max(bmax - bmin, glm::vec3(0.0f));
+        return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+    }
+
+    int buildBinary(std::vector<BuildTriangle>& tris, int first, int count, std::vector<BinaryNode>& out)
+    {
+        int index = (int)out.size();
+        out.push_back(BinaryNode());
+        glm::vec3 bmin(FLT_MAX), bmax(-FLT_MAX), cmin(FLT_MAX), cmax(-FLT_MAX);
+        for (int i = first; i < first + count; i++)
+        {
+            bmin = glm::min(bmin, tris[i].bmin);
+            bmax = glm::max(bmax, tris[i].bmax);
+            cmin = glm::min(cmin, tris[i].centroid);
+            cmax = glm::max(cmax, tris[i].centroid);
+        }
+        out[index].bmin = bmin;
+        out[index].bmax = bmax;
+        out[index].left = out[index].right = -1;
+        out[index].first = first;
+        out[index].count = count;
+        if (count <= 1)
+            return index;
+
+        // binned SAH over all three axes
+        const int BINS = 16;
+        float bestCost = FLT_MAX;
+        int bestAxis = -1, bestSplit = 0;
+        for (int axis = 0; axis < 3; axis++)
+        {
+            float extent = cmax[axis] - cmin[axis];
+            if (extent <= 0.0f)
+                continue;
+            glm::vec3 binMin[BINS], binMax[BINS];
+            int binCount[BINS] = { 0 };
+            for (int b = 0; b < BINS; b++)
+            {
+                binMin[b] = glm::vec3(FLT_MAX);
+                binMax[b] = glm::vec3(-FLT_MAX);
+            }
+            float scale = BINS / extent;
+            for (int i = first; i < first + count; i++)
+            {
+                int b = std::min(BINS - 1, (int)((tris[i].centroid[axis] - cmin[axis]) * scale));
+                binCount[b]++;
+                binMin[b] = glm::min(binMin[b], tris[i].bmin);
+                binMax[b] = glm::max(binMax[b], tris[i].bmax);
+            }
+            // sweep from the right, then evaluate every split from the left
+            float rightArea[BINS];
+            int rightCount[BINS];
+            glm::vec3 rmin(FLT_MAX), rmax(-FLT_MAX);
+            int rc = 0;
+            for (int b = BINS - 1; b > 0; b--)
+            {
+                rmin = glm::min(rmin, binMin[b]);
+                rmax = glm::max(rmax, binMax[b]);
+                rc += binCount[b];
+                rightArea[b] = rc ? area(rmin, rmax) : 0.0f;
+                rightCount[b] = rc;
+            }
+            glm::vec3 lmin(FLT_MAX), lmax(-FLT_MAX);
+            int lc = 0;
+            for (int b = 0; b < BINS - 1; b++)
+            {
+                lmin = glm::min(lmin, binMin[b]);
+                lmax = glm::max(lmax, binMax[b]);
+                lc += binCount[b];
+                if (lc == 0 || rightCount[b + 1] == 0)
+                    continue;
+                float cost = area(lmin, lmax) * lc + rightArea[b + 1] * rightCount[b + 1];
+                if (cost < bestCost)
+                {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestSplit = b;
+                }
+            }
+        }
+
+        // stay a leaf when splitting doesn't pay off (traversal step costs about one triangle test)
+        float leafCost = area(bmin, bmax) * count;
+        if (bestAxis < 0 || (count <= MAX_LEAF_TRIANGLES && bestCost + area(bmin, bmax) >= leafCost))
+        {
+            if (count <= MAX_LEAF_TRIANGLES)
+                return index;
+            // all centroids coincide: split in the middle of the list
+            bestAxis = -1;
+        }
+
+        int mid;
+        if (bestAxis >= 0)
+        {
+            float scale = BINS / (cmax[bestAxis] - cmin[bestAxis]);
+            float axisMin = cmin[bestAxis];
+            int axis = bestAxis, split = bestSplit;
+            BuildTriangle* middle = std::partition(&tris[first], &tris[first] + count, [=](const BuildTriangle& t) {
+                return std::min(BINS - 1, (int)((t.centroid[axis] - axisMin) * scale)) <= split;
+            });
+            mid = (int)(middle - &tris[0]);
+        }
+        else
+            mid = first + count / 2;
+
+        int left = buildBinary(tris, first, mid - first, out);
+        int right = buildBinary(tris, mid, first + count - mid, out);
+        out[index].left = left;
+        out[index].right = right;
+        return index;
+    }
+
+    int collapse(const std::vector<BinaryNode>& binary, int binaryIndex, int depth)
+    {
+        maxDepth = std::max(maxDepth, depth);
+        int index = (int)nodes.size();
+        nodes.push_back(Node4());
+
+        // open the largest inner child until there are four children (or only leaves left)
+        int children[4];
+        int childCount = 0;
+        const BinaryNode& root = binary[binaryIndex];
+        if (root.left < 0)
+            children[childCount++] = binaryIndex;
+        else
+        {
+            children[childCount++] = root.left;
+            children[childCount++] = root.right;
+        }
+        while (childCount < 4)
+        {
+            int largest = -1;
+            float largestArea = -1.0f;
+            for (int i = 0; i < childCount; i++)
+            {
+                const BinaryNode& node = binary[children[i]];
+                if (node.left >= 0 && area(node.bmin, node.bmax) > largestArea)
+                {
+                    largestArea = area(node.bmin, node.bmax);
+                    largest = i;
+                }
+            }
+            if (largest < 0)
+                break;
+            const BinaryNode& node = binary[children[largest]];
+            children[largest] = node.left;
+            children[childCount++] = node.right;
+        }
+
+        for (int i = 0; i < 4; i++)
+        {
+            // nodes may reallocate during the recursion, never hold a reference across it
+            if (i >= childCount)
+            {
+                Node4& node = nodes[index];
+                node.minX[i] = node.minY[i] = node.minZ[i] = FLT_MAX;
+                node.maxX[i] = node.maxY[i] = node.maxZ[i] = -FLT_MAX;
+                node.child[i] = 0;
+                node.count[i] = -1;
+                continue;
+            }
+            const BinaryNode& child = binary[children[i]];
+            int32_t childIndex, childCountValue;
+            if (child.left < 0)
+            {
+                childIndex = child.first;
+                childCountValue = child.count;
+            }
+            else
+            {
+                childIndex = collapse(binary, children[i], depth + 1);
+                childCountValue = 0;
+            }
+            Node4& node = nodes[index];
+            node.minX[i] = child.bmin.x; node.minY[i] = child.bmin.y; node.minZ[i] = child.bmin.z;
+            node.maxX[i] = child.bmax.x; node.maxY[i] = child.bmax.y; node.maxZ[i] = child.bmax.z;
+            node.child[i] = childIndex;
+            node.count[i] = childCountValue;
+        }
+        return index;
+    }
+
+    bool intersectTriangle(int index, const glm::vec3& origin, const glm::vec3& direction, float tMax, Hit& hit) const
+    {
+        const Triangle& tri = triangles[index];
+        glm::vec3 p = glm::cross(direction, tri.e2);
+        float det = glm::dot(tri.e1, p);
+        if (std::abs(det) < 1e-12f)
+            return false;
+        float invDet = 1.0f / det;
+        glm::vec3 s = origin - tri.v0;
+        float u = glm::dot(s, p) * invDet;
+        if (u < 0.0f || u > 1.0f)
+            return false;
+        glm::vec3 q = glm::cross(s, tri.e1);
+        float v = glm::dot(direction, q) * invDet;
+        if (v < 0.0f || u + v > 1.0f)
+            return false;
+        float t = glm::dot(tri.e2, q) * invDet;
+        if (t <= 1e-5f || t >= tMax)
+            return false;
+        hit.t = t;
+        hit.u = u;
+        hit.v = v;
+        hit.triangle = triangleIds[index];
+        return true;
+    }
+
+    // sphere against one triangle: the face first, then the three edges (as cylinders) and the three corners
+    bool sweepTriangle(int index, const glm::vec3& center, float radius, const glm::vec3& direction, float tMax, SweepHit& hit) const
+    {
+        const Triangle& tri = triangles[index];
+        glm::vec3 normal = glm::cross(tri.e1, tri.e2);
+        float normalLength = glm::length(normal);
+        if (normalLength < 1e-12f)
+            return false;
+        normal /= normalLength;
+        float distance = glm::dot(normal, center - tri.v0);
+        if (distance < 0.0f)
+        {
+            normal = -normal;
+            distance = -distance;
+        }
+        glm::vec3 corners[3] = { tri.v0, tri.v0 + tri.e1, tri.v0 + tri.e2 };
+
+        if (distance <= radius)
+        {
+            glm::vec3 closest = closestPointOnTriangle(center, corners[0], corners[1], corners[2]);
+            glm::vec3 away = center - closest;
+            float distanceSquared = glm::dot(away, away);
+            if (distanceSquared < radius * radius)
+            {
+                glm::vec3 contactNormal = distanceSquared > 1e-12f ? away / std::sqrt(distanceSquared) : normal;
+                // moving along the surface (give or take rounding) or away from it
+                if (glm::dot(direction, contactNormal) > -1e-3f)
+                    return false;
+                hit.t = 0.0f;
+                hit.point = closest;
+                hit.normal = contactNormal;
+                hit.triangle = triangleIds[index];
+                return true;
+            }
+        }
+        else
+        {
+            float approach = -glm::dot(normal, direction);
+            if (approach <= 0.0f)
+                return false;
+            float t = (distance - radius) / approach;
+            if (t >= tMax)
+                return false;
+            glm::vec3 contact = center + direction * t - normal * radius;
+            glm::vec3 offset = contact - tri.v0;
+            float d00 = glm::dot(tri.e1, tri.e1), d01 = glm::dot(tri.e1, tri.e2), d11 = glm::dot(tri.e2, tri.e2);
+            float d20 = glm::dot(offset, tri.e1), d21 = glm::dot(offset, tri.e2);
+            float denom = d00 * d11 - d01 * d01;
+            float v = (d11 * d20 - d01 * d21) / denom, w = (d00 * d21 - d01 * d20) / denom;
+            if (v >= 0.0f && w >= 0.0f && v + w <= 1.0f)
+            {
+                hit.t = t;
+                hit.point = contact;
+                hit.normal = normal;
+                hit.triangle = triangleIds[index];
+                return true;
+            }
+        }
+
+        bool found = false;
+        float best = tMax;
+        for (int e = 0; e < 3; e++)
+        {
+            const glm::vec3& p = corners[e];
+            glm::vec3 edge = corners[(e + 1) % 3] - p, offset = center - p;
+            float ee = glm::dot(edge, edge), ed = glm::dot(edge, direction), eo = glm::dot(edge, offset);
+            float a = ee - ed * ed;
+            if (a < 1e-12f * ee)
+                continue; // parallel to the edge, the corners catch it
+            float b = ee * glm::dot(offset, direction) - eo * ed;
+            float c = ee * glm::dot(offset, offset) - eo * eo - radius * radius * ee;
+            float discriminant = b * b - a * c;
+            if (discriminant < 0.0f)
+                continue;
+            float t = (-b - std::sqrt(discriminant)) / a;
+            float s = (eo + t * ed) / ee;
+            if (t < 0.0f || t >= best || s < 0.0f || s > 1.0f)
+                continue;
+            found = true;
+            best = t;
+            hit.point = p + edge * s;
+        }
+        for (int v = 0; v < 3; v++)
+        {
+            glm::vec3 offset = center - corners[v];
+            float b = glm::dot(offset, direction);
+            float discriminant = b * b - (glm::dot(offset, offset) - radius * radius);
+            if (discriminant < 0.0f)
+                continue;
+            float t = -b - std::sqrt(discriminant);
+            if (t < 0.0f || t >= best)
+                continue;
+            found = true;
+            best = t;
+            hit.point = corners[v];
+        }
+        if (!found)
+            return false;
+        hit.t = best;
+        hit.normal = glm::normalize(center + direction * best - hit.point);
+        hit.triangle = triangleIds[index];
+        return true;
+    }
+
+    // separating axis test (Akenine-Moller): the box axes, the triangle's normal and the nine edge cross products
+    bool triangleOverlapsBox(int index, const glm::vec3& boxCenter, const glm::vec3& halfSize) const
+    {
+        const Triangle& tri = triangles[index];
+        glm::vec3 v[3] = { tri.v0 - boxCenter, tri.v0 + tri.e1 - boxCenter, tri.v0 + tri.e2 - boxCenter };
+        glm::vec3 edges[3] = { v[1] - v[0], v[2] - v[1], v[0] - v[2] };
+        glm::vec3 axes[13];
+        int axisCount = 0;
+        for (int i = 0; i < 3; i++)
+        {
+            glm::vec3 boxAxis(0.0f);
+            boxAxis[i] = 1.0f;
+            axes[axisCount++] = boxAxis;
+            for (int e = 0; e < 3; e++)
+                axes[axisCount++] = glm::cross(boxAxis, edges[e]);
+        }
+        axes[axisCount++] = glm::cross(tri.e1, tri.e2);
+        for (int i = 0; i < axisCount; i++)
+        {
+            const glm::vec3& axis = axes[i];
+            float p0 = glm::dot(v[0], axis), p1 = glm::dot(v[1], axis), p2 = glm::dot(v[2], axis);
+            float r = halfSize.x * std::abs(axis.x) + halfSize.y * std::abs(axis.y) + halfSize.z * std::abs(axis.z);
+            if (std::min(p0, std::min(p1, p2)) > r || std::max(p0, std::max(p1, p2)) < -r)
+                return false;
+        }
+        return true;
+    }
+
+    // Front to back walk over the leaves whose boxes, grown by `expand` on every side, the ray enters before
+    // `closest`. leaf(first, count, closest) tests a run of triangles, may lower closest, and returns true to end
+    // the walk.
+    template <class LeafTest>
+    void walkRay(const glm::vec3& origin, const glm::vec3& direction, float expand, float& closest, LeafTest leaf) const
+    {
+        if (nodes.empty())
+            return;
+        glm::vec3 inv;
+        for (int i = 0; i < 3; i++)
+            inv[i] = 1.0f / (std::abs(direction[i]) > 1e-20f ? direction[i] : (direction[i] < 0.0f ? -1e-20f : 1e-20f));
+
+        const __m128 ox = _mm_set1_ps(origin.x), oy = _mm_set1_ps(origin.y), oz = _mm_set1_ps(origin.z);
+        const __m128 ix = _mm_set1_ps(inv.x), iy = _mm_set1_ps(inv.y), iz = _mm_set1_ps(inv.z);
+        const __m128 grow = _mm_set1_ps(expand);
+        const bool negX = inv.x < 0.0f, negY = inv.y < 0.0f, negZ = inv.z < 0.0f;
+
+        NodeStack stack(3 * maxDepth + 4);
+        stack.push(0);
+        while (!stack.empty())
+        {
+            const Node4& node = nodes[stack.pop()];
+            // slab test against the four child boxes at once
+            __m128 minX = _mm_sub_ps(_mm_loadu_ps(node.minX), grow), maxX = _mm_add_ps(_mm_loadu_ps(node.maxX), grow);
+            __m128 minY = _mm_sub_ps(_mm_loadu_ps(node.minY), grow), maxY = _mm_add_ps(_mm_loadu_ps(node.maxY), grow);
+            __m128 minZ = _mm_sub_ps(_mm_loadu_ps(node.minZ), grow), maxZ = _mm_add_ps(_mm_loadu_ps(node.maxZ), grow);
+            __m128 loX = negX ? maxX : minX, hiX = negX ? minX : maxX;
+            __m128 loY = negY ? maxY : minY, hiY = negY ? minY : maxY;
+            __m128 loZ = negZ ? maxZ : minZ, hiZ = negZ ? minZ : maxZ;
+            __m128 tNear = _mm_max_ps(_mm_max_ps(_mm_mul_ps(_mm_sub_ps(loX, ox), ix), _mm_mul_ps(_mm_sub_ps(loY, oy), iy)),
+                _mm_max_ps(_mm_mul_ps(_mm_sub_ps(loZ, oz), iz), _mm_setzero_ps()));
+            __m128 tFar = _mm_min_ps(_mm_min_ps(_mm_mul_ps(_mm_sub_ps(hiX, ox), ix), _mm_mul_ps(_mm_sub_ps(hiY, oy), iy)),
+                _mm_min_ps(_mm_mul_ps(_mm_sub_ps(hiZ, oz), iz), _mm_set1_ps(closest)));
+            int mask = _mm_movemask_ps(_mm_cmple_ps(tNear, tFar));
+            if (!mask)
+                continue;
+
+            float nearDistances[4];
+            _mm_storeu_ps(nearDistances, tNear);
+            // visit the nearest children first: push them last
+            int order[4];
+            int orderCount = 0;
+            for (int i = 0; i < 4; i++)
+                if ((mask & (1 << i)) && node.count[i] >= 0)
+                    order[orderCount++] = i;
+            for (int a = 1; a < orderCount; a++)
+                for (int b = a; b > 0 && nearDistances[order[b]] > nearDistances[order[b - 1]]; b--)
+                    std::swap(order[b], order[b - 1]);
+
+            for (int o = 0; o < orderCount; o++)
+            {
+                int i = order[o];
+                if (node.count[i] == 0)
+                {
+                    stack.push(node.child[i]);
+                    continue;
+                }
+                if (leaf(node.child[i], node.count[i], closest))
+                    return;
+            }
+        }
+    }
+
+    bool traverse(const glm::vec3& origin, const glm::vec3& direction, float tMax, Hit& hit, bool anyHit) const
+    {
+        bool found = false;
+        float closest = tMax;
+        walkRay(origin, direction, 0.0f, closest, [&](int first, int count, float& limit) {
+            for (int t = first; t < first + count; t++)
+            {
+                if (intersectTriangle(t, origin, direction, limit, hit))
+                {
+                    found = true;
+                    limit = hit.t;
+                    if (anyHit)
+                        return true;
+                }
+            }
+            return false;
+        });
+        return found;
+    }
+};
+#endif
@@ -0,0 +1,298 @@
+#ifndef CLUSTERED_LIGHTING_H
+#define CLUSTERED_LIGHTING_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "gl_handles.h"
+#include "shader.h"
+
+#include <emmintrin.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+struct PointLight {
+    glm::vec3 position;
+    // distance at which the light's contribution reaches zero
+    float radius;
+    glm::vec3 color;
+    float intensity;
+};
+
+struct ClusterGridSettings {
+    // screen tiles and exponential depth slices between nearPlane and farPlane
+    int tilesX = 16;
+    int tilesY = 9;
+    int slicesZ = 24;
+    float nearPlane = 0.1f;
+    float farPlane = 100.0f;
+    // lights beyond this many in one cluster are dropped
+    int maxLightsPerCluster = 128;
+};
+
+// Result of binning the lights of one frame, laid out exactly as it is uploaded to the texture buffers.
+struct ClusteredLightList {
+    // two texels per light: (position, radius) and (color * intensity, 0)
+    std::vector<glm::vec4> lights;
+    // per cluster: offset into lightIndices and number of lights
+    std::vector<uint32_t> clusterRanges;
+    std::vector<uint32_t> lightIndices;
+
+    int lightCount() const { return (int)(lights.size() / 2); }
+};
+
+// Splits the view frustum into clusters and bins point lights into them on the CPU.
+// Candidate clusters of a light are found from its projected bounds, then tested exactly against the
+// cluster boxes four at a time with SSE, so the cost grows with the lights' screen coverage rather than
+// with lights * clusters.
+class LightClusterer
+{
+public:
+    LightClusterer(const ClusterGridSettings& gridSettings = ClusterGridSettings()) : settings(gridSettings), boundsProjection(0.0f)
+    {
+        // pad every row of tiles to a multiple of four so the SSE loop never runs off a row
+        rowStride = (settings.tilesX + 3) & ~3;
+        int padded = rowStride * settings.tilesY * settings.slicesZ;
+        for (int i = 0; i < 6; i++)
+            bounds[i].assign(padded, 0.0f);
+    }
+
+    const ClusterGridSettings& grid() const { return settings; }
+    int clusterCount() const { return settings.tilesX * settings.tilesY * settings.slicesZ; }
+
+    // slice = log(depth) * zScale + zBias, as evaluated by the fragment shader
+    float zScale() const { return settings.slicesZ / std::log(settings.farPlane / settings.nearPlane); }
+    float zBias() const { return -settings.slicesZ * std::log(settings.nearPlane) / std::log(settings.farPlane / settings.nearPlane); }
+
+    void build(const std::vector<PointLight>& sceneLights, const glm::mat4& view, const glm::mat4& projection, ClusteredLightList& out)
+    {
+        if (projection != boundsProjection)
+            rebuildClusterBounds(projection);
+
+        out.lights.resize(sceneLights.size() * 2);
+        for (size_t i = 0; i < sceneLights.size(); i++)
+        {
+            out.lights[i * 2] = glm::vec4(sceneLights[i].position, sceneLights[i].radius);
+            out.lights[i * 2 + 1] = glm::vec4(sceneLights[i].color * sceneLights[i].intensity, 0.0f);
+        }
+
+        // 1. find (cluster, light) pairs
+        hits.clear();
+        float P00 = projection[0][0];
+        float P11 = projection[1][1];
+        float sliceScale = zScale();
+        float sliceBias = zBias();
+        for (size_t lightIndex = 0; lightIndex < sceneLights.size(); lightIndex++)
+        {
+            const PointLight& light = sceneLights[lightIndex];
+            glm::vec3 center = glm::vec3(view * glm::vec4(light.position, 1.0f));
+            float r = light.radius;
+            float depthMin = -center.z - r;
+            float depthMax = -center.z + r;
+            if (depthMax < settings.nearPlane || depthMin > settings.farPlane)
+                continue;
+
+            int k0 = sliceOf(std::max(depthMin, settings.nearPlane), sliceScale, sliceBias);
+            int k1 = sliceOf(std::min(depthMax, settings.farPlane), sliceScale, sliceBias);
+
+            int i0 = 0, i1 = settings.tilesX - 1, j0 = 0, j1 = settings.tilesY - 1;
+            if (depthMin > settings.nearPlane)
+            {
+                // conservative screen bounds: extremes of x/depth over the corners of the sphere's box
+                float xs[2] = { center.x - r, center.x + r };
+                float ys[2] = { center.y - r, center.y + r };
+                float ds[2] = { depthMin, depthMax };
+                float xMin = 1e30f, xMax = -1e30f, yMin = 1e30f, yMax = -1e30f;
+                for (int a = 0; a < 2; a++)
+                    for (int b = 0; b < 2; b++)
+                    {
+                        xMin = std::min(xMin, P00 * xs[a] / ds[b]);
+                        xMax = std::max(xMax, P00 * xs[a] / ds[b]);
+                        yMin = std::min(yMin, P11 * ys[a] / ds[b]);
+                        yMax = std::max(yMax, P11 * ys[a] / ds[b]);
+                    }
+                if (xMax < -1.0f || xMin > 1.0f || yMax < -1.0f || yMin > 1.0f)
+                    continue;
+                i0 = tileOf(xMin, settings.tilesX);
+                i1 = tileOf(xMax, settings.tilesX);
+                j0 = tileOf(yMin, settings.tilesY);
+                j1 = tileOf(yMax, settings.tilesY);
+            }
+
+            __m128 cx = _mm_set1_ps(center.x), cy = _mm_set1_ps(center.y), cz = _mm_set1_ps(center.z);
+            __m128 radiusSq = _mm_set1_ps(r * r);
+            __m128 zero = _mm_setzero_ps();
+            int first = i0 & ~3;
+            for (int k = k0; k <= k1; k++)
+                for (int j = j0; j <= j1; j++)
+                {
+                    int row = (k * settings.tilesY + j) * rowStride;
+                    for (int i = first; i <= i1; i += 4)
+                    {
+                        // squared distance from the sphere center to four cluster boxes
+                        int c = row + i;
+                        __m128 dx = _mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&bounds[0][c]), cx), _mm_sub_ps(cx, _mm_loadu_ps(&bounds[3][c])));
+                        __m128 dy = _mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&bounds[1][c]), cy), _mm_sub_ps(cy, _mm_loadu_ps(&bounds[4][c])));
+                        __m128 dz = _mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&bounds[2][c]), cz), _mm_sub_ps(cz, _mm_loadu_ps(&bounds[5][c])));
+                        dx = _mm_max_ps(dx, zero);
+                        dy = _mm_max_ps(dy, zero);
+                        dz = _mm_max_ps(dz, zero);
+                        __m128 distSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+                        int mask = _mm_movemask_ps(_mm_cmple_ps(distSq, radiusSq));
+                        for (int lane = 0; lane < 4; lane++)
+                        {
+                            int tile = i + lane;
+                            if ((mask & (1 << lane)) && tile >= i0 && tile <= i1)
+                                hits.push_back(LightHit{ (uint32_t)((k * settings.tilesY + j) * settings.tilesX + tile), (uint32_t)lightIndex });
+                        }
+                    }
+                }
+        }
+
+        // 2. counting sort of the pairs by cluster into contiguous per-cluster lists
+        int clusters = clusterCount();
+        out.clusterRanges.assign(clusters * 2, 0);
+        for (const LightHit& hit : hits)
+            out.clusterRanges[hit.cluster * 2 + 1]++;
+        uint32_t offset = 0;
+        for (int c = 0; c < clusters; c++)
+        {
+            uint32_t count = std::min(out.clusterRanges[c * 2 + 1], (uint32_t)settings.maxLightsPerCluster);
+            out.clusterRanges[c * 2] = offset;
+            out.clusterRanges[c * 2 + 1] = 0;
+            offset += count;
+        }
+        out.lightIndices.resize(std::max(offset, 1u));
+        for (const LightHit& hit : hits)
+        {
+            uint32_t& count = out.clusterRanges[hit.cluster * 2 + 1];
+            if (count < (uint32_t)settings.maxLightsPerCluster)
+                out.lightIndices[out.clusterRanges[hit.cluster * 2] + count++] = hit.light;
+        }
+    }
+
+private:
+    struct LightHit {
+        uint32_t cluster;
+        uint32_t light;
+    };
+
+    ClusterGridSettings settings;
+    glm::mat4 boundsProjection;
+    int rowStride;
+    // view space boxes of the clusters in structure-of-arrays form: min x/y/z, max x/y/z
+    std::vector<float> bounds[6];
+    std::vector<LightHit> hits;
+
+    static int clampInt(int value, int low, int high) { return std::max(low, std::min(high, value)); }
+
+    int sliceOf(float depth, float sliceScale, float sliceBias) const
+    {
+        return clampInt((int)std::floor(std::log(depth) * sliceScale + sliceBias), 0, settings.slicesZ - 1);
+    }
+
+    static int tileOf(float ndc, int tiles)
+    {
+        return clampInt((int)std::floor((ndc * 0.5f + 0.5f) * tiles), 0, tiles - 1);
+    }
+
+    void rebuildClusterBounds(const glm::mat4& projection)
+    {
+        boundsProjection = projection;
+        float P00 = projection[0][0];
+        float P11 = projection[1][1];
+        for (int k = 0; k < settings.slicesZ; k++)
+        {
+            float depthNear = settings.nearPlane * std::pow(settings.farPlane / settings.nearPlane, (float)k / settings.slicesZ);
+            float depthFar = settings.nearPlane * std::pow(settings.farPlane / settings.nearPlane, (float)(k + 1) / settings.slicesZ);
+            for (int j = 0; j < settings.tilesY; j++)
+                for (int i = 0; i < rowStride; i++)
+                {
+                    int c = (k * settings.tilesY + j) * rowStride + i;
+                    if (i >= settings.tilesX)
+                    {
+                        // padding lanes never intersect anything
+                        bounds[0][c] = bounds[1][c] = bounds[2][c] = 1e30f;
+                        bounds[3][c] = bounds[4][c] = bounds[5][c] = -1e30f;
+                        continue;
+                    }
+                    float x0 = -1.0f + 2.0f * i / settings.tilesX, x1 = -1.0f + 2.0f * (i + 1) / settings.tilesX;
+                    float y0 = -1.0f + 2.0f * j / settings.tilesY, y1 = -1.0f + 2.0f * (j + 1) / settings.tilesY;
+                    // the tile's side planes pass through the eye, so the box spans both depth ends
+                    bounds[0][c] = std::min(std::min(x0 * depthNear, x0 * depthFar), std::min(x1 * depthNear, x1 * depthFar)) / P00;
+                    bounds[3][c] = std::max(std::max(x0 * depthNear, x0 * depthFar), std::max(x1 * depthNear, x1 * depthFar)) / P00;
+                    bounds[1][c] = std::min(std::min(y0 * depthNear, y0 * depthFar), std::min(y1 * depthNear, y1 * depthFar)) / P11;
+                    bounds[4][c] = std::max(std::max(y0 * depthNear, y0 * depthFar), std::max(y1 * depthNear, y1 * depthFar)) / P11;
+                    bounds[2][c] = -depthFar;
+                    bounds[5][c] = -depthNear;
+                }
+        }
+    }
+};
+
+// Texture buffers holding a ClusteredLightList on the GPU. GL 3.3 has no storage buffers, texture buffers
+// give the fragment shader the same indexed access.
+class ClusteredLightBuffers
+{
+public:
+    void upload(const ClusteredLightList& list)
+    {
+        if (buffers[0] == 0)
+            create();
+        // orphan and refill, the driver hands out fresh storage while the previous frame may still read the old one
+        fill(0, list.lights.size() * sizeof(glm::vec4), list.lights.empty() ? NULL : &list.lights[0]);
+        fill(1, list.clusterRanges.size() * sizeof(uint32_t), list.clusterRanges.empty() ? NULL : &list.clusterRanges[0]);
+        fill(2, list.lightIndices.size() * sizeof(uint32_t), list.lightIndices.empty() ? NULL : &list.lightIndices[0]);
+    }
+
+    // binds the buffers to the given texture units and sets the grid uniforms
+    void bind(Shader& shader, const LightClusterer& clusterer, int firstUnit, int renderWidth, int renderHeight)
+    {
+        const char* samplers[3] = { "clusterLights", "clusterRanges", "clusterLightIndices" };
+        for (int i = 0; i < 3; i++)
+        {
+            glActiveTexture(GL_TEXTURE0 + firstUnit + i);
+            glBindTexture(GL_TEXTURE_BUFFER, textures[i]);
+            shader.setInt(samplers[i], firstUnit + i);
+        }
+        glActiveTexture(GL_TEXTURE0);
+        const ClusterGridSettings& grid = clusterer.grid();
+        glUniform3i(glGetUniformLocation(shader.ID, "clusterDims"), grid.tilesX, grid.tilesY, grid.slicesZ);
+        shader.setFloat("clusterZScale", clusterer.zScale());
+        shader.setFloat("clusterZBias", clusterer.zBias());
+        shader.setVec2("clusterRenderSize", (float)renderWidth, (float)renderHeight);
+    }
+
+private:
+    GlBuffer buffers[3];
+    GlTexture textures[3];
+
+    void create()
+    {
+        const GLenum formats[3] = { GL_RGBA32F, GL_RG32UI, GL_R32UI };
+        for (int i = 0; i < 3; i++)
+        {
+            buffers[i] = GlBuffer::create();
+            textures[i] = GlTexture::create();
+            glBindBuffer(GL_TEXTURE_BUFFER, buffers[i]);
+            glBufferData(GL_TEXTURE_BUFFER, 16, NULL, GL_STREAM_DRAW);
+            glBindTexture(GL_TEXTURE_BUFFER, textures[i]);
+            glTexBuffer(GL_TEXTURE_BUFFER, formats[i], buffers[i]);
+        }
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    }
+
+    void fill(int index, size_t bytes, const void* data)
+    {
+        glBindBuffer(GL_TEXTURE_BUFFER, buffers[index]);
+        glBufferData(GL_TEXTURE_BUFFER, std::max(bytes, (size_t)16), NULL, GL_STREAM_DRAW);
+        if (data)
+            glBufferSubData(GL_TEXTURE_BUFFER, 0, bytes, data);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    }
+};
+#endif
@@ -0,0 +1,12 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D screenTexture;
+uniform vec2 uvMax;
+
+void main()
+{
+    FragColor = vec4(texture(screenTexture, min(TexCoords, uvMax)).rgb, 1.0);
+}
\ No newline at end of file
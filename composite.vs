@@ -0,0 +1,12 @@
+#version 330 core
+out vec2 TexCoords;
+
+uniform vec2 uvScale;
+
+void main()
+{
+    // full screen triangle generated from the vertex id, no vertex buffer needed
+    vec2 corner = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    TexCoords = corner * uvScale;
+    gl_Position = vec4(corner * 2.0 - 1.0, 0.0, 1.0);
+}
\ No newline at end of file
@@ -0,0 +1,35 @@
+#ifndef CPU_FEATURES_H
+#define CPU_FEATURES_H
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// compiles a function for AVX2 and FMA, whatever the rest of the build targets; only call it when
+// cpuHasAvx2() says the machine has them
+#ifdef _MSC_VER
+#define TARGET_AVX2
+#else
+#define TARGET_AVX2 __attribute__((target("avx2,fma")))
+#endif
+
+inline bool cpuHasAvx2()
+{
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+        return false;
+    __cpuid(info, 1);
+    bool fma = (info[2] & (1 << 12)) != 0;
+    // the OS has to save the AVX registers too
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    if (!fma || !osxsave || (_xgetbv(0) & 6) != 6)
+        return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+}
+#endif
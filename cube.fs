@@ -7,9 +7,45 @@ in vec3 Position;
 uniform vec3 cameraPos;
 uniform samplerCube skybox;
 
+// prefiltered environment (see environment_map.h): mip level roughness * maxLod holds the sky convolved with a GGX
+// lobe of that roughness, environmentSH the sky's irradiance
+uniform bool prefiltered;
+uniform float maxLod;
+uniform vec3 environmentSH[9];
+uniform float roughness;
+uniform float metallic;
+uniform vec3 baseColor;
+
+vec3 irradiance(vec3 n)
+{
+    vec3 result = environmentSH[0] * 0.282095
+        + environmentSH[1] * 0.488603 * n.y
+        + environmentSH[2] * 0.488603 * n.z
+        + environmentSH[3] * 0.488603 * n.x
+        + environmentSH[4] * 1.092548 * n.x * n.y
+        + environmentSH[5] * 1.092548 * n.y * n.z
+        + environmentSH[6] * 0.315392 * (3.0 * n.z * n.z - 1.0)
+        + environmentSH[7] * 1.092548 * n.x * n.z
+        + environmentSH[8] * 0.546274 * (n.x * n.x - n.y * n.y);
+    return max(result, vec3(0.0));
+}
+
 void main()
 {             
     vec3 I = normalize(Position - cameraPos);
-    vec3 R = reflect(I, normalize(Normal));
-    FragColor = vec4(texture(skybox, R).rgb, 1.0);
+    vec3 N = normalize(Normal);
+    vec3 R = reflect(I, N);
+    if (!prefiltered)
+    {
+        FragColor = vec4(texture(skybox, R).rgb, 1.0);
+        return;
+    }
+
+    // rough reflection: Schlick fresnel with the roughness-aware horizon term, diffuse from the SH irradiance
+    vec3 F0 = mix(vec3(0.04), baseColor, metallic);
+    float NdotV = max(dot(N, -I), 0.0);
+    vec3 F = F0 + (max(vec3(1.0 - roughness), F0) - F0) * pow(1.0 - NdotV, 5.0);
+    vec3 specular = textureLod(skybox, R, roughness * maxLod).rgb * F;
+    vec3 diffuse = baseColor * (1.0 - metallic) * (1.0 - F) * irradiance(N);
+    FragColor = vec4(diffuse + specular, 1.0);
 }
\ No newline at end of file
@@ -6,12 +6,13 @@ out vec3 Normal;
 out vec3 Position;
 
 uniform mat4 model;
+uniform mat3 normalMatrix;
 uniform mat4 view;
 uniform mat4 projection;
 
 void main()
 {
-    Normal = mat3(transpose(inverse(model))) * aNormal;
+    Normal = normalMatrix * aNormal;
     Position = vec3(model * vec4(aPos, 1.0));
     gl_Position = projection * view * vec4(Position, 1.0);
 }
\ No newline at end of file
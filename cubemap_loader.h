@@ -0,0 +1,297 @@
+#ifndef CUBEMAP_LOADER_H
+#define CUBEMAP_LOADER_H
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+#include <stb_image.h>
+
+#include "gl_handles.h"
+
+#include <emmintrin.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Decoded cube map faces in GL order (+X, -X, +Y, -Y, +Z, -Z), rows as GL reads them. LDR images keep their 8 bit
+// texels with 3 or 4 channels, HDR ones are RGB floats.
+struct CubemapImage {
+    static const int FACES = 6;
+
+    int size = 0;
+    int channels = 0;
+    bool hdr = false;
+    std::vector<unsigned char> ldrTexels[FACES];
+    std::vector<float> hdrTexels[FACES];
+
+    bool empty() const { return size == 0; }
+
+    glm::vec3 texel(int face, int x, int y) const
+    {
+        size_t i = ((size_t)y * size + x) * channels;
+        if (hdr)
+            return glm::vec3(hdrTexels[face][i], hdrTexels[face][i + 1], hdrTexels[face][i + 2]);
+        const unsigned char* t = &ldrTexels[face][i];
+        return glm::vec3(t[0], t[1], t[2]) * (1.0f / 255.0f);
+    }
+};
+
+// Loads skyboxes off the critical path of startup: six face images are decoded on one thread each, and a single
+// equirectangular panorama (8 bit or Radiance .hdr) is resampled to six faces with rows shared out to all cores,
+// four texels at a time with SSE.
+class CubemapLoader
+{
+public:
+    CubemapLoader(int threadCount = 0) : threads(threadCount > 0 ? threadCount : (int)std::max(1u, std::thread::hardware_concurrency())) {}
+
+    // six paths are faces in GL order, a single path is an equirectangular panorama
+    CubemapImage load(const std::vector<std::string>& paths, int faceSize = 0) const
+    {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        CubemapImage image;
+        if (paths.size() == CubemapImage::FACES)
+            image = loadFaces(paths);
+        else if (paths.size() == 1)
+            image = loadEquirectangular(paths[0], faceSize);
+        else
+            std::cout << "ERROR::CUBEMAP::NEEDS_SIX_FACES_OR_ONE_PANORAMA" << std::endl;
+        if (!image.empty())
+        {
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            std::cout << "CUBEMAP::LOAD:: " << image.size << "^2 " << (image.hdr ? "HDR" : "LDR") << " faces from " << paths[0]
+                << (paths.size() == 1 ? " (equirectangular)" : "") << " in " << ms << " ms" << std::endl;
+        }
+        return image;
+    }
+
+    // one immutable allocation through glTexStorage2D when the driver has it (GL 4.2 or ARB_texture_storage),
+    // otherwise the six faces are specified one by one; an empty image gives an empty handle
+    static GlTexture upload(const CubemapImage& image)
+    {
+        if (image.empty())
+            return GlTexture();
+        GLenum internalFormat = image.hdr ? GL_RGB16F : (image.channels == 4 ? GL_RGBA8 : GL_RGB8);
+        GLenum format = image.channels == 4 ? GL_RGBA : GL_RGB;
+        GLenum type = image.hdr ? GL_FLOAT : GL_UNSIGNED_BYTE;
+
+        GlTexture texture = GlTexture::create();
+        glBindTexture(GL_TEXTURE_CUBE_MAP, texture);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        TexStorage2DProc texStorage2D = textureStorage();
+        if (texStorage2D)
+            texStorage2D(GL_TEXTURE_CUBE_MAP, 1, internalFormat, image.size, image.size);
+        for (int face = 0; face < CubemapImage::FACES; face++)
+        {
+            const void* data = image.hdr ? (const void*)&image.hdrTexels[face][0] : (const void*)&image.ldrTexels[face][0];
+            if (texStorage2D)
+                glTexSubImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, 0, 0, 0, image.size, image.size, format, type, data);
+            else
+                glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, 0, internalFormat, image.size, image.size, 0, format, type, data);
+        }
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LEVEL, 0);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+        return texture;
+    }
+
+private:
+    typedef void (APIENTRYP TexStorage2DProc)(GLenum target, GLsizei levels, GLenum internalformat, GLsizei width, GLsizei height);
+
+    int threads;
+
+    // glad is generated for 3.3 core, so the 4.2 entry point is looked up by hand
+    static TexStorage2DProc textureStorage()
+    {
+        bool supported = GLVersion.major > 4 || (GLVersion.major == 4 && GLVersion.minor >= 2) || glfwExtensionSupported("GL_ARB_texture_storage");
+        return supported ? (TexStorage2DProc)glfwGetProcAddress("glTexStorage2D") : NULL;
+    }
+
+    CubemapImage loadFaces(const std::vector<std::string>& faces) const
+    {
+        // every face gets the channel count of the first so they share one texture format
+        CubemapImage image;
+        int width, height, components;
+        if (!stbi_info(faces[0].c_str(), &width, &height, &components))
+        {
+            std::cout << "Cubemap texture failed to load at path: " << faces[0] << std::endl;
+            return image;
+        }
+        image.hdr = stbi_is_hdr(faces[0].c_str()) != 0;
+        image.channels = image.hdr ? 3 : (components == 2 || components == 4 ? 4 : 3);
+        image.size = width;
+
+        std::atomic<bool> failed(false);
+        std::vector<std::thread> workers;
+        for (int face = 0; face < CubemapImage::FACES; face++)
+        {
+            workers.push_back(std::thread([&, face]() {
+                int faceWidth, faceHeight, faceComponents;
+                void* data = image.hdr ? (void*)stbi_loadf(faces[face].c_str(), &faceWidth, &faceHeight, &faceComponents, image.channels)
+                    : (void*)stbi_load(faces[face].c_str(), &faceWidth, &faceHeight, &faceComponents, image.channels);
+                if (!data || faceWidth != image.size || faceHeight != image.size)
+                {
+                    std::cout << "Cubemap texture failed to load at path: " << faces[face] << std::endl;
+                    failed = true;
+                }
+                else
+                {
+                    size_t count = (size_t)image.size * image.size * image.channels;
+                    if (image.hdr)
+                        image.hdrTexels[face].assign((const float*)data, (const float*)data + count);
+                    else
+                        image.ldrTexels[face].assign((const unsigned char*)data, (const unsigned char*)data + count);
+                }
+                stbi_image_free(data);
+            }));
+        }
+        for (std::thread& worker : workers)
+            worker.join();
+        return failed ? CubemapImage() : image;
+    }
+
+    CubemapImage loadEquirectangular(const std::string& path, int faceSize) const
+    {
+        CubemapImage image;
+        int width, height, components;
+        bool hdr = stbi_is_hdr(path.c_str()) != 0;
+        std::vector<float> panorama;
+        if (hdr)
+        {
+            float* data = stbi_loadf(path.c_str(), &width, &height, &components, 3);
+            if (data)
+                panorama.assign(data, data + (size_t)width * height * 3);
+            stbi_image_free(data);
+        }
+        else
+        {
+            unsigned char* data = stbi_load(path.c_str(), &width, &height, &components, 3);
+            if (data)
+            {
+                panorama.resize((size_t)width * height * 3);
+                for (size_t i = 0; i < panorama.size(); i++)
+                    panorama[i] = data[i] * (1.0f / 255.0f);
+            }
+            stbi_image_free(data);
+        }
+        if (panorama.empty())
+        {
+            std::cout << "Cubemap texture failed to load at path: " << path << std::endl;
+            return image;
+        }
+
+        // a quarter of the panorama's width keeps the texel density around the horizon
+        image.size = faceSize > 0 ? faceSize : std::max(1, width / 4);
+        image.channels = 3;
+        image.hdr = hdr;
+        for (int face = 0; face < CubemapImage::FACES; face++)
+        {
+            if (hdr)
+                image.hdrTexels[face].resize((size_t)image.size * image.size * 3);
+            else
+                image.ldrTexels[face].resize((size_t)image.size * image.size * 3);
+        }
+
+        std::atomic<int> nextRow(0);
+        int rowCount = CubemapImage::FACES * image.size;
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; t++)
+        {
+            workers.push_back(std::thread([&]() {
+                for (int row = nextRow++; row < rowCount; row = nextRow++)
+                    resampleRow(panorama, width, height, row / image.size, row % image.size, image);
+            }));
+        }
+        for (std::thread& worker : workers)
+            worker.join();
+        return image;
+    }
+
+    // atan2 for four lanes, a minimax polynomial good to about 1e-5 radians, far below a texel of any panorama
+    static __m128 atan2Approx(__m128 y, __m128 x)
+    {
+        const __m128 signMask = _mm_set1_ps(-0.0f);
+        __m128 ax = _mm_andnot_ps(signMask, x), ay = _mm_andnot_ps(signMask, y);
+        __m128 a = _mm_div_ps(_mm_min_ps(ax, ay), _mm_max_ps(_mm_max_ps(ax, ay), _mm_set1_ps(1e-30f)));
+        __m128 s = _mm_mul_ps(a, a);
+        __m128 r = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(-0.0464964749f), s), _mm_set1_ps(0.15931422f));
+        r = _mm_sub_ps(_mm_mul_ps(r, s), _mm_set1_ps(0.327622764f));
+        r = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(r, s), a), a);
+        __m128 steep = _mm_cmpgt_ps(ay, ax);
+        r = _mm_or_ps(_mm_and_ps(steep, _mm_sub_ps(_mm_set1_ps(1.57079637f), r)), _mm_andnot_ps(steep, r));
+        __m128 left = _mm_cmplt_ps(x, _mm_setzero_ps());
+        r = _mm_or_ps(_mm_and_ps(left, _mm_sub_ps(_mm_set1_ps(3.14159274f), r)), _mm_andnot_ps(left, r));
+        return _mm_or_ps(r, _mm_and_ps(signMask, y));
+    }
+
+    // one row of a face: directions through four texel centers at a time, mapped to panorama coordinates with
+    // u = 0.5 + atan2(z, x) / 2pi and v = 0.5 - asin(y) / pi (row 0 is straight up), then filtered bilinearly
+    static void resampleRow(const std::vector<float>& panorama, int width, int height, int face, int y, CubemapImage& image)
+    {
+        int size = image.size;
+        float v = 2.0f * (y + 0.5f) / size - 1.0f;
+        const __m128 inversePi = _mm_set1_ps(0.318309886f);
+        for (int x = 0; x < size; x += 4)
+        {
+            __m128 u = _mm_sub_ps(_mm_mul_ps(_mm_add_ps(_mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f), _mm_set1_ps((float)x)), _mm_set1_ps(2.0f / size)), _mm_set1_ps(1.0f));
+            __m128 one = _mm_set1_ps(1.0f), minusOne = _mm_set1_ps(-1.0f), vs = _mm_set1_ps(v), negU = _mm_sub_ps(_mm_setzero_ps(), u);
+            __m128 dx, dy, dz;
+            switch (face)
+            {
+            case 0: dx = one; dy = _mm_sub_ps(_mm_setzero_ps(), vs); dz = negU; break;
+            case 1: dx = minusOne; dy = _mm_sub_ps(_mm_setzero_ps(), vs); dz = u; break;
+            case 2: dx = u; dy = one; dz = vs; break;
+            case 3: dx = u; dy = minusOne; dz = _mm_sub_ps(_mm_setzero_ps(), vs); break;
+            case 4: dx = u; dy = _mm_sub_ps(_mm_setzero_ps(), vs); dz = one; break;
+            default: dx = negU; dy = _mm_sub_ps(_mm_setzero_ps(), vs); dz = minusOne; break;
+            }
+            __m128 horizontal = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dz, dz)));
+            __m128 longitude = _mm_add_ps(_mm_set1_ps(0.5f), _mm_mul_ps(atan2Approx(dz, dx), _mm_mul_ps(inversePi, _mm_set1_ps(0.5f))));
+            __m128 latitude = _mm_sub_ps(_mm_set1_ps(0.5f), _mm_mul_ps(atan2Approx(dy, horizontal), inversePi));
+            float px[4], py[4];
+            _mm_storeu_ps(px, _mm_sub_ps(_mm_mul_ps(longitude, _mm_set1_ps((float)width)), _mm_set1_ps(0.5f)));
+            _mm_storeu_ps(py, _mm_sub_ps(_mm_mul_ps(latitude, _mm_set1_ps((float)height)), _mm_set1_ps(0.5f)));
+
+            for (int lane = 0; lane < 4 && x + lane < size; lane++)
+            {
+                glm::vec3 color = bilinear(panorama, width, height, px[lane], py[lane]);
+                size_t i = ((size_t)y * size + x + lane) * 3;
+                for (int c = 0; c < 3; c++)
+                {
+                    if (image.hdr)
+                        image.hdrTexels[face][i + c] = color[c];
+                    else
+                        image.ldrTexels[face][i + c] = (unsigned char)std::min(255.0f, color[c] * 255.0f + 0.5f);
+                }
+            }
+        }
+    }
+
+    // longitude wraps around the seam, latitude clamps at the poles
+    static glm::vec3 bilinear(const std::vector<float>& panorama, int width, int height, float x, float y)
+    {
+        float fx = std::floor(x), fy = std::floor(y);
+        float tx = x - fx, ty = y - fy;
+        int x0 = ((int)fx % width + width) % width, x1 = (x0 + 1) % width;
+        int y0 = std::min(std::max((int)fy, 0), height - 1), y1 = std::min(std::max((int)fy + 1, 0), height - 1);
+        const float* a = &panorama[((size_t)y0 * width + x0) * 3];
+        const float* b = &panorama[((size_t)y0 * width + x1) * 3];
+        const float* c = &panorama[((size_t)y1 * width + x0) * 3];
+        const float* d = &panorama[((size_t)y1 * width + x1) * 3];
+        glm::vec3 top = glm::mix(glm::vec3(a[0], a[1], a[2]), glm::vec3(b[0], b[1], b[2]), tx);
+        glm::vec3 bottom = glm::mix(glm::vec3(c[0], c[1], c[2]), glm::vec3(d[0], d[1], d[2]), tx);
+        return glm::mix(top, bottom, ty);
+    }
+};
+#endif
@@ -0,0 +1,188 @@
+#ifndef DYNAMIC_RESOLUTION_H
+#define DYNAMIC_RESOLUTION_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "gl_handles.h"
+#include "shader.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+// Offscreen color/depth target the scene is rendered into at a fraction of the window resolution.
+// Storage is allocated for the largest scale once per window size, changing the scale only changes the viewport.
+class ScalableRenderTarget
+{
+public:
+    GlFramebuffer FBO;
+    GlTexture colorTexture;
+    GlRenderbuffer depthRenderbuffer;
+    // allocated size of the attachments
+    int allocatedWidth;
+    int allocatedHeight;
+    // region rendered into this frame
+    int renderWidth;
+    int renderHeight;
+
+    ScalableRenderTarget() : allocatedWidth(0), allocatedHeight(0), renderWidth(0), renderHeight(0) {}
+
+    // (re)allocates the attachments if the window size or the maximum scale changed
+    void resize(int windowWidth, int windowHeight, float maxScale)
+    {
+        int width = std::max(1, (int)std::ceil(windowWidth * maxScale));
+        int height = std::max(1, (int)std::ceil(windowHeight * maxScale));
+        if (FBO != 0 && width == allocatedWidth && height == allocatedHeight)
+            return;
+
+        // assigning the new objects deletes the old ones
+        FBO = GlFramebuffer::create();
+        glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+
+        colorTexture = GlTexture::create();
+        glBindTexture(GL_TEXTURE_2D, colorTexture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTexture, 0);
+
+        depthRenderbuffer = GlRenderbuffer::create();
+        glBindRenderbuffer(GL_RENDERBUFFER, depthRenderbuffer);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depthRenderbuffer);
+
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "ERROR::FRAMEBUFFER:: scalable render target is not complete" << std::endl;
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+        allocatedWidth = width;
+        allocatedHeight = height;
+    }
+
+    // binds the target and sets the viewport to the scaled window size
+    void bind(int windowWidth, int windowHeight, float scale)
+    {
+        renderWidth = std::max(1, std::min(allocatedWidth, (int)(windowWidth * scale + 0.5f)));
+        renderHeight = std::max(1, std::min(allocatedHeight, (int)(windowHeight * scale + 0.5f)));
+        glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+        glViewport(0, 0, renderWidth, renderHeight);
+    }
+
+    // upscales the rendered region onto the default framebuffer with a full screen triangle
+    void composite(Shader& compositeShader, unsigned int emptyVAO, int windowWidth, int windowHeight)
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glViewport(0, 0, windowWidth, windowHeight);
+        glDisable(GL_DEPTH_TEST);
+
+        compositeShader.use();
+        compositeShader.setVec2("uvScale", (float)renderWidth / allocatedWidth, (float)renderHeight / allocatedHeight);
+        // keep bilinear taps inside the rendered region, the texels beyond it hold stale data from larger scales
+        compositeShader.setVec2("uvMax", (renderWidth - 0.5f) / allocatedWidth, (renderHeight - 0.5f) / allocatedHeight);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, colorTexture);
+        glBindVertexArray(emptyVAO);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        glBindVertexArray(0);
+
+        glEnable(GL_DEPTH_TEST);
+    }
+};
+
+// Measures GPU time with GL_TIME_ELAPSED queries. Results are read a few frames late so the CPU never stalls on them.
+class GpuFrameTimer
+{
+public:
+    static const int QUERY_COUNT = 4;
+
+    GpuFrameTimer() : current(0), started(0), lastMs(0.0) {}
+
+    void begin()
+    {
+        if (queries[0] == 0)
+            for (GlQuery& query : queries)
+                query = GlQuery::create();
+        glBeginQuery(GL_TIME_ELAPSED, queries[current]);
+    }
+
+    void end()
+    {
+        glEndQuery(GL_TIME_ELAPSED);
+        current = (current + 1) % QUERY_COUNT;
+        started = std::min(started + 1, QUERY_COUNT);
+    }
+
+    // returns true if a new measurement became available since the last call
+    bool poll()
+    {
+        if (started < QUERY_COUNT)
+            return false;
+        // the query issued QUERY_COUNT-1 frames ago is the next one to be reused
+        unsigned int oldest = queries[current];
+        GLint available = 0;
+        glGetQueryObjectiv(oldest, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+            return false;
+        GLuint64 elapsed = 0;
+        glGetQueryObjectui64v(oldest, GL_QUERY_RESULT, &elapsed);
+        lastMs = elapsed / 1000000.0;
+        return true;
+    }
+
+    double milliseconds() const { return lastMs; }
+
+private:
+    GlQuery queries[QUERY_COUNT];
+    int current;
+    int started;
+    double lastMs;
+};
+
+struct ResolutionGovernorSettings {
+    // GPU frame time the governor tries to hold, in milliseconds
+    double targetFrameMs = 14.0;
+    float minScale = 0.5f;
+    float maxScale = 1.0f;
+    // only scale back up once the GPU time dropped below this fraction of the target
+    double headroom = 0.85;
+    // largest change of the scale per measurement, keeps the image from pumping
+    float maxStep = 0.05f;
+};
+
+// Adjusts the render scale within the configured bounds to hold the GPU frame time target.
+class ResolutionGovernor
+{
+public:
+    ResolutionGovernor(const ResolutionGovernorSettings& governorSettings = ResolutionGovernorSettings()) : settings(governorSettings), scale(governorSettings.maxScale), smoothedMs(0.0) {}
+
+    // feeds a new GPU frame time measurement and returns the scale to render the next frame at
+    float update(double gpuMs)
+    {
+        // exponential moving average so single spikes don't change the resolution
+        smoothedMs = smoothedMs == 0.0 ? gpuMs : smoothedMs * 0.9 + gpuMs * 0.1;
+
+        // GPU time scales roughly with the pixel count, i.e. the square of the scale
+        float desired = scale;
+        if (smoothedMs > settings.targetFrameMs)
+            desired = scale * (float)std::sqrt(settings.targetFrameMs / smoothedMs);
+        else if (smoothedMs < settings.targetFrameMs * settings.headroom)
+            desired = scale * (float)std::sqrt(settings.targetFrameMs * settings.headroom / smoothedMs);
+
+        desired = std::max(scale - settings.maxStep, std::min(scale + settings.maxStep, desired));
+        scale = std::max(settings.minScale, std::min(settings.maxScale, desired));
+        return scale;
+    }
+
+    float currentScale() const { return scale; }
+    double smoothedFrameMs() const { return smoothedMs; }
+    const ResolutionGovernorSettings& bounds() const { return settings; }
+
+private:
+    ResolutionGovernorSettings settings;
+    float scale;
+    double smoothedMs;
+};
+#endif
@@ -0,0 +1,381 @@
+#ifndef ENVIRONMENT_MAP_H
+#define ENVIRONMENT_MAP_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <emmintrin.h>
+
+#include "gl_handles.h"
+#include "shader.h"
+#include "irradiance_volume.h"
+#include "cubemap_loader.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+struct EnvironmentBakeSettings {
+    // edge of the sharpest (mirror) level, halved for every level down to the roughest
+    int size = 128;
+    int levels = 6;
+    // largest source face the GGX lobes are convolved against; each level uses its own edge up to this
+    int maxSourceSize = 64;
+    // source face edge the SH9 irradiance is projected from
+    int irradianceSourceSize = 32;
+    // worker threads, 0 for one per core
+    int threads = 0;
+};
+
+// Image based lighting baked from the skybox: a cube map whose mip levels hold the sky convolved with GGX lobes of
+// growing roughness (level / (levels - 1)), and the sky's irradiance as 9 SH coefficients using the same
+// convention as the irradiance volume, so albedo * irradiance is the diffuse color.
+struct EnvironmentMap {
+    static const int FACES = 6;
+
+    int size = 0;
+    int levels = 0;
+    glm::vec3 irradiance[IrradianceVolume::COEFFICIENTS];
+    // RGB9E5 texels, level by level, then face by face in GL order, rows as GL reads them
+    std::vector<uint32_t> texels;
+
+    bool empty() const { return texels.empty(); }
+    static int levelSize(int baseSize, int level) { return std::max(1, baseSize >> level); }
+
+    size_t levelOffset(int level) const
+    {
+        size_t offset = 0;
+        for (int l = 0; l < level; l++)
+            offset += (size_t)FACES * levelSize(size, l) * levelSize(size, l);
+        return offset;
+    }
+
+    // shared exponent packing of GL_RGB9_E5, 4 bytes a texel with ample range for the sky
+    static uint32_t packRGB9E5(const glm::vec3& color)
+    {
+        const float MAX_RGB9E5 = 65408.0f;
+        float r = std::min(std::max(color.r, 0.0f), MAX_RGB9E5);
+        float g = std::min(std::max(color.g, 0.0f), MAX_RGB9E5);
+        float b = std::min(std::max(color.b, 0.0f), MAX_RGB9E5);
+        float maxComponent = std::max(r, std::max(g, b));
+        int exponent = std::max(-16, (int)std::floor(std::log2(std::max(maxComponent, 1e-30f)))) + 1 + 15;
+        float scale = std::ldexp(1.0f, exponent - 15 - 9);
+        if ((int)std::floor(maxComponent / scale + 0.5f) == 512)
+        {
+            exponent++;
+            scale *= 2.0f;
+        }
+        uint32_t rm = (uint32_t)std::floor(r / scale + 0.5f);
+        uint32_t gm = (uint32_t)std::floor(g / scale + 0.5f);
+        uint32_t bm = (uint32_t)std::floor(b / scale + 0.5f);
+        return ((uint32_t)exponent << 27) | (bm << 18) | (gm << 9) | rm;
+    }
+
+    bool save(const char* path) const
+    {
+        std::ofstream file(path, std::ios::binary);
+        if (!file)
+        {
+            std::cout << "ERROR::ENVIRONMENT_MAP::FILE_NOT_WRITTEN: " << path << std::endl;
+            return false;
+        }
+        int32_t header[2] = { size, levels };
+        file.write(magic(), 8);
+        file.write((const char*)header, sizeof(header));
+        file.write((const char*)irradiance, sizeof(irradiance));
+        if (!texels.empty())
+            file.write((const char*)&texels[0], texels.size() * sizeof(uint32_t));
+        return (bool)file;
+    }
+
+    bool load(const char* path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file)
+            return false;
+        char fileMagic[8];
+        int32_t header[2] = { 0, 0 };
+        file.read(fileMagic, 8);
+        file.read((char*)header, sizeof(header));
+        file.read((char*)irradiance, sizeof(irradiance));
+        if (!file || std::memcmp(fileMagic, magic(), 8) != 0 || header[0] <= 0 || header[1] <= 0 || header[1] > 16)
+        {
+            std::cout << "ERROR::ENVIRONMENT_MAP::FILE_NOT_VALID: " << path << std::endl;
+            return false;
+        }
+        size = header[0];
+        levels = header[1];
+        texels.resize(levelOffset(levels));
+        file.read((char*)&texels[0], texels.size() * sizeof(uint32_t));
+        if (!file)
+        {
+            std::cout << "ERROR::ENVIRONMENT_MAP::FILE_TRUNCATED: " << path << std::endl;
+            texels.clear();
+            return false;
+        }
+        return true;
+    }
+
+private:
+    static const char* magic() { return "ROOMENV1"; }
+};
+
+// Prefilters the decoded skybox faces on the CPU. Every texel of a rough level is the GGX weighted average of a
+// source face set scaled to that level, evaluated four source texels at a time with SSE; rows of all levels and
+// faces are shared out to the worker threads.
+class EnvironmentBaker
+{
+public:
+    EnvironmentBaker(const EnvironmentBakeSettings& bakeSettings = EnvironmentBakeSettings()) : settings(bakeSettings) {}
+
+    EnvironmentMap bake(const CubemapImage& image)
+    {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        EnvironmentMap environment;
+        if (image.empty())
+            return environment;
+        sky = &image;
+
+        environment.size = std::max(1, settings.size);
+        environment.levels = std::max(1, std::min(settings.levels, 1 + (int)std::log2((float)environment.size)));
+        environment.texels.assign(environment.levelOffset(environment.levels), 0u);
+        projectIrradiance(environment);
+
+        // the mirror level is a plain downsample, every other level convolves a source matched to its size
+        std::vector<SourceTexels> sources(environment.levels);
+        for (int level = 1; level < environment.levels; level++)
+        {
+            int edge = EnvironmentMap::levelSize(environment.size, level);
+            prepareSource(std::max(8, std::min(edge, settings.maxSourceSize)), sources[level]);
+        }
+
+        struct Row { int level, face, y; };
+        std::vector<Row> rows;
+        for (int level = 0; level < environment.levels; level++)
+            for (int face = 0; face < EnvironmentMap::FACES; face++)
+                for (int y = 0; y < EnvironmentMap::levelSize(environment.size, level); y++)
+                    rows.push_back(Row{ level, face, y });
+
+        int threadCount = settings.threads > 0 ? settings.threads : (int)std::max(1u, std::thread::hardware_concurrency());
+        std::atomic<int> nextRow(0);
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threadCount; t++)
+        {
+            workers.push_back(std::thread([&]() {
+                for (int i = nextRow++; i < (int)rows.size(); i = nextRow++)
+                {
+                    const Row& row = rows[i];
+                    int edge = EnvironmentMap::levelSize(environment.size, row.level);
+                    uint32_t* out = &environment.texels[environment.levelOffset(row.level) + ((size_t)row.face * edge + row.y) * edge];
+                    float roughness = environment.levels > 1 ? (float)row.level / (environment.levels - 1) : 0.0f;
+                    for (int x = 0; x < edge; x++)
+                    {
+                        glm::vec3 color = row.level == 0 ? boxFilter(row.face, x, row.y, edge)
+                            : convolve(sources[row.level], texelDirection(row.face, x, row.y, edge), roughness);
+                        out[x] = EnvironmentMap::packRGB9E5(color);
+                    }
+                }
+            }));
+        }
+        for (std::thread& worker : workers)
+            worker.join();
+
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "ENVIRONMENT_MAP::BAKE:: " << environment.size << "^2 x " << environment.levels << " levels from "
+            << sky->size << "^2 faces on " << threadCount << " threads in " << seconds << " s" << std::endl;
+        return environment;
+    }
+
+private:
+    // source texels in SoA layout padded to a multiple of 4, radiance premultiplied by the texel's solid angle
+    struct SourceTexels {
+        std::vector<float> x, y, z, solidAngle, r, g, b;
+    };
+
+    EnvironmentBakeSettings settings;
+    const CubemapImage* sky = NULL;
+
+    // direction through the center of texel (x, y) of a face with the given edge, following the GL cube map rules
+    static glm::vec3 texelDirection(int face, int x, int y, int edge)
+    {
+        float u = 2.0f * (x + 0.5f) / edge - 1.0f;
+        float v = 2.0f * (y + 0.5f) / edge - 1.0f;
+        glm::vec3 direction;
+        switch (face)
+        {
+        case 0: direction = glm::vec3(1.0f, -v, -u); break;
+        case 1: direction = glm::vec3(-1.0f, -v, u); break;
+        case 2: direction = glm::vec3(u, 1.0f, v); break;
+        case 3: direction = glm::vec3(u, -1.0f, -v); break;
+        case 4: direction = glm::vec3(u, -v, 1.0f); break;
+        default: direction = glm::vec3(-u, -v, -1.0f); break;
+        }
+        return glm::normalize(direction);
+    }
+
+    static float texelSolidAngle(int x, int y, int edge)
+    {
+        float u = 2.0f * (x + 0.5f) / edge - 1.0f;
+        float v = 2.0f * (y + 0.5f) / edge - 1.0f;
+        float texelArea = 4.0f / ((float)edge * edge);
+        return texelArea / std::pow(1.0f + u * u + v * v, 1.5f);
+    }
+
+    // average of the source texels covered by texel (x, y) of a face scaled to edge
+    glm::vec3 boxFilter(int face, int x, int y, int edge) const
+    {
+        int x0 = x * sky->size / edge, x1 = std::max(x0 + 1, (x + 1) * sky->size / edge);
+        int y0 = y * sky->size / edge, y1 = std::max(y0 + 1, (y + 1) * sky->size / edge);
+        glm::vec3 sum(0.0f);
+        for (int sy = y0; sy < y1; sy++)
+            for (int sx = x0; sx < x1; sx++)
+                sum += sky->texel(face, sx, sy);
+        return sum / (float)((x1 - x0) * (y1 - y0));
+    }
+
+    void prepareSource(int edge, SourceTexels& source) const
+    {
+        size_t count = (size_t)EnvironmentMap::FACES * edge * edge;
+        size_t padded = (count + 3) & ~(size_t)3;
+        // padding lanes get no solid angle so they add nothing to either sum
+        source.x.assign(padded, 0.0f);
+        source.y.assign(padded, 0.0f);
+        source.z.assign(padded, 0.0f);
+        source.solidAngle.assign(padded, 0.0f);
+        source.r.assign(padded, 0.0f);
+        source.g.assign(padded, 0.0f);
+        source.b.assign(padded, 0.0f);
+        size_t i = 0;
+        for (int face = 0; face < EnvironmentMap::FACES; face++)
+            for (int y = 0; y < edge; y++)
+                for (int x = 0; x < edge; x++, i++)
+                {
+                    glm::vec3 direction = texelDirection(face, x, y, edge);
+                    float solidAngle = texelSolidAngle(x, y, edge);
+                    glm::vec3 radiance = boxFilter(face, x, y, edge) * solidAngle;
+                    source.x[i] = direction.x;
+                    source.y[i] = direction.y;
+                    source.z[i] = direction.z;
+                    source.solidAngle[i] = solidAngle;
+                    source.r[i] = radiance.r;
+                    source.g[i] = radiance.g;
+                    source.b[i] = radiance.b;
+                }
+    }
+
+    // GGX prefiltering with the usual n = v = r assumption: a source direction l is weighted by D(n.h) * (n.l),
+    // where (n.h)^2 = (1 + n.l) / 2, so the whole lobe reduces to a few multiplies per texel
+    static glm::vec3 convolve(const SourceTexels& source, const glm::vec3& normal, float roughness)
+    {
+        float alpha = roughness * roughness;
+        float alpha2 = std::max(alpha * alpha, 1e-6f);
+        const __m128 nx = _mm_set1_ps(normal.x), ny = _mm_set1_ps(normal.y), nz = _mm_set1_ps(normal.z);
+        const __m128 half = _mm_set1_ps(0.5f), one = _mm_set1_ps(1.0f), zero = _mm_setzero_ps();
+        const __m128 alphaTerm = _mm_set1_ps(alpha2 - 1.0f);
+        __m128 sumR = zero, sumG = zero, sumB = zero, sumWeight = zero;
+        for (size_t i = 0; i < source.x.size(); i += 4)
+        {
+            __m128 nDotL = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, _mm_loadu_ps(&source.x[i])), _mm_mul_ps(ny, _mm_loadu_ps(&source.y[i]))),
+                _mm_mul_ps(nz, _mm_loadu_ps(&source.z[i])));
+            __m128 nDotH2 = _mm_mul_ps(_mm_add_ps(one, nDotL), half);
+            __m128 denominator = _mm_add_ps(_mm_mul_ps(nDotH2, alphaTerm), one);
+            __m128 weight = _mm_div_ps(_mm_max_ps(nDotL, zero), _mm_mul_ps(denominator, denominator));
+            sumR = _mm_add_ps(sumR, _mm_mul_ps(weight, _mm_loadu_ps(&source.r[i])));
+            sumG = _mm_add_ps(sumG, _mm_mul_ps(weight, _mm_loadu_ps(&source.g[i])));
+            sumB = _mm_add_ps(sumB, _mm_mul_ps(weight, _mm_loadu_ps(&source.b[i])));
+            sumWeight = _mm_add_ps(sumWeight, _mm_mul_ps(weight, _mm_loadu_ps(&source.solidAngle[i])));
+        }
+        float r[4], g[4], b[4], w[4];
+        _mm_storeu_ps(r, sumR);
+        _mm_storeu_ps(g, sumG);
+        _mm_storeu_ps(b, sumB);
+        _mm_storeu_ps(w, sumWeight);
+        float weight = w[0] + w[1] + w[2] + w[3];
+        if (weight <= 0.0f)
+            return glm::vec3(0.0f);
+        return glm::vec3(r[0] + r[1] + r[2] + r[3], g[0] + g[1] + g[2] + g[3], b[0] + b[1] + b[2] + b[3]) / weight;
+    }
+
+    void projectIrradiance(EnvironmentMap& environment) const
+    {
+        glm::vec3 projected[IrradianceVolume::COEFFICIENTS];
+        float sh[IrradianceVolume::COEFFICIENTS];
+        for (int c = 0; c < IrradianceVolume::COEFFICIENTS; c++)
+            projected[c] = glm::vec3(0.0f);
+        int edge = std::max(1, std::min(settings.irradianceSourceSize, sky->size));
+        for (int face = 0; face < EnvironmentMap::FACES; face++)
+            for (int y = 0; y < edge; y++)
+                for (int x = 0; x < edge; x++)
+                {
+                    glm::vec3 radiance = boxFilter(face, x, y, edge) * texelSolidAngle(x, y, edge);
+                    IrradianceVolume::basis(texelDirection(face, x, y, edge), sh);
+                    for (int c = 0; c < IrradianceVolume::COEFFICIENTS; c++)
+                        projected[c] += radiance * sh[c];
+                }
+        for (int c = 0; c < IrradianceVolume::COEFFICIENTS; c++)
+            environment.irradiance[c] = projected[c] * IrradianceVolume::bandScale(c);
+    }
+};
+
+// GL side of the environment: a mipmapped RGB9E5 cube map sampled with textureLod by roughness, plus the SH9
+// irradiance as a uniform array.
+class EnvironmentTexture
+{
+public:
+    GlTexture texture;
+
+    EnvironmentTexture() : levels(0) {}
+
+    void upload(const EnvironmentMap& environment)
+    {
+        levels = environment.levels;
+        for (int c = 0; c < IrradianceVolume::COEFFICIENTS; c++)
+            irradiance[c] = environment.irradiance[c];
+
+        if (!texture)
+            texture = GlTexture::create();
+        glBindTexture(GL_TEXTURE_CUBE_MAP, texture);
+        for (int level = 0; level < levels; level++)
+        {
+            int edge = EnvironmentMap::levelSize(environment.size, level);
+            const uint32_t* texels = &environment.texels[environment.levelOffset(level)];
+            for (int face = 0; face < EnvironmentMap::FACES; face++)
+                glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, level, GL_RGB9_E5, edge, edge, 0, GL_RGB, GL_UNSIGNED_INT_5_9_9_9_REV,
+                    texels + (size_t)face * edge * edge);
+        }
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_BASE_LEVEL, 0);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LEVEL, levels - 1);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+        // the rough levels are only a few texels wide, filtering across face edges hides the seams
+        glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
+    }
+
+    void bind(Shader& shader, int unit)
+    {
+        shader.setBool("prefiltered", texture != 0);
+        if (!texture)
+            return;
+        glActiveTexture(GL_TEXTURE0 + unit);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, texture);
+        shader.setInt("skybox", unit);
+        shader.setFloat("maxLod", (float)(levels - 1));
+        glUniform3fv(glGetUniformLocation(shader.ID, "environmentSH"), IrradianceVolume::COEFFICIENTS, &irradiance[0].x);
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+private:
+    int levels;
+    glm::vec3 irradiance[IrradianceVolume::COEFFICIENTS];
+};
+#endif
@@ -0,0 +1,208 @@
+#ifndef FRAME_PACER_H
+#define FRAME_PACER_H
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "gl_handles.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+// seconds on a monotonic clock shared by the main and the render thread
+inline double pacingClock()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Frame pacing settings. Lower latency: swapInterval 0 or a target frame rate, one frame in flight.
+// Maximum throughput: vsync or no limit, three frames in flight.
+struct FramePacingSettings {
+    // passed to glfwSwapInterval; 0 disables vsync, -1 requests adaptive vsync where supported
+    int swapInterval = 1;
+    // frame rate limit applied on top of vsync, 0 for no limit
+    double targetFps = 0.0;
+    // how many frames the CPU may submit before the GPU has finished the oldest one (1-3)
+    int maxFramesInFlight = 2;
+    // seconds between two reports on the console, 0 to stay quiet
+    double reportInterval = 2.0;
+};
+
+// latency of the frames finished during the last report interval, in milliseconds
+struct FrameLatencyStats {
+    int frames = 0;
+    double fps = 0.0;
+    double average = 0.0;
+    double minimum = 0.0;
+    double maximum = 0.0;
+    double p95 = 0.0;
+};
+
+// Paces the render thread: applies the swap interval, limits the frame rate, bounds the number of frames in
+// flight with fences and measures the time from sampling input to the GPU finishing the frame that showed it.
+// The finish is a GL_TIMESTAMP query written next to the fence, so the latency doesn't depend on how late the
+// fence is polled. All member functions must be called on the thread that owns the GL context.
+class FramePacer
+{
+public:
+    static const int MAX_FRAMES_IN_FLIGHT = 3;
+
+    FramePacer(const FramePacingSettings& pacingSettings = FramePacingSettings()) : settings(pacingSettings), slot(0), nextDeadline(0.0), reportStart(0.0), framesSinceReport(0)
+    {
+        settings.maxFramesInFlight = std::max(1, std::min(MAX_FRAMES_IN_FLIGHT, settings.maxFramesInFlight));
+        for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+        {
+            fences[i] = 0;
+            inputTimes[i] = 0.0;
+        }
+    }
+
+    // called once the context is current on the render thread
+    void begin()
+    {
+        glfwSwapInterval(settings.swapInterval);
+        for (GlQuery& query : finishQueries)
+            query = GlQuery::create();
+        reportStart = pacingClock();
+        nextDeadline = reportStart;
+    }
+
+    // blocks until the frame about to be recorded is allowed to start: the GPU must have finished the frame
+    // that used this slot maxFramesInFlight frames ago, and the frame rate limit must have elapsed.
+    void waitForFrameSlot()
+    {
+        retireFence(slot, true);
+
+        if (settings.targetFps > 0.0)
+        {
+            double interval = 1.0 / settings.targetFps;
+            double now = pacingClock();
+            // don't try to catch up on frames we already missed
+            if (nextDeadline < now - interval)
+                nextDeadline = now;
+            // sleep for the bulk of the wait and spin the last millisecond, sleeps are too coarse on most systems
+            double sleepFor = nextDeadline - now - 0.001;
+            if (sleepFor > 0.0)
+                std::this_thread::sleep_for(std::chrono::duration<double>(sleepFor));
+            while (pacingClock() < nextDeadline)
+                std::this_thread::yield();
+            nextDeadline += interval;
+        }
+    }
+
+    // called right after glfwSwapBuffers with the input sample time of the frame that was just submitted
+    void frameSubmitted(double inputSampleTime)
+    {
+        glQueryCounter(finishQueries[slot], GL_TIMESTAMP);
+        fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        inputTimes[slot] = inputSampleTime;
+        slot = (slot + 1) % settings.maxFramesInFlight;
+
+        // timestamp any other frame that already completed without waiting for it
+        for (int i = 0; i < settings.maxFramesInFlight; i++)
+            if (i != slot)
+                retireFence(i, false);
+
+        framesSinceReport++;
+        report();
+    }
+
+    // releases the fences still in flight and the queries; call before the context goes away
+    void end()
+    {
+        for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+        {
+            if (fences[i])
+                glDeleteSync(fences[i]);
+            fences[i] = 0;
+            finishQueries[i].reset();
+        }
+    }
+
+    const FrameLatencyStats& latency() const { return lastStats; }
+    const FramePacingSettings& pacing() const { return settings; }
+
+private:
+    FramePacingSettings settings;
+    GLsync fences[MAX_FRAMES_IN_FLIGHT];
+    // GPU time each frame finished at
+    GlQuery finishQueries[MAX_FRAMES_IN_FLIGHT];
+    double inputTimes[MAX_FRAMES_IN_FLIGHT];
+    int slot;
+    double nextDeadline;
+
+    // latency samples of the current report interval
+    std::vector<double> samples;
+    double reportStart;
+    int framesSinceReport;
+    FrameLatencyStats lastStats;
+
+    // checks (or waits for) the fence of a slot and records the latency of its frame once it signalled
+    void retireFence(int index, bool wait)
+    {
+        if (!fences[index])
+            return;
+        GLuint64 timeout = wait ? 100000000 : 0; // 100ms per attempt while waiting
+        GLenum result;
+        do
+        {
+            result = glClientWaitSync(fences[index], GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+        } while (wait && result == GL_TIMEOUT_EXPIRED);
+        if (result == GL_TIMEOUT_EXPIRED)
+            return;
+
+        // the GPU finishing the frame is the closest to "photon" we can observe without platform specific present
+        // statistics. Its timestamp is on the GPU's clock: reading the GPU's clock now and pacingClock() together
+        // moves it onto ours.
+        double finished = pacingClock();
+        GLint available = 0;
+        glGetQueryObjectiv(finishQueries[index], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available)
+        {
+            GLuint64 finishedGpu = 0;
+            GLint64 nowGpu = 0;
+            glGetQueryObjectui64v(finishQueries[index], GL_QUERY_RESULT, &finishedGpu);
+            glGetInteger64v(GL_TIMESTAMP, &nowGpu);
+            finished -= std::max(0.0, (double)(nowGpu - (GLint64)finishedGpu) * 1e-9);
+        }
+        samples.push_back((finished - inputTimes[index]) * 1000.0);
+        glDeleteSync(fences[index]);
+        fences[index] = 0;
+    }
+
+    void report()
+    {
+        double now = pacingClock();
+        double elapsed = now - reportStart;
+        if (settings.reportInterval <= 0.0 || elapsed < settings.reportInterval)
+            return;
+
+        FrameLatencyStats stats;
+        stats.frames = framesSinceReport;
+        stats.fps = framesSinceReport / elapsed;
+        if (!samples.empty())
+        {
+            std::sort(samples.begin(), samples.end());
+            double sum = 0.0;
+            for (double sample : samples)
+                sum += sample;
+            stats.average = sum / samples.size();
+            stats.minimum = samples.front();
+            stats.maximum = samples.back();
+            stats.p95 = samples[std::min(samples.size() - 1, (size_t)(samples.size() * 0.95))];
+        }
+        lastStats = stats;
+
+        std::cout << "FRAME::PACING:: " << stats.fps << " fps, input-to-present latency avg " << stats.average << " ms, p95 " << stats.p95
+            << " ms, max " << stats.maximum << " ms (swap interval " << settings.swapInterval << ", " << settings.maxFramesInFlight << " frames in flight)" << std::endl;
+
+        samples.clear();
+        reportStart = now;
+        framesSinceReport = 0;
+    }
+};
+#endif
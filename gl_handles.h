@@ -0,0 +1,137 @@
+#ifndef GL_HANDLES_H
+#define GL_HANDLES_H
+
+#include <glad/glad.h>
+
+#include <atomic>
+#include <iostream>
+
+// kinds of GL object a GlHandle can own
+enum GlObjectKind {
+    GL_OBJECT_BUFFER,
+    GL_OBJECT_VERTEX_ARRAY,
+    GL_OBJECT_TEXTURE,
+    GL_OBJECT_PROGRAM,
+    GL_OBJECT_FRAMEBUFFER,
+    GL_OBJECT_RENDERBUFFER,
+    GL_OBJECT_QUERY,
+    GL_OBJECT_KIND_COUNT
+};
+
+// how many handles of each kind are alive, for reportGlLeaks()
+inline std::atomic<int>& liveGlObjects(GlObjectKind kind)
+{
+    static std::atomic<int> counts[GL_OBJECT_KIND_COUNT];
+    return counts[kind];
+}
+
+// Sole owner of one GL object: deletes it when destroyed, can be moved but not copied. Converts to the object's
+// name so it can be handed straight to GL calls and to anything that just refers to the object, like a DrawItem.
+// Has to go away while the context it was made in is still current.
+template <GlObjectKind KIND>
+class GlHandle
+{
+public:
+    GlHandle() : name(0) {}
+    GlHandle(GlHandle&& other) : name(other.name) { other.name = 0; }
+    GlHandle& operator=(GlHandle&& other)
+    {
+        if (this != &other)
+        {
+            reset();
+            name = other.name;
+            other.name = 0;
+        }
+        return *this;
+    }
+    GlHandle(const GlHandle&) = delete;
+    GlHandle& operator=(const GlHandle&) = delete;
+    ~GlHandle() { reset(); }
+
+    // a new object of this kind; programs come from glCreateProgram, so they are adopted instead
+    static GlHandle create()
+    {
+        unsigned int created = 0;
+        if (KIND == GL_OBJECT_BUFFER)
+            glGenBuffers(1, &created);
+        else if (KIND == GL_OBJECT_VERTEX_ARRAY)
+            glGenVertexArrays(1, &created);
+        else if (KIND == GL_OBJECT_TEXTURE)
+            glGenTextures(1, &created);
+        else if (KIND == GL_OBJECT_FRAMEBUFFER)
+            glGenFramebuffers(1, &created);
+        else if (KIND == GL_OBJECT_RENDERBUFFER)
+            glGenRenderbuffers(1, &created);
+        else if (KIND == GL_OBJECT_QUERY)
+            glGenQueries(1, &created);
+        return adopt(created);
+    }
+
+    // takes over an object made elsewhere
+    static GlHandle adopt(unsigned int object)
+    {
+        GlHandle handle;
+        handle.name = object;
+        if (object)
+            liveGlObjects(KIND)++;
+        return handle;
+    }
+
+    void reset()
+    {
+        if (!name)
+            return;
+        if (KIND == GL_OBJECT_BUFFER)
+            glDeleteBuffers(1, &name);
+        else if (KIND == GL_OBJECT_VERTEX_ARRAY)
+            glDeleteVertexArrays(1, &name);
+        else if (KIND == GL_OBJECT_TEXTURE)
+            glDeleteTextures(1, &name);
+        else if (KIND == GL_OBJECT_PROGRAM)
+            glDeleteProgram(name);
+        else if (KIND == GL_OBJECT_FRAMEBUFFER)
+            glDeleteFramebuffers(1, &name);
+        else if (KIND == GL_OBJECT_RENDERBUFFER)
+            glDeleteRenderbuffers(1, &name);
+        else if (KIND == GL_OBJECT_QUERY)
+            glDeleteQueries(1, &name);
+        liveGlObjects(KIND)--;
+        name = 0;
+    }
+
+    unsigned int id() const { return name; }
+    operator unsigned int() const { return name; }
+
+private:
+    unsigned int name;
+};
+
+typedef GlHandle<GL_OBJECT_BUFFER> GlBuffer;
+typedef GlHandle<GL_OBJECT_VERTEX_ARRAY> GlVertexArray;
+typedef GlHandle<GL_OBJECT_TEXTURE> GlTexture;
+typedef GlHandle<GL_OBJECT_PROGRAM> GlProgram;
+typedef GlHandle<GL_OBJECT_FRAMEBUFFER> GlFramebuffer;
+typedef GlHandle<GL_OBJECT_RENDERBUFFER> GlRenderbuffer;
+typedef GlHandle<GL_OBJECT_QUERY> GlQuery;
+
+// Prints the handles that are still alive. Called when everything owning GL objects should be gone, any count
+// left is an object that outlived its owner's scope or was never released.
+inline int reportGlLeaks()
+{
+    static const char* kinds[GL_OBJECT_KIND_COUNT] = { "buffers", "vertex arrays", "textures", "programs", "framebuffers", "renderbuffers", "queries" };
+    int total = 0;
+    for (int kind = 0; kind < GL_OBJECT_KIND_COUNT; kind++)
+        total += liveGlObjects((GlObjectKind)kind).load();
+    if (total == 0)
+    {
+        std::cout << "GL::LEAKS:: none" << std::endl;
+        return 0;
+    }
+    std::cout << "ERROR::GL::LEAKS:";
+    for (int kind = 0; kind < GL_OBJECT_KIND_COUNT; kind++)
+        if (int live = liveGlObjects((GlObjectKind)kind).load())
+            std::cout << " " << live << " " << kinds[kind];
+    std::cout << " still alive" << std::endl;
+    return total;
+}
+#endif
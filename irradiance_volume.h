@@ -0,0 +1,291 @@
+#ifndef IRRADIANCE_VOLUME_H
+#define IRRADIANCE_VOLUME_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp>
+
+#include "gl_handles.h"
+#include "shader.h"
+#include "lightmap_baker.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+struct IrradianceVolumeSettings {
+    // probes per axis, placed at the cell centers of the bounds
+    glm::ivec3 resolution = glm::ivec3(12, 4, 9);
+    glm::vec3 boundsMin = glm::vec3(-10.0f, -1.0f, -10.5f);
+    glm::vec3 boundsMax = glm::vec3(10.0f, 5.0f, 4.5f);
+    // rays per probe and diffuse bounces per ray
+    int rays = 1024;
+    int bounces = 2;
+    // worker threads, 0 for one per core
+    int threads = 0;
+};
+
+// Grid of L2 spherical harmonics probes. The 9 RGB coefficients of a probe are already convolved with the clamped
+// cosine lobe and divided by pi, so evaluating them for a normal gives the same lighting factor Fragment.fs
+// computes for the room: albedo * factor is the shaded color.
+struct IrradianceVolume {
+    static const int COEFFICIENTS = 9;
+
+    glm::ivec3 resolution = glm::ivec3(0);
+    glm::vec3 boundsMin = glm::vec3(0.0f);
+    glm::vec3 boundsMax = glm::vec3(0.0f);
+    // COEFFICIENTS per probe, probes ordered x fastest, then y, then z
+    std::vector<glm::vec3> coefficients;
+
+    bool empty() const { return coefficients.empty(); }
+    int probeCount() const { return resolution.x * resolution.y * resolution.z; }
+
+    glm::vec3 probePosition(int x, int y, int z) const
+    {
+        return boundsMin + (glm::vec3(x, y, z) + 0.5f) / glm::vec3(resolution) * (boundsMax - boundsMin);
+    }
+
+    // real SH basis up to l = 2
+    static void basis(const glm::vec3& d, float out[COEFFICIENTS])
+    {
+        out[0] = 0.282095f;
+        out[1] = 0.488603f * d.y;
+        out[2] = 0.488603f * d.z;
+        out[3] = 0.488603f * d.x;
+        out[4] = 1.092548f * d.x * d.y;
+        out[5] = 1.092548f * d.y * d.z;
+        out[6] = 0.315392f * (3.0f * d.z * d.z - 1.0f);
+        out[7] = 1.092548f * d.x * d.z;
+        out[8] = 0.546274f * (d.x * d.x - d.y * d.y);
+    }
+
+    // clamped cosine convolution per band, divided by pi
+    static float bandScale(int coefficient)
+    {
+        return coefficient == 0 ? 1.0f : (coefficient < 4 ? 2.0f / 3.0f : 0.25f);
+    }
+
+    bool save(const char* path) const
+    {
+        std::ofstream file(path, std::ios::binary);
+        if (!file)
+        {
+            std::cout << "ERROR::IRRADIANCE_VOLUME::FILE_NOT_WRITTEN: " << path << std::endl;
+            return false;
+        }
+        file.write(magic(), 8);
+        file.write((const char*)&resolution, sizeof(resolution));
+        file.write((const char*)&boundsMin, sizeof(boundsMin));
+        file.write((const char*)&boundsMax, sizeof(boundsMax));
+        std::vector<uint16_t> halves(coefficients.size() * 3);
+        for (size_t i = 0; i < coefficients.size(); i++)
+            for (int c = 0; c < 3; c++)
+                halves[i * 3 + c] = (uint16_t)glm::packHalf1x16(coefficients[i][c]);
+        if (!halves.empty())
+            file.write((const char*)&halves[0], halves.size() * sizeof(uint16_t));
+        return (bool)file;
+    }
+
+    bool load(const char* path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file)
+            return false;
+        char fileMagic[8];
+        file.read(fileMagic, 8);
+        file.read((char*)&resolution, sizeof(resolution));
+        file.read((char*)&boundsMin, sizeof(boundsMin));
+        file.read((char*)&boundsMax, sizeof(boundsMax));
+        if (!file || std::memcmp(fileMagic, magic(), 8) != 0 || resolution.x <= 0 || resolution.y <= 0 || resolution.z <= 0)
+        {
+            std::cout << "ERROR::IRRADIANCE_VOLUME::FILE_NOT_VALID: " << path << std::endl;
+            resolution = glm::ivec3(0);
+            return false;
+        }
+        std::vector<uint16_t> halves((size_t)probeCount() * COEFFICIENTS * 3);
+        file.read((char*)&halves[0], halves.size() * sizeof(uint16_t));
+        if (!file)
+        {
+            std::cout << "ERROR::IRRADIANCE_VOLUME::FILE_TRUNCATED: " << path << std::endl;
+            coefficients.clear();
+            return false;
+        }
+        coefficients.resize((size_t)probeCount() * COEFFICIENTS);
+        for (size_t i = 0; i < coefficients.size(); i++)
+            coefficients[i] = glm::vec3(glm::unpackHalf1x16(halves[i * 3]), glm::unpackHalf1x16(halves[i * 3 + 1]), glm::unpackHalf1x16(halves[i * 3 + 2]));
+        return true;
+    }
+
+private:
+    static const char* magic() { return "ROOMIRV1"; }
+};
+
+// Bakes an irradiance volume for the static room. Every probe integrates the radiance arriving from the surfaces
+// and the sky with stratified rays (the same paths the lightmap baker follows) and adds the point lights and the
+// sun it can see directly; probes are spread over all cores.
+class IrradianceVolumeBaker
+{
+public:
+    IrradianceVolumeBaker(const IrradianceVolumeSettings& volumeSettings = IrradianceVolumeSettings()) : settings(volumeSettings) {}
+
+    IrradianceVolume bake(const std::vector<LightmapSurface>& surfaces, const BakeLights& lights)
+    {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        scene.build(surfaces, lights);
+
+        IrradianceVolume volume;
+        volume.resolution = glm::max(settings.resolution, glm::ivec3(1));
+        volume.boundsMin = settings.boundsMin;
+        volume.boundsMax = settings.boundsMax;
+        volume.coefficients.assign((size_t)volume.probeCount() * IrradianceVolume::COEFFICIENTS, glm::vec3(0.0f));
+
+        int threadCount = settings.threads > 0 ? settings.threads : (int)std::max(1u, std::thread::hardware_concurrency());
+        std::atomic<int> nextProbe(0);
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threadCount; t++)
+        {
+            workers.push_back(std::thread([&]() {
+                for (int probe = nextProbe++; probe < volume.probeCount(); probe = nextProbe++)
+                {
+                    int x = probe % volume.resolution.x;
+                    int y = (probe / volume.resolution.x) % volume.resolution.y;
+                    int z = probe / (volume.resolution.x * volume.resolution.y);
+                    bakeProbe(volume.probePosition(x, y, z), (uint32_t)probe, &volume.coefficients[(size_t)probe * IrradianceVolume::COEFFICIENTS]);
+                }
+            }));
+        }
+        for (std::thread& worker : workers)
+            worker.join();
+
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "IRRADIANCE_VOLUME::BAKE:: " << volume.resolution.x << "x" << volume.resolution.y << "x" << volume.resolution.z << " probes, "
+            << settings.rays << " rays x " << settings.bounces << " bounces on " << threadCount << " threads in " << seconds << " s" << std::endl;
+        return volume;
+    }
+
+private:
+    IrradianceVolumeSettings settings;
+    BakeScene scene;
+
+    void bakeProbe(const glm::vec3& position, uint32_t seed, glm::vec3* out) const
+    {
+        BakeRandom random(seed);
+        float sh[IrradianceVolume::COEFFICIENTS];
+        glm::vec3 projected[IrradianceVolume::COEFFICIENTS];
+        for (int c = 0; c < IrradianceVolume::COEFFICIENTS; c++)
+            projected[c] = glm::vec3(0.0f);
+
+        // jittered spherical fibonacci directions cover the sphere far more evenly than independent samples
+        const float GOLDEN_ANGLE = 2.3999632f;
+        int rays = std::max(1, settings.rays);
+        float rotation = random.next() * 6.2831853f;
+        for (int i = 0; i < rays; i++)
+        {
+            float z = 1.0f - 2.0f * (i + random.next()) / rays;
+            float r = std::sqrt(std::max(0.0f, 1.0f - z * z));
+            float phi = i * GOLDEN_ANGLE + rotation;
+            glm::vec3 direction(r * std::cos(phi), r * std::sin(phi), z);
+            glm::vec3 radiance = scene.incomingRadiance(position, direction, settings.bounces, random);
+            IrradianceVolume::basis(direction, sh);
+            for (int c = 0; c < IrradianceVolume::COEFFICIENTS; c++)
+                projected[c] += radiance * sh[c];
+        }
+        for (int c = 0; c < IrradianceVolume::COEFFICIENTS; c++)
+            projected[c] *= 4.0f * 3.14159265f / rays;
+
+        // the lights themselves are points the rays never hit: project each visible one as a delta. Scaled so a
+        // surface facing the light gets the factor the room shader would compute, diff * attenuation * color.
+        const BakeLights& lights = scene.lighting();
+        for (const PointLight& light : lights.points)
+        {
+            glm::vec3 direction;
+            float attenuation = scene.pointLightAttenuation(light, position, direction);
+            if (attenuation <= 0.0f)
+                continue;
+            IrradianceVolume::basis(direction, sh);
+            for (int c = 0; c < IrradianceVolume::COEFFICIENTS; c++)
+                projected[c] += 3.14159265f * attenuation * light.color * light.intensity * sh[c];
+        }
+        if (lights.sunEnabled && !scene.bvh().occluded(position, -lights.sunDirection, 1e4f))
+        {
+            IrradianceVolume::basis(-lights.sunDirection, sh);
+            for (int c = 0; c < IrradianceVolume::COEFFICIENTS; c++)
+                projected[c] += 3.14159265f * lights.sunColor * sh[c];
+        }
+
+        for (int c = 0; c < IrradianceVolume::COEFFICIENTS; c++)
+            out[c] = projected[c] * IrradianceVolume::bandScale(c);
+    }
+};
+
+// GL side of the volume: one RGBA16F 3D texture holding the 27 coefficient floats of every probe as 7 slabs stacked
+// along z, so the model shader filters all of them trilinearly with the hardware.
+class IrradianceVolumeTexture
+{
+public:
+    static const int SLABS = 7;
+
+    GlTexture texture;
+
+    IrradianceVolumeTexture() : resolution(0), boundsMin(0.0f), boundsMax(0.0f) {}
+
+    void upload(const IrradianceVolume& volume)
+    {
+        resolution = volume.resolution;
+        boundsMin = volume.boundsMin;
+        boundsMax = volume.boundsMax;
+
+        // slab k holds floats 4k..4k+3 of a probe's r, g, b interleaved coefficients
+        std::vector<float> texels((size_t)volume.probeCount() * SLABS * 4, 0.0f);
+        for (int probe = 0; probe < volume.probeCount(); probe++)
+        {
+            const glm::vec3* coefficients = &volume.coefficients[(size_t)probe * IrradianceVolume::COEFFICIENTS];
+            int x = probe % resolution.x;
+            int yz = probe / resolution.x;
+            for (int f = 0; f < IrradianceVolume::COEFFICIENTS * 3; f++)
+            {
+                int slab = f / 4;
+                size_t texel = ((size_t)slab * resolution.y * resolution.z + yz) * resolution.x + x;
+                texels[texel * 4 + f % 4] = coefficients[f / 3][f % 3];
+            }
+        }
+
+        if (!texture)
+            texture = GlTexture::create();
+        glBindTexture(GL_TEXTURE_3D, texture);
+        glTexImage3D(GL_TEXTURE_3D, 0, GL_RGBA16F, resolution.x, resolution.y, resolution.z * SLABS, 0, GL_RGBA, GL_FLOAT, &texels[0]);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+        glBindTexture(GL_TEXTURE_3D, 0);
+    }
+
+    void bind(Shader& shader, int unit)
+    {
+        shader.setBool("volumeEnabled", texture != 0);
+        if (!texture)
+            return;
+        glActiveTexture(GL_TEXTURE0 + unit);
+        glBindTexture(GL_TEXTURE_3D, texture);
+        shader.setInt("irradianceVolume", unit);
+        shader.setVec3("volumeMin", boundsMin);
+        shader.setVec3("volumeMax", boundsMax);
+        glUniform3i(glGetUniformLocation(shader.ID, "volumeResolution"), resolution.x, resolution.y, resolution.z);
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+private:
+    glm::ivec3 resolution;
+    glm::vec3 boundsMin;
+    glm::vec3 boundsMax;
+};
+#endif
@@ -0,0 +1,750 @@
+#ifndef LIGHTMAP_BAKER_H
+#define LIGHTMAP_BAKER_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp>
+#include <stb_image.h>
+
+#include "gl_handles.h"
+#include "shader.h"
+#include "bvh.h"
+#include "clustered_lighting.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+// distance rays start off the surface they leave, to not hit it again
+const float LIGHTMAP_RAY_OFFSET = 1e-3f;
+
+// static geometry handed to the baker: position/normal/texcoord arrays with 8 floats per vertex
+struct LightmapSurface {
+    const float* vertices;
+    int vertexCount;
+    // average color of the surface's texture, light bouncing off the surface is tinted with it
+    glm::vec3 albedo;
+    // surfaces without a lightmap (the window panes) neither receive nor block baked light
+    bool lightmapped;
+};
+
+struct LightmapBakeSettings {
+    // lightmap resolution on the surfaces, lowered automatically if the atlas would exceed maxAtlasSize
+    float texelsPerUnit = 8.0f;
+    int maxAtlasSize = 2048;
+    // texels around every chart so bilinear filtering never reaches into a neighbouring chart
+    int padding = 2;
+    // indirect paths per texel and diffuse bounces per path
+    int samples = 128;
+    int bounces = 2;
+    // worker threads, 0 for one per core
+    int threads = 0;
+};
+
+// the light sources the bakers trace
+struct BakeLights {
+    std::vector<PointLight> points;
+    // directional light, same conventions as ShadowSettings (color already multiplied by the intensity)
+    bool sunEnabled = false;
+    glm::vec3 sunDirection = glm::vec3(0.0f, -1.0f, 0.0f);
+    glm::vec3 sunColor = glm::vec3(0.0f);
+    // radiance of the sky seen through the windows
+    glm::vec3 skyColor = glm::vec3(0.35f, 0.45f, 0.6f);
+};
+
+// Baked lighting of the static room: an atlas of lighting factors (the shader multiplies them with the albedo)
+// and the second uv set of every surface that addresses it.
+struct Lightmap {
+    int width = 0;
+    int height = 0;
+    // the first bakedLightCount scene lights and, if bakedSun is set, the sun are contained in the texels
+    int bakedLightCount = 0;
+    bool bakedSun = false;
+    // rows from the bottom up, as glTexImage2D expects them
+    std::vector<glm::vec3> texels;
+    // per surface, one uv per vertex; empty for surfaces that aren't lightmapped
+    std::vector<std::vector<glm::vec2>> uvs;
+
+    bool empty() const { return texels.empty(); }
+
+    // the uv sets only fit geometry with the same vertex counts they were baked for
+    bool matches(const std::vector<LightmapSurface>& surfaces) const
+    {
+        if (uvs.size() != surfaces.size())
+            return false;
+        for (size_t i = 0; i < surfaces.size(); i++)
+            if (uvs[i].size() != (surfaces[i].lightmapped ? (size_t)surfaces[i].vertexCount : 0))
+                return false;
+        return true;
+    }
+
+    bool save(const char* path) const
+    {
+        std::ofstream file(path, std::ios::binary);
+        if (!file)
+        {
+            std::cout << "ERROR::LIGHTMAP::FILE_NOT_WRITTEN: " << path << std::endl;
+            return false;
+        }
+        int32_t header[5] = { width, height, bakedLightCount, bakedSun ? 1 : 0, (int32_t)uvs.size() };
+        file.write(magic(), 8);
+        file.write((const char*)header, sizeof(header));
+        for (const std::vector<glm::vec2>& surface : uvs)
+        {
+            int32_t count = (int32_t)surface.size();
+            file.write((const char*)&count, sizeof(count));
+            if (count)
+                file.write((const char*)&surface[0], count * sizeof(glm::vec2));
+        }
+        // half floats are plenty for lighting and halve the file
+        std::vector<uint16_t> halves(texels.size() * 3);
+        for (size_t i = 0; i < texels.size(); i++)
+            for (int c = 0; c < 3; c++)
+                halves[i * 3 + c] = (uint16_t)glm::packHalf1x16(texels[i][c]);
+        if (!halves.empty())
+            file.write((const char*)&halves[0], halves.size() * sizeof(uint16_t));
+        return (bool)file;
+    }
+
+    bool load(const char* path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file)
+            return false;
+        char fileMagic[8];
+        int32_t header[5];
+        file.read(fileMagic, 8);
+        file.read((char*)header, sizeof(header));
+        if (!file || std::memcmp(fileMagic, magic(), 8) != 0 || header[0] <= 0 || header[1] <= 0 || header[4] < 0)
+        {
+            std::cout << "ERROR::LIGHTMAP::FILE_NOT_VALID: " << path << std::endl;
+            return false;
+        }
+        width = header[0];
+        height = header[1];
+        bakedLightCount = header[2];
+        bakedSun = header[3] != 0;
+        uvs.assign(header[4], std::vector<glm::vec2>());
+        for (std::vector<glm::vec2>& surface : uvs)
+        {
+            int32_t count = 0;
+            file.read((char*)&count, sizeof(count));
+            if (!file || count < 0)
+                break;
+            surface.resize(count);
+            if (count)
+                file.read((char*)&surface[0], count * sizeof(glm::vec2));
+        }
+        std::vector<uint16_t> halves((size_t)width * height * 3);
+        file.read((char*)&halves[0], halves.size() * sizeof(uint16_t));
+        if (!file)
+        {
+            std::cout << "ERROR::LIGHTMAP::FILE_TRUNCATED: " << path << std::endl;
+            texels.clear();
+            return false;
+        }
+        texels.resize((size_t)width * height);
+        for (size_t i = 0; i < texels.size(); i++)
+            texels[i] = glm::vec3(glm::unpackHalf1x16(halves[i * 3]), glm::unpackHalf1x16(halves[i * 3 + 1]), glm::unpackHalf1x16(halves[i * 3 + 2]));
+        return true;
+    }
+
+private:
+    static const char* magic() { return "ROOMLMA1"; }
+};
+
+// average color of a texture on disk, used as the albedo of the surfaces it is applied to
+inline glm::vec3 averageTextureColor(const char* path)
+{
+    int width, height, components;
+    unsigned char* data = stbi_load(path, &width, &height, &components, 3);
+    if (!data)
+    {
+        std::cout << "Texture failed to load at path: " << path << std::endl;
+        return glm::vec3(0.5f);
+    }
+    glm::dvec3 sum(0.0);
+    size_t count = (size_t)width * height;
+    for (size_t i = 0; i < count; i++)
+        sum += glm::dvec3(data[i * 3], data[i * 3 + 1], data[i * 3 + 2]);
+    stbi_image_free(data);
+    return glm::vec3(sum / (count * 255.0));
+}
+
+// xorshift, one stream per texel or probe so bakes don't depend on the thread count
+struct BakeRandom {
+    uint32_t state;
+    explicit BakeRandom(uint32_t seed) : state(seed * 747796405u + 2891336453u)
+    {
+        if (state == 0)
+            state = 1;
+    }
+    float next()
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return (state >> 8) * (1.0f / 16777216.0f);
+    }
+};
+
+// The static room as the bakers see it: a BVH over the lightmapped surfaces (the window panes let light through),
+// the albedo of every triangle and the lights. All queries are const and safe to call from any number of threads.
+class BakeScene
+{
+public:
+    void build(const std::vector<LightmapSurface>& surfaces, const BakeLights& bakeLights)
+    {
+        lights = bakeLights;
+        if (lights.sunEnabled)
+            lights.sunDirection = glm::normalize(lights.sunDirection);
+
+        std::vector<glm::vec3> positions;
+        triangleNormals.clear();
+        triangleAlbedos.clear();
+        for (const LightmapSurface& surface : surfaces)
+        {
+            if (!surface.lightmapped)
+                continue;
+            for (int v = 0; v + 2 < surface.vertexCount; v += 3)
+            {
+                const float* p = surface.vertices + v * 8;
+                glm::vec3 a(p[0], p[1], p[2]), b(p[8], p[9], p[10]), c(p[16], p[17], p[18]);
+                glm::vec3 n = faceNormal(a, b, c);
+                if (n == glm::vec3(0.0f))
+                    continue;
+                positions.push_back(a);
+                positions.push_back(b);
+                positions.push_back(c);
+                triangleNormals.push_back(n);
+                triangleAlbedos.push_back(surface.albedo);
+            }
+        }
+        tree.build(positions);
+    }
+
+    const Bvh& bvh() const { return tree; }
+    const BakeLights& lighting() const { return lights; }
+
+    static glm::vec3 faceNormal(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c)
+    {
+        glm::vec3 n = glm::cross(b - a, c - a);
+        float length = glm::length(n);
+        return length > 1e-12f ? n / length : glm::vec3(0.0f);
+    }
+
+    static glm::vec3 cosineDirection(const glm::vec3& normal, BakeRandom& random)
+    {
+        float u = random.next(), v = random.next();
+        float r = std::sqrt(u), phi = 6.2831853f * v;
+        glm::vec3 tangent = glm::normalize(glm::cross(normal, std::abs(normal.x) < 0.9f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f)));
+        glm::vec3 bitangent = glm::cross(normal, tangent);
+        return glm::normalize(tangent * (r * std::cos(phi)) + bitangent * (r * std::sin(phi)) + normal * std::sqrt(std::max(0.0f, 1.0f - u)));
+    }
+
+    // unoccluded contribution of a point light at a point, with the same attenuation as Fragment.fs;
+    // direction is set to the direction towards the light
+    float pointLightAttenuation(const PointLight& light, const glm::vec3& point, glm::vec3& direction) const
+    {
+        glm::vec3 toLight = light.position - point;
+        float distance = glm::length(toLight);
+        if (distance >= light.radius || distance <= 0.0f)
+            return 0.0f;
+        direction = toLight / distance;
+        float ratio = distance / light.radius;
+        float window = 1.0f - ratio * ratio * ratio * ratio;
+        if (tree.occluded(point, direction, distance - LIGHTMAP_RAY_OFFSET))
+            return 0.0f;
+        return window * window / (1.0f + distance * distance);
+    }
+
+    // direct lighting factor at a point on a surface
+    glm::vec3 directLight(const glm::vec3& point, const glm::vec3& normal) const
+    {
+        glm::vec3 result(0.0f);
+        glm::vec3 origin = point + normal * LIGHTMAP_RAY_OFFSET;
+        for (const PointLight& light : lights.points)
+        {
+            glm::vec3 lightDir;
+            if (glm::dot(normal, light.position - point) <= 0.0f)
+                continue;
+            float attenuation = pointLightAttenuation(light, origin, lightDir);
+            if (attenuation > 0.0f)
+                result += std::max(0.0f, glm::dot(normal, lightDir)) * attenuation * light.color * light.intensity;
+        }
+        if (lights.sunEnabled)
+        {
+            glm::vec3 lightDir = -lights.sunDirection;
+            float diff = glm::dot(normal, lightDir);
+            if (diff > 0.0f && !tree.occluded(origin, lightDir, 1e4f))
+                result += diff * lights.sunColor;
+        }
+        return result;
+    }
+
+    // radiance arriving at origin from direction, following up to `bounces` diffuse bounces
+    glm::vec3 incomingRadiance(glm::vec3 origin, glm::vec3 direction, int bounces, BakeRandom& random) const
+    {
+        glm::vec3 radiance(0.0f);
+        glm::vec3 throughput(1.0f);
+        for (int bounce = 0; bounce < bounces; bounce++)
+        {
+            Bvh::Hit hit;
+            if (!tree.intersect(origin, direction, 1e4f, hit))
+            {
+                radiance += throughput * lights.skyColor;
+                break;
+            }
+            glm::vec3 point = origin + direction * hit.t;
+            glm::vec3 normal = triangleNormals[hit.triangle];
+            if (glm::dot(normal, direction) > 0.0f)
+                normal = -normal;
+            throughput *= triangleAlbedos[hit.triangle];
+            radiance += throughput * directLight(point, normal);
+            origin = point + normal * LIGHTMAP_RAY_OFFSET;
+            direction = cosineDirection(normal, random);
+        }
+        return radiance;
+    }
+
+private:
+    BakeLights lights;
+    Bvh tree;
+    // per BVH triangle
+    std::vector<glm::vec3> triangleNormals;
+    std::vector<glm::vec3> triangleAlbedos;
+};
+
+// Offline lightmap baker. Generates a second uv set by cutting the surfaces into planar charts and shelf packing
+// them into one atlas, then path traces direct light (point lights and sun, with shadow rays) plus diffuse
+// bounces for every texel against a BVH of the room, spread over all cores.
+class LightmapBaker
+{
+public:
+    LightmapBaker(const LightmapBakeSettings& bakeSettings = LightmapBakeSettings()) : settings(bakeSettings) {}
+
+    Lightmap bake(const std::vector<LightmapSurface>& bakeSurfaces, const BakeLights& lights)
+    {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        surfaces = bakeSurfaces;
+
+        Lightmap lightmap;
+        lightmap.bakedLightCount = (int)lights.points.size();
+        lightmap.bakedSun = lights.sunEnabled;
+        lightmap.uvs.assign(surfaces.size(), std::vector<glm::vec2>());
+
+        scene.build(surfaces, lights);
+        buildCharts();
+        pack(lightmap);
+        orientCharts();
+        rasterize(lightmap);
+
+        // rows of texels are handed out to the workers one at a time
+        int threadCount = settings.threads > 0 ? settings.threads : (int)std::max(1u, std::thread::hardware_concurrency());
+        lightmap.texels.assign(samples.size(), glm::vec3(0.0f));
+        std::atomic<int> nextRow(0);
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threadCount; t++)
+        {
+            workers.push_back(std::thread([&]() {
+                for (int y = nextRow++; y < lightmap.height; y = nextRow++)
+                    for (int x = 0; x < lightmap.width; x++)
+                    {
+                        size_t index = (size_t)y * lightmap.width + x;
+                        if (samples[index].chart >= 0)
+                            lightmap.texels[index] = shade(samples[index], (uint32_t)index);
+                    }
+            }));
+        }
+        for (std::thread& worker : workers)
+            worker.join();
+
+        dilate(lightmap);
+
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        size_t covered = 0;
+        for (const TexelSample& sample : samples)
+            covered += sample.chart >= 0;
+        std::cout << "LIGHTMAP::BAKE:: " << lightmap.width << "x" << lightmap.height << " atlas, " << charts.size() << " charts, " << covered << " texels, "
+            << settings.samples << " samples x " << settings.bounces << " bounces on " << threadCount << " threads in " << seconds << " s" << std::endl;
+        return lightmap;
+    }
+
+private:
+    // edge-connected coplanar triangles of one surface, flattened onto their plane
+    struct Chart {
+        int surface;
+        // first vertex of each triangle
+        std::vector<int> triangles;
+        glm::vec3 normal, tangent, bitangent;
+        glm::vec2 planeMin, planeMax;
+        // placement in the atlas in texels, including the padding
+        int x, y, width, height;
+        float texelsPerUnit;
+    };
+
+    struct TexelSample {
+        glm::vec3 position;
+        glm::vec3 normal;
+        int chart = -1;
+    };
+
+    LightmapBakeSettings settings;
+    std::vector<LightmapSurface> surfaces;
+    BakeScene scene;
+    std::vector<Chart> charts;
+    // one per atlas texel
+    std::vector<TexelSample> samples;
+
+    glm::vec3 position(int surface, int vertex) const
+    {
+        const float* v = surfaces[surface].vertices + vertex * 8;
+        return glm::vec3(v[0], v[1], v[2]);
+    }
+
+    static glm::vec2 project(const Chart& chart, const glm::vec3& p)
+    {
+        return glm::vec2(glm::dot(p, chart.tangent), glm::dot(p, chart.bitangent));
+    }
+
+    glm::vec2 atlasPosition(const Chart& chart, const glm::vec3& p) const
+    {
+        return glm::vec2(chart.x + settings.padding, chart.y + settings.padding) + (project(chart, p) - chart.planeMin) * chart.texelsPerUnit;
+    }
+
+    void buildCharts()
+    {
+        charts.clear();
+        for (int s = 0; s < (int)surfaces.size(); s++)
+        {
+            if (!surfaces[s].lightmapped)
+                continue;
+            int triangleCount = surfaces[s].vertexCount / 3;
+
+            // weld vertices by position so triangles listed separately still find their neighbours
+            std::map<std::tuple<int, int, int>, int> welded;
+            std::vector<int> vertexIds(triangleCount * 3);
+            for (int v = 0; v < triangleCount * 3; v++)
+            {
+                glm::vec3 p = position(s, v) * 1000.0f;
+                std::tuple<int, int, int> key((int)std::floor(p.x + 0.5f), (int)std::floor(p.y + 0.5f), (int)std::floor(p.z + 0.5f));
+                std::map<std::tuple<int, int, int>, int>::iterator found = welded.find(key);
+                if (found == welded.end())
+                    found = welded.insert(std::make_pair(key, (int)welded.size())).first;
+                vertexIds[v] = found->second;
+            }
+
+            std::vector<glm::vec3> normals(triangleCount);
+            std::vector<int> parent(triangleCount);
+            for (int t = 0; t < triangleCount; t++)
+            {
+                normals[t] = BakeScene::faceNormal(position(s, t * 3), position(s, t * 3 + 1), position(s, t * 3 + 2));
+                parent[t] = t;
+            }
+
+            // union neighbours on the same plane; the room's winding is inconsistent, so they may face either way
+            std::map<std::pair<int, int>, int> edges;
+            for (int t = 0; t < triangleCount; t++)
+            {
+                if (normals[t] == glm::vec3(0.0f))
+                    continue;
+                for (int e = 0; e < 3; e++)
+                {
+                    int a = vertexIds[t * 3 + e], b = vertexIds[t * 3 + (e + 1) % 3];
+                    std::pair<int, int> key(std::min(a, b), std::max(a, b));
+                    std::map<std::pair<int, int>, int>::iterator found = edges.find(key);
+                    if (found == edges.end())
+                        edges.insert(std::make_pair(key, t));
+                    else if (std::abs(glm::dot(normals[t], normals[found->second])) > 0.999f)
+                        parent[findRoot(parent, t)] = findRoot(parent, found->second);
+                }
+            }
+
+            std::map<int, int> chartOfRoot;
+            for (int t = 0; t < triangleCount; t++)
+            {
+                // degenerate triangles cover no texels, they keep the uv (0, 0)
+                if (normals[t] == glm::vec3(0.0f))
+                    continue;
+                int root = findRoot(parent, t);
+                std::map<int, int>::iterator found = chartOfRoot.find(root);
+                if (found == chartOfRoot.end())
+                {
+                    found = chartOfRoot.insert(std::make_pair(root, (int)charts.size())).first;
+                    Chart chart;
+                    chart.surface = s;
+                    chart.x = chart.y = chart.width = chart.height = 0;
+                    chart.texelsPerUnit = settings.texelsPerUnit;
+                    chart.normal = normals[t];
+                    chart.tangent = glm::normalize(glm::cross(chart.normal, std::abs(chart.normal.y) < 0.9f ? glm::vec3(0.0f, 1.0f, 0.0f) : glm::vec3(1.0f, 0.0f, 0.0f)));
+                    chart.bitangent = glm::cross(chart.normal, chart.tangent);
+                    chart.planeMin = glm::vec2(FLT_MAX);
+                    chart.planeMax = glm::vec2(-FLT_MAX);
+                    charts.push_back(chart);
+                }
+                Chart& chart = charts[found->second];
+                chart.triangles.push_back(t * 3);
+                for (int v = 0; v < 3; v++)
+                {
+                    glm::vec2 q = project(chart, position(s, t * 3 + v));
+                    chart.planeMin = glm::min(chart.planeMin, q);
+                    chart.planeMax = glm::max(chart.planeMax, q);
+                }
+            }
+        }
+    }
+
+    static int findRoot(std::vector<int>& parent, int t)
+    {
+        while (parent[t] != t)
+        {
+            parent[t] = parent[parent[t]];
+            t = parent[t];
+        }
+        return t;
+    }
+
+    // shelf packing, tallest charts first; lowers the texel density until the atlas fits
+    void pack(Lightmap& lightmap)
+    {
+        float texelsPerUnit = settings.texelsPerUnit;
+        for (;;)
+        {
+            long long area = 0;
+            int widest = 0;
+            for (Chart& chart : charts)
+            {
+                glm::vec2 extent = chart.planeMax - chart.planeMin;
+                chart.texelsPerUnit = texelsPerUnit;
+                chart.width = std::max(1, (int)std::ceil(extent.x * texelsPerUnit)) + 2 * settings.padding;
+                chart.height = std::max(1, (int)std::ceil(extent.y * texelsPerUnit)) + 2 * settings.padding;
+                area += (long long)chart.width * chart.height;
+                widest = std::max(widest, chart.width);
+            }
+            int width = 64;
+            while (width < settings.maxAtlasSize && ((long long)width * width < area * 5 / 4 || width < widest))
+                width *= 2;
+
+            std::vector<int> order(charts.size());
+            for (size_t i = 0; i < order.size(); i++)
+                order[i] = (int)i;
+            std::sort(order.begin(), order.end(), [&](int a, int b) { return charts[a].height > charts[b].height; });
+
+            int x = 0, y = 0, shelfHeight = 0;
+            for (int index : order)
+            {
+                Chart& chart = charts[index];
+                if (x + chart.width > width)
+                {
+                    y += shelfHeight;
+                    x = 0;
+                    shelfHeight = 0;
+                }
+                chart.x = x;
+                chart.y = y;
+                x += chart.width;
+                shelfHeight = std::max(shelfHeight, chart.height);
+            }
+            int height = std::max(4, (y + shelfHeight + 3) & ~3);
+            if (widest <= width && height <= settings.maxAtlasSize)
+            {
+                lightmap.width = width;
+                lightmap.height = height;
+                break;
+            }
+            texelsPerUnit *= 0.8f;
+        }
+
+        // the second uv set maps the chart's plane coordinates into its rectangle
+        for (const Chart& chart : charts)
+        {
+            std::vector<glm::vec2>& uvs = lightmap.uvs[chart.surface];
+            if (uvs.empty())
+                uvs.assign(surfaces[chart.surface].vertexCount, glm::vec2(0.0f));
+            for (int first : chart.triangles)
+                for (int v = 0; v < 3; v++)
+                    uvs[first + v] = atlasPosition(chart, position(chart.surface, first + v)) / glm::vec2((float)lightmap.width, (float)lightmap.height);
+        }
+    }
+
+    // A chart is lit from one side only. Walls are seen from inside the room and furniture from outside, so pick
+    // the side whose rays travel furthest before hitting something, counting rays that leave the room as zero.
+    void orientCharts()
+    {
+        const int RAYS = 32;
+        for (size_t c = 0; c < charts.size(); c++)
+        {
+            Chart& chart = charts[c];
+            BakeRandom random((uint32_t)c * 9781u + 1u);
+            float score[2] = { 0.0f, 0.0f };
+            for (int side = 0; side < 2; side++)
+            {
+                glm::vec3 normal = side == 0 ? chart.normal : -chart.normal;
+                for (int r = 0; r < RAYS; r++)
+                {
+                    int first = chart.triangles[r % chart.triangles.size()];
+                    float u = random.next(), v = random.next();
+                    if (u + v > 1.0f)
+                    {
+                        u = 1.0f - u;
+                        v = 1.0f - v;
+                    }
+                    glm::vec3 a = position(chart.surface, first), b = position(chart.surface, first + 1), c2 = position(chart.surface, first + 2);
+                    glm::vec3 origin = a + (b - a) * u + (c2 - a) * v + normal * LIGHTMAP_RAY_OFFSET;
+                    Bvh::Hit hit;
+                    if (scene.bvh().intersect(origin, BakeScene::cosineDirection(normal, random), 1e4f, hit))
+                        score[side] += hit.t;
+                }
+            }
+            if (score[1] > score[0])
+                chart.normal = -chart.normal;
+        }
+    }
+
+    // finds the surface point behind every texel center
+    void rasterize(const Lightmap& lightmap)
+    {
+        samples.assign((size_t)lightmap.width * lightmap.height, TexelSample());
+        for (int c = 0; c < (int)charts.size(); c++)
+        {
+            const Chart& chart = charts[c];
+            for (int first : chart.triangles)
+            {
+                glm::vec3 p[3];
+                glm::vec2 q[3];
+                for (int v = 0; v < 3; v++)
+                {
+                    p[v] = position(chart.surface, first + v);
+                    q[v] = atlasPosition(chart, p[v]);
+                }
+                float area = (q[1].x - q[0].x) * (q[2].y - q[0].y) - (q[2].x - q[0].x) * (q[1].y - q[0].y);
+                if (std::abs(area) < 1e-8f)
+                    continue;
+                int minX = std::max(0, (int)std::floor(std::min(q[0].x, std::min(q[1].x, q[2].x))));
+                int maxX = std::min(lightmap.width - 1, (int)std::ceil(std::max(q[0].x, std::max(q[1].x, q[2].x))));
+                int minY = std::max(0, (int)std::floor(std::min(q[0].y, std::min(q[1].y, q[2].y))));
+                int maxY = std::min(lightmap.height - 1, (int)std::ceil(std::max(q[0].y, std::max(q[1].y, q[2].y))));
+                for (int y = minY; y <= maxY; y++)
+                    for (int x = minX; x <= maxX; x++)
+                    {
+                        glm::vec2 center(x + 0.5f, y + 0.5f);
+                        float w0 = ((q[1].x - center.x) * (q[2].y - center.y) - (q[2].x - center.x) * (q[1].y - center.y)) / area;
+                        float w1 = ((q[2].x - center.x) * (q[0].y - center.y) - (q[0].x - center.x) * (q[2].y - center.y)) / area;
+                        float w2 = 1.0f - w0 - w1;
+                        if (w0 < -1e-4f || w1 < -1e-4f || w2 < -1e-4f)
+                            continue;
+                        TexelSample& sample = samples[(size_t)y * lightmap.width + x];
+                        sample.position = p[0] * w0 + p[1] * w1 + p[2] * w2;
+                        sample.normal = chart.normal;
+                        sample.chart = c;
+                    }
+            }
+        }
+    }
+
+    glm::vec3 shade(const TexelSample& sample, uint32_t seed) const
+    {
+        // cosine weighted paths: the lambert term and the pdf cancel, every path contributes its radiance directly
+        BakeRandom random(seed);
+        glm::vec3 origin = sample.position + sample.normal * LIGHTMAP_RAY_OFFSET;
+        glm::vec3 indirect(0.0f);
+        for (int s = 0; s < settings.samples; s++)
+            indirect += scene.incomingRadiance(origin, BakeScene::cosineDirection(sample.normal, random), settings.bounces, random);
+        return scene.directLight(sample.position, sample.normal) + indirect / (float)std::max(1, settings.samples);
+    }
+
+    // grows every chart into its padding so bilinear taps on the chart border pick up its own lighting
+    void dilate(Lightmap& lightmap)
+    {
+        std::vector<bool> filled(samples.size());
+        for (size_t i = 0; i < samples.size(); i++)
+            filled[i] = samples[i].chart >= 0;
+        for (int pass = 0; pass < settings.padding; pass++)
+        {
+            std::vector<bool> next = filled;
+            for (int y = 0; y < lightmap.height; y++)
+                for (int x = 0; x < lightmap.width; x++)
+                {
+                    size_t index = (size_t)y * lightmap.width + x;
+                    if (filled[index])
+                        continue;
+                    glm::vec3 sum(0.0f);
+                    int count = 0;
+                    for (int dy = -1; dy <= 1; dy++)
+                        for (int dx = -1; dx <= 1; dx++)
+                        {
+                            int nx = x + dx, ny = y + dy;
+                            if (nx < 0 || ny < 0 || nx >= lightmap.width || ny >= lightmap.height)
+                                continue;
+                            size_t neighbour = (size_t)ny * lightmap.width + nx;
+                            if (filled[neighbour])
+                            {
+                                sum += lightmap.texels[neighbour];
+                                count++;
+                            }
+                        }
+                    if (count)
+                    {
+                        lightmap.texels[index] = sum / (float)count;
+                        next[index] = true;
+                    }
+                }
+            filled.swap(next);
+        }
+    }
+};
+
+// GL side of a baked lightmap: the atlas texture and one uv buffer per lightmapped VAO (attribute location 3).
+class LightmapResources
+{
+public:
+    GlTexture texture;
+
+    void upload(const Lightmap& lightmap)
+    {
+        if (!texture)
+            texture = GlTexture::create();
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, lightmap.width, lightmap.height, 0, GL_RGB, GL_FLOAT, &lightmap.texels[0]);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+
+    // adds the second uv set to an existing VAO
+    void attach(unsigned int VAO, const std::vector<glm::vec2>& uvs)
+    {
+        GlBuffer VBO = GlBuffer::create();
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferData(GL_ARRAY_BUFFER, uvs.size() * sizeof(glm::vec2), &uvs[0], GL_STATIC_DRAW);
+        glEnableVertexAttribArray(3);
+        glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), (void*)0);
+        glBindVertexArray(0);
+        uvBuffers.push_back(std::move(VBO));
+    }
+
+    void bind(Shader& shader, int unit, int bakedLightCount, bool bakedSun)
+    {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        shader.setInt("lightmap", unit);
+        shader.setInt("bakedLightCount", bakedLightCount);
+        shader.setBool("bakedSun", bakedSun);
+    }
+
+private:
+    std::vector<GlBuffer> uvBuffers;
+};
+#endif
@@ -0,0 +1,125 @@
+#ifndef MATERIAL_H
+#define MATERIAL_H
+
+#include <glad/glad.h>
+
+#include "shader.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+using namespace std;
+
+struct Texture {
+    unsigned int id;
+    string type;
+    string path;
+};
+
+// a texture and the unit it is bound to
+struct TextureBinding {
+    unsigned int unit;
+    unsigned int texture;
+};
+
+// Texture units of the sampler names a model's shaders use ("texture_diffuse1", "texture_specular1", ...),
+// shared by all of the model's materials: a name always gets the same unit, so a program's sampler uniforms are
+// set once, by apply(), instead of before every draw. Units are handed out in the order names first come up,
+// below MAX_UNITS: the units from there on belong to the renderer (irradiance volume, bones, shadow maps).
+class SamplerSlots
+{
+public:
+    static const unsigned int MAX_UNITS = 8;
+    // what slot() returns for a name past MAX_UNITS, whose textures aren't bound
+    static const unsigned int NO_UNIT = ~0u;
+
+    unsigned int slot(const std::string& name)
+    {
+        for (size_t i = 0; i < names.size(); i++)
+            if (names[i] == name)
+                return (unsigned int)i;
+        if (names.size() == MAX_UNITS)
+        {
+            std::cout << "ERROR::MATERIAL::TOO_MANY_SAMPLERS: " << name << " left unbound, units " << MAX_UNITS << " and up are taken" << std::endl;
+            return NO_UNIT;
+        }
+        names.push_back(name);
+        return (unsigned int)names.size() - 1;
+    }
+
+    // points the program's samplers at their units; the program has to be in use
+    void apply(const Shader& shader) const
+    {
+        for (size_t i = 0; i < names.size(); i++)
+            glUniform1i(glGetUniformLocation(shader.ID, names[i].c_str()), (GLint)i);
+    }
+
+    size_t size() const { return names.size(); }
+
+private:
+    std::vector<std::string> names;
+};
+
+// The textures of a mesh resolved into a fixed binding set when the model loads. Materials with the same
+// bindings share an id, which is what draws are sorted and batched by: binding one is only glActiveTexture and
+// glBindTexture calls, and only when the previous draw used another.
+class Material
+{
+public:
+    // -1 for a material no model has numbered yet
+    int id;
+
+    Material() : id(-1) {}
+
+    // names the textures by type and count as the shaders expect them, texture_diffuse1 being the first diffuse
+    // one, and looks the names up in slots
+    Material(const std::vector<Texture>& textures, SamplerSlots& slots) : id(-1)
+    {
+        unsigned int diffuseNr = 1;
+        unsigned int specularNr = 1;
+        unsigned int normalNr = 1;
+        unsigned int heightNr = 1;
+        for (const Texture& texture : textures)
+        {
+            std::string number;
+            const std::string& name = texture.type;
+            if (name == "texture_diffuse")
+                number = std::to_string(diffuseNr++);
+            else if (name == "texture_specular")
+                number = std::to_string(specularNr++);
+            else if (name == "texture_normal")
+                number = std::to_string(normalNr++);
+            else if (name == "texture_height")
+                number = std::to_string(heightNr++);
+            unsigned int unit = slots.slot(name + number);
+            if (unit != SamplerSlots::NO_UNIT)
+                bindingSet.push_back(TextureBinding{ unit, texture.id });
+        }
+    }
+
+    const std::vector<TextureBinding>& bindings() const { return bindingSet; }
+
+    bool sameBindings(const Material& other) const
+    {
+        if (bindingSet.size() != other.bindingSet.size())
+            return false;
+        for (size_t i = 0; i < bindingSet.size(); i++)
+            if (bindingSet[i].unit != other.bindingSet[i].unit || bindingSet[i].texture != other.bindingSet[i].texture)
+                return false;
+        return true;
+    }
+
+    void bind() const
+    {
+        for (const TextureBinding& binding : bindingSet)
+        {
+            glActiveTexture(GL_TEXTURE0 + binding.unit);
+            glBindTexture(GL_TEXTURE_2D, binding.texture);
+        }
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+private:
+    std::vector<TextureBinding> bindingSet;
+};
+#endif
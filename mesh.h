@@ -6,12 +6,18 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include "gl_handles.h"
+#include "material.h"
 #include "shader.h"
 
+#include <algorithm>
 #include <string>
 #include <vector>
 using namespace std;
 
+// bones that can move one vertex
+const int MAX_BONE_INFLUENCE = 4;
+
 struct Vertex {
     // position
     glm::vec3 Position;
@@ -23,12 +29,32 @@ struct Vertex {
     glm::vec3 Tangent;
     // bitangent
     glm::vec3 Bitangent;
+    // bones moving the vertex and how much, all weights zero for vertices that aren't skinned
+    int BoneIDs[MAX_BONE_INFLUENCE] = { 0, 0, 0, 0 };
+    float Weights[MAX_BONE_INFLUENCE] = { 0.0f, 0.0f, 0.0f, 0.0f };
+};
+
+// one level of detail: a range of the mesh's index buffer
+struct MeshLod {
+    unsigned int firstIndex;
+    unsigned int indexCount;
+    // how far, in model space, this level's surface strays from the full resolution one
+    float error;
+    // the meshlets splitting up that range, see meshlets.h
+    unsigned int firstMeshlet;
+    unsigned int meshletCount;
 };
 
-struct Texture {
-    unsigned int id;
-    string type;
-    string path;
+// a cluster of triangles with its own contiguous index range, and the bounds that let it be culled as a whole:
+// a sphere around it and a cone holding all of its normals (coneCutoff is the sine of the cone's half angle,
+// 1 when the normals spread too far to ever be back facing together)
+struct Meshlet {
+    unsigned int firstIndex;
+    unsigned int indexCount;
+    glm::vec3 center;
+    float radius;
+    glm::vec3 coneAxis;
+    float coneCutoff;
 };
 
 class Mesh {
@@ -37,68 +63,82 @@ public:
     vector<Vertex>       vertices;
     vector<unsigned int> indices;
     vector<Texture>      textures;
-    unsigned int VAO;
-
-    // constructor
-    Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures)
+    // the textures as bound for drawing, filled in by the model that owns the mesh
+    Material             material;
+    // levels of detail, finest first; their index ranges all live in indices
+    vector<MeshLod>      lods;
+    vector<Meshlet>      meshlets;
+    // whether any vertex has bone weights
+    bool                 skinned;
+    GlVertexArray VAO;
+
+    // constructor, takes over the arrays it is handed; pass them with std::move to skip the copies
+    Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures, vector<MeshLod> lods = vector<MeshLod>(), vector<Meshlet> meshlets = vector<Meshlet>())
     {
-        this->vertices = vertices;
-        this->indices = indices;
-        this->textures = textures;
+        this->vertices = std::move(vertices);
+        this->indices = std::move(indices);
+        this->textures = std::move(textures);
+        this->lods = std::move(lods);
+        this->meshlets = std::move(meshlets);
+        if (this->lods.empty())
+            this->lods.push_back(MeshLod{ 0, (unsigned int)this->indices.size(), 0.0f, 0, 0 });
+        skinned = false;
+        for (const Vertex& vertex : this->vertices)
+            skinned = skinned || vertex.Weights[0] > 0.0f;
 
         // now that we have all the required data, set the vertex buffers and its attribute pointers.
         setupMesh();
     }
 
-    // render the mesh
-    void Draw(Shader& shader)
+    // a mesh owns its GL objects, so it moves (into a vector, say) but never copies
+    Mesh(Mesh&&) = default;
+    Mesh& operator=(Mesh&&) = default;
+
+    // render the mesh, at the given level of detail or the coarsest one it has. bindMaterial can be false when
+    // the previous draw left the same material bound.
+    void Draw(int lod = 0, bool bindMaterial = true)
     {
-        // bind appropriate textures
-        unsigned int diffuseNr = 1;
-        unsigned int specularNr = 1;
-        unsigned int normalNr = 1;
-        unsigned int heightNr = 1;
-        for (unsigned int i = 0; i < textures.size(); i++)
-        {
-            glActiveTexture(GL_TEXTURE0 + i); // active proper texture unit before binding
-            // retrieve texture number (the N in diffuse_textureN)
-            string number;
-            string name = textures[i].type;
-            if (name == "texture_diffuse")
-                number = std::to_string(diffuseNr++);
-            else if (name == "texture_specular")
-                number = std::to_string(specularNr++); // transfer unsigned int to stream
-            else if (name == "texture_normal")
-                number = std::to_string(normalNr++); // transfer unsigned int to stream
-            else if (name == "texture_height")
-                number = std::to_string(heightNr++); // transfer unsigned int to stream
-
-            // now set the sampler to the correct texture unit
-            glUniform1i(glGetUniformLocation(shader.ID, (name + number).c_str()), i);
-            // and finally bind the texture
-            glBindTexture(GL_TEXTURE_2D, textures[i].id);
-        }
+        if (bindMaterial)
+            material.bind();
 
         // draw mesh
+        const MeshLod& level = lods[std::min(std::max(lod, 0), (int)lods.size() - 1)];
         glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
+        glDrawElements(GL_TRIANGLES, level.indexCount, GL_UNSIGNED_INT, (void*)(level.firstIndex * sizeof(unsigned int)));
         glBindVertexArray(0);
+    }
 
-        // always good practice to set everything back to defaults once configured.
-        glActiveTexture(GL_TEXTURE0);
+    // render only some ranges of the index buffer, e.g. the meshlets that survived culling, in one call
+    void DrawRanges(const vector<GLsizei>& counts, const vector<const void*>& offsets, bool bindMaterial = true)
+    {
+        if (counts.empty())
+            return;
+        if (bindMaterial)
+            material.bind();
+        glBindVertexArray(VAO);
+        glMultiDrawElements(GL_TRIANGLES, &counts[0], GL_UNSIGNED_INT, &offsets[0], (GLsizei)counts.size());
+        glBindVertexArray(0);
+    }
+
+    // replaces the vertex buffer's contents, e.g. with vertices skinned on the CPU; same count as vertices
+    void UpdateVertices(const vector<Vertex>& updated)
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, updated.size() * sizeof(Vertex), &updated[0]);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
     }
 
 private:
     // render data 
-    unsigned int VBO, EBO;
+    GlBuffer VBO, EBO;
 
     // initializes all the buffer objects/arrays
     void setupMesh()
     {
         // create buffers/arrays
-        glGenVertexArrays(1, &VAO);
-        glGenBuffers(1, &VBO);
-        glGenBuffers(1, &EBO);
+        VAO = GlVertexArray::create();
+        VBO = GlBuffer::create();
+        EBO = GlBuffer::create();
 
         glBindVertexArray(VAO);
         // load data into vertex buffers
@@ -106,7 +146,7 @@ private:
         // A great thing about structs is that their memory layout is sequential for all its items.
         // The effect is that we can simply pass a pointer to the struct and it translates perfectly to a glm::vec3/2 array which
         // again translates to 3/2 floats which translates to a byte array.
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
+        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], skinned ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW);
 
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
         glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
@@ -127,6 +167,12 @@ private:
         // vertex bitangent
         glEnableVertexAttribArray(4);
         glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Bitangent));
+        // bone ids
+        glEnableVertexAttribArray(5);
+        glVertexAttribIPointer(5, MAX_BONE_INFLUENCE, GL_INT, sizeof(Vertex), (void*)offsetof(Vertex, BoneIDs));
+        // bone weights
+        glEnableVertexAttribArray(6);
+        glVertexAttribPointer(6, MAX_BONE_INFLUENCE, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Weights));
 
         glBindVertexArray(0);
     }
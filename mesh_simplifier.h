@@ -0,0 +1,403 @@
+#ifndef MESH_SIMPLIFIER_H
+#define MESH_SIMPLIFIER_H
+
+#include <glm/glm.hpp>
+
+#include "mesh.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+using namespace std;
+
+struct LodSettings {
+    // simplified levels generated below the full resolution mesh
+    int levels = 4;
+    // triangle count of each level relative to the one above it
+    float reduction = 0.5f;
+    // a level stops simplifying once a collapse would move the surface further than this fraction of the mesh size
+    float maxRelativeError = 0.05f;
+    // meshes smaller than this are left at full resolution
+    int minTriangles = 64;
+};
+
+// Edge collapse simplifier driven by quadric error metrics (Garland & Heckbert). Vertices only ever collapse onto
+// one of their neighbours, so every level indexes the original vertex buffer and just needs its own index range.
+// UV and normal seams stay intact: vertices sharing a position are treated as one, a vertex split by a seam may only
+// slide along that seam (taking its twin on the other side with it), open borders only slide along the border, and
+// anything more tangled than that is locked.
+class MeshSimplifier
+{
+public:
+    MeshSimplifier(const vector<Vertex>& meshVertices, const vector<unsigned int>& meshIndices)
+        : vertices(meshVertices), indices(meshIndices), maxError(0.0f)
+    {
+        weldPositions();
+        buildQuadrics();
+    }
+
+    // current index buffer and the largest object space distance the collapses so far have moved the surface
+    const vector<unsigned int>& result() const { return indices; }
+    float error() const { return maxError; }
+
+    // keeps collapsing the cheapest edges until at most targetIndexCount indices are left, no collapse stays
+    // under errorLimit, or nothing can collapse without breaking a seam, a border or flipping a triangle
+    void simplify(size_t targetIndexCount, float errorLimit)
+    {
+        while (indices.size() > targetIndexCount)
+        {
+            if (!collapsePass(targetIndexCount / 3, errorLimit * errorLimit))
+                break;
+        }
+    }
+
+private:
+    enum VertexKind { MANIFOLD, BORDER, SEAM, LOCKED };
+
+    struct Quadric {
+        float a00, a11, a22, a10, a20, a21, b0, b1, b2, c, weight;
+
+        static Quadric plane(const glm::vec3& n, float d, float w)
+        {
+            Quadric q;
+            q.a00 = w * n.x * n.x; q.a11 = w * n.y * n.y; q.a22 = w * n.z * n.z;
+            q.a10 = w * n.y * n.x; q.a20 = w * n.z * n.x; q.a21 = w * n.z * n.y;
+            q.b0 = w * n.x * d; q.b1 = w * n.y * d; q.b2 = w * n.z * d;
+            q.c = w * d * d;
+            q.weight = w;
+            return q;
+        }
+
+        void add(const Quadric& q)
+        {
+            a00 += q.a00; a11 += q.a11; a22 += q.a22; a10 += q.a10; a20 += q.a20; a21 += q.a21;
+            b0 += q.b0; b1 += q.b1; b2 += q.b2; c += q.c; weight += q.weight;
+        }
+
+        // squared distance to the accumulated planes, averaged by their weight
+        float error(const glm::vec3& p) const
+        {
+            float e = a00 * p.x * p.x + a11 * p.y * p.y + a22 * p.z * p.z
+                + 2.0f * (a10 * p.x * p.y + a20 * p.x * p.z + a21 * p.y * p.z)
+                + 2.0f * (b0 * p.x + b1 * p.y + b2 * p.z) + c;
+            return weight > 0.0f ? std::fabs(e) / weight : 0.0f;
+        }
+    };
+
+    struct Collapse {
+        unsigned int from, to;
+        float cost;
+        bool operator<(const Collapse& other) const { return cost < other.cost; }
+    };
+
+    // open edges inside the border quadrics count this much more than the faces, so outlines hold their shape
+    static float borderWeight() { return 10.0f; }
+
+    const vector<Vertex>& vertices;
+    vector<unsigned int> indices;
+    // first vertex with the same position, the unit seams and quadrics work in
+    vector<unsigned int> positionOf;
+    vector<Quadric> quadrics;
+    float maxError;
+
+    static uint64_t edgeKey(unsigned int a, unsigned int b) { return ((uint64_t)a << 32) | b; }
+
+    void weldPositions()
+    {
+        struct PositionHash {
+            size_t operator()(const glm::vec3& p) const
+            {
+                uint32_t bits[3];
+                std::memcpy(bits, &p, sizeof(bits));
+                return (bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u);
+            }
+        };
+        unordered_map<glm::vec3, unsigned int, PositionHash> firstAt;
+        positionOf.resize(vertices.size());
+        for (unsigned int v = 0; v < vertices.size(); v++)
+            positionOf[v] = firstAt.insert(std::make_pair(vertices[v].Position, v)).first->second;
+    }
+
+    void buildQuadrics()
+    {
+        Quadric zero;
+        std::memset(&zero, 0, sizeof(zero));
+        quadrics.assign(vertices.size(), zero);
+
+        unordered_set<uint64_t> indexEdges, positionEdges;
+        for (size_t t = 0; t + 2 < indices.size(); t += 3)
+            for (int e = 0; e < 3; e++)
+            {
+                unsigned int a = indices[t + e], b = indices[t + (e + 1) % 3];
+                indexEdges.insert(edgeKey(a, b));
+                positionEdges.insert(edgeKey(positionOf[a], positionOf[b]));
+            }
+
+        for (size_t t = 0; t + 2 < indices.size(); t += 3)
+        {
+            glm::vec3 p[3];
+            for (int e = 0; e < 3; e++)
+                p[e] = vertices[indices[t + e]].Position;
+            glm::vec3 normal = glm::cross(p[1] - p[0], p[2] - p[0]);
+            float length = glm::length(normal);
+            if (length <= 0.0f)
+                continue;
+            normal /= length;
+            Quadric face = Quadric::plane(normal, -glm::dot(normal, p[0]), length * 0.5f);
+            for (int e = 0; e < 3; e++)
+                quadrics[positionOf[indices[t + e]]].add(face);
+
+            // borders and seams get a plane through the edge at right angles to the face
+            for (int e = 0; e < 3; e++)
+            {
+                unsigned int a = indices[t + e], b = indices[t + (e + 1) % 3];
+                bool seam = indexEdges.count(edgeKey(b, a)) == 0;
+                bool border = positionEdges.count(edgeKey(positionOf[b], positionOf[a])) == 0;
+                if (!seam && !border)
+                    continue;
+                glm::vec3 edge = p[(e + 1) % 3] - p[e];
+                glm::vec3 perpendicular = glm::cross(edge, normal);
+                float perpendicularLength = glm::length(perpendicular);
+                if (perpendicularLength <= 0.0f)
+                    continue;
+                perpendicular /= perpendicularLength;
+                Quadric outline = Quadric::plane(perpendicular, -glm::dot(perpendicular, p[e]), glm::dot(edge, edge) * borderWeight());
+                quadrics[positionOf[a]].add(outline);
+                quadrics[positionOf[b]].add(outline);
+            }
+        }
+    }
+
+    // one round of independent collapses, cheapest first; false once nothing could collapse
+    bool collapsePass(size_t targetTriangles, float errorLimitSquared)
+    {
+        size_t triangles = indices.size() / 3;
+        size_t vertexCount = vertices.size();
+
+        // topology of what is left
+        unordered_set<uint64_t> indexEdges, positionEdges;
+        indexEdges.reserve(indices.size() * 2);
+        positionEdges.reserve(indices.size() * 2);
+        for (size_t t = 0; t < indices.size(); t += 3)
+            for (int e = 0; e < 3; e++)
+            {
+                unsigned int a = indices[t + e], b = indices[t + (e + 1) % 3];
+                indexEdges.insert(edgeKey(a, b));
+                positionEdges.insert(edgeKey(positionOf[a], positionOf[b]));
+            }
+
+        vector<unsigned char> openOut(vertexCount, 0), openIn(vertexCount, 0), borderOut(vertexCount, 0), borderIn(vertexCount, 0);
+        vector<unsigned char> referenced(vertexCount, 0);
+        for (size_t t = 0; t < indices.size(); t += 3)
+            for (int e = 0; e < 3; e++)
+            {
+                unsigned int a = indices[t + e], b = indices[t + (e + 1) % 3];
+                referenced[a] = 1;
+                if (indexEdges.count(edgeKey(b, a)) == 0)
+                {
+                    openOut[a] = (unsigned char)std::min(openOut[a] + 1, 255);
+                    openIn[b] = (unsigned char)std::min(openIn[b] + 1, 255);
+                }
+                if (positionEdges.count(edgeKey(positionOf[b], positionOf[a])) == 0)
+                {
+                    borderOut[a] = (unsigned char)std::min(borderOut[a] + 1, 255);
+                    borderIn[b] = (unsigned char)std::min(borderIn[b] + 1, 255);
+                }
+            }
+
+        // the vertices still referenced at each position
+        vector<unsigned int> wedgeCount(vertexCount, 0);
+        vector<unsigned int> twin(vertexCount, ~0u);
+        vector<unsigned int> firstWedge(vertexCount, ~0u);
+        for (unsigned int v = 0; v < vertexCount; v++)
+        {
+            if (!referenced[v])
+                continue;
+            unsigned int p = positionOf[v];
+            if (wedgeCount[p]++ == 0)
+                firstWedge[p] = v;
+            else
+            {
+                twin[v] = firstWedge[p];
+                twin[firstWedge[p]] = v;
+            }
+        }
+
+        vector<unsigned char> kind(vertexCount, LOCKED);
+        for (unsigned int v = 0; v < vertexCount; v++)
+        {
+            if (!referenced[v])
+                continue;
+            unsigned int wedges = wedgeCount[positionOf[v]];
+            bool simpleOpen = openOut[v] == 1 && openIn[v] == 1;
+            if (wedges == 1 && openOut[v] == 0 && openIn[v] == 0)
+                kind[v] = MANIFOLD;
+            else if (wedges == 1 && simpleOpen && borderOut[v] == 1 && borderIn[v] == 1)
+                kind[v] = BORDER;
+            else if (wedges == 2 && simpleOpen && borderOut[v] == 0 && borderIn[v] == 0
+                && openOut[twin[v]] == 1 && openIn[twin[v]] == 1 && borderOut[twin[v]] == 0 && borderIn[twin[v]] == 0)
+                kind[v] = SEAM;
+        }
+
+        // candidates along every edge, both ways
+        vector<Collapse> candidates;
+        candidates.reserve(indices.size() * 2);
+        for (size_t t = 0; t < indices.size(); t += 3)
+            for (int e = 0; e < 3; e++)
+            {
+                unsigned int a = indices[t + e], b = indices[t + (e + 1) % 3];
+                bool open = indexEdges.count(edgeKey(b, a)) == 0;
+                // an interior edge is listed by both of its triangles, keep one copy
+                if (!open && a > b)
+                    continue;
+                for (int direction = 0; direction < 2; direction++)
+                {
+                    unsigned int from = direction ? b : a, to = direction ? a : b;
+                    bool allowed = kind[from] == MANIFOLD || ((kind[from] == BORDER || kind[from] == SEAM) && open);
+                    if (!allowed)
+                        continue;
+                    Quadric q = quadrics[positionOf[from]];
+                    q.add(quadrics[positionOf[to]]);
+                    candidates.push_back(Collapse{ from, to, q.error(vertices[to].Position) });
+                }
+            }
+        std::sort(candidates.begin(), candidates.end());
+
+        // triangles around every position, for the flip test and for locking the neighbourhood of a collapse
+        vector<unsigned int> adjacencyOffsets(vertexCount + 1, 0), adjacency(indices.size());
+        for (size_t i = 0; i < indices.size(); i++)
+            adjacencyOffsets[positionOf[indices[i]] + 1]++;
+        for (size_t v = 0; v < vertexCount; v++)
+            adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+        vector<unsigned int> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+        for (size_t i = 0; i < indices.size(); i++)
+            adjacency[fill[positionOf[indices[i]]]++] = (unsigned int)(i / 3);
+
+        vector<unsigned int> collapseTo(vertexCount);
+        for (unsigned int v = 0; v < vertexCount; v++)
+            collapseTo[v] = v;
+        vector<unsigned char> touched(vertexCount, 0);
+        size_t collapses = 0;
+        size_t removed = 0;
+        size_t goal = triangles > targetTriangles ? triangles - targetTriangles : 0;
+
+        for (const Collapse& collapse : candidates)
+        {
+            if (removed >= goal || collapse.cost > errorLimitSquared)
+                break;
+            unsigned int fromPosition = positionOf[collapse.from], toPosition = positionOf[collapse.to];
+            if (touched[fromPosition] || touched[toPosition])
+                continue;
+
+            // a seam vertex drags its twin along the matching edge on the other side
+            unsigned int twinFrom = ~0u, twinTo = ~0u;
+            if (kind[collapse.from] == SEAM)
+            {
+                twinFrom = twin[collapse.from];
+                unsigned int other = twin[collapse.to] != ~0u ? twin[collapse.to] : collapse.to;
+                if (indexEdges.count(edgeKey(twinFrom, other)) || indexEdges.count(edgeKey(other, twinFrom)))
+                    twinTo = other;
+                else if (indexEdges.count(edgeKey(twinFrom, collapse.to)) || indexEdges.count(edgeKey(collapse.to, twinFrom)))
+                    twinTo = collapse.to;
+                else
+                    continue;
+            }
+
+            if (flips(fromPosition, toPosition, adjacency, adjacencyOffsets))
+                continue;
+
+            collapseTo[collapse.from] = collapse.to;
+            if (twinFrom != ~0u)
+                collapseTo[twinFrom] = twinTo;
+            quadrics[toPosition].add(quadrics[fromPosition]);
+            maxError = std::max(maxError, std::sqrt(collapse.cost));
+            collapses++;
+            removed += kind[collapse.from] == MANIFOLD ? 2 : 1;
+
+            // nothing around this collapse moves again this pass, so the flip tests above stay valid
+            for (unsigned int a = adjacencyOffsets[fromPosition]; a < adjacencyOffsets[fromPosition + 1]; a++)
+                for (int c = 0; c < 3; c++)
+                    touched[positionOf[indices[adjacency[a] * 3 + c]]] = 1;
+        }
+        if (collapses == 0)
+            return false;
+
+        // rewrite the triangles and drop the ones that lost an edge
+        size_t write = 0;
+        for (size_t t = 0; t < indices.size(); t += 3)
+        {
+            unsigned int a = collapseTo[indices[t]], b = collapseTo[indices[t + 1]], c = collapseTo[indices[t + 2]];
+            if (positionOf[a] == positionOf[b] || positionOf[b] == positionOf[c] || positionOf[a] == positionOf[c])
+                continue;
+            indices[write++] = a;
+            indices[write++] = b;
+            indices[write++] = c;
+        }
+        indices.resize(write);
+        return true;
+    }
+
+    // whether moving fromPosition onto toPosition turns any surviving triangle around it over
+    bool flips(unsigned int fromPosition, unsigned int toPosition, const vector<unsigned int>& adjacency, const vector<unsigned int>& offsets) const
+    {
+        const glm::vec3& target = vertices[toPosition].Position;
+        for (unsigned int a = offsets[fromPosition]; a < offsets[fromPosition + 1]; a++)
+        {
+            size_t t = (size_t)adjacency[a] * 3;
+            glm::vec3 before[3], after[3];
+            bool degenerate = false;
+            for (int c = 0; c < 3; c++)
+            {
+                unsigned int position = positionOf[indices[t + c]];
+                degenerate = degenerate || position == toPosition;
+                before[c] = vertices[position].Position;
+                after[c] = position == fromPosition ? target : before[c];
+            }
+            if (degenerate)
+                continue;
+            glm::vec3 normalBefore = glm::cross(before[1] - before[0], before[2] - before[0]);
+            glm::vec3 normalAfter = glm::cross(after[1] - after[0], after[2] - after[0]);
+            if (glm::dot(normalBefore, normalAfter) <= 0.25f * glm::length(normalBefore) * glm::length(normalAfter))
+                return true;
+        }
+        return false;
+    }
+};
+
+// Appends the simplified levels of a mesh to its index buffer and describes every level, the full resolution one
+// included, as a range of that buffer.
+inline vector<MeshLod> buildMeshLods(const vector<Vertex>& vertices, vector<unsigned int>& indices, const LodSettings& settings = LodSettings())
+{
+    vector<MeshLod> lods(1, MeshLod{ 0, (unsigned int)indices.size(), 0.0f, 0, 0 });
+    if (indices.size() / 3 < (size_t)settings.minTriangles || vertices.empty())
+        return lods;
+
+    glm::vec3 boundsMin(vertices[0].Position), boundsMax(vertices[0].Position);
+    for (const Vertex& vertex : vertices)
+    {
+        boundsMin = glm::min(boundsMin, vertex.Position);
+        boundsMax = glm::max(boundsMax, vertex.Position);
+    }
+    float errorLimit = glm::length(boundsMax - boundsMin) * settings.maxRelativeError;
+
+    MeshSimplifier simplifier(vertices, indices);
+    size_t previousCount = indices.size();
+    for (int level = 1; level <= settings.levels; level++)
+    {
+        size_t target = (size_t)(previousCount / 3 * settings.reduction) * 3;
+        simplifier.simplify(target, errorLimit);
+        const vector<unsigned int>& simplified = simplifier.result();
+        // a level that barely shrank isn't worth switching to
+        if (simplified.empty() || simplified.size() > previousCount * 9 / 10)
+            break;
+        lods.push_back(MeshLod{ (unsigned int)indices.size(), (unsigned int)simplified.size(), simplifier.error(), 0, 0 });
+        indices.insert(indices.end(), simplified.begin(), simplified.end());
+        previousCount = simplified.size();
+    }
+    return lods;
+}
+#endif
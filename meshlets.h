@@ -0,0 +1,343 @@
+#ifndef MESHLETS_H
+#define MESHLETS_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <emmintrin.h>
+
+#include "mesh.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+using namespace std;
+
+// the meshlet size mesh shading hardware settled on; small enough to cull tightly, big enough to draw efficiently
+const unsigned int MESHLET_MAX_VERTICES = 64;
+const unsigned int MESHLET_MAX_TRIANGLES = 124;
+
+// first vertex with the same position as each vertex, so triangles split apart along UV or normal seams, or
+// imported as a soup with a vertex of their own per corner, are still neighbours
+inline vector<unsigned int> meshletPositions(const vector<Vertex>& vertices)
+{
+    struct PositionHash {
+        size_t operator()(const glm::vec3& p) const
+        {
+            uint32_t bits[3];
+            std::memcpy(bits, &p, sizeof(bits));
+            return (bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u);
+        }
+    };
+    unordered_map<glm::vec3, unsigned int, PositionHash> firstAt;
+    vector<unsigned int> positionOf(vertices.size());
+    for (unsigned int v = 0; v < vertices.size(); v++)
+        positionOf[v] = firstAt.insert(std::make_pair(vertices[v].Position, v)).first->second;
+    return positionOf;
+}
+
+// 30 bit Morton code of a point, 10 bits an axis of its place in the bounds
+inline unsigned int meshletMortonCode(const glm::vec3& point, const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+{
+    glm::vec3 extent = glm::max(boundsMax - boundsMin, glm::vec3(1e-20f));
+    glm::vec3 unit = glm::clamp((point - boundsMin) / extent, 0.0f, 1.0f) * 1023.0f;
+    unsigned int axes[3] = { (unsigned int)unit.x, (unsigned int)unit.y, (unsigned int)unit.z };
+    unsigned int code = 0;
+    for (int bit = 0; bit < 10; bit++)
+        for (int axis = 0; axis < 3; axis++)
+            code |= ((axes[axis] >> bit) & 1u) << (bit * 3 + 2 - axis);
+    return code;
+}
+
+// Splits every level of detail of a mesh into meshlets. The triangles of a level are regrouped in place, so each
+// meshlet is a contiguous slice of the level's index range and the level still draws in one call. Meshlets grow
+// greedily from a seed triangle, always taking the neighbour (by position) that brings in the fewest new
+// vertices, which keeps them compact and their normal cones narrow. Seeds, and the triangle a meshlet continues
+// with once it has no neighbours left, are taken in Morton order, the first unused one is close to the last.
+inline vector<Meshlet> buildMeshlets(const vector<Vertex>& vertices, vector<unsigned int>& indices, vector<MeshLod>& lods)
+{
+    vector<Meshlet> meshlets;
+    vector<unsigned int> positionOf = meshletPositions(vertices);
+    vector<unsigned int> triangleOffsets(vertices.size() + 1), vertexTriangles, localVertex(vertices.size(), ~0u);
+    vector<unsigned char> used;
+    vector<unsigned int> candidates, members, regrouped, seedOrder, mortonCodes;
+
+    for (MeshLod& lod : lods)
+    {
+        lod.firstMeshlet = (unsigned int)meshlets.size();
+        const unsigned int* levelIndices = &indices[lod.firstIndex];
+        unsigned int triangleCount = lod.indexCount / 3;
+        if (triangleCount == 0)
+        {
+            lod.meshletCount = 0;
+            continue;
+        }
+
+        // triangles around each vertex
+        std::fill(triangleOffsets.begin(), triangleOffsets.end(), 0u);
+        for (unsigned int i = 0; i < triangleCount * 3; i++)
+            triangleOffsets[positionOf[levelIndices[i]] + 1]++;
+        for (size_t v = 0; v < vertices.size(); v++)
+            triangleOffsets[v + 1] += triangleOffsets[v];
+        vertexTriangles.resize(triangleCount * 3);
+        vector<unsigned int> fill(triangleOffsets.begin(), triangleOffsets.end() - 1);
+        for (unsigned int i = 0; i < triangleCount * 3; i++)
+            vertexTriangles[fill[positionOf[levelIndices[i]]]++] = i / 3;
+
+        glm::vec3 levelMin(FLT_MAX), levelMax(-FLT_MAX);
+        for (unsigned int i = 0; i < triangleCount * 3; i++)
+        {
+            levelMin = glm::min(levelMin, vertices[levelIndices[i]].Position);
+            levelMax = glm::max(levelMax, vertices[levelIndices[i]].Position);
+        }
+        mortonCodes.resize(triangleCount);
+        seedOrder.resize(triangleCount);
+        for (unsigned int t = 0; t < triangleCount; t++)
+        {
+            glm::vec3 centroid = (vertices[levelIndices[t * 3]].Position + vertices[levelIndices[t * 3 + 1]].Position + vertices[levelIndices[t * 3 + 2]].Position) / 3.0f;
+            mortonCodes[t] = meshletMortonCode(centroid, levelMin, levelMax);
+            seedOrder[t] = t;
+        }
+        std::sort(seedOrder.begin(), seedOrder.end(), [&](unsigned int a, unsigned int b) { return mortonCodes[a] < mortonCodes[b]; });
+        float levelSize = glm::length(levelMax - levelMin);
+
+        used.assign(triangleCount, 0);
+        regrouped.clear();
+        regrouped.reserve(triangleCount * 3);
+        unsigned int nextSeed = 0;
+        while (true)
+        {
+            while (nextSeed < triangleCount && used[seedOrder[nextSeed]])
+                nextSeed++;
+            if (nextSeed == triangleCount)
+                break;
+
+            members.clear();
+            candidates.clear();
+            unsigned int vertexCount = 0;
+            unsigned int triangle = seedOrder[nextSeed];
+            glm::vec3 growMin(FLT_MAX), growMax(-FLT_MAX);
+            while (triangle != ~0u)
+            {
+                used[triangle] = 1;
+                members.push_back(triangle);
+                for (int c = 0; c < 3; c++)
+                {
+                    unsigned int v = levelIndices[triangle * 3 + c];
+                    growMin = glm::min(growMin, vertices[v].Position);
+                    growMax = glm::max(growMax, vertices[v].Position);
+                    if (localVertex[v] == ~0u)
+                        localVertex[v] = vertexCount++;
+                    unsigned int position = positionOf[v];
+                    for (unsigned int t = triangleOffsets[position]; t < triangleOffsets[position + 1]; t++)
+                        if (!used[vertexTriangles[t]])
+                            candidates.push_back(vertexTriangles[t]);
+                }
+                if (members.size() == MESHLET_MAX_TRIANGLES)
+                    break;
+
+                // the neighbour that adds the fewest vertices and still fits
+                triangle = ~0u;
+                unsigned int bestNew = 4;
+                size_t write = 0;
+                for (size_t i = 0; i < candidates.size(); i++)
+                {
+                    unsigned int candidate = candidates[i];
+                    if (used[candidate])
+                        continue;
+                    candidates[write++] = candidate;
+                    unsigned int added = 0;
+                    for (int c = 0; c < 3; c++)
+                        added += localVertex[levelIndices[candidate * 3 + c]] == ~0u ? 1 : 0;
+                    if (added < bestNew && vertexCount + added <= MESHLET_MAX_VERTICES)
+                    {
+                        bestNew = added;
+                        triangle = candidate;
+                    }
+                }
+                candidates.resize(write);
+
+                // no neighbour left: carry on with the nearest unused triangle in Morton order if it fits and keeps
+                // the meshlet within a sixteenth of the level's size, a meshlet spread wider would rarely be culled
+                if (triangle == ~0u)
+                {
+                    while (nextSeed < triangleCount && used[seedOrder[nextSeed]])
+                        nextSeed++;
+                    if (nextSeed == triangleCount)
+                        break;
+                    unsigned int next = seedOrder[nextSeed], added = 0;
+                    for (int c = 0; c < 3; c++)
+                        added += localVertex[levelIndices[next * 3 + c]] == ~0u ? 1 : 0;
+                    glm::vec3 nextMin = growMin, nextMax = growMax;
+                    for (int c = 0; c < 3; c++)
+                    {
+                        nextMin = glm::min(nextMin, vertices[levelIndices[next * 3 + c]].Position);
+                        nextMax = glm::max(nextMax, vertices[levelIndices[next * 3 + c]].Position);
+                    }
+                    if (vertexCount + added <= MESHLET_MAX_VERTICES && glm::length(nextMax - nextMin) <= levelSize / 16.0f)
+                        triangle = next;
+                }
+            }
+
+            Meshlet meshlet;
+            meshlet.firstIndex = lod.firstIndex + (unsigned int)regrouped.size();
+            meshlet.indexCount = (unsigned int)members.size() * 3;
+            glm::vec3 boundsMin(FLT_MAX), boundsMax(-FLT_MAX), normalSum(0.0f);
+            for (unsigned int member : members)
+            {
+                glm::vec3 p[3];
+                for (int c = 0; c < 3; c++)
+                {
+                    unsigned int v = levelIndices[member * 3 + c];
+                    localVertex[v] = ~0u;
+                    regrouped.push_back(v);
+                    p[c] = vertices[v].Position;
+                    boundsMin = glm::min(boundsMin, p[c]);
+                    boundsMax = glm::max(boundsMax, p[c]);
+                }
+                glm::vec3 normal = glm::cross(p[1] - p[0], p[2] - p[0]);
+                float length = glm::length(normal);
+                if (length > 0.0f)
+                    normalSum += normal / length;
+            }
+            meshlet.center = (boundsMin + boundsMax) * 0.5f;
+            meshlet.radius = 0.0f;
+            for (size_t i = regrouped.size() - meshlet.indexCount; i < regrouped.size(); i++)
+                meshlet.radius = std::max(meshlet.radius, glm::length(vertices[regrouped[i]].Position - meshlet.center));
+
+            // the widest angle between the average normal and any triangle's bounds the cone
+            float axisLength = glm::length(normalSum);
+            meshlet.coneAxis = axisLength > 0.0f ? normalSum / axisLength : glm::vec3(0.0f, 0.0f, 1.0f);
+            float minDot = axisLength > 0.0f ? 1.0f : -1.0f;
+            for (size_t i = regrouped.size() - meshlet.indexCount; i < regrouped.size(); i += 3)
+            {
+                glm::vec3 normal = glm::cross(vertices[regrouped[i + 1]].Position - vertices[regrouped[i]].Position,
+                    vertices[regrouped[i + 2]].Position - vertices[regrouped[i]].Position);
+                float length = glm::length(normal);
+                if (length > 0.0f)
+                    minDot = std::min(minDot, glm::dot(meshlet.coneAxis, normal / length));
+            }
+            meshlet.coneCutoff = minDot > 0.0f ? std::sqrt(1.0f - minDot * minDot) : 1.0f;
+            meshlets.push_back(meshlet);
+        }
+
+        std::copy(regrouped.begin(), regrouped.end(), indices.begin() + lod.firstIndex);
+        lod.meshletCount = (unsigned int)meshlets.size() - lod.firstMeshlet;
+    }
+    return meshlets;
+}
+
+// Per frame cluster culling on the CPU: four meshlets at a time against the six frustum planes and their normal
+// cones, with SSE. The survivors come out as index ranges, neighbouring ones merged, ready for glMultiDrawElements.
+class MeshletCuller
+{
+public:
+    // index ranges that survived the last cull
+    vector<GLsizei> counts;
+    vector<const void*> offsets;
+    // triangles of the level before and after culling, summed since the last resetStats
+    size_t submittedTriangles;
+    size_t visibleTriangles;
+
+    MeshletCuller() : submittedTriangles(0), visibleTriangles(0) {}
+
+    void resetStats()
+    {
+        submittedTriangles = 0;
+        visibleTriangles = 0;
+    }
+
+    // modelViewProjection takes the mesh to clip space, cameraPosition is in the mesh's model space; back facing
+    // clusters are only dropped when backfaceCulling is set, as models may rely on two sided triangles
+    void cull(const Mesh& mesh, int lod, const glm::mat4& modelViewProjection, const glm::vec3& cameraPosition, bool backfaceCulling = true)
+    {
+        counts.clear();
+        offsets.clear();
+        const MeshLod& level = mesh.lods[std::min(std::max(lod, 0), (int)mesh.lods.size() - 1)];
+        submittedTriangles += level.indexCount / 3;
+        if (level.meshletCount == 0)
+        {
+            // nothing to cull with, draw the level whole
+            addRange(level.firstIndex, level.indexCount);
+            visibleTriangles += level.indexCount / 3;
+            return;
+        }
+
+        // frustum planes in model space, normalized so the sphere radii compare against real distances
+        __m128 planeX[6], planeY[6], planeZ[6], planeW[6];
+        for (int p = 0; p < 6; p++)
+        {
+            int row = p / 2;
+            float sign = (p % 2) ? -1.0f : 1.0f;
+            glm::vec4 plane;
+            for (int column = 0; column < 4; column++)
+                plane[column] = modelViewProjection[column][3] + sign * modelViewProjection[column][row];
+            float length = glm::length(glm::vec3(plane));
+            plane /= length > 0.0f ? length : 1.0f;
+            planeX[p] = _mm_set1_ps(plane.x);
+            planeY[p] = _mm_set1_ps(plane.y);
+            planeZ[p] = _mm_set1_ps(plane.z);
+            planeW[p] = _mm_set1_ps(plane.w);
+        }
+        const __m128 cameraX = _mm_set1_ps(cameraPosition.x), cameraY = _mm_set1_ps(cameraPosition.y), cameraZ = _mm_set1_ps(cameraPosition.z);
+        const __m128 cullBackfaces = backfaceCulling ? _mm_castsi128_ps(_mm_set1_epi32(-1)) : _mm_setzero_ps();
+
+        const Meshlet* meshlets = &mesh.meshlets[level.firstMeshlet];
+        for (unsigned int first = 0; first < level.meshletCount; first += 4)
+        {
+            // the last group is padded with copies of its first meshlet, whose results are ignored
+            const Meshlet* group[4];
+            for (int i = 0; i < 4; i++)
+                group[i] = &meshlets[first + i < level.meshletCount ? first + i : first];
+
+            __m128 cx = _mm_loadu_ps(&group[0]->center.x), cy = _mm_loadu_ps(&group[1]->center.x);
+            __m128 cz = _mm_loadu_ps(&group[2]->center.x), radius = _mm_loadu_ps(&group[3]->center.x);
+            _MM_TRANSPOSE4_PS(cx, cy, cz, radius);
+            __m128 ax = _mm_loadu_ps(&group[0]->coneAxis.x), ay = _mm_loadu_ps(&group[1]->coneAxis.x);
+            __m128 az = _mm_loadu_ps(&group[2]->coneAxis.x), cutoff = _mm_loadu_ps(&group[3]->coneAxis.x);
+            _MM_TRANSPOSE4_PS(ax, ay, az, cutoff);
+
+            __m128 negativeRadius = _mm_sub_ps(_mm_setzero_ps(), radius);
+            __m128 visible = _mm_castsi128_ps(_mm_set1_epi32(-1));
+            for (int p = 0; p < 6; p++)
+            {
+                __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(planeX[p], cx), _mm_mul_ps(planeY[p], cy)),
+                    _mm_add_ps(_mm_mul_ps(planeZ[p], cz), planeW[p]));
+                visible = _mm_and_ps(visible, _mm_cmpge_ps(distance, negativeRadius));
+            }
+
+            // back facing: every normal in the cone points away from every point of the sphere
+            __m128 vx = _mm_sub_ps(cx, cameraX), vy = _mm_sub_ps(cy, cameraY), vz = _mm_sub_ps(cz, cameraZ);
+            __m128 along = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, ax), _mm_mul_ps(vy, ay)), _mm_mul_ps(vz, az));
+            __m128 distance = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)), _mm_mul_ps(vz, vz)));
+            __m128 backFacing = _mm_cmpge_ps(along, _mm_add_ps(_mm_mul_ps(cutoff, distance), radius));
+            visible = _mm_andnot_ps(_mm_and_ps(backFacing, cullBackfaces), visible);
+
+            int mask = _mm_movemask_ps(visible);
+            for (int i = 0; i < 4 && first + i < level.meshletCount; i++)
+            {
+                if (!(mask & (1 << i)))
+                    continue;
+                addRange(group[i]->firstIndex, group[i]->indexCount);
+                visibleTriangles += group[i]->indexCount / 3;
+            }
+        }
+    }
+
+private:
+    void addRange(unsigned int firstIndex, unsigned int indexCount)
+    {
+        const void* offset = (const void*)((size_t)firstIndex * sizeof(unsigned int));
+        if (!counts.empty() && (const char*)offsets.back() + counts.back() * sizeof(unsigned int) == (const char*)offset)
+            counts.back() += (GLsizei)indexCount;
+        else
+        {
+            counts.push_back((GLsizei)indexCount);
+            offsets.push_back(offset);
+        }
+    }
+};
+#endif
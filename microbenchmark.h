@@ -0,0 +1,354 @@
+#ifndef MICROBENCHMARK_H
+#define MICROBENCHMARK_H
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <regex>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+// CPU time of the calling thread in seconds; GL work the driver does on its own threads isn't in it, which is
+// what the real time column is for
+inline double threadCpuSeconds()
+{
+#ifdef _WIN32
+    FILETIME creation, exit, kernel, user;
+    GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user);
+    ULARGE_INTEGER k, u;
+    k.LowPart = kernel.dwLowDateTime;
+    k.HighPart = kernel.dwHighDateTime;
+    u.LowPart = user.dwLowDateTime;
+    u.HighPart = user.dwHighDateTime;
+    return (k.QuadPart + u.QuadPart) * 1e-7;
+#else
+    timespec now;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+#endif
+}
+
+// keeps the compiler from dropping a computation whose result is never used
+template <class T>
+inline void doNotOptimize(const T& value)
+{
+#ifdef _MSC_VER
+    static volatile char sink;
+    sink = *(const volatile char*)&value;
+#else
+    asm volatile("" : : "r,m"(value) : "memory");
+#endif
+}
+
+// What a benchmark's function gets, in the way of google benchmark: the code under test runs once for every
+// keepRunning() that returns true, with setup before the loop or between pauseTiming() and resumeTiming().
+class BenchmarkState
+{
+public:
+    BenchmarkState(int64_t inputSize, int64_t iterationCount)
+        : size(inputSize), count(iterationCount), done(0), started(false), running(false), items(0), bytes(0), realSeconds(0.0), cpuSeconds(0.0) {}
+
+    bool keepRunning()
+    {
+        if (!started)
+        {
+            started = true;
+            resumeTiming();
+        }
+        if (done < count)
+        {
+            done++;
+            return true;
+        }
+        pauseTiming();
+        return false;
+    }
+
+    // the input size the benchmark was registered with, or --bench-size
+    int64_t range() const { return size; }
+    int64_t iterations() const { return count; }
+
+    void pauseTiming()
+    {
+        if (!running)
+            return;
+        realSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - realStart).count();
+        cpuSeconds += threadCpuSeconds() - cpuStart;
+        running = false;
+    }
+
+    void resumeTiming()
+    {
+        if (running)
+            return;
+        running = true;
+        cpuStart = threadCpuSeconds();
+        realStart = std::chrono::steady_clock::now();
+    }
+
+    // totals over all iterations, reported per second
+    void setItemsProcessed(int64_t itemCount) { items = itemCount; }
+    void setBytesProcessed(int64_t byteCount) { bytes = byteCount; }
+    void setLabel(const std::string& text) { label = text; }
+
+    // for a benchmark whose setup failed: return right after, without running the loop
+    void skipWithError(const std::string& message) { error = message; }
+
+private:
+    friend class BenchmarkSuite;
+
+    int64_t size;
+    int64_t count;
+    int64_t done;
+    bool started;
+    bool running;
+    int64_t items;
+    int64_t bytes;
+    std::string label;
+    std::string error;
+    double realSeconds;
+    double cpuSeconds;
+    double cpuStart;
+    std::chrono::steady_clock::time_point realStart;
+};
+
+struct Benchmark {
+    std::string name;
+    std::function<void(BenchmarkState&)> function;
+    // input sizes it runs at, none for a benchmark without one
+    std::vector<int64_t> sizes;
+
+    // from, then every multiple of multiplier up to to, and to itself
+    Benchmark& range(int64_t from, int64_t to, int64_t multiplier = 8)
+    {
+        for (int64_t size = from; size < to; size *= multiplier)
+            sizes.push_back(size);
+        sizes.push_back(to);
+        return *this;
+    }
+};
+
+struct BenchmarkSettings {
+    // ECMAScript regex a benchmark's full name (name/size) has to contain a match of, empty runs everything
+    std::string filter;
+    // input size every sized benchmark runs at instead of its own range, 0 keeps the ranges
+    int64_t size = 0;
+    // each benchmark's iteration count grows until one run takes at least this long
+    double minSeconds = 0.5;
+    // results in google benchmark's JSON format, so its tools/compare.py can diff two commits' runs
+    std::string jsonPath;
+};
+
+// The registered benchmarks and running them. Anything the code under test prints is swallowed while it runs,
+// loaders log every file they read.
+class BenchmarkSuite
+{
+public:
+    Benchmark& add(const std::string& name, std::function<void(BenchmarkState&)> function)
+    {
+        benchmarks.push_back(Benchmark{ name, function, std::vector<int64_t>() });
+        return benchmarks.back();
+    }
+
+    // extra "context" entries of the JSON output, like the GL renderer the numbers were taken on
+    void addContext(const std::string& key, const std::string& value) { context.push_back(std::make_pair(key, value)); }
+
+    // runs the benchmarks the settings select, returns false if the JSON couldn't be written
+    bool run(const BenchmarkSettings& settings)
+    {
+        std::regex filter(settings.filter.empty() ? std::string(".") : settings.filter);
+        std::vector<Result> results;
+        std::cout << std::string(100, '-') << "\n" << std::left << std::setw(48) << "Benchmark" << std::right << std::setw(15) << "Time" << std::setw(15) << "CPU"
+                  << std::setw(12) << "Iterations" << "\n" << std::string(100, '-') << std::endl;
+        for (const Benchmark& benchmark : benchmarks)
+        {
+            std::vector<int64_t> sizes = benchmark.sizes;
+            if (!sizes.empty() && settings.size > 0)
+                sizes.assign(1, settings.size);
+            if (sizes.empty())
+                sizes.push_back(0);
+            for (int64_t size : sizes)
+            {
+                std::string name = benchmark.sizes.empty() ? benchmark.name : benchmark.name + "/" + std::to_string(size);
+                if (!std::regex_search(name, filter))
+                    continue;
+                Result result = measure(benchmark, size, settings.minSeconds);
+                result.name = name;
+                print(result);
+                results.push_back(result);
+            }
+        }
+        return settings.jsonPath.empty() || writeJson(settings.jsonPath, results);
+    }
+
+private:
+    struct Result {
+        std::string name;
+        int64_t iterations;
+        // per iteration, in nanoseconds
+        double realTime;
+        double cpuTime;
+        double itemsPerSecond;
+        double bytesPerSecond;
+        std::string label;
+        std::string error;
+    };
+
+    struct DiscardBuffer : std::streambuf {
+        int overflow(int c) override { return c; }
+    };
+
+    std::vector<Benchmark> benchmarks;
+    std::vector<std::pair<std::string, std::string>> context;
+
+    // google benchmark's search: start at one iteration and grow the count, predicting from the last run, until
+    // a run is long enough to trust
+    static Result measure(const Benchmark& benchmark, int64_t size, double minSeconds)
+    {
+        DiscardBuffer discard;
+        int64_t iterations = 1;
+        for (;;)
+        {
+            BenchmarkState state(size, iterations);
+            std::streambuf* console = std::cout.rdbuf(&discard);
+            benchmark.function(state);
+            std::cout.rdbuf(console);
+
+            if (!state.error.empty() || state.realSeconds >= minSeconds || iterations >= 1000000000)
+            {
+                Result result;
+                result.error = state.error;
+                result.iterations = iterations;
+                result.realTime = state.realSeconds * 1e9 / iterations;
+                result.cpuTime = state.cpuSeconds * 1e9 / iterations;
+                result.itemsPerSecond = state.items > 0 ? state.items / state.realSeconds : 0.0;
+                result.bytesPerSecond = state.bytes > 0 ? state.bytes / state.realSeconds : 0.0;
+                result.label = state.label;
+                return result;
+            }
+            double multiplier = state.realSeconds <= 0.0 ? 10.0 : std::min(10.0, minSeconds * 1.4 / state.realSeconds);
+            iterations = std::max(iterations + 1, (int64_t)(iterations * multiplier));
+        }
+    }
+
+    static std::string readableTime(double nanoseconds)
+    {
+        std::ostringstream text;
+        text << std::fixed << std::setprecision(nanoseconds < 10.0 ? 2 : 0);
+        if (nanoseconds < 1e4)
+            text << nanoseconds << " ns";
+        else if (nanoseconds < 1e7)
+            text << nanoseconds / 1e3 << " us";
+        else
+            text << nanoseconds / 1e6 << " ms";
+        return text.str();
+    }
+
+    static std::string readableRate(double perSecond)
+    {
+        const char* prefixes[] = { "", "k", "M", "G", "T" };
+        int prefix = 0;
+        for (; perSecond >= 1000.0 && prefix < 4; prefix++)
+            perSecond /= 1000.0;
+        std::ostringstream text;
+        text << std::setprecision(4) << perSecond << prefixes[prefix];
+        return text.str();
+    }
+
+    static void print(const Result& result)
+    {
+        if (!result.error.empty())
+        {
+            std::cout << std::left << std::setw(48) << result.name << std::right << " ERROR OCCURRED: '" << result.error << "'" << std::endl;
+            return;
+        }
+        std::cout << std::left << std::setw(48) << result.name << std::right << std::setw(15) << readableTime(result.realTime) << std::setw(15) << readableTime(result.cpuTime)
+                  << std::setw(12) << result.iterations;
+        if (result.itemsPerSecond > 0.0)
+            std::cout << " items_per_second=" << readableRate(result.itemsPerSecond) << "/s";
+        if (result.bytesPerSecond > 0.0)
+            std::cout << " bytes_per_second=" << readableRate(result.bytesPerSecond) << "B/s";
+        if (!result.label.empty())
+            std::cout << " " << result.label;
+        std::cout << std::endl;
+    }
+
+    static std::string quoted(const std::string& text)
+    {
+        std::ostringstream out;
+        out << '"';
+        for (char c : text)
+        {
+            if (c == '"' || c == '\\')
+                out << '\\' << c;
+            else if ((unsigned char)c < 0x20)
+                out << "\\u" << std::hex << std::setw(4) << std::setfill('0') << (int)c << std::dec << std::setfill(' ');
+            else
+                out << c;
+        }
+        out << '"';
+        return out.str();
+    }
+
+    bool writeJson(const std::string& path, const std::vector<Result>& results) const
+    {
+        std::ofstream file(path);
+        char date[32];
+        std::time_t now = std::time(nullptr);
+        std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+        file << "{\n  \"context\": {\n    \"date\": " << quoted(date) << ",\n    \"num_cpus\": " << std::thread::hardware_concurrency() << ",\n";
+#ifdef NDEBUG
+        file << "    \"library_build_type\": \"release\"";
+#else
+        file << "    \"library_build_type\": \"debug\"";
+#endif
+        for (const auto& entry : context)
+            file << ",\n    " << quoted(entry.first) << ": " << quoted(entry.second);
+        file << "\n  },\n  \"benchmarks\": [";
+        file << std::setprecision(10);
+        for (size_t i = 0; i < results.size(); i++)
+        {
+            const Result& result = results[i];
+            file << (i ? "," : "") << "\n    {\n      \"name\": " << quoted(result.name) << ",\n      \"run_name\": " << quoted(result.name)
+                 << ",\n      \"run_type\": \"iteration\",\n      \"repetitions\": 1,\n      \"repetition_index\": 0,\n      \"threads\": 1,\n      \"iterations\": " << result.iterations
+                 << ",\n      \"real_time\": " << result.realTime << ",\n      \"cpu_time\": " << result.cpuTime << ",\n      \"time_unit\": \"ns\"";
+            if (result.itemsPerSecond > 0.0)
+                file << ",\n      \"items_per_second\": " << result.itemsPerSecond;
+            if (result.bytesPerSecond > 0.0)
+                file << ",\n      \"bytes_per_second\": " << result.bytesPerSecond;
+            if (!result.label.empty())
+                file << ",\n      \"label\": " << quoted(result.label);
+            if (!result.error.empty())
+                file << ",\n      \"error_occurred\": true,\n      \"error_message\": " << quoted(result.error);
+            file << "\n    }";
+        }
+        file << "\n  ]\n}\n";
+        if (!file)
+        {
+            std::cout << "ERROR::BENCHMARK::FILE_NOT_WRITTEN: " << path << std::endl;
+            return false;
+        }
+        return true;
+    }
+};
+#endif
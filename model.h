@@ -5,23 +5,37 @@
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
 #include "stb_image.h"
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 
+#include "blend_file.h"
 #include "mesh.h"
+#include "mesh_simplifier.h"
+#include "meshlets.h"
+#include "scene_graph.h"
 #include "shader.h"
+#include "skeletal_animation.h"
 
 #include <string>
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <chrono>
 #include <fstream>
+#include <iterator>
 #include <sstream>
 #include <iostream>
 #include <map>
+#include <thread>
 #include <vector>
 using namespace std;
 
 unsigned int TextureFromFile(const char* path, const string& directory, bool gamma = false);
+unsigned int TextureFromColor(const glm::vec3& color);
+struct ModelLoaderAccess;
 
 class Model
 {
@@ -31,60 +45,418 @@ public:
     vector<Mesh>    meshes;
     string directory;
     bool gammaCorrection;
+    // level of detail every mesh is drawn at, picked by selectLod
+    int lod;
+    // largest model space error of each level over all meshes, and a sphere around the model for its distance
+    vector<float> lodErrors;
+    glm::vec3 boundsCenter;
+    float boundsRadius;
+    // the file's node hierarchy, parents first: each node's parent (-1 for the root) and transform relative to it
+    vector<int> nodeParents;
+    vector<glm::mat4> nodeLocals;
+    // node every mesh hangs from
+    vector<int> meshNodes;
+    // the nodes again as joints, with the bones the skinned meshes' vertices are bound to and the file's clips;
+    // empty when nothing is skinned or animated
+    Skeleton skeleton;
 
     // constructor, expects a filepath to a 3D model.
-    Model(string const& path, bool gamma = false) : gammaCorrection(gamma)
+    Model(string const& path, bool gamma = false, const LodSettings& lods = LodSettings())
+        : gammaCorrection(gamma), lod(0), boundsCenter(0.0f), boundsRadius(0.0f), firstNode(-1), placementNode(-1), lodSettings(lods)
     {
         loadModel(path);
     }
 
-    // draws the model, and thus all its meshes
-    void Draw(Shader& shader)
+    // meshes and textures are owned GL objects: a model moves but doesn't copy, and frees them all when destroyed.
+    // Anything holding on to the skeleton (an AnimationSystem instance) has to follow a moved model.
+    Model(Model&&) = default;
+    Model& operator=(Model&&) = default;
+
+    // adds the model's nodes to a scene graph below parent, which places the whole model in the scene
+    void attach(SceneGraph& graph, int parent)
     {
-        for (unsigned int i = 0; i < meshes.size(); i++)
-            meshes[i].Draw(shader);
+        firstNode = graph.nodeCount();
+        placementNode = parent;
+        for (size_t i = 0; i < nodeParents.size(); i++)
+            graph.addNode(nodeParents[i] < 0 ? parent : firstNode + nodeParents[i], nodeLocals[i]);
     }
 
-private:
-    // loads a model with supported ASSIMP extensions from file and stores the resulting meshes in the meshes vector.
-    void loadModel(string const& path)
+    // draws the model, and thus all its meshes, each with the world and normal matrix of its node. The matrices
+    // are those of the scene graph the model was attached to, indexed by node.
+    void Draw(Shader& shader, const vector<glm::mat4>& worlds, const vector<glm::mat3>& normalMatrices)
+    {
+        const ProgramUniforms& uniforms = prepareProgram(shader);
+        int boundMaterial = -1;
+        for (unsigned int i : drawOrder)
+        {
+            setNodeTransform(uniforms, i, worlds, normalMatrices);
+            meshes[i].Draw(lod, meshes[i].material.id != boundMaterial);
+            boundMaterial = meshes[i].material.id;
+        }
+    }
+
+    // draws only the meshlets that are inside the view frustum and, with GL_CULL_FACE on, not facing away from
+    // the camera. Skinned meshes are drawn whole, their meshlet bounds only hold in the bind pose.
+    void DrawCulled(Shader& shader, const vector<glm::mat4>& worlds, const vector<glm::mat3>& normalMatrices, const glm::mat4& viewProjection, const glm::vec3& cameraPos)
+    {
+        culler.resetStats();
+        // without face culling the back faces are drawn too, dropping back facing meshlets would lose them
+        bool backfaceCulling = glIsEnabled(GL_CULL_FACE) == GL_TRUE;
+        const ProgramUniforms& uniforms = prepareProgram(shader);
+        int boundMaterial = -1;
+        for (unsigned int i : drawOrder)
+        {
+            const glm::mat4& transform = setNodeTransform(uniforms, i, worlds, normalMatrices);
+            if (meshes[i].skinned)
+            {
+                meshes[i].Draw(lod, meshes[i].material.id != boundMaterial);
+                boundMaterial = meshes[i].material.id;
+                continue;
+            }
+            glm::vec3 cameraInModel = glm::vec3(glm::inverse(transform) * glm::vec4(cameraPos, 1.0f));
+            culler.cull(meshes[i], lod, viewProjection * transform, cameraInModel, backfaceCulling);
+            if (culler.counts.empty())
+                continue;
+            meshes[i].DrawRanges(culler.counts, culler.offsets, meshes[i].material.id != boundMaterial);
+            boundMaterial = meshes[i].material.id;
+        }
+    }
+
+    // skins every skinned mesh on the CPU with the skeleton's skin matrices, as AnimationSystem wrote them for
+    // one instance, and uploads the result in place of the bind pose
+    void SkinOnCpu(const SkinMatrix* bones)
+    {
+        cpuSkinned.resize(meshes.size());
+        for (size_t i = 0; i < meshes.size(); i++)
+        {
+            Mesh& mesh = meshes[i];
+            if (!mesh.skinned)
+                continue;
+            if (cpuSkinned[i].size() != mesh.vertices.size())
+                cpuSkinned[i] = mesh.vertices;
+            skinVertices(bones, &mesh.vertices[0], &cpuSkinned[i][0], mesh.vertices.size());
+            mesh.UpdateVertices(cpuSkinned[i]);
+        }
+    }
+
+    // appends the triangles of the full detail level, three model space positions each
+    void collisionTriangles(vector<glm::vec3>& positions) const
+    {
+        for (size_t m = 0; m < meshes.size(); m++)
+        {
+            const Mesh& mesh = meshes[m];
+            glm::mat4 toModel = modelTransform(meshNodes[m]);
+            unsigned int first = mesh.lods.empty() ? 0 : mesh.lods[0].firstIndex;
+            unsigned int count = mesh.lods.empty() ? (unsigned int)mesh.indices.size() : mesh.lods[0].indexCount;
+            for (unsigned int i = first; i < first + count; i++)
+                positions.push_back(glm::vec3(toModel * glm::vec4(mesh.vertices[mesh.indices[i]].Position, 1.0f)));
+        }
+    }
+
+    // scene graph node whose world matrix places a mesh: its own node, or the model's placement for skinned
+    // meshes, whose bones already carry the node transforms
+    int meshTransform(unsigned int mesh) const
+    {
+        return meshes[mesh].skinned ? placementNode : firstNode + meshNodes[mesh];
+    }
+
+    // triangles the last DrawCulled started from and kept
+    size_t submittedTriangles() const { return culler.submittedTriangles; }
+    size_t visibleTriangles() const { return culler.visibleTriangles; }
+
+    // picks the coarsest level whose error projects to no more than thresholdPixels on screen. pixelsPerUnit is
+    // the size in pixels of one unit at distance one (projection[1][1] * viewport height / 2). Going coarser needs
+    // the error to drop a further hysteresis fraction below the threshold, so a model hovering at a switching
+    // distance doesn't flicker between two levels.
+    void selectLod(const glm::mat4& transform, const glm::vec3& cameraPos, float pixelsPerUnit, float thresholdPixels, float hysteresis = 0.25f)
     {
-        // read file via ASSIMP
-        Assimp::Importer importer;
-        const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
-        // check for errors
-        if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) // if is Not Zero
+        if (lodErrors.size() < 2)
         {
-            cout << "ERROR::ASSIMP:: " << importer.GetErrorString() << endl;
+            lod = 0;
             return;
         }
+        float scale = std::max(glm::length(glm::vec3(transform[0])), std::max(glm::length(glm::vec3(transform[1])), glm::length(glm::vec3(transform[2]))));
+        glm::vec3 center = glm::vec3(transform * glm::vec4(boundsCenter, 1.0f));
+        float distance = std::max(glm::length(center - cameraPos) - boundsRadius * scale, 1e-3f);
+        float pixelsPerModelUnit = scale * pixelsPerUnit / distance;
+        while (lod > 0 && lodErrors[lod] * pixelsPerModelUnit > thresholdPixels)
+            lod--;
+        while (lod + 1 < (int)lodErrors.size() && lodErrors[lod + 1] * pixelsPerModelUnit <= thresholdPixels * (1.0f - hysteresis))
+            lod++;
+    }
+
+private:
+    // the benchmarks time the loader's steps on synthetic input, on a model with no file behind it
+    friend struct ModelLoaderAccess;
+    Model() : gammaCorrection(false), lod(0), boundsCenter(0.0f), boundsRadius(0.0f), firstNode(-1), placementNode(-1) {}
+
+    // a mesh read from the file, waiting for its levels of detail before it goes to the GPU
+    struct MeshData {
+        vector<Vertex> vertices;
+        vector<unsigned int> indices;
+        vector<Texture> textures;
+        vector<MeshLod> lods;
+        vector<Meshlet> meshlets;
+    };
+
+    // uniform locations of a shader program the model has drawn with, looked up the first time it did
+    struct ProgramUniforms {
+        unsigned int program;
+        GLint model;
+        GLint normalMatrix;
+    };
+
+    // a bone read from a mesh, found among the nodes by name once they have all been read
+    struct PendingBone {
+        string name;
+        glm::mat4 inverseBind;
+    };
+
+    // index of the root node in the scene graph attach() added the nodes to, and of the node it went below;
+    // skinned meshes are placed by the latter, their bones already carry the rest
+    int firstNode;
+    int placementNode;
+    vector<string> nodeNames;
+    vector<PendingBone> pendingBones;
+    map<string, int> boneIndices;
+    // skinned vertices of every mesh, kept between frames by SkinOnCpu
+    vector<vector<Vertex>> cpuSkinned;
+    // texture units of the meshes' samplers, one distinct material per id, and the meshes ordered by material
+    SamplerSlots samplerSlots;
+    vector<Material> materials;
+    vector<unsigned int> drawOrder;
+    vector<ProgramUniforms> programs;
+    LodSettings lodSettings;
+    MeshletCuller culler;
+    vector<MeshData> loadedMeshes;
+    // the GL textures behind textures_loaded, deleted with the model
+    vector<GlTexture> textureObjects;
+
+    // loads a model with supported ASSIMP extensions (or a .blend, read natively) from file and stores the resulting meshes in the meshes vector.
+    void loadModel(string const& path)
+    {
         // retrieve the directory path of the filepath
         directory = path.substr(0, path.find_last_of('/'));
 
-        // process ASSIMP's root node recursively
-        processNode(scene->mRootNode, scene);
+        if (path.size() > 6 && path.compare(path.size() - 6, 6, ".blend") == 0)
+        {
+            if (!loadBlend(path))
+                return;
+        }
+        else
+        {
+            // read file via ASSIMP
+            Assimp::Importer importer;
+            const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_JoinIdenticalVertices | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
+            // check for errors
+            if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) // if is Not Zero
+            {
+                cout << "ERROR::ASSIMP:: " << importer.GetErrorString() << endl;
+                return;
+            }
+
+            // process ASSIMP's root node recursively
+            processNode(scene->mRootNode, scene, -1);
+            loadSkeleton(scene);
+        }
+
+        // simplify the meshes and cluster every level on loader threads, then upload them all
+        std::atomic<size_t> nextMesh(0);
+        vector<std::thread> loaders;
+        unsigned int threadCount = std::max(1u, std::min(std::thread::hardware_concurrency(), (unsigned int)loadedMeshes.size()));
+        for (unsigned int t = 0; t < threadCount; t++)
+        {
+            loaders.push_back(std::thread([&]() {
+                for (size_t i = nextMesh++; i < loadedMeshes.size(); i = nextMesh++)
+                {
+                    MeshData& data = loadedMeshes[i];
+                    data.lods = buildMeshLods(data.vertices, data.indices, lodSettings);
+                    data.meshlets = buildMeshlets(data.vertices, data.indices, data.lods);
+                }
+            }));
+        }
+        for (std::thread& loader : loaders)
+            loader.join();
+
+        glm::vec3 boundsMin(FLT_MAX), boundsMax(-FLT_MAX);
+        meshes.reserve(meshes.size() + loadedMeshes.size());
+        for (size_t m = 0; m < loadedMeshes.size(); m++)
+        {
+            MeshData& data = loadedMeshes[m];
+            glm::mat4 toModel = modelTransform(meshNodes[m]);
+            for (const Vertex& vertex : data.vertices)
+            {
+                glm::vec3 position = glm::vec3(toModel * glm::vec4(vertex.Position, 1.0f));
+                boundsMin = glm::min(boundsMin, position);
+                boundsMax = glm::max(boundsMax, position);
+            }
+            if (lodErrors.size() < data.lods.size())
+                lodErrors.resize(data.lods.size(), 0.0f);
+            // a mesh out of levels keeps drawing its coarsest one, whose error then counts for the deeper levels too
+            for (size_t level = 0; level < lodErrors.size(); level++)
+                lodErrors[level] = std::max(lodErrors[level], data.lods[std::min(level, data.lods.size() - 1)].error);
+            meshes.push_back(Mesh(std::move(data.vertices), std::move(data.indices), std::move(data.textures), std::move(data.lods), std::move(data.meshlets)));
+        }
+        loadedMeshes.clear();
+        buildMaterials();
+        if (!meshes.empty())
+        {
+            boundsCenter = (boundsMin + boundsMax) * 0.5f;
+            boundsRadius = glm::length(boundsMax - boundsMin) * 0.5f;
+        }
     }
 
-    // processes a node in a recursive fashion. Processes each individual mesh located at the node and repeats this process on its children nodes (if any).
-    void processNode(aiNode* node, const aiScene* scene)
+    // reads the meshes of a .blend straight from the mapped file, see blend_file.h
+    bool loadBlend(string const& path)
     {
+        auto start = std::chrono::steady_clock::now();
+        BlendFile blend;
+        BlendImporter importer;
+        if (!blend.open(path.c_str()) || !importer.import(blend))
+            return false;
+
+        // one texture per material: its image if that can be found, else its flat color
+        vector<Texture> materialTextures;
+        for (const BlendMaterial& material : importer.materials)
+        {
+            Texture texture;
+            texture.type = "texture_diffuse";
+            string image = material.image;
+            std::replace(image.begin(), image.end(), '\\', '/');
+            // "//" is relative to the .blend; for absolute paths look for the file next to it
+            if (image.compare(0, 2, "//") == 0)
+                image = image.substr(2);
+            else if (!image.empty())
+                image = image.substr(image.find_last_of('/') + 1);
+            texture.path = image.empty() ? "color:" + material.name : image;
+
+            bool loaded = false;
+            for (const Texture& done : textures_loaded)
+            {
+                if (done.path == texture.path)
+                {
+                    texture = done;
+                    loaded = true;
+                    break;
+                }
+            }
+            if (!loaded)
+            {
+                if (!image.empty() && std::ifstream(directory + '/' + image))
+                    texture.id = TextureFromFile(image.c_str(), directory);
+                else
+                {
+                    texture.id = TextureFromColor(material.color);
+                    texture.path = "color:" + material.name;
+                }
+                textures_loaded.push_back(texture);
+                textureObjects.push_back(GlTexture::adopt(texture.id));
+            }
+            materialTextures.push_back(texture);
+        }
+
+        // objects come with their world matrices applied, so every mesh hangs from a single root node
+        nodeParents.push_back(-1);
+        nodeLocals.push_back(glm::mat4(1.0f));
+        size_t triangles = 0;
+        for (BlendMesh& mesh : importer.meshes)
+        {
+            meshNodes.push_back(0);
+            triangles += mesh.indices.size() / 3;
+            vector<Texture> textures(1, materialTextures[mesh.material]);
+            loadedMeshes.push_back(MeshData{ std::move(mesh.vertices), std::move(mesh.indices), textures, vector<MeshLod>(), vector<Meshlet>() });
+        }
+        double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        cout << "BLEND::LOAD:: " << path << ": " << importer.objectCount << " objects, " << importer.meshes.size() << " meshes, "
+            << triangles << " triangles in " << milliseconds << " ms" << (importer.fixedLayout ? " (fixed layout)" : "") << endl;
+        return true;
+    }
+
+    // processes a node in a recursive fashion. Keeps the node and its transformation, processes each individual mesh located at the node and repeats this process on its children nodes (if any).
+    void processNode(aiNode* node, const aiScene* scene, int parent)
+    {
+        // assimp's matrices are row major, glm's column major
+        int index = (int)nodeParents.size();
+        nodeParents.push_back(parent);
+        nodeLocals.push_back(glm::transpose(glm::make_mat4(&node->mTransformation.a1)));
+        nodeNames.push_back(node->mName.C_Str());
         // process each mesh located at the current node
         for (unsigned int i = 0; i < node->mNumMeshes; i++)
         {
             // the node object only contains indices to index the actual objects in the scene. 
             // the scene contains all the data, node is just to keep stuff organized (like relations between nodes).
             aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-            meshes.push_back(processMesh(mesh, scene));
+            loadedMeshes.push_back(processMesh(mesh, scene, index));
+            meshNodes.push_back(index);
         }
         // after we've processed all of the meshes (if any) we then recursively process each of the children nodes
         for (unsigned int i = 0; i < node->mNumChildren; i++)
         {
-            processNode(node->mChildren[i], scene);
+            processNode(node->mChildren[i], scene, index);
         }
 
     }
 
-    Mesh processMesh(aiMesh* mesh, const aiScene* scene)
+    // a node's transform in model space, the space attach() places the whole model in, for what is computed
+    // once at load time
+    glm::mat4 modelTransform(int node) const
+    {
+        glm::mat4 transform(1.0f);
+        for (; node >= 0; node = nodeParents[node])
+            transform = nodeLocals[node] * transform;
+        return transform;
+    }
+
+    // resolves every mesh's textures into a material, numbering equal ones alike, and sorts the draws by them
+    void buildMaterials()
+    {
+        for (Mesh& mesh : meshes)
+        {
+            mesh.material = Material(mesh.textures, samplerSlots);
+            for (const Material& material : materials)
+            {
+                if (material.sameBindings(mesh.material))
+                {
+                    mesh.material.id = material.id;
+                    break;
+                }
+            }
+            if (mesh.material.id < 0)
+            {
+                mesh.material.id = (int)materials.size();
+                materials.push_back(mesh.material);
+            }
+        }
+        drawOrder.resize(meshes.size());
+        for (unsigned int i = 0; i < meshes.size(); i++)
+            drawOrder[i] = i;
+        std::stable_sort(drawOrder.begin(), drawOrder.end(), [&](unsigned int a, unsigned int b) {
+            return meshes[a].material.id < meshes[b].material.id;
+        });
+    }
+
+    // the uniform locations of the program in use, which on its first draw of this model also gets its
+    // samplers pointed at the model's texture units
+    const ProgramUniforms& prepareProgram(Shader& shader)
+    {
+        for (const ProgramUniforms& uniforms : programs)
+            if (uniforms.program == shader.ID)
+                return uniforms;
+        samplerSlots.apply(shader);
+        programs.push_back(ProgramUniforms{ shader.ID, glGetUniformLocation(shader.ID, "model"), glGetUniformLocation(shader.ID, "normalMatrix") });
+        return programs.back();
+    }
+
+    // sets a mesh's model and normal matrix, and returns the model matrix
+    const glm::mat4& setNodeTransform(const ProgramUniforms& uniforms, unsigned int mesh, const vector<glm::mat4>& worlds, const vector<glm::mat3>& normalMatrices)
+    {
+        int node = meshTransform(mesh);
+        glUniformMatrix4fv(uniforms.model, 1, GL_FALSE, &worlds[node][0][0]);
+        glUniformMatrix3fv(uniforms.normalMatrix, 1, GL_FALSE, &normalMatrices[node][0][0]);
+        return worlds[node];
+    }
+
+    MeshData processMesh(aiMesh* mesh, const aiScene* scene, int node)
     {
         // data to fill
         vector<Vertex> vertices;
@@ -142,6 +514,8 @@ private:
             for (unsigned int j = 0; j < face.mNumIndices; j++)
                 indices.push_back(face.mIndices[j]);
         }
+        if (mesh->HasBones() || scene->HasAnimations())
+            readBoneWeights(mesh, node, vertices);
         // process materials
         aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
         // we assume a convention for sampler names in the shaders. Each diffuse texture should be named
@@ -153,19 +527,187 @@ private:
 
         // 1. diffuse maps
         vector<Texture> diffuseMaps = loadMaterialTextures(material, aiTextureType_DIFFUSE, "texture_diffuse");
-        textures.insert(textures.end(), diffuseMaps.begin(), diffuseMaps.end());
+        textures.insert(textures.end(), std::make_move_iterator(diffuseMaps.begin()), std::make_move_iterator(diffuseMaps.end()));
         // 2. specular maps
         vector<Texture> specularMaps = loadMaterialTextures(material, aiTextureType_SPECULAR, "texture_specular");
-        textures.insert(textures.end(), specularMaps.begin(), specularMaps.end());
+        textures.insert(textures.end(), std::make_move_iterator(specularMaps.begin()), std::make_move_iterator(specularMaps.end()));
         // 3. normal maps
         std::vector<Texture> normalMaps = loadMaterialTextures(material, aiTextureType_HEIGHT, "texture_normal");
-        textures.insert(textures.end(), normalMaps.begin(), normalMaps.end());
+        textures.insert(textures.end(), std::make_move_iterator(normalMaps.begin()), std::make_move_iterator(normalMaps.end()));
         // 4. height maps
         std::vector<Texture> heightMaps = loadMaterialTextures(material, aiTextureType_AMBIENT, "texture_height");
-        textures.insert(textures.end(), heightMaps.begin(), heightMaps.end());
+        textures.insert(textures.end(), std::make_move_iterator(heightMaps.begin()), std::make_move_iterator(heightMaps.end()));
+
+        // return the extracted mesh data, it becomes a mesh object once its levels of detail are built
+        return MeshData{ std::move(vertices), std::move(indices), std::move(textures), vector<MeshLod>(), vector<Meshlet>() };
+    }
+
+    // Binds the vertices to the mesh's bones, the four heaviest per vertex with their weights normalized. In an
+    // animated file every mesh is skinned: vertices without bones follow the mesh's own node, so clips that
+    // move whole nodes play through the same skinning as ones that bend meshes.
+    void readBoneWeights(aiMesh* mesh, int node, vector<Vertex>& vertices)
+    {
+        for (unsigned int b = 0; b < mesh->mNumBones; b++)
+        {
+            const aiBone* bone = mesh->mBones[b];
+            int boneIndex = findBone(bone->mName.C_Str(), glm::transpose(glm::make_mat4(&bone->mOffsetMatrix.a1)));
+            for (unsigned int w = 0; w < bone->mNumWeights; w++)
+            {
+                const aiVertexWeight& weight = bone->mWeights[w];
+                if (weight.mVertexId >= vertices.size() || weight.mWeight <= 0.0f)
+                    continue;
+                // replace the lightest influence when this one weighs more
+                Vertex& vertex = vertices[weight.mVertexId];
+                int lightest = 0;
+                for (int k = 1; k < MAX_BONE_INFLUENCE; k++)
+                    if (vertex.Weights[k] < vertex.Weights[lightest])
+                        lightest = k;
+                if (weight.mWeight > vertex.Weights[lightest])
+                {
+                    vertex.BoneIDs[lightest] = boneIndex;
+                    vertex.Weights[lightest] = weight.mWeight;
+                }
+            }
+        }
+        int nodeBone = -1;
+        for (Vertex& vertex : vertices)
+        {
+            float total = 0.0f;
+            for (int k = 0; k < MAX_BONE_INFLUENCE; k++)
+                total += vertex.Weights[k];
+            if (total > 0.0f)
+            {
+                // heaviest first, so Weights[0] tells whether a vertex is skinned at all
+                for (int k = 1; k < MAX_BONE_INFLUENCE; k++)
+                    for (int j = k; j > 0 && vertex.Weights[j] > vertex.Weights[j - 1]; j--)
+                    {
+                        std::swap(vertex.Weights[j], vertex.Weights[j - 1]);
+                        std::swap(vertex.BoneIDs[j], vertex.BoneIDs[j - 1]);
+                    }
+                for (int k = 0; k < MAX_BONE_INFLUENCE; k++)
+                    vertex.Weights[k] /= total;
+                continue;
+            }
+            // the vertices are in the node's space already, so its bone's inverse bind is the identity
+            if (nodeBone < 0)
+                nodeBone = findBone(nodeNames[node], glm::mat4(1.0f));
+            vertex.BoneIDs[0] = nodeBone;
+            vertex.Weights[0] = 1.0f;
+        }
+    }
 
-        // return a mesh object created from the extracted mesh data
-        return Mesh(vertices, indices, textures);
+    // index of the bone with this name, added with its inverse bind pose the first time it comes up
+    int findBone(const string& name, const glm::mat4& inverseBind)
+    {
+        map<string, int>::iterator found = boneIndices.find(name);
+        if (found != boneIndices.end())
+            return found->second;
+        pendingBones.push_back(PendingBone{ name, inverseBind });
+        return boneIndices[name] = (int)pendingBones.size() - 1;
+    }
+
+    // Builds the skeleton once all nodes are read: a joint per node, the bones found by name (a bone without a
+    // node stays at its bind pose on the root), and the file's animations as clips in seconds
+    void loadSkeleton(const aiScene* scene)
+    {
+        if (pendingBones.empty())
+            return;
+        map<string, int> nodeIndices;
+        for (size_t i = 0; i < nodeNames.size(); i++)
+            nodeIndices.insert(std::make_pair(nodeNames[i], (int)i));
+        for (size_t i = 0; i < nodeParents.size(); i++)
+            skeleton.addJoint(nodeParents[i], nodeLocals[i]);
+        for (const PendingBone& bone : pendingBones)
+        {
+            map<string, int>::iterator node = nodeIndices.find(bone.name);
+            if (node != nodeIndices.end())
+                skeleton.addBone(node->second, bone.inverseBind);
+            else
+            {
+                cout << "ERROR::ASSIMP::BONE_WITHOUT_NODE: " << bone.name << endl;
+                skeleton.addBone(0, glm::inverse(modelTransform(0)));
+            }
+        }
+        pendingBones.clear();
+
+        for (unsigned int a = 0; a < scene->mNumAnimations; a++)
+        {
+            const aiAnimation* animation = scene->mAnimations[a];
+            float ticksPerSecond = animation->mTicksPerSecond > 0.0 ? (float)animation->mTicksPerSecond : 25.0f;
+            AnimationClip clip;
+            clip.name = animation->mName.C_Str();
+            clip.duration = (float)animation->mDuration / ticksPerSecond;
+            for (unsigned int c = 0; c < animation->mNumChannels; c++)
+            {
+                const aiNodeAnim* channel = animation->mChannels[c];
+                map<string, int>::iterator node = nodeIndices.find(channel->mNodeName.C_Str());
+                if (node == nodeIndices.end())
+                    continue;
+                // a kind of key the channel lacks holds the node's rest value
+                glm::vec3 restPosition, restScale;
+                glm::quat restRotation;
+                splitTransform(nodeLocals[node->second], restPosition, restRotation, restScale);
+                AnimationTrack track;
+                track.node = node->second;
+                track.firstPosition = (int)clip.positions.size();
+                for (unsigned int k = 0; k < channel->mNumPositionKeys; k++)
+                {
+                    const aiVectorKey& key = channel->mPositionKeys[k];
+                    clip.positionTimes.push_back((float)key.mTime / ticksPerSecond);
+                    clip.positions.push_back(glm::vec3(key.mValue.x, key.mValue.y, key.mValue.z));
+                }
+                if (channel->mNumPositionKeys == 0)
+                {
+                    clip.positionTimes.push_back(0.0f);
+                    clip.positions.push_back(restPosition);
+                }
+                track.positionCount = (int)clip.positions.size() - track.firstPosition;
+                track.firstRotation = (int)clip.rotations.size();
+                for (unsigned int k = 0; k < channel->mNumRotationKeys; k++)
+                {
+                    const aiQuatKey& key = channel->mRotationKeys[k];
+                    clip.rotationTimes.push_back((float)key.mTime / ticksPerSecond);
+                    clip.rotations.push_back(PackedRotation::pack(glm::quat(key.mValue.w, key.mValue.x, key.mValue.y, key.mValue.z)));
+                }
+                if (channel->mNumRotationKeys == 0)
+                {
+                    clip.rotationTimes.push_back(0.0f);
+                    clip.rotations.push_back(PackedRotation::pack(restRotation));
+                }
+                track.rotationCount = (int)clip.rotations.size() - track.firstRotation;
+                track.firstScale = (int)clip.scales.size();
+                for (unsigned int k = 0; k < channel->mNumScalingKeys; k++)
+                {
+                    const aiVectorKey& key = channel->mScalingKeys[k];
+                    clip.scaleTimes.push_back((float)key.mTime / ticksPerSecond);
+                    clip.scales.push_back(glm::vec3(key.mValue.x, key.mValue.y, key.mValue.z));
+                }
+                if (channel->mNumScalingKeys == 0)
+                {
+                    clip.scaleTimes.push_back(0.0f);
+                    clip.scales.push_back(restScale);
+                }
+                track.scaleCount = (int)clip.scales.size() - track.firstScale;
+                clip.tracks.push_back(track);
+            }
+            skeleton.clips.push_back(clip);
+        }
+        cout << "ANIMATION::LOAD:: " << skeleton.jointCount() << " joints, " << skeleton.boneCount() << " bones, "
+            << skeleton.clips.size() << " clips" << endl;
+    }
+
+    // translation, rotation and scale of a transform without shear
+    static void splitTransform(const glm::mat4& m, glm::vec3& translation, glm::quat& rotation, glm::vec3& scale)
+    {
+        translation = glm::vec3(m[3]);
+        glm::mat3 axes(m);
+        for (int c = 0; c < 3; c++)
+        {
+            scale[c] = glm::length(axes[c]);
+            if (scale[c] > 0.0f)
+                axes[c] /= scale[c];
+        }
+        rotation = glm::quat_cast(axes);
     }
 
     // checks all material textures of a given type and loads the textures if they're not loaded yet.
@@ -196,6 +738,7 @@ private:
                 texture.path = str.C_Str();
                 textures.push_back(texture);
                 textures_loaded.push_back(texture);  // store it as texture loaded for entire model, to ensure we won't unnecesery load duplicate textures.
+                textureObjects.push_back(GlTexture::adopt(texture.id));
             }
         }
         return textures;
@@ -242,5 +785,22 @@ unsigned int TextureFromFile(const char* path, const string& directory, bool gam
 
     return textureID;
 }
+
+unsigned int TextureFromColor(const glm::vec3& color)
+{
+    unsigned char texel[3];
+    for (int i = 0; i < 3; i++)
+        texel[i] = (unsigned char)(glm::clamp(color[i], 0.0f, 1.0f) * 255.0f + 0.5f);
+
+    unsigned int textureID;
+    glGenTextures(1, &textureID);
+    glBindTexture(GL_TEXTURE_2D, textureID);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, 1, 1, 0, GL_RGB, GL_UNSIGNED_BYTE, texel);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    return textureID;
+}
 #endif
 //{"mode":"full", "isActive" : false}
@@ -0,0 +1,214 @@
+#ifndef PORTAL_VISIBILITY_H
+#define PORTAL_VISIBILITY_H
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <vector>
+
+// Cells and portals: the scene is split into convex cells (rooms, and the outside) joined by portals (the door
+// and window openings). Whatever is seen from one cell of another is seen through a chain of portals, so the
+// visible set comes from walking that graph from the camera's cell, clipping each portal against the frustum that
+// the portals before it left open and narrowing the frustum to the clipped opening before going through.
+class PortalGraph
+{
+public:
+    static const int MAX_DEPTH = 16;
+
+    // an axis aligned cell; the one cell added without bounds is everything that is in no other cell
+    int addCell(const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+    {
+        cells.push_back(Cell{ boundsMin, boundsMax, true, std::vector<int>() });
+        return (int)cells.size() - 1;
+    }
+
+    int addCell()
+    {
+        cells.push_back(Cell{ glm::vec3(0.0f), glm::vec3(0.0f), false, std::vector<int>() });
+        return (int)cells.size() - 1;
+    }
+
+    // a flat rectangular opening between two cells, given by its bounds (one axis has no extent)
+    int addPortal(int cellA, int cellB, const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+    {
+        glm::vec3 extent = boundsMax - boundsMin;
+        int flat = extent.x <= extent.y && extent.x <= extent.z ? 0 : (extent.y <= extent.z ? 1 : 2);
+        int u = (flat + 1) % 3, v = (flat + 2) % 3;
+        Portal portal;
+        portal.cells[0] = cellA;
+        portal.cells[1] = cellB;
+        for (int corner = 0; corner < 4; corner++)
+        {
+            glm::vec3 p = boundsMin;
+            p[u] = (corner == 1 || corner == 2) ? boundsMax[u] : boundsMin[u];
+            p[v] = (corner >= 2) ? boundsMax[v] : boundsMin[v];
+            portal.corners.push_back(p);
+        }
+        portals.push_back(portal);
+        cells[cellA].portals.push_back((int)portals.size() - 1);
+        cells[cellB].portals.push_back((int)portals.size() - 1);
+        return (int)portals.size() - 1;
+    }
+
+    // the portal through the opening of an interleaved vertex array (position first, stride floats per vertex)
+    int addPortal(int cellA, int cellB, const float* vertices, int vertexCount, int stride)
+    {
+        glm::vec3 boundsMin(FLT_MAX), boundsMax(-FLT_MAX);
+        for (int i = 0; i < vertexCount; i++)
+        {
+            glm::vec3 p(vertices[i * stride], vertices[i * stride + 1], vertices[i * stride + 2]);
+            boundsMin = glm::min(boundsMin, p);
+            boundsMax = glm::max(boundsMax, p);
+        }
+        return addPortal(cellA, cellB, boundsMin, boundsMax);
+    }
+
+    int cellCount() const { return (int)cells.size(); }
+
+    int cellAt(const glm::vec3& position) const
+    {
+        int unbounded = -1;
+        for (size_t c = 0; c < cells.size(); c++)
+        {
+            if (!cells[c].bounded)
+                unbounded = (int)c;
+            else if (glm::all(glm::greaterThanEqual(position, cells[c].boundsMin)) && glm::all(glm::lessThanEqual(position, cells[c].boundsMax)))
+                return (int)c;
+        }
+        return unbounded;
+    }
+
+    // visible[c] is set for every cell seen from cameraPos through the frustum of viewProjection
+    void findVisibleCells(const glm::vec3& cameraPos, const glm::mat4& viewProjection, std::vector<unsigned char>& visible) const
+    {
+        visible.assign(cells.size(), 0);
+        int start = cellAt(cameraPos);
+        if (start < 0)
+            return;
+
+        std::vector<glm::vec4> frustum;
+        for (int p = 0; p < 6; p++)
+        {
+            int row = p / 2;
+            float sign = (p % 2) ? -1.0f : 1.0f;
+            glm::vec4 plane;
+            for (int column = 0; column < 4; column++)
+                plane[column] = viewProjection[column][3] + sign * viewProjection[column][row];
+            frustum.push_back(plane / glm::length(glm::vec3(plane)));
+        }
+        std::vector<unsigned char> onPath(cells.size(), 0);
+        onPath[start] = 1;
+        visit(start, cameraPos, frustum, 0, onPath, visible);
+    }
+
+    // whether any cell of a bit mask (bit c for cell c) is visible
+    static bool anyVisible(unsigned int cellMask, const std::vector<unsigned char>& visible)
+    {
+        for (size_t c = 0; c < visible.size() && c < 32; c++)
+            if ((cellMask & (1u << c)) && visible[c])
+                return true;
+        return false;
+    }
+
+private:
+    struct Cell {
+        glm::vec3 boundsMin, boundsMax;
+        bool bounded;
+        std::vector<int> portals;
+    };
+
+    struct Portal {
+        std::vector<glm::vec3> corners;
+        int cells[2];
+    };
+
+    std::vector<Cell> cells;
+    std::vector<Portal> portals;
+
+    void visit(int cell, const glm::vec3& cameraPos, const std::vector<glm::vec4>& frustum, int depth,
+        std::vector<unsigned char>& onPath, std::vector<unsigned char>& visible) const
+    {
+        visible[cell] = 1;
+        if (depth >= MAX_DEPTH)
+            return;
+        for (int index : cells[cell].portals)
+        {
+            const Portal& portal = portals[index];
+            int next = portal.cells[0] == cell ? portal.cells[1] : portal.cells[0];
+            if (onPath[next])
+                continue;
+            std::vector<glm::vec3> opening = portal.corners;
+            for (const glm::vec4& plane : frustum)
+            {
+                clip(opening, plane);
+                if (opening.size() < 3)
+                    break;
+            }
+            if (opening.size() < 3)
+                continue;
+
+            onPath[next] = 1;
+            visit(next, cameraPos, narrow(cameraPos, opening, frustum), depth + 1, onPath, visible);
+            onPath[next] = 0;
+        }
+    }
+
+    // Sutherland-Hodgman against one plane, keeping the side the plane's normal points to
+    static void clip(std::vector<glm::vec3>& polygon, const glm::vec4& plane)
+    {
+        std::vector<glm::vec3> kept;
+        for (size_t i = 0; i < polygon.size(); i++)
+        {
+            const glm::vec3& a = polygon[i];
+            const glm::vec3& b = polygon[(i + 1) % polygon.size()];
+            float da = glm::dot(glm::vec3(plane), a) + plane.w;
+            float db = glm::dot(glm::vec3(plane), b) + plane.w;
+            if (da >= 0.0f)
+                kept.push_back(a);
+            if ((da >= 0.0f) != (db >= 0.0f))
+                kept.push_back(a + (b - a) * (da / (da - db)));
+        }
+        polygon.swap(kept);
+    }
+
+    // the frustum from the camera through the clipped opening, closed off by the opening's own plane. A camera
+    // standing in the opening sees through it with its whole current frustum.
+    static std::vector<glm::vec4> narrow(const glm::vec3& cameraPos, const std::vector<glm::vec3>& opening, const std::vector<glm::vec4>& frustum)
+    {
+        glm::vec3 centroid(0.0f);
+        for (const glm::vec3& p : opening)
+            centroid += p;
+        centroid /= (float)opening.size();
+
+        glm::vec3 normal = glm::cross(opening[1] - opening[0], opening[2] - opening[0]);
+        float normalLength = glm::length(normal);
+        if (normalLength <= 0.0f)
+            return frustum;
+        normal /= normalLength;
+        float cameraDistance = glm::dot(normal, cameraPos - opening[0]);
+        if (std::fabs(cameraDistance) < 1e-3f)
+            return frustum;
+        // facing away from the camera, so only what lies beyond the opening is kept
+        if (cameraDistance > 0.0f)
+            normal = -normal;
+
+        std::vector<glm::vec4> narrowed;
+        narrowed.push_back(glm::vec4(normal, -glm::dot(normal, opening[0])));
+        for (size_t i = 0; i < opening.size(); i++)
+        {
+            glm::vec3 edgeNormal = glm::cross(opening[i] - cameraPos, opening[(i + 1) % opening.size()] - cameraPos);
+            float length = glm::length(edgeNormal);
+            if (length <= 1e-6f)
+                continue;
+            edgeNormal /= length;
+            glm::vec4 plane(edgeNormal, -glm::dot(edgeNormal, cameraPos));
+            if (glm::dot(glm::vec3(plane), centroid) + plane.w < 0.0f)
+                plane = -plane;
+            narrowed.push_back(plane);
+        }
+        return narrowed;
+    }
+};
+#endif
@@ -0,0 +1,79 @@
+#ifndef PPM_IMAGE_H
+#define PPM_IMAGE_H
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// An 8 bit RGB image, rows top to bottom, read and written as binary PPM (P6): no dependency, and every image
+// viewer and diff tool opens it.
+struct RgbImage {
+    int width = 0;
+    int height = 0;
+    std::vector<unsigned char> pixels;
+
+    RgbImage() {}
+    RgbImage(int imageWidth, int imageHeight) : width(imageWidth), height(imageHeight), pixels((size_t)imageWidth * imageHeight * 3, 0) {}
+
+    unsigned char* pixel(int x, int y) { return &pixels[((size_t)y * width + x) * 3]; }
+    const unsigned char* pixel(int x, int y) const { return &pixels[((size_t)y * width + x) * 3]; }
+
+    // turns an image read back from GL, whose rows go bottom to top, the right way up
+    void flipVertically()
+    {
+        size_t rowSize = (size_t)width * 3;
+        for (int y = 0; y < height / 2; y++)
+            std::swap_ranges(pixels.begin() + y * rowSize, pixels.begin() + (y + 1) * rowSize, pixels.begin() + (height - 1 - y) * rowSize);
+    }
+
+    bool save(const std::string& path) const
+    {
+        std::ofstream file(path, std::ios::binary);
+        file << "P6\n" << width << " " << height << "\n255\n";
+        file.write((const char*)pixels.data(), pixels.size());
+        if (!file)
+        {
+            std::cout << "ERROR::PPM::FILE_NOT_WRITTEN: " << path << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    bool load(const std::string& path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        std::string magic;
+        int maxValue = 0;
+        file >> magic;
+        // header fields are separated by whitespace, with comments running from '#' to the end of the line
+        int* fields[] = { &width, &height, &maxValue };
+        for (int* field : fields)
+        {
+            file >> std::ws;
+            while (file.peek() == '#')
+            {
+                file.ignore(1 << 20, '\n');
+                file >> std::ws;
+            }
+            file >> *field;
+        }
+        if (!file || magic != "P6" || maxValue != 255 || width <= 0 || height <= 0)
+        {
+            std::cout << "ERROR::PPM::NOT_AN_8_BIT_P6: " << path << std::endl;
+            width = height = 0;
+            return false;
+        }
+        file.get();
+        pixels.resize((size_t)width * height * 3);
+        file.read((char*)pixels.data(), pixels.size());
+        if (!file)
+        {
+            std::cout << "ERROR::PPM::TRUNCATED: " << path << std::endl;
+            return false;
+        }
+        return true;
+    }
+};
+#endif
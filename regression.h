@@ -0,0 +1,298 @@
+#ifndef REGRESSION_H
+#define REGRESSION_H
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+// version 2 maps GetProcessMemoryInfo to kernel32, no psapi.lib to link
+#ifndef PSAPI_VERSION
+#define PSAPI_VERSION 2
+#endif
+#include <windows.h>
+#include <psapi.h>
+#elif defined(__linux__)
+#include <unistd.h>
+#endif
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "ppm_image.h"
+
+// One fixed view the regression run renders: a camera pose, the time the scene is posed at and how many extra
+// lamps are scattered through the room in place of --lamps (-1 keeps them). A budget of 0 is no budget.
+struct RegressionScene {
+    std::string name;
+    glm::vec3 position = glm::vec3(0.0f, 0.0f, 3.0f);
+    float yaw = -90.0f;
+    float pitch = 0.0f;
+    float zoom = 45.0f;
+    float time = 0.0f;
+    int lamps = -1;
+    double maxCpuMs = 0.0;
+    double maxGpuMs = 0.0;
+    double maxMemoryMb = 0.0;
+};
+
+// The scenes file: '#' starts a comment, every other line is a setting or a scene
+//   tolerance N       perceptual difference (0 to 1) below which two pixels count as the same, default 0.1
+//   max-different N   fraction of the pixels allowed to differ from the golden image, default 0.001
+//   slack N           how much slower or bigger than the baseline a scene may get, default 0.25 (25%)
+//   slack-ms N        differences in frame time below this many milliseconds are noise, default 0.25
+//   frames N          frames timed per scene, the median is what's compared, default 16
+//   scene NAME camera X Y Z YAW PITCH [zoom N] [time N] [lamps N] [max-cpu-ms N] [max-gpu-ms N] [max-memory-mb N]
+// Golden images and the baseline live next to the scenes file.
+struct RegressionSettings {
+    std::string goldenDirectory = ".";
+    double tolerance = 0.1;
+    double maxDifferent = 0.001;
+    double slack = 0.25;
+    double slackMs = 0.25;
+    int frames = 16;
+    std::vector<RegressionScene> scenes;
+
+    bool load(const std::string& path)
+    {
+        std::ifstream file(path);
+        if (!file)
+        {
+            std::cout << "ERROR::REGRESSION::FILE_NOT_READ: " << path << std::endl;
+            return false;
+        }
+        size_t slash = path.find_last_of("/\\");
+        if (slash != std::string::npos)
+            goldenDirectory = path.substr(0, slash);
+
+        std::string line;
+        for (int lineNumber = 1; std::getline(file, line); lineNumber++)
+        {
+            std::istringstream words(line.substr(0, line.find('#')));
+            std::string key;
+            if (!(words >> key))
+                continue;
+            bool valid = true;
+            if (key == "tolerance")
+                valid = (bool)(words >> tolerance);
+            else if (key == "max-different")
+                valid = (bool)(words >> maxDifferent);
+            else if (key == "slack")
+                valid = (bool)(words >> slack);
+            else if (key == "slack-ms")
+                valid = (bool)(words >> slackMs);
+            else if (key == "frames")
+                valid = (bool)(words >> frames) && frames > 0;
+            else if (key == "scene")
+                valid = parseScene(words);
+            else
+                valid = false;
+            if (!valid)
+            {
+                std::cout << "ERROR::REGRESSION::BAD_LINE: " << path << ":" << lineNumber << ": " << line << std::endl;
+                return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    bool parseScene(std::istringstream& words)
+    {
+        RegressionScene scene;
+        bool hasCamera = false;
+        if (!(words >> scene.name))
+            return false;
+        std::string option;
+        while (words >> option)
+        {
+            if (option == "camera")
+                hasCamera = (bool)(words >> scene.position.x >> scene.position.y >> scene.position.z >> scene.yaw >> scene.pitch);
+            else if (option == "zoom")
+                words >> scene.zoom;
+            else if (option == "time")
+                words >> scene.time;
+            else if (option == "lamps")
+                words >> scene.lamps;
+            else if (option == "max-cpu-ms")
+                words >> scene.maxCpuMs;
+            else if (option == "max-gpu-ms")
+                words >> scene.maxGpuMs;
+            else if (option == "max-memory-mb")
+                words >> scene.maxMemoryMb;
+            else
+                return false;
+            if (!words)
+                return false;
+        }
+        if (!hasCamera)
+            return false;
+        scenes.push_back(scene);
+        return true;
+    }
+};
+
+// What a scene cost: median CPU time to snapshot and submit a frame, median GPU time of the frame, and the
+// process's resident memory and the GPU's used memory once it's drawn. GPU memory is -1 without a driver that
+// reports it (NVX_gpu_memory_info).
+struct RegressionMeasurement {
+    double cpuMs = 0.0;
+    double gpuMs = 0.0;
+    double memoryMb = 0.0;
+    double gpuMemoryMb = -1.0;
+};
+
+// The measurements of the last accepted run, one line per scene: name, CPU ms, GPU ms, memory MB, GPU memory MB.
+struct RegressionBaseline {
+    std::map<std::string, RegressionMeasurement> scenes;
+
+    // a missing baseline is not an error, the first run writes one with --regression-update
+    void load(const std::string& path)
+    {
+        std::ifstream file(path);
+        std::string name;
+        RegressionMeasurement measurement;
+        while (file >> name >> measurement.cpuMs >> measurement.gpuMs >> measurement.memoryMb >> measurement.gpuMemoryMb)
+            scenes[name] = measurement;
+    }
+
+    bool save(const std::string& path) const
+    {
+        std::ofstream file(path);
+        for (const auto& scene : scenes)
+            file << scene.first << " " << scene.second.cpuMs << " " << scene.second.gpuMs << " " << scene.second.memoryMb << " " << scene.second.gpuMemoryMb << "\n";
+        if (!file)
+        {
+            std::cout << "ERROR::REGRESSION::FILE_NOT_WRITTEN: " << path << std::endl;
+            return false;
+        }
+        return true;
+    }
+};
+
+// Resident memory of this process in MB, 0 where the platform has no cheap way to ask.
+inline double processMemoryMb()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return counters.WorkingSetSize / (1024.0 * 1024.0);
+#elif defined(__linux__)
+    std::ifstream statm("/proc/self/statm");
+    long pages = 0, residentPages = 0;
+    if (statm >> pages >> residentPages)
+        return (double)residentPages * sysconf(_SC_PAGESIZE) / (1024.0 * 1024.0);
+#endif
+    return 0.0;
+}
+
+// Video memory in use in MB, on drivers exposing GL_NVX_gpu_memory_info, -1 elsewhere.
+inline double gpuMemoryMb()
+{
+    const GLenum TOTAL_AVAILABLE_MEMORY_NVX = 0x9048;
+    const GLenum CURRENT_AVAILABLE_MEMORY_NVX = 0x9049;
+    GLint extensionCount = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+    for (GLint i = 0; i < extensionCount; i++)
+    {
+        if (std::strcmp((const char*)glGetStringi(GL_EXTENSIONS, i), "GL_NVX_gpu_memory_info") != 0)
+            continue;
+        GLint totalKb = 0, availableKb = 0;
+        glGetIntegerv(TOTAL_AVAILABLE_MEMORY_NVX, &totalKb);
+        glGetIntegerv(CURRENT_AVAILABLE_MEMORY_NVX, &availableKb);
+        return (totalKb - availableKb) / 1024.0;
+    }
+    return -1.0;
+}
+
+inline double medianOf(std::vector<double> values)
+{
+    if (values.empty())
+        return 0.0;
+    std::nth_element(values.begin(), values.begin() + values.size() / 2, values.end());
+    return values[values.size() / 2];
+}
+
+struct ImageDifference {
+    int differentPixels = 0;
+    double differentFraction = 0.0;
+    // largest perceptual difference of any pixel, 0 to 1
+    double maxDelta = 0.0;
+    // the golden image faded to grey with the differing pixels in red
+    RgbImage heatmap;
+};
+
+// Perceptual distance of two colors, 0 to 1: the difference in YIQ, weighted the way the eye weighs brightness
+// against the two color axes (Kotsarenko and Ramos, the metric pixelmatch uses). 35215 is the largest weighted
+// square, so this is on the scale of pixelmatch's threshold, which it compares against 35215 * threshold^2.
+inline double perceptualDelta(const unsigned char* a, const unsigned char* b)
+{
+    double dr = a[0] - b[0], dg = a[1] - b[1], db = a[2] - b[2];
+    double y = dr * 0.29889531 + dg * 0.58662247 + db * 0.11448223;
+    double i = dr * 0.59597799 - dg * 0.27417610 - db * 0.32180189;
+    double q = dr * 0.21147017 - dg * 0.52261711 + db * 0.31114694;
+    return std::sqrt((0.5053 * y * y + 0.299 * i * i + 0.1957 * q * q) / 35215.0);
+}
+
+// true if no pixel of image within one pixel of (x, y) is within tolerance of color
+inline bool unmatchedNearby(const unsigned char* color, const RgbImage& image, int x, int y, double tolerance)
+{
+    for (int ny = std::max(y - 1, 0); ny <= std::min(y + 1, image.height - 1); ny++)
+        for (int nx = std::max(x - 1, 0); nx <= std::min(x + 1, image.width - 1); nx++)
+            if (perceptualDelta(color, image.pixel(nx, ny)) <= tolerance)
+                return false;
+    return true;
+}
+
+// Compares a rendered image with its golden image. A pixel differs if its distance to the golden pixel is above
+// the tolerance and it has no close match one pixel away in the other image, checked both ways: an edge that
+// moved by a pixel because a driver rasterizes or filters a little differently is no regression, a changed
+// surface or a thin line gone missing is.
+inline ImageDifference compareImages(const RgbImage& rendered, const RgbImage& golden, double tolerance)
+{
+    ImageDifference result;
+    if (rendered.width != golden.width || rendered.height != golden.height)
+    {
+        result.differentPixels = rendered.width * rendered.height;
+        result.differentFraction = 1.0;
+        result.maxDelta = 1.0;
+        return result;
+    }
+    result.heatmap = RgbImage(golden.width, golden.height);
+    for (int y = 0; y < golden.height; y++)
+    {
+        for (int x = 0; x < golden.width; x++)
+        {
+            const unsigned char* pixel = rendered.pixel(x, y);
+            const unsigned char* reference = golden.pixel(x, y);
+            double delta = perceptualDelta(pixel, reference);
+            result.maxDelta = std::max(result.maxDelta, delta);
+            bool different = delta > tolerance && (unmatchedNearby(pixel, golden, x, y, tolerance) || unmatchedNearby(reference, rendered, x, y, tolerance));
+
+            unsigned char* out = result.heatmap.pixel(x, y);
+            if (different)
+            {
+                result.differentPixels++;
+                out[0] = 255;
+                out[1] = out[2] = 0;
+            }
+            else
+                out[0] = out[1] = out[2] = (unsigned char)(64 + (reference[0] * 77 + reference[1] * 150 + reference[2] * 29) / 512);
+        }
+    }
+    result.differentFraction = (double)result.differentPixels / ((double)golden.width * golden.height);
+    return result;
+}
+#endif
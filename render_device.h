@@ -0,0 +1,89 @@
+#ifndef RENDER_DEVICE_H
+#define RENDER_DEVICE_H
+
+#include <glad/glad.h>
+
+#include "ppm_image.h"
+#include "render_thread.h"
+#include "shader.h"
+
+// Turns a frame snapshot's room draw list into one graphics API's commands. Item i of the list is the room's
+// i-th surface: GL draws it from the VAO the item names, other backends from their own copy of the surface
+// uploaded in the same order. The DRAW_SHADOW_ONLY items after the surfaces are for the shadow maps. Anything a
+// backend sets up around the room pass (lights, shadows, the lightmap on GL) is its own business, the simulation
+// side only ever hands over snapshots.
+class RenderDevice
+{
+public:
+    virtual ~RenderDevice() {}
+
+    virtual const char* name() const = 0;
+
+    // draws the items of frame.drawList not flagged DRAW_NOT_VISIBLE or DRAW_SHADOW_ONLY
+    virtual void drawRoom(const FrameSnapshot& frame) = 0;
+
+    // the last frame drawn, rows top to bottom; false if the backend can't read it back
+    virtual bool readback(RgbImage& /*image*/) { return false; }
+};
+
+// The room pass as the GL path has always drawn it: one program, the room's texture array bound once, a uniform
+// update and glDrawArrays per item. The program's lighting inputs (light clusters, shadow maps, lightmap) have to
+// be bound by the caller, drawRoom only sets what changes with the camera and the items.
+class GlRenderDevice : public RenderDevice
+{
+public:
+    explicit GlRenderDevice(Shader& roomProgram) : program(roomProgram), readWidth(0), readHeight(0) {}
+
+    const char* name() const override { return "OpenGL"; }
+
+    void drawRoom(const FrameSnapshot& frame) override
+    {
+        program.use();
+        program.setMat4("view", frame.view);
+        program.setMat4("projection", frame.projection);
+        program.setVec3("viewPos", frame.cameraPos);
+        program.setFloat("ambientStrength", 0.15f);
+
+        // every part of the room samples the same texture array, so this binds once a frame
+        program.setInt("roomTextures", 0);
+        unsigned int boundTexture = 0;
+        for (const DrawItem& item : frame.drawList)
+        {
+            if (item.flags & (DRAW_NOT_VISIBLE | DRAW_SHADOW_ONLY))
+                continue;
+            if (item.texture != boundTexture)
+            {
+                glActiveTexture(GL_TEXTURE0);
+                glBindTexture(GL_TEXTURE_2D_ARRAY, item.texture);
+                boundTexture = item.texture;
+            }
+            program.setMat4("model", frame.transforms[item.transform]);
+            program.setMat3("normalMatrix", frame.normalMatrices[item.transform]);
+            program.setBool("useLightmap", (item.flags & DRAW_LIGHTMAPPED) != 0);
+            glBindVertexArray(item.VAO);
+            glDrawArrays(GL_TRIANGLES, item.first, item.count);
+        }
+        glBindVertexArray(0);
+        readWidth = frame.width;
+        readHeight = frame.height;
+    }
+
+    // reads the default framebuffer, where the frame ends up once composited
+    bool readback(RgbImage& image) override
+    {
+        if (readWidth <= 0 || readHeight <= 0)
+            return false;
+        image = RgbImage(readWidth, readHeight);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glReadPixels(0, 0, readWidth, readHeight, GL_RGB, GL_UNSIGNED_BYTE, &image.pixels[0]);
+        glPixelStorei(GL_PACK_ALIGNMENT, 4);
+        image.flipVertically();
+        return true;
+    }
+
+private:
+    Shader& program;
+    int readWidth, readHeight;
+};
+#endif
@@ -0,0 +1,217 @@
+#ifndef RENDER_THREAD_H
+#define RENDER_THREAD_H
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <glm/glm.hpp>
+
+#include "frame_pacer.h"
+#include "clustered_lighting.h"
+#include "skeletal_animation.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// DrawItem flags
+enum DrawFlags {
+    // moves or changes, excluded from anything cached for static geometry
+    DRAW_DYNAMIC = 1,
+    // doesn't block light (the window panes)
+    DRAW_NO_SHADOW = 2,
+    // has a second uv set into the baked lightmap (see lightmap_baker.h)
+    DRAW_LIGHTMAPPED = 4,
+    // in no cell the camera can see this frame (see portal_visibility.h), still drawn into the shadow maps
+    DRAW_NOT_VISIBLE = 8,
+    // drawn into the shadow maps only, its own pass draws it with its materials (the imported model's meshes)
+    DRAW_SHADOW_ONLY = 16,
+    // first and count are a range of the VAO's element buffer (unsigned int indices) rather than of its vertices
+    DRAW_INDEXED = 32
+};
+
+// A single draw of one of the room's vertex arrays, or of one of the model's meshes. The render thread only ever
+// sees GL object names, so the list can be copied around freely between threads.
+struct DrawItem {
+    unsigned int VAO;
+    // texture array the VAO's vertices pick their layer from (attribute 4, see texture_array.h)
+    unsigned int texture;
+    int first;
+    int count;
+    // index into FrameSnapshot::transforms
+    int transform;
+    // DrawFlags
+    int flags;
+};
+
+// Everything the render thread needs to draw one frame. Built by the main/simulation thread and handed over
+// through a SnapshotMailbox, so the render thread never touches the Camera or any other simulation state.
+struct FrameSnapshot {
+    uint64_t frameIndex = 0;
+    // pacingClock() time at which the input this frame reflects was sampled
+    double inputSampleTime = 0.0;
+    // camera state
+    glm::mat4 view = glm::mat4(1.0f);
+    glm::mat4 projection = glm::mat4(1.0f);
+    glm::vec3 cameraPos = glm::vec3(0.0f);
+    float zoom = 45.0f;
+    // framebuffer size at the time the snapshot was taken
+    int width = 0;
+    int height = 0;
+    // world matrices of the scene graph's nodes, their normal matrices, and the draw list referencing them
+    std::vector<glm::mat4> transforms;
+    std::vector<glm::mat3> normalMatrices;
+    std::vector<DrawItem> drawList;
+    // skin matrices of the imported model's bones, empty when it has none
+    std::vector<SkinMatrix> boneMatrices;
+    // per cell of the portal graph, whether the camera sees into it; empty when everything is visible
+    std::vector<unsigned char> visibleCells;
+    // point lights binned into the clusters of this frame's view frustum
+    ClusteredLightList lighting;
+};
+
+// Lock-free single producer / single consumer handoff of the most recent value (a "triple buffer").
+// The producer fills writeBuffer() and publishes it, the consumer acquires the newest published value.
+// Neither side ever waits for the other: the producer keeps overwriting the spare slot when the consumer
+// is slow, and the consumer keeps reading its current slot until something newer arrives.
+template <typename T>
+class SnapshotMailbox
+{
+public:
+    SnapshotMailbox() : state(MIDDLE_INIT), writeIndex(0), readIndex(2) {}
+
+    // slot owned by the producer until the next publish()
+    T& writeBuffer() { return slots[writeIndex]; }
+
+    // slot owned by the consumer until the next acquire()
+    const T& readBuffer() const { return slots[readIndex]; }
+
+    // makes the write slot visible to the consumer and hands the producer a new slot to fill
+    void publish()
+    {
+        unsigned int previous = state.exchange(writeIndex | FRESH);
+        writeIndex = previous & INDEX_MASK;
+        if (parked.load())
+        {
+            std::lock_guard<std::mutex> lock(parkMutex);
+            parkCondition.notify_one();
+        }
+    }
+
+    // swaps in the newest published slot if there is one, returns false if nothing new was published
+    bool acquire()
+    {
+        if (!(state.load(std::memory_order_acquire) & FRESH))
+            return false;
+        unsigned int previous = state.exchange(readIndex, std::memory_order_acq_rel);
+        readIndex = previous & INDEX_MASK;
+        return true;
+    }
+
+    // parks the consumer until something is published or the timeout expires; the handoff itself stays
+    // lock-free, the mutex is only used to sleep instead of spinning when the producer is idle.
+    bool waitForPublish(std::chrono::microseconds timeout)
+    {
+        if (acquire())
+            return true;
+        std::unique_lock<std::mutex> lock(parkMutex);
+        parked.store(true);
+        parkCondition.wait_for(lock, timeout, [this]() { return (state.load() & FRESH) != 0; });
+        parked.store(false);
+        lock.unlock();
+        return acquire();
+    }
+
+private:
+    static const unsigned int INDEX_MASK = 3;
+    static const unsigned int FRESH = 4;
+    static const unsigned int MIDDLE_INIT = 1;
+
+    T slots[3];
+    std::atomic<unsigned int> state;
+    unsigned int writeIndex;
+    unsigned int readIndex;
+
+    std::atomic<bool> parked{ false };
+    std::mutex parkMutex;
+    std::condition_variable parkCondition;
+};
+
+// Owns the GL context of a window on a dedicated thread. The main thread keeps polling events, processing
+// input and updating the scene while this thread is blocked in glfwSwapBuffers or in the driver.
+class RenderThread
+{
+public:
+    typedef std::function<void(const FrameSnapshot&)> RenderFunction;
+
+    SnapshotMailbox<FrameSnapshot> mailbox;
+
+    RenderThread() : window(NULL), pacer(NULL), running(false), framesRendered(0) {}
+    ~RenderThread() { stop(); }
+
+    // the caller must release the context (glfwMakeContextCurrent(NULL)) before starting the thread.
+    // the optional pacer is driven from the render thread and must outlive it.
+    void start(GLFWwindow* targetWindow, RenderFunction renderFunction, FramePacer* framePacer = NULL)
+    {
+        window = targetWindow;
+        render = renderFunction;
+        pacer = framePacer;
+        running.store(true);
+        thread = std::thread(&RenderThread::run, this);
+    }
+
+    // joins the render thread; the context is released again so the caller can make it current for cleanup
+    void stop()
+    {
+        if (!thread.joinable())
+            return;
+        running.store(false);
+        thread.join();
+    }
+
+    uint64_t renderedFrames() const { return framesRendered.load(std::memory_order_relaxed); }
+
+private:
+    GLFWwindow* window;
+    RenderFunction render;
+    FramePacer* pacer;
+    std::thread thread;
+    std::atomic<bool> running;
+    std::atomic<uint64_t> framesRendered;
+
+    void run()
+    {
+        glfwMakeContextCurrent(window);
+        if (pacer)
+            pacer->begin();
+        while (running.load())
+        {
+            // only redraw when the simulation produced something new, but wake up regularly to notice stop()
+            if (!mailbox.waitForPublish(std::chrono::microseconds(10000)))
+                continue;
+
+            if (pacer)
+            {
+                pacer->waitForFrameSlot();
+                // late latch: the simulation kept running while we waited, submit the newest camera and scene state
+                mailbox.acquire();
+            }
+
+            const FrameSnapshot& frame = mailbox.readBuffer();
+            render(frame);
+            glfwSwapBuffers(window);
+            if (pacer)
+                pacer->frameSubmitted(frame.inputSampleTime);
+            framesRendered.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (pacer)
+            pacer->end();
+        glfwMakeContextCurrent(NULL);
+    }
+};
+#endif
@@ -0,0 +1,50 @@
+#version 450
+// Fragment.fs for the Vulkan backend: every point light, no clusters, shadows, sun or lightmap
+layout (location = 0) in vec3 Normal;
+layout (location = 1) in vec3 Position;
+layout (location = 2) in vec2 TexCoord;
+layout (location = 3) flat in float Layer;
+
+layout (location = 0) out vec4 FragColor;
+
+layout (set = 0, binding = 0) uniform FrameConstants
+{
+    mat4 view;
+    mat4 projection;
+    vec4 viewPosAmbient;
+    ivec4 lightCount;
+    vec4 lights[128];   // 2 per light: (position, radius), (color, 0)
+} frame;
+
+layout (set = 0, binding = 1) uniform sampler2DArray roomTextures;
+
+void main()
+{
+    vec3 albedo = texture(roomTextures, vec3(TexCoord, Layer)).rgb;
+
+    // the room's triangles don't have a consistent winding, light whichever side faces the viewer
+    vec3 viewDir = normalize(frame.viewPosAmbient.xyz - Position);
+    vec3 norm = normalize(Normal);
+    if (dot(norm, viewDir) < 0.0)
+        norm = -norm;
+
+    vec3 lighting = vec3(frame.viewPosAmbient.w);
+    for (int light = 0; light < frame.lightCount.x; light++)
+    {
+        vec4 positionRadius = frame.lights[light * 2];
+        vec3 color = frame.lights[light * 2 + 1].rgb;
+
+        vec3 toLight = positionRadius.xyz - Position;
+        float distance = length(toLight);
+        vec3 lightDir = toLight / distance;
+        float window = clamp(1.0 - pow(distance / positionRadius.w, 4.0), 0.0, 1.0);
+        float attenuation = window * window / (1.0 + distance * distance);
+
+        float diff = max(dot(norm, lightDir), 0.0);
+        vec3 halfway = normalize(lightDir + viewDir);
+        float spec = pow(max(dot(norm, halfway), 0.0), 32.0) * 0.25;
+        lighting += (diff + spec) * attenuation * color;
+    }
+
+    FragColor = vec4(albedo * lighting, 1.0);
+}
\ No newline at end of file
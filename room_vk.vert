@@ -0,0 +1,37 @@
+#version 450
+// Vertex.vs for the Vulkan backend (vulkan_device.h)
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoord;
+
+layout (location = 0) out vec3 Normal;
+layout (location = 1) out vec3 Position;
+layout (location = 2) out vec2 TexCoord;
+layout (location = 3) flat out float Layer;
+
+layout (set = 0, binding = 0) uniform FrameConstants
+{
+    mat4 view;
+    mat4 projection;
+    vec4 viewPosAmbient;
+    ivec4 lightCount;
+    vec4 lights[128];
+} frame;
+
+// the normal matrix's columns, the surface's texture layer in the first one's w
+layout (push_constant) uniform DrawConstants
+{
+    mat4 model;
+    vec4 normalMatrix[3];
+} draw;
+
+void main()
+{
+    Normal = mat3(draw.normalMatrix[0].xyz, draw.normalMatrix[1].xyz, draw.normalMatrix[2].xyz) * aNormal;
+    Position = vec3(draw.model * vec4(aPos, 1.0));
+    gl_Position = frame.projection * frame.view * vec4(Position, 1.0);
+    // GL's projection gives depth in -w..w, Vulkan clips to 0..w
+    gl_Position.z = (gl_Position.z + gl_Position.w) * 0.5;
+    TexCoord = aTexCoord;
+    Layer = draw.normalMatrix[0].w;
+}
\ No newline at end of file
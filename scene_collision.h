@@ -0,0 +1,284 @@
+#ifndef SCENE_COLLISION_H
+#define SCENE_COLLISION_H
+
+#include <glm/glm.hpp>
+
+#include "bvh.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+// the viewer's body: a vertical capsule hanging below the camera, its top sphere centered on the eye
+struct CameraCapsule {
+    float radius = 0.25f;
+    // from the eye down to the center of the bottom sphere
+    float height = 0.6f;
+};
+
+// Everything rays and the camera can run into, as bodies with a BVH each. Body 0 is the static room in world
+// space; further bodies (the imported model) keep their BVH in model space and are queried through their current
+// transform, so a turning model never needs a rebuild. Transforms may only rotate, translate and scale uniformly,
+// which keeps spheres spheres in model space. All queries are const and safe to call from any number of threads.
+class SceneCollision
+{
+public:
+    struct Hit {
+        float t;
+        glm::vec3 point;
+        // facing back along the query
+        glm::vec3 normal;
+        int body;
+    };
+
+    struct Overlap {
+        int body;
+        int triangle;
+    };
+
+    // adds a triangle soup (three consecutive positions per triangle) and returns its body index
+    int addBody(const std::vector<glm::vec3>& positions, const glm::mat4& transform = glm::mat4(1.0f))
+    {
+        bodies.push_back(Body());
+        Body& body = bodies.back();
+        body.bvh.build(positions);
+        for (size_t i = 0; i + 2 < positions.size(); i += 3)
+        {
+            glm::vec3 n = glm::cross(positions[i + 1] - positions[i], positions[i + 2] - positions[i]);
+            float length = glm::length(n);
+            body.normals.push_back(length > 1e-12f ? n / length : glm::vec3(0.0f, 1.0f, 0.0f));
+        }
+        setTransform((int)bodies.size() - 1, transform);
+        return (int)bodies.size() - 1;
+    }
+
+    void setTransform(int body, const glm::mat4& transform)
+    {
+        Body& b = bodies[body];
+        b.transform = transform;
+        b.inverse = glm::inverse(transform);
+        b.scale = glm::length(glm::vec3(transform[0]));
+    }
+
+    int bodyCount() const { return (int)bodies.size(); }
+    size_t triangleCount() const
+    {
+        size_t count = 0;
+        for (const Body& body : bodies)
+            count += body.bvh.triangleCount();
+        return count;
+    }
+
+    // closest hit along a ray with a unit direction within (0, tMax)
+    bool raycast(const glm::vec3& origin, const glm::vec3& direction, float tMax, Hit& hit) const
+    {
+        bool found = false;
+        for (size_t b = 0; b < bodies.size(); b++)
+        {
+            const Body& body = bodies[b];
+            glm::vec3 localOrigin = glm::vec3(body.inverse * glm::vec4(origin, 1.0f));
+            glm::vec3 localDirection = glm::vec3(body.inverse * glm::vec4(direction, 0.0f)) * body.scale;
+            Bvh::Hit local;
+            if (!body.bvh.intersect(localOrigin, localDirection, tMax / body.scale, local))
+                continue;
+            // the local direction has unit length, so local distances are world ones over the scale
+            tMax = local.t * body.scale;
+            glm::vec3 normal = body.toWorldNormal(body.normals[local.triangle]);
+            hit.t = tMax;
+            hit.point = origin + direction * tMax;
+            hit.normal = glm::dot(normal, direction) > 0.0f ? -normal : normal;
+            hit.body = (int)b;
+            found = true;
+        }
+        return found;
+    }
+
+    // first contact of a sphere moving along a unit direction within [0, tMax), see Bvh::sweepSphere
+    bool sweepSphere(const glm::vec3& center, float radius, const glm::vec3& direction, float tMax, Hit& hit) const
+    {
+        bool found = false;
+        for (size_t b = 0; b < bodies.size() && tMax > 0.0f; b++)
+        {
+            const Body& body = bodies[b];
+            glm::vec3 localCenter = glm::vec3(body.inverse * glm::vec4(center, 1.0f));
+            glm::vec3 localDirection = glm::vec3(body.inverse * glm::vec4(direction, 0.0f)) * body.scale;
+            Bvh::SweepHit local;
+            if (!body.bvh.sweepSphere(localCenter, radius / body.scale, localDirection, tMax / body.scale, local))
+                continue;
+            tMax = local.t * body.scale;
+            hit.t = tMax;
+            hit.point = glm::vec3(body.transform * glm::vec4(local.point, 1.0f));
+            hit.normal = body.toWorldNormal(local.normal);
+            hit.body = (int)b;
+            found = true;
+        }
+        return found;
+    }
+
+    // The capsule is swept as a chain of spheres along its axis, no further apart than the radius. Between two of
+    // them the surface dips in by at most 0.14 of the radius, which only something thinner than that and lined up
+    // exactly with the waist could slip into.
+    bool sweepCapsule(const glm::vec3& top, const glm::vec3& bottom, float radius, const glm::vec3& direction, float tMax, Hit& hit) const
+    {
+        int spheres = std::max(2, (int)std::ceil(glm::length(top - bottom) / radius) + 1);
+        bool found = false;
+        for (int i = 0; i < spheres; i++)
+        {
+            glm::vec3 center = glm::mix(top, bottom, (float)i / (float)(spheres - 1));
+            if (sweepSphere(center, radius, direction, tMax, hit))
+            {
+                tMax = hit.t;
+                found = true;
+            }
+        }
+        return found;
+    }
+
+    // every triangle touching a world space box. Bodies that are turned test the model space bounds of the box,
+    // so they may report a few triangles just outside it.
+    void overlapBox(const glm::vec3& boxMin, const glm::vec3& boxMax, std::vector<Overlap>& result) const
+    {
+        std::vector<int> triangles;
+        for (size_t b = 0; b < bodies.size(); b++)
+        {
+            const Body& body = bodies[b];
+            glm::vec3 localMin(FLT_MAX), localMax(-FLT_MAX);
+            for (int corner = 0; corner < 8; corner++)
+            {
+                glm::vec3 p((corner & 1) ? boxMax.x : boxMin.x, (corner & 2) ? boxMax.y : boxMin.y, (corner & 4) ? boxMax.z : boxMin.z);
+                p = glm::vec3(body.inverse * glm::vec4(p, 1.0f));
+                localMin = glm::min(localMin, p);
+                localMax = glm::max(localMax, p);
+            }
+            triangles.clear();
+            body.bvh.overlapBox(localMin, localMax, triangles);
+            for (int triangle : triangles)
+                result.push_back(Overlap{ (int)b, triangle });
+        }
+    }
+
+    // Moves the capsule by delta, sliding along whatever it runs into, and returns where the eye ends up. A second
+    // surface met while sliding along the first leaves the crease between them to slide along; a third stops it.
+    glm::vec3 slide(const CameraCapsule& capsule, glm::vec3 eye, glm::vec3 delta) const
+    {
+        // kept between the capsule and what it touched, so the next sweep doesn't start out touching it
+        const float SKIN = 1e-3f;
+        const glm::vec3 wanted = delta;
+        glm::vec3 firstNormal(0.0f);
+        for (int contact = 0; contact < 3; contact++)
+        {
+            float distance = glm::length(delta);
+            if (distance < 1e-6f)
+                break;
+            glm::vec3 direction = delta / distance;
+            Hit hit;
+            if (!sweepCapsule(eye, eye - glm::vec3(0.0f, capsule.height, 0.0f), capsule.radius, direction, distance, hit))
+                return eye + delta;
+
+            float travel = std::max(0.0f, hit.t - SKIN);
+            eye += direction * travel + hit.normal * SKIN;
+            delta = direction * (distance - travel);
+            if (contact == 2)
+                break;
+            delta -= hit.normal * glm::dot(delta, hit.normal);
+            if (contact == 1 && glm::dot(delta, firstNormal) < 0.0f)
+            {
+                glm::vec3 crease = glm::cross(firstNormal, hit.normal);
+                float length = glm::length(crease);
+                delta = length > 1e-6f ? crease * (glm::dot(delta, crease) / (length * length)) : glm::vec3(0.0f);
+            }
+            firstNormal = hit.normal;
+            // never slide back against the way the viewer wanted to go
+            if (glm::dot(delta, wanted) <= 0.0f)
+                break;
+        }
+        return eye;
+    }
+
+private:
+    struct Body {
+        Bvh bvh;
+        // per triangle, in model space
+        std::vector<glm::vec3> normals;
+        glm::mat4 transform, inverse;
+        float scale;
+
+        glm::vec3 toWorldNormal(const glm::vec3& normal) const
+        {
+            return glm::normalize(glm::vec3(transform * glm::vec4(normal, 0.0f)));
+        }
+    };
+
+    std::vector<Body> bodies;
+};
+
+// Query throughput against a scene: rays, sphere sweeps and box overlaps from random points inside the given
+// bounds, first on one thread and then on every core, printed per second.
+inline void benchmarkSceneQueries(const SceneCollision& scene, const glm::vec3& boundsMin, const glm::vec3& boundsMax, int queryCount)
+{
+    // generated up front so only the queries are timed
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::vector<glm::vec3> origins(queryCount), directions(queryCount);
+    for (int i = 0; i < queryCount; i++)
+    {
+        origins[i] = glm::mix(boundsMin, boundsMax, glm::vec3(unit(random), unit(random), unit(random)));
+        float z = unit(random) * 2.0f - 1.0f, phi = unit(random) * 6.2831853f, r = std::sqrt(1.0f - z * z);
+        directions[i] = glm::vec3(r * std::cos(phi), r * std::sin(phi), z);
+    }
+
+    const char* names[] = { "rays", "sphere sweeps", "box overlaps" };
+    int cores = std::max(1, (int)std::thread::hardware_concurrency());
+    std::cout << "COLLISION::BENCHMARK:: " << scene.triangleCount() << " triangles in " << scene.bodyCount() << " bodies, "
+        << queryCount << " queries of each kind" << std::endl;
+    for (int kind = 0; kind < 3; kind++)
+    {
+        for (int threadCount : { 1, cores })
+        {
+            std::atomic<int> next(0);
+            std::atomic<int> hits(0);
+            auto worker = [&]()
+            {
+                const int BATCH = 256;
+                int localHits = 0;
+                std::vector<SceneCollision::Overlap> overlaps;
+                for (int first = next.fetch_add(BATCH); first < queryCount; first = next.fetch_add(BATCH))
+                {
+                    for (int i = first; i < std::min(first + BATCH, queryCount); i++)
+                    {
+                        SceneCollision::Hit hit;
+                        if (kind == 0)
+                            localHits += scene.raycast(origins[i], directions[i], 100.0f, hit);
+                        else if (kind == 1)
+                            localHits += scene.sweepSphere(origins[i], 0.25f, directions[i], 100.0f, hit);
+                        else
+                        {
+                            overlaps.clear();
+                            scene.overlapBox(origins[i] - glm::vec3(0.5f), origins[i] + glm::vec3(0.5f), overlaps);
+                            localHits += !overlaps.empty();
+                        }
+                    }
+                }
+                hits += localHits;
+            };
+            auto start = std::chrono::steady_clock::now();
+            std::vector<std::thread> threads;
+            for (int t = 1; t < threadCount; t++)
+                threads.emplace_back(worker);
+            worker();
+            for (std::thread& thread : threads)
+                thread.join();
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            std::cout << "COLLISION::BENCHMARK:: " << names[kind] << ", " << threadCount << (threadCount == 1 ? " thread: " : " threads: ")
+                << queryCount / seconds / 1e6 << " M/s, " << (100.0 * hits / queryCount) << "% hit" << std::endl;
+            if (cores == 1)
+                break;
+        }
+    }
+}
+#endif
@@ -0,0 +1,172 @@
+#ifndef SCENE_GRAPH_H
+#define SCENE_GRAPH_H
+
+#include <glm/glm.hpp>
+
+#include <emmintrin.h>
+
+#include <vector>
+
+// A 4x4 matrix as four SSE columns, laid out like glm::mat4 so the two convert with a copy
+struct NodeMatrix {
+    __m128 columns[4];
+};
+
+// The normal matrix of a node (the inverse transpose of its world matrix' upper 3x3) as three padded columns
+struct NodeNormalMatrix {
+    __m128 columns[3];
+};
+
+// Node hierarchy kept as structure of arrays: parents, local matrices, world matrices, normal matrices and dirty
+// flags each live in their own contiguous array, indexed by node. Nodes are added parents first, so walking the
+// arrays front to back always reaches a parent before its children and one pass brings every world matrix up to
+// date. update() only touches nodes whose local matrix, or that of a node above them, changed since the last one.
+class SceneGraph
+{
+public:
+    static const int NO_PARENT = -1;
+
+    // parent has to be a node added before, or NO_PARENT for a root
+    int addNode(int parent, const glm::mat4& local)
+    {
+        if (parent >= (int)parents.size())
+            parent = NO_PARENT;
+        parents.push_back(parent);
+        locals.push_back(toNode(local));
+        worlds.push_back(locals.back());
+        normals.push_back(NodeNormalMatrix());
+        dirty.push_back(1);
+        return (int)parents.size() - 1;
+    }
+
+    void setLocal(int node, const glm::mat4& local)
+    {
+        locals[node] = toNode(local);
+        dirty[node] = 1;
+    }
+
+    int nodeCount() const { return (int)parents.size(); }
+    int parent(int node) const { return parents[node]; }
+
+    glm::mat4 local(int node) const { return toGlm(locals[node]); }
+    glm::mat4 world(int node) const { return toGlm(worlds[node]); }
+    glm::mat3 normalMatrix(int node) const
+    {
+        glm::mat3 result;
+        for (int c = 0; c < 3; c++)
+        {
+            float column[4];
+            _mm_storeu_ps(column, normals[node].columns[c]);
+            result[c] = glm::vec3(column[0], column[1], column[2]);
+        }
+        return result;
+    }
+
+    // Brings world and normal matrices up to date in three passes: one over the flags that collects the dirty
+    // nodes (a node is dirty when its parent is), then the world and normal matrices of exactly those, each a
+    // tight loop of SSE arithmetic over contiguous arrays. Returns how many nodes were updated.
+    int update()
+    {
+        updated.clear();
+        for (size_t i = 0; i < parents.size(); i++)
+        {
+            if (parents[i] != NO_PARENT)
+                dirty[i] |= dirty[parents[i]];
+            if (dirty[i])
+                updated.push_back((int)i);
+        }
+        for (int node : updated)
+        {
+            if (parents[node] == NO_PARENT)
+                worlds[node] = locals[node];
+            else
+                multiply(worlds[parents[node]], locals[node], worlds[node]);
+        }
+        for (int node : updated)
+            inverseTranspose(worlds[node], normals[node]);
+        // flags are cleared last: a child further down the list still has to see its parent's
+        for (int node : updated)
+            dirty[node] = 0;
+        return (int)updated.size();
+    }
+
+    // world and normal matrices of every node, in node order, for a frame snapshot
+    void copyWorlds(std::vector<glm::mat4>& worldMatrices, std::vector<glm::mat3>& normalMatrices) const
+    {
+        worldMatrices.resize(worlds.size());
+        normalMatrices.resize(normals.size());
+        for (size_t i = 0; i < worlds.size(); i++)
+        {
+            worldMatrices[i] = toGlm(worlds[i]);
+            normalMatrices[i] = normalMatrix((int)i);
+        }
+    }
+
+    static NodeMatrix toNode(const glm::mat4& m)
+    {
+        NodeMatrix result;
+        for (int c = 0; c < 4; c++)
+            result.columns[c] = _mm_loadu_ps(&m[c][0]);
+        return result;
+    }
+
+    static glm::mat4 toGlm(const NodeMatrix& m)
+    {
+        glm::mat4 result;
+        for (int c = 0; c < 4; c++)
+            _mm_storeu_ps(&result[c][0], m.columns[c]);
+        return result;
+    }
+
+    // out = a * b, each column of the result a sum of a's columns weighted by one column of b
+    static void multiply(const NodeMatrix& a, const NodeMatrix& b, NodeMatrix& out)
+    {
+        for (int c = 0; c < 4; c++)
+        {
+            __m128 column = b.columns[c];
+            __m128 sum = _mm_mul_ps(a.columns[0], _mm_shuffle_ps(column, column, _MM_SHUFFLE(0, 0, 0, 0)));
+            sum = _mm_add_ps(sum, _mm_mul_ps(a.columns[1], _mm_shuffle_ps(column, column, _MM_SHUFFLE(1, 1, 1, 1))));
+            sum = _mm_add_ps(sum, _mm_mul_ps(a.columns[2], _mm_shuffle_ps(column, column, _MM_SHUFFLE(2, 2, 2, 2))));
+            sum = _mm_add_ps(sum, _mm_mul_ps(a.columns[3], _mm_shuffle_ps(column, column, _MM_SHUFFLE(3, 3, 3, 3))));
+            out.columns[c] = sum;
+        }
+    }
+
+private:
+    std::vector<int> parents;
+    std::vector<NodeMatrix> locals;
+    std::vector<NodeMatrix> worlds;
+    std::vector<NodeNormalMatrix> normals;
+    std::vector<unsigned char> dirty;
+    std::vector<int> updated;
+
+    static __m128 cross(__m128 a, __m128 b)
+    {
+        __m128 aYZX = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1)), bYZX = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+        __m128 crossZXY = _mm_sub_ps(_mm_mul_ps(a, bYZX), _mm_mul_ps(aYZX, b));
+        return _mm_shuffle_ps(crossZXY, crossZXY, _MM_SHUFFLE(3, 0, 2, 1));
+    }
+
+    // The inverse transpose of the upper 3x3 has the cross products of pairs of columns as its columns, over the
+    // determinant. Singular matrices keep the unscaled cross products, which still point the right way.
+    static void inverseTranspose(const NodeMatrix& m, NodeNormalMatrix& out)
+    {
+        __m128 c0 = m.columns[0], c1 = m.columns[1], c2 = m.columns[2];
+        __m128 n0 = cross(c1, c2), n1 = cross(c2, c0), n2 = cross(c0, c1);
+        // dot(c0, n0) over x, y and z; the w lane of a cross product is always zero
+        __m128 product = _mm_mul_ps(c0, n0);
+        __m128 determinant = _mm_add_ps(product, _mm_shuffle_ps(product, product, _MM_SHUFFLE(2, 3, 0, 1)));
+        determinant = _mm_add_ps(determinant, _mm_shuffle_ps(determinant, determinant, _MM_SHUFFLE(1, 0, 3, 2)));
+        if (_mm_cvtss_f32(determinant) != 0.0f)
+        {
+            __m128 scale = _mm_div_ps(_mm_set1_ps(1.0f), determinant);
+            n0 = _mm_mul_ps(n0, scale);
+            n1 = _mm_mul_ps(n1, scale);
+            n2 = _mm_mul_ps(n2, scale);
+        }
+        out.columns[0] = n0;
+        out.columns[1] = n1;
+        out.columns[2] = n2;
+    }
+};
+#endif
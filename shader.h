@@ -4,6 +4,8 @@
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
+#include "gl_handles.h"
+
 #include <string>
 #include <fstream>
 #include <sstream>
@@ -12,7 +14,8 @@
 class Shader
 {
 public:
-    unsigned int ID;
+    // the program, deleted with the Shader
+    GlProgram ID;
     // constructor generates the shader on the fly
     // ------------------------------------------------------------------------
     Shader(const char* vertexPath, const char* fragmentPath, const char* geometryPath = nullptr)
@@ -82,7 +85,7 @@ public:
             checkCompileErrors(geometry, "GEOMETRY");
         }
         // shader Program
-        ID = glCreateProgram();
+        ID = GlProgram::adopt(glCreateProgram());
         glAttachShader(ID, vertex);
         glAttachShader(ID, fragment);
         if (geometryPath != nullptr)
@@ -0,0 +1,290 @@
+#ifndef SHADOW_MAPS_H
+#define SHADOW_MAPS_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "gl_handles.h"
+#include "shader.h"
+#include "render_thread.h"
+
+#include <cmath>
+#include <iostream>
+#include <string>
+
+struct ShadowSettings {
+    // which of the scene's point lights casts shadows
+    int pointLightIndex = 0;
+    int pointResolution = 1024;
+    // optional directional "window sun"
+    bool sunEnabled = true;
+    glm::vec3 sunDirection = glm::vec3(-1.0f, -0.6f, -0.3f);
+    glm::vec3 sunColor = glm::vec3(1.0f, 0.9f, 0.75f);
+    float sunIntensity = 1.2f;
+    int sunResolution = 2048;
+    // world space bounds the sun's shadow map has to cover
+    glm::vec3 sceneMin = glm::vec3(-10.0f, -1.0f, -10.5f);
+    glm::vec3 sceneMax = glm::vec3(10.0f, 5.0f, 4.5f);
+};
+
+// Shadow maps for one point light (depth cube map) and the sun (2D depth map).
+// Static geometry is rendered once into cached maps. Each frame the cached depth is copied into the
+// per-frame maps and only dynamic draws (the turning model's meshes) are added on top; frames without
+// dynamic draws sample the cached maps directly, so a static room costs nothing after the first frame.
+// The six cube faces are rendered in one layered pass through a geometry shader.
+class ShadowMaps
+{
+public:
+    ShadowMaps(const ShadowSettings& shadowSettings = ShadowSettings()) : settings(shadowSettings), created(false), staticValid(false),
+        cachedLightPosition(0.0f), cachedLightFar(0.0f), pointFar(1.0f), pointColor(0.0f), usingDynamic(false)
+    {
+        settings.sunDirection = glm::normalize(settings.sunDirection);
+    }
+
+    const ShadowSettings& shadowSettings() const { return settings; }
+
+    // forces the static maps to be re-rendered, e.g. after static geometry changed
+    void invalidate() { staticValid = false; }
+
+    // brings the shadow maps up to date for a frame; leaves the default framebuffer bound
+    void update(const FrameSnapshot& frame, Shader& pointShader, Shader& sunShader)
+    {
+        if (!created)
+            create();
+        if (settings.pointLightIndex >= frame.lighting.lightCount())
+            return;
+
+        glm::vec4 light = frame.lighting.lights[settings.pointLightIndex * 2];
+        glm::vec3 lightPosition = glm::vec3(light);
+        pointFar = light.w;
+        pointColor = glm::vec3(frame.lighting.lights[settings.pointLightIndex * 2 + 1]);
+        if (lightPosition != cachedLightPosition || pointFar != cachedLightFar)
+        {
+            cachedLightPosition = lightPosition;
+            cachedLightFar = pointFar;
+            staticValid = false;
+        }
+
+        if (!staticValid)
+        {
+            renderPoint(frame, pointShader, staticPointFBO, false);
+            if (settings.sunEnabled)
+                renderSun(frame, sunShader, staticSunFBO, false);
+            staticValid = true;
+        }
+
+        usingDynamic = false;
+        for (const DrawItem& item : frame.drawList)
+            if ((item.flags & DRAW_DYNAMIC) && !(item.flags & DRAW_NO_SHADOW))
+                usingDynamic = true;
+
+        if (usingDynamic)
+        {
+            // start from the cached static depth, then add the moving objects
+            for (int face = 0; face < 6; face++)
+            {
+                glBindFramebuffer(GL_READ_FRAMEBUFFER, copyReadFBO);
+                glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, staticPointMap, 0);
+                glBindFramebuffer(GL_DRAW_FRAMEBUFFER, copyDrawFBO);
+                glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, dynamicPointMap, 0);
+                glBlitFramebuffer(0, 0, settings.pointResolution, settings.pointResolution, 0, 0, settings.pointResolution, settings.pointResolution, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+            }
+            renderPoint(frame, pointShader, dynamicPointFBO, true);
+
+            if (settings.sunEnabled)
+            {
+                glBindFramebuffer(GL_READ_FRAMEBUFFER, staticSunFBO);
+                glBindFramebuffer(GL_DRAW_FRAMEBUFFER, dynamicSunFBO);
+                glBlitFramebuffer(0, 0, settings.sunResolution, settings.sunResolution, 0, 0, settings.sunResolution, settings.sunResolution, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+                renderSun(frame, sunShader, dynamicSunFBO, true);
+            }
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    // binds the maps to two texture units and sets the lighting shader's shadow uniforms
+    void bind(Shader& shader, int firstUnit)
+    {
+        glActiveTexture(GL_TEXTURE0 + firstUnit);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, usingDynamic ? dynamicPointMap : staticPointMap);
+        shader.setInt("pointShadowMap", firstUnit);
+        glActiveTexture(GL_TEXTURE0 + firstUnit + 1);
+        glBindTexture(GL_TEXTURE_2D, usingDynamic ? dynamicSunMap : staticSunMap);
+        shader.setInt("sunShadowMap", firstUnit + 1);
+        glActiveTexture(GL_TEXTURE0);
+
+        shader.setInt("shadowLightIndex", staticValid ? settings.pointLightIndex : -1);
+        shader.setFloat("pointShadowFar", pointFar);
+        shader.setBool("sunEnabled", settings.sunEnabled);
+        shader.setVec3("sunDirection", settings.sunDirection);
+        shader.setVec3("sunColor", settings.sunColor * settings.sunIntensity);
+        shader.setMat4("sunMatrix", sunMatrix());
+    }
+
+    // bind() for surfaces lit from baked light that already has the static shadows in it (the model's probe
+    // lighting): the cached static maps go to the next two units, so the shader can tell what only the dynamic
+    // casters block, and the shadowed light's position, radius and color come along to take that light out
+    void bindForBakedLighting(Shader& shader, int firstUnit)
+    {
+        bind(shader, firstUnit);
+        glActiveTexture(GL_TEXTURE0 + firstUnit + 2);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, staticPointMap);
+        shader.setInt("staticPointShadowMap", firstUnit + 2);
+        glActiveTexture(GL_TEXTURE0 + firstUnit + 3);
+        glBindTexture(GL_TEXTURE_2D, staticSunMap);
+        shader.setInt("staticSunShadowMap", firstUnit + 3);
+        glActiveTexture(GL_TEXTURE0);
+
+        shader.setVec4("shadowLight", glm::vec4(cachedLightPosition, pointFar));
+        shader.setVec3("shadowLightColor", pointColor);
+    }
+
+private:
+    ShadowSettings settings;
+    bool created;
+    bool staticValid;
+    glm::vec3 cachedLightPosition;
+    float cachedLightFar;
+    float pointFar;
+    glm::vec3 pointColor;
+    bool usingDynamic;
+
+    GlTexture staticPointMap, dynamicPointMap, staticSunMap, dynamicSunMap;
+    GlFramebuffer staticPointFBO, dynamicPointFBO, staticSunFBO, dynamicSunFBO;
+    GlFramebuffer copyReadFBO, copyDrawFBO;
+
+    glm::mat4 sunMatrix() const
+    {
+        glm::vec3 center = (settings.sceneMin + settings.sceneMax) * 0.5f;
+        float extent = glm::length(settings.sceneMax - settings.sceneMin) * 0.5f;
+        glm::vec3 up = std::abs(settings.sunDirection.y) > 0.99f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+        glm::mat4 sunView = glm::lookAt(center - settings.sunDirection * extent * 2.0f, center, up);
+        return glm::ortho(-extent, extent, -extent, extent, extent, extent * 3.0f) * sunView;
+    }
+
+    GlTexture createCube()
+    {
+        GlTexture texture = GlTexture::create();
+        glBindTexture(GL_TEXTURE_CUBE_MAP, texture);
+        for (int face = 0; face < 6; face++)
+            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, 0, GL_DEPTH_COMPONENT24, settings.pointResolution, settings.pointResolution, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+        return texture;
+    }
+
+    GlTexture createSun()
+    {
+        GlTexture texture = GlTexture::create();
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, settings.sunResolution, settings.sunResolution, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+        float border[] = { 1.0f, 1.0f, 1.0f, 1.0f };
+        glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, border);
+        // hardware 2x2 PCF through sampler2DShadow
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+        return texture;
+    }
+
+    GlFramebuffer createDepthFBO(unsigned int texture)
+    {
+        GlFramebuffer framebuffer = GlFramebuffer::create();
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        // layered attachment for cube maps, the geometry shader picks the face with gl_Layer
+        glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, texture, 0);
+        glDrawBuffer(GL_NONE);
+        glReadBuffer(GL_NONE);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "ERROR::FRAMEBUFFER:: shadow map framebuffer is not complete" << std::endl;
+        return framebuffer;
+    }
+
+    // a framebuffer update() attaches one cube face at a time to for copying, checked with the first face
+    GlFramebuffer createCopyFBO(unsigned int cube)
+    {
+        GlFramebuffer framebuffer = GlFramebuffer::create();
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_CUBE_MAP_POSITIVE_X, cube, 0);
+        glDrawBuffer(GL_NONE);
+        glReadBuffer(GL_NONE);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "ERROR::FRAMEBUFFER:: shadow map copy framebuffer is not complete" << std::endl;
+        return framebuffer;
+    }
+
+    void create()
+    {
+        staticPointMap = createCube();
+        dynamicPointMap = createCube();
+        staticSunMap = createSun();
+        dynamicSunMap = createSun();
+        staticPointFBO = createDepthFBO(staticPointMap);
+        dynamicPointFBO = createDepthFBO(dynamicPointMap);
+        staticSunFBO = createDepthFBO(staticSunMap);
+        dynamicSunFBO = createDepthFBO(dynamicSunMap);
+        copyReadFBO = createCopyFBO(staticPointMap);
+        copyDrawFBO = createCopyFBO(dynamicPointMap);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        created = true;
+    }
+
+    // draws the static or the dynamic part of the draw list into a depth-only framebuffer
+    void drawCasters(const FrameSnapshot& frame, Shader& shader, bool dynamicPass)
+    {
+        for (const DrawItem& item : frame.drawList)
+        {
+            if (item.flags & DRAW_NO_SHADOW)
+                continue;
+            if (((item.flags & DRAW_DYNAMIC) != 0) != dynamicPass)
+                continue;
+            shader.setMat4("model", frame.transforms[item.transform]);
+            glBindVertexArray(item.VAO);
+            if (item.flags & DRAW_INDEXED)
+                glDrawElements(GL_TRIANGLES, item.count, GL_UNSIGNED_INT, (void*)(item.first * sizeof(unsigned int)));
+            else
+                glDrawArrays(GL_TRIANGLES, item.first, item.count);
+        }
+        glBindVertexArray(0);
+    }
+
+    void renderPoint(const FrameSnapshot& frame, Shader& shader, unsigned int framebuffer, bool dynamicPass)
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glViewport(0, 0, settings.pointResolution, settings.pointResolution);
+        if (!dynamicPass)
+            glClear(GL_DEPTH_BUFFER_BIT);
+        // the room's triangles are single sided with a mixed winding, never cull them
+        glDisable(GL_CULL_FACE);
+
+        glm::vec3 position = cachedLightPosition;
+        glm::mat4 projection = glm::perspective(glm::radians(90.0f), 1.0f, 0.05f, pointFar);
+        const glm::vec3 targets[6] = { glm::vec3(1, 0, 0), glm::vec3(-1, 0, 0), glm::vec3(0, 1, 0), glm::vec3(0, -1, 0), glm::vec3(0, 0, 1), glm::vec3(0, 0, -1) };
+        const glm::vec3 ups[6] = { glm::vec3(0, -1, 0), glm::vec3(0, -1, 0), glm::vec3(0, 0, 1), glm::vec3(0, 0, -1), glm::vec3(0, -1, 0), glm::vec3(0, -1, 0) };
+        shader.use();
+        for (int face = 0; face < 6; face++)
+            shader.setMat4("shadowMatrices[" + std::to_string(face) + "]", projection * glm::lookAt(position, position + targets[face], ups[face]));
+        shader.setVec3("lightPos", position);
+        shader.setFloat("farPlane", pointFar);
+        drawCasters(frame, shader, dynamicPass);
+    }
+
+    void renderSun(const FrameSnapshot& frame, Shader& shader, unsigned int framebuffer, bool dynamicPass)
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glViewport(0, 0, settings.sunResolution, settings.sunResolution);
+        if (!dynamicPass)
+            glClear(GL_DEPTH_BUFFER_BIT);
+        shader.use();
+        shader.setMat4("lightSpaceMatrix", sunMatrix());
+        drawCasters(frame, shader, dynamicPass);
+    }
+};
+#endif
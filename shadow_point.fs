@@ -0,0 +1,11 @@
+#version 330 core
+in vec4 FragPos;
+
+uniform vec3 lightPos;
+uniform float farPlane;
+
+void main()
+{
+    // store the linear distance to the light, mapped to [0, 1]
+    gl_FragDepth = length(FragPos.xyz - lightPos) / farPlane;
+}
\ No newline at end of file
@@ -0,0 +1,6 @@
+#version 330 core
+
+void main()
+{
+    // depth only
+}
\ No newline at end of file
@@ -0,0 +1,31 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 5) in ivec4 aBoneIDs;
+layout (location = 6) in vec4 aWeights;
+
+uniform mat4 lightSpaceMatrix;
+uniform mat4 model;
+
+// skinned casters as 1.model_loading.vs skins them; the room's vertices have no weights and stay put
+uniform bool gpuSkinning;
+uniform samplerBuffer boneMatrices;
+
+mat4 boneMatrix(int bone)
+{
+    return transpose(mat4(texelFetch(boneMatrices, bone * 3), texelFetch(boneMatrices, bone * 3 + 1),
+        texelFetch(boneMatrices, bone * 3 + 2), vec4(0.0, 0.0, 0.0, 1.0)));
+}
+
+vec4 skinned(vec4 position)
+{
+    if (!gpuSkinning || aWeights.x <= 0.0)
+        return position;
+    mat4 skin = aWeights.x * boneMatrix(aBoneIDs.x) + aWeights.y * boneMatrix(aBoneIDs.y)
+        + aWeights.z * boneMatrix(aBoneIDs.z) + aWeights.w * boneMatrix(aBoneIDs.w);
+    return skin * position;
+}
+
+void main()
+{
+    gl_Position = lightSpaceMatrix * model * skinned(vec4(aPos, 1.0));
+}
\ No newline at end of file
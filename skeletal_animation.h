@@ -0,0 +1,522 @@
+#ifndef SKELETAL_ANIMATION_H
+#define SKELETAL_ANIMATION_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "cpu_features.h"
+#include "gl_handles.h"
+#include "mesh.h"
+#include "scene_graph.h"
+#include "shader.h"
+#include "worker_pool.h"
+
+#include <emmintrin.h>
+#include <immintrin.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// a unit quaternion in four 16 bit snorms, half the size of four floats and good to about 3e-5
+struct PackedRotation {
+    int16_t x, y, z, w;
+
+    static PackedRotation pack(glm::quat q)
+    {
+        q = glm::normalize(q);
+        // q and -q are the same rotation; a positive w keeps neighbouring keys close for interpolation
+        if (q.w < 0.0f)
+            q = -q;
+        PackedRotation packed;
+        packed.x = (int16_t)std::lround(glm::clamp(q.x, -1.0f, 1.0f) * 32767.0f);
+        packed.y = (int16_t)std::lround(glm::clamp(q.y, -1.0f, 1.0f) * 32767.0f);
+        packed.z = (int16_t)std::lround(glm::clamp(q.z, -1.0f, 1.0f) * 32767.0f);
+        packed.w = (int16_t)std::lround(glm::clamp(q.w, -1.0f, 1.0f) * 32767.0f);
+        return packed;
+    }
+};
+
+// one node's keys, as ranges of the clip's key pools; every track has at least one key of each kind
+struct AnimationTrack {
+    int node;
+    int firstPosition, positionCount;
+    int firstRotation, rotationCount;
+    int firstScale, scaleCount;
+};
+
+// An animation: all tracks' keys live in a handful of pools, times in seconds next to their values, so sampling
+// a clip walks a few contiguous arrays rather than one allocation per track and key kind
+struct AnimationClip {
+    std::string name;
+    float duration = 0.0f;
+    std::vector<AnimationTrack> tracks;
+    std::vector<float> positionTimes;
+    std::vector<glm::vec3> positions;
+    std::vector<float> rotationTimes;
+    std::vector<PackedRotation> rotations;
+    std::vector<float> scaleTimes;
+    std::vector<glm::vec3> scales;
+};
+
+// the upper three rows of a bone's skinning matrix, row major: the layout CPU skinning reads and the bone
+// buffer hands to the vertex shader as three texels
+struct SkinMatrix {
+    float rows[3][4];
+};
+
+// Joints and bones of a model. Every node of the model is a joint (parents first, as in the scene graph); bones
+// are the joints vertices are bound to, each with the inverse of its bind pose in model space.
+struct Skeleton {
+    std::vector<int> parents;
+    std::vector<NodeMatrix> restLocals;
+    std::vector<int> boneNodes;
+    std::vector<NodeMatrix> inverseBinds;
+    std::vector<AnimationClip> clips;
+
+    int addJoint(int parent, const glm::mat4& local)
+    {
+        parents.push_back(parent);
+        restLocals.push_back(SceneGraph::toNode(local));
+        return (int)parents.size() - 1;
+    }
+
+    int addBone(int node, const glm::mat4& inverseBind)
+    {
+        boneNodes.push_back(node);
+        inverseBinds.push_back(SceneGraph::toNode(inverseBind));
+        return (int)boneNodes.size() - 1;
+    }
+
+    int jointCount() const { return (int)parents.size(); }
+    int boneCount() const { return (int)boneNodes.size(); }
+};
+
+// Poses any number of skeletons playing a clip each. evaluate() samples every track, four at a time in SSE
+// registers (position and scale lerp, rotation nlerp, then the four TRS matrices built side by side), walks the
+// joints parents first, and writes each instance's skin matrices to one array, instances split over threads
+// kept from one evaluate() to the next. One skeleton isn't split, its joints are too few to pay for the handoff.
+class AnimationSystem
+{
+public:
+    struct Instance {
+        const Skeleton* skeleton;
+        int clip;
+        float time;
+        // index of the instance's first bone in skinMatrices()
+        int firstBone;
+    };
+
+    int addInstance(const Skeleton* skeleton, int clip)
+    {
+        Instance instance{ skeleton, clip, 0.0f, (int)skin.size() };
+        skin.resize(skin.size() + skeleton->boneCount());
+        instances.push_back(instance);
+        return (int)instances.size() - 1;
+    }
+
+    // seconds into the clip, which loops
+    void setTime(int instance, float seconds) { instances[instance].time = seconds; }
+
+    int instanceCount() const { return (int)instances.size(); }
+    const Instance& instance(int index) const { return instances[index]; }
+    const std::vector<SkinMatrix>& skinMatrices() const { return skin; }
+
+    void evaluate(int threadCount = 1)
+    {
+        threadCount = std::max(1, std::min(threadCount, (int)instances.size()));
+        if (scratch.size() < (size_t)threadCount)
+            scratch.resize(threadCount);
+        if (threadCount == 1)
+        {
+            for (const Instance& instance : instances)
+                evaluateInstance(instance, scratch[0]);
+            return;
+        }
+        if (!pool || pool->size() != threadCount)
+            pool.reset(new WorkerPool(threadCount));
+        std::atomic<int> next(0);
+        pool->run([&](int t)
+        {
+            const int BATCH = 16;
+            for (int first = next.fetch_add(BATCH); first < (int)instances.size(); first = next.fetch_add(BATCH))
+                for (int i = first; i < std::min(first + BATCH, (int)instances.size()); i++)
+                    evaluateInstance(instances[i], scratch[t]);
+        });
+    }
+
+private:
+    struct Scratch {
+        std::vector<NodeMatrix> locals, worlds;
+    };
+
+    std::vector<Instance> instances;
+    std::vector<SkinMatrix> skin;
+    std::vector<Scratch> scratch;
+    std::unique_ptr<WorkerPool> pool;
+
+    // the key at or before time and how far it is to the next, clamped at the ends
+    static int findKey(const float* times, int count, float time, float& fraction)
+    {
+        fraction = 0.0f;
+        if (count <= 1 || time <= times[0])
+            return 0;
+        if (time >= times[count - 1])
+            return count - 1;
+        int key = (int)(std::upper_bound(times, times + count, time) - times) - 1;
+        float span = times[key + 1] - times[key];
+        fraction = span > 0.0f ? (time - times[key]) / span : 0.0f;
+        return key;
+    }
+
+    void evaluateInstance(const Instance& instance, Scratch& work)
+    {
+        const Skeleton& skeleton = *instance.skeleton;
+        work.locals = skeleton.restLocals;
+        work.worlds.resize(skeleton.restLocals.size());
+        if (instance.clip >= 0 && instance.clip < (int)skeleton.clips.size())
+            sampleClip(skeleton.clips[instance.clip], instance.time, work.locals);
+
+        for (size_t j = 0; j < skeleton.parents.size(); j++)
+        {
+            if (skeleton.parents[j] < 0)
+                work.worlds[j] = work.locals[j];
+            else
+                SceneGraph::multiply(work.worlds[skeleton.parents[j]], work.locals[j], work.worlds[j]);
+        }
+
+        SkinMatrix* out = &skin[instance.firstBone];
+        for (int b = 0; b < skeleton.boneCount(); b++)
+        {
+            NodeMatrix m;
+            SceneGraph::multiply(work.worlds[skeleton.boneNodes[b]], skeleton.inverseBinds[b], m);
+            __m128 c0 = m.columns[0], c1 = m.columns[1], c2 = m.columns[2], c3 = m.columns[3];
+            _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+            _mm_storeu_ps(out[b].rows[0], c0);
+            _mm_storeu_ps(out[b].rows[1], c1);
+            _mm_storeu_ps(out[b].rows[2], c2);
+        }
+    }
+
+    // Samples the clip's tracks four at a time into the joints' local matrices. The key lookups are scalar; the
+    // interpolation and matrix building run on one track per SSE lane.
+    static void sampleClip(const AnimationClip& clip, float time, std::vector<NodeMatrix>& locals)
+    {
+        if (clip.duration > 0.0f)
+        {
+            time = std::fmod(time, clip.duration);
+            if (time < 0.0f)
+                time += clip.duration;
+        }
+        const float SNORM = 1.0f / 32767.0f;
+        for (size_t first = 0; first < clip.tracks.size(); first += 4)
+        {
+            int lanes = (int)std::min<size_t>(4, clip.tracks.size() - first);
+            // per lane: both keys of each kind and the fraction between them
+            alignas(16) float p0[3][4], p1[3][4], tp[4];
+            alignas(16) float r0[4][4], r1[4][4], tr[4];
+            alignas(16) float s0[3][4], s1[3][4], ts[4];
+            for (int lane = 0; lane < 4; lane++)
+            {
+                // idle lanes repeat the last track and are never written back
+                const AnimationTrack& track = clip.tracks[first + std::min(lane, lanes - 1)];
+                int key = findKey(&clip.positionTimes[track.firstPosition], track.positionCount, time, tp[lane]);
+                const glm::vec3& pa = clip.positions[track.firstPosition + key];
+                const glm::vec3& pb = clip.positions[track.firstPosition + std::min(key + 1, track.positionCount - 1)];
+                key = findKey(&clip.rotationTimes[track.firstRotation], track.rotationCount, time, tr[lane]);
+                const PackedRotation& ra = clip.rotations[track.firstRotation + key];
+                const PackedRotation& rb = clip.rotations[track.firstRotation + std::min(key + 1, track.rotationCount - 1)];
+                key = findKey(&clip.scaleTimes[track.firstScale], track.scaleCount, time, ts[lane]);
+                const glm::vec3& sa = clip.scales[track.firstScale + key];
+                const glm::vec3& sb = clip.scales[track.firstScale + std::min(key + 1, track.scaleCount - 1)];
+                for (int k = 0; k < 3; k++)
+                {
+                    p0[k][lane] = pa[k];
+                    p1[k][lane] = pb[k];
+                    s0[k][lane] = sa[k];
+                    s1[k][lane] = sb[k];
+                }
+                r0[0][lane] = ra.x; r0[1][lane] = ra.y; r0[2][lane] = ra.z; r0[3][lane] = ra.w;
+                r1[0][lane] = rb.x; r1[1][lane] = rb.y; r1[2][lane] = rb.z; r1[3][lane] = rb.w;
+            }
+
+            __m128 t = _mm_load_ps(tp);
+            __m128 px = lerp(_mm_load_ps(p0[0]), _mm_load_ps(p1[0]), t);
+            __m128 py = lerp(_mm_load_ps(p0[1]), _mm_load_ps(p1[1]), t);
+            __m128 pz = lerp(_mm_load_ps(p0[2]), _mm_load_ps(p1[2]), t);
+            t = _mm_load_ps(ts);
+            __m128 sx = lerp(_mm_load_ps(s0[0]), _mm_load_ps(s1[0]), t);
+            __m128 sy = lerp(_mm_load_ps(s0[1]), _mm_load_ps(s1[1]), t);
+            __m128 sz = lerp(_mm_load_ps(s0[2]), _mm_load_ps(s1[2]), t);
+
+            // nlerp along the shorter arc; the snorm scale drops out in the normalization
+            __m128 ax = _mm_load_ps(r0[0]), ay = _mm_load_ps(r0[1]), az = _mm_load_ps(r0[2]), aw = _mm_load_ps(r0[3]);
+            __m128 bx = _mm_load_ps(r1[0]), by = _mm_load_ps(r1[1]), bz = _mm_load_ps(r1[2]), bw = _mm_load_ps(r1[3]);
+            __m128 dot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)), _mm_add_ps(_mm_mul_ps(az, bz), _mm_mul_ps(aw, bw)));
+            __m128 flip = _mm_and_ps(_mm_cmplt_ps(dot, _mm_setzero_ps()), _mm_set1_ps(-0.0f));
+            bx = _mm_xor_ps(bx, flip); by = _mm_xor_ps(by, flip); bz = _mm_xor_ps(bz, flip); bw = _mm_xor_ps(bw, flip);
+            t = _mm_load_ps(tr);
+            __m128 qx = lerp(ax, bx, t), qy = lerp(ay, by, t), qz = lerp(az, bz, t), qw = lerp(aw, bw, t);
+            __m128 length2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(qx, qx), _mm_mul_ps(qy, qy)), _mm_add_ps(_mm_mul_ps(qz, qz), _mm_mul_ps(qw, qw)));
+            __m128 inverseLength = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(_mm_max_ps(length2, _mm_set1_ps(SNORM * SNORM))));
+            qx = _mm_mul_ps(qx, inverseLength); qy = _mm_mul_ps(qy, inverseLength);
+            qz = _mm_mul_ps(qz, inverseLength); qw = _mm_mul_ps(qw, inverseLength);
+
+            // rotation times scale, one column per scale axis, plus the translation
+            const __m128 one = _mm_set1_ps(1.0f), two = _mm_set1_ps(2.0f);
+            __m128 xx = _mm_mul_ps(qx, qx), yy = _mm_mul_ps(qy, qy), zz = _mm_mul_ps(qz, qz);
+            __m128 xy = _mm_mul_ps(qx, qy), xz = _mm_mul_ps(qx, qz), yz = _mm_mul_ps(qy, qz);
+            __m128 wx = _mm_mul_ps(qw, qx), wy = _mm_mul_ps(qw, qy), wz = _mm_mul_ps(qw, qz);
+            __m128 columns[4][4] = {
+                { _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))), sx), _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xy, wz)), sx),
+                  _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xz, wy)), sx), _mm_setzero_ps() },
+                { _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xy, wz)), sy), _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))), sy),
+                  _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(yz, wx)), sy), _mm_setzero_ps() },
+                { _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xz, wy)), sz), _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(yz, wx)), sz),
+                  _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))), sz), _mm_setzero_ps() },
+                { px, py, pz, one },
+            };
+            // from one matrix element per lane to one column per register
+            for (int c = 0; c < 4; c++)
+                _MM_TRANSPOSE4_PS(columns[c][0], columns[c][1], columns[c][2], columns[c][3]);
+            for (int lane = 0; lane < lanes; lane++)
+            {
+                NodeMatrix& local = locals[clip.tracks[first + lane].node];
+                for (int c = 0; c < 4; c++)
+                    local.columns[c] = columns[c][lane];
+            }
+        }
+    }
+
+    static __m128 lerp(__m128 a, __m128 b, __m128 t)
+    {
+        return _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), t));
+    }
+};
+
+// CPU skinning of bind pose vertices into out, which already holds copies of them (only positions and normals
+// are written). Each vertex blends its bones' 3x4 matrices with its weights, then transforms by the blend.
+
+// one vertex at a time, rows 0 and 1 of the matrices in one AVX register and row 2 in an SSE one
+TARGET_AVX2 inline void skinVerticesAvx2(const SkinMatrix* bones, const Vertex* bind, Vertex* out, size_t count)
+{
+    for (size_t v = 0; v < count; v++)
+    {
+        const Vertex& in = bind[v];
+        __m256 rows01 = _mm256_setzero_ps();
+        __m128 row2 = _mm_setzero_ps();
+        for (int k = 0; k < MAX_BONE_INFLUENCE; k++)
+        {
+            float weight = in.Weights[k];
+            if (weight == 0.0f)
+                continue;
+            const SkinMatrix& bone = bones[in.BoneIDs[k]];
+            rows01 = _mm256_fmadd_ps(_mm256_set1_ps(weight), _mm256_loadu_ps(bone.rows[0]), rows01);
+            row2 = _mm_fmadd_ps(_mm_set1_ps(weight), _mm_loadu_ps(bone.rows[2]), row2);
+        }
+        __m128 p = _mm_setr_ps(in.Position.x, in.Position.y, in.Position.z, 1.0f);
+        __m128 n = _mm_setr_ps(in.Normal.x, in.Normal.y, in.Normal.z, 0.0f);
+        __m256 pp = _mm256_insertf128_ps(_mm256_castps128_ps256(p), p, 1);
+        __m256 nn = _mm256_insertf128_ps(_mm256_castps128_ps256(n), n, 1);
+        // dot products of both rows with p and n: lanes 0 and 4 end up with position x and y, 1 and 5 with normal x and y
+        __m256 sums = _mm256_hadd_ps(_mm256_mul_ps(rows01, pp), _mm256_mul_ps(rows01, nn));
+        sums = _mm256_hadd_ps(sums, sums);
+        __m128 x = _mm256_castps256_ps128(sums), y = _mm256_extractf128_ps(sums, 1);
+        __m128 z = _mm_hadd_ps(_mm_mul_ps(row2, p), _mm_mul_ps(row2, n));
+        z = _mm_hadd_ps(z, z);
+        alignas(16) float xs[4], ys[4], zs[4];
+        _mm_store_ps(xs, x);
+        _mm_store_ps(ys, y);
+        _mm_store_ps(zs, z);
+        out[v].Position = glm::vec3(xs[0], ys[0], zs[0]);
+        glm::vec3 normal(xs[1], ys[1], zs[1]);
+        float length2 = glm::dot(normal, normal);
+        out[v].Normal = length2 > 0.0f ? normal / std::sqrt(length2) : in.Normal;
+    }
+}
+
+// the same with SSE2 alone, for machines without AVX2
+inline void skinVerticesSse(const SkinMatrix* bones, const Vertex* bind, Vertex* out, size_t count)
+{
+    for (size_t v = 0; v < count; v++)
+    {
+        const Vertex& in = bind[v];
+        __m128 rows[3] = { _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps() };
+        for (int k = 0; k < MAX_BONE_INFLUENCE; k++)
+        {
+            float weight = in.Weights[k];
+            if (weight == 0.0f)
+                continue;
+            const SkinMatrix& bone = bones[in.BoneIDs[k]];
+            __m128 w = _mm_set1_ps(weight);
+            for (int r = 0; r < 3; r++)
+                rows[r] = _mm_add_ps(rows[r], _mm_mul_ps(w, _mm_loadu_ps(bone.rows[r])));
+        }
+        __m128 p = _mm_setr_ps(in.Position.x, in.Position.y, in.Position.z, 1.0f);
+        __m128 n = _mm_setr_ps(in.Normal.x, in.Normal.y, in.Normal.z, 0.0f);
+        // transposed, the rows make a matrix applied to (x, y, z, w) with column arithmetic
+        __m128 r0 = rows[0], r1 = rows[1], r2 = rows[2], r3 = _mm_setzero_ps();
+        _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+        __m128 position = _mm_add_ps(_mm_add_ps(_mm_mul_ps(r0, _mm_shuffle_ps(p, p, _MM_SHUFFLE(0, 0, 0, 0))), _mm_mul_ps(r1, _mm_shuffle_ps(p, p, _MM_SHUFFLE(1, 1, 1, 1)))),
+            _mm_add_ps(_mm_mul_ps(r2, _mm_shuffle_ps(p, p, _MM_SHUFFLE(2, 2, 2, 2))), r3));
+        __m128 normal = _mm_add_ps(_mm_add_ps(_mm_mul_ps(r0, _mm_shuffle_ps(n, n, _MM_SHUFFLE(0, 0, 0, 0))), _mm_mul_ps(r1, _mm_shuffle_ps(n, n, _MM_SHUFFLE(1, 1, 1, 1)))),
+            _mm_mul_ps(r2, _mm_shuffle_ps(n, n, _MM_SHUFFLE(2, 2, 2, 2))));
+        alignas(16) float ps[4], ns[4];
+        _mm_store_ps(ps, position);
+        _mm_store_ps(ns, normal);
+        out[v].Position = glm::vec3(ps[0], ps[1], ps[2]);
+        glm::vec3 skinnedNormal(ns[0], ns[1], ns[2]);
+        float length2 = glm::dot(skinnedNormal, skinnedNormal);
+        out[v].Normal = length2 > 0.0f ? skinnedNormal / std::sqrt(length2) : in.Normal;
+    }
+}
+
+inline void skinVertices(const SkinMatrix* bones, const Vertex* bind, Vertex* out, size_t count)
+{
+    static const bool avx2 = cpuHasAvx2();
+    if (avx2)
+        skinVerticesAvx2(bones, bind, out, count);
+    else
+        skinVerticesSse(bones, bind, out, count);
+}
+
+// Skin matrices on the GPU: a texture buffer of three RGBA32F texels per bone that the vertex shader fetches
+// with texelFetch, so a skeleton's size is limited by the buffer rather than by the uniform space.
+class BoneBuffer
+{
+public:
+    GlBuffer buffer;
+    GlTexture texture;
+
+    void upload(const std::vector<SkinMatrix>& bones)
+    {
+        if (bones.empty())
+            return;
+        if (!buffer)
+        {
+            buffer = GlBuffer::create();
+            texture = GlTexture::create();
+        }
+        glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+        // orphaned every frame, so a buffer the GPU still reads from is never waited for
+        glBufferData(GL_TEXTURE_BUFFER, bones.size() * sizeof(SkinMatrix), &bones[0], GL_STREAM_DRAW);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+        glBindTexture(GL_TEXTURE_BUFFER, texture);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, buffer);
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+    }
+
+    void bind(Shader& shader, int unit)
+    {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        glBindTexture(GL_TEXTURE_BUFFER, texture);
+        shader.setInt("boneMatrices", unit);
+        glActiveTexture(GL_TEXTURE0);
+    }
+};
+
+// Animation throughput on made up characters: a 64 joint skeleton playing a two second clip with keys at 30 Hz
+// on every joint, and a 4096 vertex mesh with four bones per vertex. Prints poses and CPU skinned characters per
+// millisecond, on one thread and on every core.
+inline void benchmarkAnimation(int characterCount)
+{
+    const int JOINTS = 64, KEYS = 60, VERTICES = 4096;
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+    Skeleton skeleton;
+    for (int j = 0; j < JOINTS; j++)
+    {
+        // four limbs of sixteen joints hanging off the first
+        int parent = j == 0 ? -1 : (j % 16 == 1 ? 0 : j - 1);
+        skeleton.addJoint(parent, glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.1f, 0.0f)));
+    }
+    glm::vec3 bindPosition(0.0f);
+    for (int j = 0; j < JOINTS; j++)
+        skeleton.addBone(j, glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -0.1f * (j == 0 ? 1 : (j - 1) % 16 + 2), 0.0f)));
+    AnimationClip clip;
+    clip.name = "benchmark";
+    clip.duration = (KEYS - 1) / 30.0f;
+    for (int j = 0; j < JOINTS; j++)
+    {
+        AnimationTrack track{ j, (int)clip.positions.size(), KEYS, (int)clip.rotations.size(), KEYS, (int)clip.scales.size(), 1 };
+        for (int k = 0; k < KEYS; k++)
+        {
+            clip.positionTimes.push_back(k / 30.0f);
+            clip.positions.push_back(glm::vec3(0.0f, 0.1f, 0.0f) + glm::vec3(unit(random), unit(random), unit(random)) * 0.01f);
+            clip.rotationTimes.push_back(k / 30.0f);
+            clip.rotations.push_back(PackedRotation::pack(glm::angleAxis(unit(random) * 0.5f, glm::normalize(glm::vec3(unit(random), unit(random), unit(random)) + glm::vec3(0.0f, 0.0f, 0.01f)))));
+        }
+        clip.scaleTimes.push_back(0.0f);
+        clip.scales.push_back(glm::vec3(1.0f));
+        clip.tracks.push_back(track);
+    }
+    skeleton.clips.push_back(clip);
+
+    std::vector<Vertex> bind(VERTICES), skinned;
+    for (Vertex& vertex : bind)
+    {
+        vertex.Position = glm::vec3(unit(random), unit(random) + 1.0f, unit(random));
+        vertex.Normal = glm::normalize(glm::vec3(unit(random), unit(random), unit(random)) + glm::vec3(0.0f, 0.0f, 0.01f));
+        float total = 0.0f;
+        for (int k = 0; k < MAX_BONE_INFLUENCE; k++)
+        {
+            vertex.BoneIDs[k] = (int)(random() % JOINTS);
+            vertex.Weights[k] = unit(random) + 1.1f;
+            total += vertex.Weights[k];
+        }
+        for (int k = 0; k < MAX_BONE_INFLUENCE; k++)
+            vertex.Weights[k] /= total;
+    }
+
+    AnimationSystem animation;
+    for (int c = 0; c < characterCount; c++)
+    {
+        int instance = animation.addInstance(&skeleton, 0);
+        animation.setTime(instance, c * 0.037f);
+    }
+    int cores = std::max(1, (int)std::thread::hardware_concurrency());
+    bool avx2 = cpuHasAvx2();
+    std::cout << "ANIMATION::BENCHMARK:: " << characterCount << " characters, " << JOINTS << " joints, " << VERTICES << " vertices each, "
+        << (avx2 ? "AVX2" : "SSE2") << " skinning" << std::endl;
+    for (int threadCount : { 1, cores })
+    {
+        // the first evaluate() on a thread count starts its workers, that's not what's timed
+        animation.evaluate(threadCount);
+        auto start = std::chrono::steady_clock::now();
+        animation.evaluate(threadCount);
+        double poseMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        std::atomic<int> next(0);
+        auto worker = [&]()
+        {
+            std::vector<Vertex> out(bind);
+            for (int c = next++; c < characterCount; c = next++)
+                skinVertices(&animation.skinMatrices()[animation.instance(c).firstBone], &bind[0], &out[0], bind.size());
+        };
+        start = std::chrono::steady_clock::now();
+        std::vector<std::thread> threads;
+        for (int t = 1; t < threadCount; t++)
+            threads.emplace_back(worker);
+        worker();
+        for (std::thread& thread : threads)
+            thread.join();
+        double skinMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "ANIMATION::BENCHMARK:: " << threadCount << (threadCount == 1 ? " thread: " : " threads: ")
+            << characterCount / poseMs << " poses/ms, " << characterCount / skinMs << " CPU skinned characters/ms" << std::endl;
+        if (cores == 1)
+            break;
+    }
+}
+#endif
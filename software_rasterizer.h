@@ -0,0 +1,649 @@
+#ifndef SOFTWARE_RASTERIZER_H
+#define SOFTWARE_RASTERIZER_H
+
+#include <glm/glm.hpp>
+
+#include "clustered_lighting.h"
+#include "cubemap_loader.h"
+#include "cpu_features.h"
+#include "ppm_image.h"
+#include "stb_image.h"
+#include "worker_pool.h"
+
+#include <emmintrin.h>
+#include <immintrin.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// An 8 bit RGB texture in memory for the software rasterizer, row 0 at v = 0 like the GL textures it mirrors
+struct SoftwareTexture {
+    int width = 0;
+    int height = 0;
+    std::vector<unsigned char> rgb;
+
+    // bottomUp for textures the GL path uploads bottom row first (the room's, through FreeImage); files read by
+    // stb_image the way Model and the cubemap loader upload them keep their top row first
+    bool load(const std::string& path, bool bottomUp)
+    {
+        int components;
+        unsigned char* data = stbi_load(path.c_str(), &width, &height, &components, 3);
+        if (!data)
+        {
+            std::cout << "ERROR::SOFTWARE::TEXTURE_NOT_LOADED: " << path << std::endl;
+            *this = flat(glm::vec3(0.5f));
+            return false;
+        }
+        rgb.resize((size_t)width * height * 3);
+        for (int y = 0; y < height; y++)
+            std::copy(data + (size_t)(bottomUp ? height - 1 - y : y) * width * 3, data + (size_t)((bottomUp ? height - 1 - y : y) + 1) * width * 3, rgb.begin() + (size_t)y * width * 3);
+        stbi_image_free(data);
+        return true;
+    }
+
+    static SoftwareTexture flat(const glm::vec3& color)
+    {
+        SoftwareTexture texture;
+        texture.width = texture.height = 1;
+        for (int i = 0; i < 3; i++)
+            texture.rgb.push_back((unsigned char)(glm::clamp(color[i], 0.0f, 1.0f) * 255.0f + 0.5f));
+        return texture;
+    }
+
+    // bilinear, repeating like the GL textures do, or clamped to the edges for cube faces
+    glm::vec3 sample(float u, float v, bool repeat = true) const
+    {
+        float x = u * width - 0.5f, y = v * height - 0.5f;
+        float x0f = std::floor(x), y0f = std::floor(y);
+        float fx = x - x0f, fy = y - y0f;
+        int x0 = (int)x0f, y0 = (int)y0f, x1 = x0 + 1, y1 = y0 + 1;
+        if (repeat)
+        {
+            x0 = wrap(x0, width);
+            x1 = x0 + 1 == width ? 0 : x0 + 1;
+            y0 = wrap(y0, height);
+            y1 = y0 + 1 == height ? 0 : y0 + 1;
+        }
+        else
+        {
+            x0 = glm::clamp(x0, 0, width - 1);
+            x1 = glm::clamp(x1, 0, width - 1);
+            y0 = glm::clamp(y0, 0, height - 1);
+            y1 = glm::clamp(y1, 0, height - 1);
+        }
+        const unsigned char* a = &rgb[((size_t)y0 * width + x0) * 3];
+        const unsigned char* b = &rgb[((size_t)y0 * width + x1) * 3];
+        const unsigned char* c = &rgb[((size_t)y1 * width + x0) * 3];
+        const unsigned char* d = &rgb[((size_t)y1 * width + x1) * 3];
+        glm::vec3 result;
+        for (int k = 0; k < 3; k++)
+        {
+            float top = a[k] + (b[k] - a[k]) * fx, bottom = c[k] + (d[k] - c[k]) * fx;
+            result[k] = (top + (bottom - top) * fy) * (1.0f / 255.0f);
+        }
+        return result;
+    }
+
+private:
+    // the division only for coordinates that actually leave the texture
+    static int wrap(int i, int size)
+    {
+        if (i >= 0 && i < size)
+            return i;
+        i %= size;
+        return i < 0 ? i + size : i;
+    }
+};
+
+// Vertices of one draw as the scene already keeps them in memory: interleaved floats with a position at offset 0,
+// a normal and a uv at the given offsets. Triangles are the indices three at a time, or consecutive vertices
+// without indices. The arrays are only pointed to and have to outlive the rasterizer's use of them.
+struct SoftwareMesh {
+    const float* vertices;
+    size_t vertexCount;
+    int stride;
+    int normalOffset;
+    int uvOffset;
+    const unsigned int* indices;
+    size_t indexCount;
+    // index into the transforms render() is given, and into the rasterizer's textures
+    int transform;
+    int texture;
+};
+
+struct SoftwareRasterizerStats {
+    size_t triangles = 0;
+    // triangles after clipping that cover a pixel center, and how many tile bins they went into
+    size_t rasterized = 0;
+    size_t binned = 0;
+    double setupMs = 0.0;
+    double rasterMs = 0.0;
+};
+
+// Renders the scene on the CPU, for hosts without a GPU and headless frames. Triangles are transformed, clipped
+// against the near plane and set up in parallel chunks, each chunk binning its triangles to 64x64 pixel tiles.
+// Worker threads then take whole tiles: every triangle binned to a tile is tested eight pixels at a time (AVX2
+// edge functions where available), with 8x8 blocks rejected early when the triangle is behind everything already
+// in them (a hierarchical depth test on each block's farthest depth). Only the nearest triangle per pixel is kept;
+// shading runs once per pixel at the end, bilinearly sampling the textures and lighting with the point lights,
+// and the sky fills in what no triangle covered.
+class SoftwareRasterizer
+{
+public:
+    static const int TILE = 64;
+    static const int BLOCK = 8;
+
+    // the result of the last render(), rows top to bottom
+    RgbImage image;
+    SoftwareRasterizerStats stats;
+    float ambient = 0.15f;
+    glm::vec3 clearColor = glm::vec3(0.1f);
+
+    explicit SoftwareRasterizer(int threads = 0)
+        : threadCount(threads > 0 ? threads : std::max(1, (int)std::thread::hardware_concurrency())), avx2(cpuHasAvx2()) {}
+
+    int addTexture(const SoftwareTexture& texture)
+    {
+        textures.push_back(texture);
+        return (int)textures.size() - 1;
+    }
+
+    void addMesh(const SoftwareMesh& mesh) { meshes.push_back(mesh); }
+
+    // keeps an 8 bit copy of the skybox's faces, sampled like GL samples the cubemap; HDR skies are clamped
+    void setSky(const CubemapImage& sky)
+    {
+        skyFaces.clear();
+        if (sky.empty())
+            return;
+        for (int face = 0; face < CubemapImage::FACES; face++)
+        {
+            SoftwareTexture texture;
+            texture.width = texture.height = sky.size;
+            texture.rgb.resize((size_t)sky.size * sky.size * 3);
+            for (int y = 0; y < sky.size; y++)
+                for (int x = 0; x < sky.size; x++)
+                {
+                    glm::vec3 texel = glm::clamp(sky.texel(face, x, y), 0.0f, 1.0f);
+                    for (int k = 0; k < 3; k++)
+                        texture.rgb[((size_t)y * sky.size + x) * 3 + k] = (unsigned char)(texel[k] * 255.0f + 0.5f);
+                }
+            skyFaces.push_back(texture);
+        }
+    }
+
+    void render(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& cameraPos, const std::vector<glm::mat4>& transforms, const std::vector<glm::mat3>& normalMatrices, const std::vector<PointLight>& lights, int width, int height)
+    {
+        stats = SoftwareRasterizerStats();
+        image = RgbImage(width, height);
+        tilesX = (width + TILE - 1) / TILE;
+        tilesY = (height + TILE - 1) / TILE;
+        frame.viewProjection = projection * view;
+        frame.skyFromClip = glm::inverse(projection * glm::mat4(glm::mat3(view)));
+        frame.cameraPos = cameraPos;
+        frame.transforms = &transforms;
+        frame.normalMatrices = &normalMatrices;
+        frame.lights = &lights;
+
+        // chunks of up to CHUNK triangles of one mesh each
+        const size_t CHUNK = 4096;
+        size_t chunkCount = 0;
+        for (const SoftwareMesh& mesh : meshes)
+        {
+            size_t triangles = (mesh.indices ? mesh.indexCount : mesh.vertexCount) / 3;
+            stats.triangles += triangles;
+            for (size_t first = 0; first < triangles; first += CHUNK)
+            {
+                if (chunks.size() <= chunkCount)
+                    chunks.push_back(Chunk());
+                Chunk& chunk = chunks[chunkCount++];
+                chunk.mesh = &mesh;
+                chunk.firstTriangle = first;
+                chunk.triangleCount = std::min(CHUNK, triangles - first);
+            }
+        }
+        activeChunks = chunkCount;
+
+        auto start = std::chrono::steady_clock::now();
+        std::atomic<size_t> next(0);
+        parallel([&](int) {
+            for (size_t c = next++; c < activeChunks; c = next++)
+                setupChunk(chunks[c]);
+        });
+        auto setupEnd = std::chrono::steady_clock::now();
+        for (size_t c = 0; c < activeChunks; c++)
+        {
+            stats.rasterized += chunks[c].triangles.size();
+            stats.binned += chunks[c].binned;
+        }
+
+        if (scratch.size() < (size_t)threadCount)
+            scratch.resize(threadCount);
+        std::atomic<int> nextTile(0);
+        parallel([&](int thread) {
+            for (int tile = nextTile++; tile < tilesX * tilesY; tile = nextTile++)
+                rasterizeTile(tile, scratch[thread]);
+        });
+        auto end = std::chrono::steady_clock::now();
+        stats.setupMs = std::chrono::duration<double, std::milli>(setupEnd - start).count();
+        stats.rasterMs = std::chrono::duration<double, std::milli>(end - setupEnd).count();
+    }
+
+private:
+    static const int ATTRIBUTES = 8;
+
+    // a vertex in clip space with what gets interpolated across the triangle: uv, world position and normal
+    struct ClipVertex {
+        glm::vec4 clip;
+        float attributes[ATTRIBUTES];
+    };
+
+    // A triangle ready to rasterize. Edge function i, A x + B y + C at a pixel center, is the barycentric weight of
+    // vertex i there, so the three are all non-negative inside and interpolate depth directly; the other
+    // attributes are stored over w and interpolated with 1/w for perspective correction.
+    struct Triangle {
+        float edgeA[3], edgeB[3], edgeC[3];
+        float z[3];
+        float invW[3];
+        float attributes[3][ATTRIBUTES];
+        int minX, minY, maxX, maxY;
+        float minZ;
+        int texture;
+    };
+
+    struct Chunk {
+        const SoftwareMesh* mesh = nullptr;
+        size_t firstTriangle = 0;
+        size_t triangleCount = 0;
+        std::vector<Triangle> triangles;
+        // per tile, indices into triangles in submission order
+        std::vector<std::vector<int>> bins;
+        size_t binned = 0;
+    };
+
+    // per thread: the nearest triangle and its barycentrics at every pixel of the tile being rasterized
+    struct TileScratch {
+        float depth[TILE * TILE];
+        float barycentric1[TILE * TILE];
+        float barycentric2[TILE * TILE];
+        const Triangle* nearest[TILE * TILE];
+        float blockFarthest[(TILE / BLOCK) * (TILE / BLOCK)];
+    };
+
+    struct FrameState {
+        glm::mat4 viewProjection;
+        glm::mat4 skyFromClip;
+        glm::vec3 cameraPos;
+        const std::vector<glm::mat4>* transforms;
+        const std::vector<glm::mat3>* normalMatrices;
+        const std::vector<PointLight>* lights;
+    };
+
+    int threadCount;
+    bool avx2;
+    std::vector<SoftwareTexture> textures;
+    std::vector<SoftwareTexture> skyFaces;
+    std::vector<SoftwareMesh> meshes;
+    std::vector<Chunk> chunks;
+    size_t activeChunks = 0;
+    std::vector<TileScratch> scratch;
+    int tilesX = 0, tilesY = 0;
+    FrameState frame;
+    // started by the first render and kept, a frame's two passes only wake the workers
+    std::unique_ptr<WorkerPool> pool;
+
+    void parallel(const std::function<void(int)>& work)
+    {
+        if (!pool)
+            pool.reset(new WorkerPool(threadCount));
+        pool->run(work);
+    }
+
+    void setupChunk(Chunk& chunk)
+    {
+        chunk.triangles.clear();
+        chunk.bins.resize(tilesX * tilesY);
+        for (std::vector<int>& bin : chunk.bins)
+            bin.clear();
+        chunk.binned = 0;
+
+        const SoftwareMesh& mesh = *chunk.mesh;
+        const glm::mat4& model = (*frame.transforms)[mesh.transform];
+        const glm::mat3& normalMatrix = (*frame.normalMatrices)[mesh.transform];
+        glm::mat4 modelViewProjection = frame.viewProjection * model;
+        for (size_t t = chunk.firstTriangle; t < chunk.firstTriangle + chunk.triangleCount; t++)
+        {
+            ClipVertex corners[3];
+            for (int k = 0; k < 3; k++)
+            {
+                size_t index = mesh.indices ? mesh.indices[t * 3 + k] : t * 3 + k;
+                const float* vertex = mesh.vertices + index * mesh.stride;
+                glm::vec4 position(vertex[0], vertex[1], vertex[2], 1.0f);
+                glm::vec3 world = glm::vec3(model * position);
+                glm::vec3 normal = normalMatrix * glm::vec3(vertex[mesh.normalOffset], vertex[mesh.normalOffset + 1], vertex[mesh.normalOffset + 2]);
+                ClipVertex& corner = corners[k];
+                corner.clip = modelViewProjection * position;
+                corner.attributes[0] = vertex[mesh.uvOffset];
+                corner.attributes[1] = vertex[mesh.uvOffset + 1];
+                for (int i = 0; i < 3; i++)
+                {
+                    corner.attributes[2 + i] = world[i];
+                    corner.attributes[5 + i] = normal[i];
+                }
+            }
+            clipAndSetup(corners, mesh.texture, chunk);
+        }
+    }
+
+    static bool allOutside(const ClipVertex* v, int axis, float sign)
+    {
+        for (int k = 0; k < 3; k++)
+            if (sign * v[k].clip[axis] <= v[k].clip.w)
+                return false;
+        return true;
+    }
+
+    static ClipVertex lerp(const ClipVertex& a, const ClipVertex& b, float t)
+    {
+        ClipVertex result;
+        result.clip = a.clip + (b.clip - a.clip) * t;
+        for (int i = 0; i < ATTRIBUTES; i++)
+            result.attributes[i] = a.attributes[i] + (b.attributes[i] - a.attributes[i]) * t;
+        return result;
+    }
+
+    // drops triangles wholly outside the frustum and cuts the rest at the near plane (z >= -w), the only plane
+    // that has to be clipped: the others are handled by the screen bounds of the bins
+    void clipAndSetup(const ClipVertex* v, int texture, Chunk& chunk)
+    {
+        for (int axis = 0; axis < 3; axis++)
+            if (allOutside(v, axis, 1.0f) || allOutside(v, axis, -1.0f))
+                return;
+        ClipVertex polygon[4];
+        int count = 0;
+        for (int k = 0; k < 3; k++)
+        {
+            const ClipVertex& a = v[k];
+            const ClipVertex& b = v[(k + 1) % 3];
+            float da = a.clip.z + a.clip.w, db = b.clip.z + b.clip.w;
+            if (da >= 0.0f)
+                polygon[count++] = a;
+            if ((da >= 0.0f) != (db >= 0.0f))
+                polygon[count++] = lerp(a, b, da / (da - db));
+        }
+        for (int k = 1; k + 1 < count; k++)
+            setupTriangle(polygon[0], polygon[k], polygon[k + 1], texture, chunk);
+    }
+
+    void setupTriangle(const ClipVertex& v0, const ClipVertex& v1, const ClipVertex& v2, int texture, Chunk& chunk)
+    {
+        const ClipVertex* v[3] = { &v0, &v1, &v2 };
+        float x[3], y[3], z[3], invW[3];
+        for (int k = 0; k < 3; k++)
+        {
+            invW[k] = 1.0f / v[k]->clip.w;
+            x[k] = (v[k]->clip.x * invW[k] * 0.5f + 0.5f) * image.width;
+            y[k] = (0.5f - v[k]->clip.y * invW[k] * 0.5f) * image.height;
+            z[k] = v[k]->clip.z * invW[k] * 0.5f + 0.5f;
+        }
+        float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+        if (std::fabs(area) < 1e-8f)
+            return;
+
+        Triangle triangle;
+        triangle.minX = std::max(0, (int)std::floor(std::min(x[0], std::min(x[1], x[2]))));
+        triangle.minY = std::max(0, (int)std::floor(std::min(y[0], std::min(y[1], y[2]))));
+        triangle.maxX = std::min(image.width - 1, (int)std::ceil(std::max(x[0], std::max(x[1], x[2]))));
+        triangle.maxY = std::min(image.height - 1, (int)std::ceil(std::max(y[0], std::max(y[1], y[2]))));
+        triangle.minZ = std::min(z[0], std::min(z[1], z[2]));
+        if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY || triangle.minZ > 1.0f)
+            return;
+        // both windings are drawn, the room's triangles don't agree on one; the weights come out the same either way
+        float invArea = 1.0f / area;
+        for (int k = 0; k < 3; k++)
+        {
+            int a = (k + 1) % 3, b = (k + 2) % 3;
+            triangle.edgeA[k] = (y[a] - y[b]) * invArea;
+            triangle.edgeB[k] = (x[b] - x[a]) * invArea;
+            triangle.edgeC[k] = (x[a] * y[b] - x[b] * y[a]) * invArea;
+            triangle.z[k] = z[k];
+            triangle.invW[k] = invW[k];
+            for (int i = 0; i < ATTRIBUTES; i++)
+                triangle.attributes[k][i] = v[k]->attributes[i] * invW[k];
+        }
+        triangle.texture = texture;
+
+        int index = (int)chunk.triangles.size();
+        chunk.triangles.push_back(triangle);
+        for (int ty = triangle.minY / TILE; ty <= triangle.maxY / TILE; ty++)
+            for (int tx = triangle.minX / TILE; tx <= triangle.maxX / TILE; tx++)
+            {
+                chunk.bins[ty * tilesX + tx].push_back(index);
+                chunk.binned++;
+            }
+    }
+
+    // Coverage and depth test of the eight pixels from (x, y): the bits of the lanes that are inside the
+    // triangle and nearer than depth, with their depth and the weights of vertices 1 and 2
+    TARGET_AVX2 static int rowAvx2(const Triangle& t, int x, int y, const float* depth, float* z, float* weight1, float* weight2)
+    {
+        __m256 px = _mm256_add_ps(_mm256_set1_ps(x + 0.5f), _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f));
+        __m256 py = _mm256_set1_ps(y + 0.5f);
+        __m256 e0 = _mm256_fmadd_ps(_mm256_set1_ps(t.edgeA[0]), px, _mm256_fmadd_ps(_mm256_set1_ps(t.edgeB[0]), py, _mm256_set1_ps(t.edgeC[0])));
+        __m256 e1 = _mm256_fmadd_ps(_mm256_set1_ps(t.edgeA[1]), px, _mm256_fmadd_ps(_mm256_set1_ps(t.edgeB[1]), py, _mm256_set1_ps(t.edgeC[1])));
+        __m256 e2 = _mm256_fmadd_ps(_mm256_set1_ps(t.edgeA[2]), px, _mm256_fmadd_ps(_mm256_set1_ps(t.edgeB[2]), py, _mm256_set1_ps(t.edgeC[2])));
+        __m256 zero = _mm256_setzero_ps();
+        __m256 inside = _mm256_and_ps(_mm256_cmp_ps(e0, zero, _CMP_GE_OQ), _mm256_and_ps(_mm256_cmp_ps(e1, zero, _CMP_GE_OQ), _mm256_cmp_ps(e2, zero, _CMP_GE_OQ)));
+        int mask = _mm256_movemask_ps(inside);
+        if (!mask)
+            return 0;
+        __m256 depthHere = _mm256_fmadd_ps(e0, _mm256_set1_ps(t.z[0]), _mm256_fmadd_ps(e1, _mm256_set1_ps(t.z[1]), _mm256_mul_ps(e2, _mm256_set1_ps(t.z[2]))));
+        mask &= _mm256_movemask_ps(_mm256_cmp_ps(depthHere, _mm256_loadu_ps(depth), _CMP_LT_OQ));
+        _mm256_storeu_ps(z, depthHere);
+        _mm256_storeu_ps(weight1, e1);
+        _mm256_storeu_ps(weight2, e2);
+        return mask;
+    }
+
+    static int rowScalar(const Triangle& t, int x, int y, const float* depth, float* z, float* weight1, float* weight2)
+    {
+        int mask = 0;
+        float py = y + 0.5f;
+        for (int lane = 0; lane < 8; lane++)
+        {
+            float px = x + lane + 0.5f;
+            float e0 = t.edgeA[0] * px + t.edgeB[0] * py + t.edgeC[0];
+            float e1 = t.edgeA[1] * px + t.edgeB[1] * py + t.edgeC[1];
+            float e2 = t.edgeA[2] * px + t.edgeB[2] * py + t.edgeC[2];
+            if (e0 < 0.0f || e1 < 0.0f || e2 < 0.0f)
+                continue;
+            z[lane] = e0 * t.z[0] + e1 * t.z[1] + e2 * t.z[2];
+            weight1[lane] = e1;
+            weight2[lane] = e2;
+            if (z[lane] < depth[lane])
+                mask |= 1 << lane;
+        }
+        return mask;
+    }
+
+    // whether the triangle misses the block entirely: some edge is negative at all four corner pixel centers
+    static bool missesBlock(const Triangle& t, int x0, int y0)
+    {
+        float xs[2] = { x0 + 0.5f, x0 + BLOCK - 0.5f }, ys[2] = { y0 + 0.5f, y0 + BLOCK - 0.5f };
+        for (int k = 0; k < 3; k++)
+        {
+            bool anyInside = false;
+            for (int i = 0; i < 4 && !anyInside; i++)
+                anyInside = t.edgeA[k] * xs[i & 1] + t.edgeB[k] * ys[i >> 1] + t.edgeC[k] >= 0.0f;
+            if (!anyInside)
+                return true;
+        }
+        return false;
+    }
+
+    void rasterizeTile(int tile, TileScratch& s)
+    {
+        int tileX = (tile % tilesX) * TILE, tileY = (tile / tilesX) * TILE;
+        std::fill(s.depth, s.depth + TILE * TILE, 1.0f);
+        std::fill(s.nearest, s.nearest + TILE * TILE, (const Triangle*)nullptr);
+        std::fill(s.blockFarthest, s.blockFarthest + (TILE / BLOCK) * (TILE / BLOCK), 1.0f);
+        const int blocksPerRow = TILE / BLOCK;
+
+        for (size_t c = 0; c < activeChunks; c++)
+        {
+            const Chunk& chunk = chunks[c];
+            for (int index : chunk.bins[tile])
+            {
+                const Triangle& t = chunk.triangles[index];
+                int minX = std::max(t.minX, tileX) - tileX, maxX = std::min(t.maxX, tileX + TILE - 1) - tileX;
+                int minY = std::max(t.minY, tileY) - tileY, maxY = std::min(t.maxY, tileY + TILE - 1) - tileY;
+                for (int by = minY / BLOCK; by <= maxY / BLOCK; by++)
+                    for (int bx = minX / BLOCK; bx <= maxX / BLOCK; bx++)
+                    {
+                        float& farthest = s.blockFarthest[by * blocksPerRow + bx];
+                        if (t.minZ >= farthest || missesBlock(t, tileX + bx * BLOCK, tileY + by * BLOCK))
+                            continue;
+                        if (rasterizeBlock(t, s, tileX, tileY, bx * BLOCK, by * BLOCK, minX, maxX, minY, maxY))
+                        {
+                            float blockMax = 0.0f;
+                            for (int y = by * BLOCK; y < (by + 1) * BLOCK; y++)
+                                for (int x = bx * BLOCK; x < (bx + 1) * BLOCK; x++)
+                                    blockMax = std::max(blockMax, s.depth[y * TILE + x]);
+                            farthest = blockMax;
+                        }
+                    }
+            }
+        }
+        shadeTile(s, tileX, tileY);
+    }
+
+    // one block's rows through the row test; returns whether any pixel was written
+    bool rasterizeBlock(const Triangle& t, TileScratch& s, int tileX, int tileY, int blockX, int blockY, int minX, int maxX, int minY, int maxY)
+    {
+        // lanes within the triangle's (and the image's) bounds
+        int laneMask = 0;
+        for (int lane = 0; lane < BLOCK; lane++)
+            if (blockX + lane >= minX && blockX + lane <= maxX)
+                laneMask |= 1 << lane;
+        bool written = false;
+        float z[8], weight1[8], weight2[8];
+        for (int y = std::max(blockY, minY); y <= std::min(blockY + BLOCK - 1, maxY); y++)
+        {
+            float* depth = &s.depth[y * TILE + blockX];
+            int mask = (avx2 ? rowAvx2(t, tileX + blockX, tileY + y, depth, z, weight1, weight2) : rowScalar(t, tileX + blockX, tileY + y, depth, z, weight1, weight2)) & laneMask;
+            for (; mask; mask &= mask - 1)
+            {
+                int lane = lowestBit(mask);
+                int pixel = y * TILE + blockX + lane;
+                s.depth[pixel] = z[lane];
+                s.barycentric1[pixel] = weight1[lane];
+                s.barycentric2[pixel] = weight2[lane];
+                s.nearest[pixel] = &t;
+                written = true;
+            }
+        }
+        return written;
+    }
+
+    static int lowestBit(int mask)
+    {
+        int bit = 0;
+        while (!(mask & (1 << bit)))
+            bit++;
+        return bit;
+    }
+
+    void shadeTile(const TileScratch& s, int tileX, int tileY)
+    {
+        int width = std::min(TILE, image.width - tileX), height = std::min(TILE, image.height - tileY);
+        for (int y = 0; y < height; y++)
+            for (int x = 0; x < width; x++)
+            {
+                int pixel = y * TILE + x;
+                glm::vec3 color = s.nearest[pixel] ? shade(*s.nearest[pixel], s.barycentric1[pixel], s.barycentric2[pixel]) : sky(tileX + x, tileY + y);
+                unsigned char* out = image.pixel(tileX + x, tileY + y);
+                for (int k = 0; k < 3; k++)
+                    out[k] = (unsigned char)(glm::clamp(color[k], 0.0f, 1.0f) * 255.0f + 0.5f);
+            }
+    }
+
+    // Fragment.fs without shadows, the sun or the lightmap: ambient plus every point light's diffuse and specular term
+    glm::vec3 shade(const Triangle& t, float weight1, float weight2) const
+    {
+        float weight0 = 1.0f - weight1 - weight2;
+        float invW = weight0 * t.invW[0] + weight1 * t.invW[1] + weight2 * t.invW[2];
+        float w = 1.0f / invW;
+        float attributes[ATTRIBUTES];
+        for (int i = 0; i < ATTRIBUTES; i++)
+            attributes[i] = (weight0 * t.attributes[0][i] + weight1 * t.attributes[1][i] + weight2 * t.attributes[2][i]) * w;
+        glm::vec3 albedo = t.texture >= 0 && t.texture < (int)textures.size() ? textures[t.texture].sample(attributes[0], attributes[1]) : glm::vec3(0.5f);
+        glm::vec3 position(attributes[2], attributes[3], attributes[4]);
+        glm::vec3 normal(attributes[5], attributes[6], attributes[7]);
+        float length = glm::length(normal);
+        normal = length > 0.0f ? normal / length : glm::vec3(0.0f, 1.0f, 0.0f);
+        glm::vec3 viewDir = glm::normalize(frame.cameraPos - position);
+        if (glm::dot(normal, viewDir) < 0.0f)
+            normal = -normal;
+
+        glm::vec3 lighting(ambient);
+        for (const PointLight& light : *frame.lights)
+        {
+            glm::vec3 toLight = light.position - position;
+            float distance = glm::length(toLight);
+            if (distance >= light.radius || distance <= 0.0f)
+                continue;
+            float ratio = distance / light.radius;
+            float window = glm::clamp(1.0f - ratio * ratio * ratio * ratio, 0.0f, 1.0f);
+            float attenuation = window * window / (1.0f + distance * distance);
+            glm::vec3 lightDir = toLight / distance;
+            float diffuse = std::max(glm::dot(normal, lightDir), 0.0f);
+            float specular = std::pow(std::max(glm::dot(normal, glm::normalize(lightDir + viewDir)), 0.0f), 32.0f) * 0.25f;
+            lighting += (diffuse + specular) * attenuation * light.color * light.intensity;
+        }
+        return albedo * lighting;
+    }
+
+    glm::vec3 sky(int x, int y) const
+    {
+        if (skyFaces.empty())
+            return clearColor;
+        glm::vec4 clip(((x + 0.5f) / image.width) * 2.0f - 1.0f, 1.0f - ((y + 0.5f) / image.height) * 2.0f, 1.0f, 1.0f);
+        glm::vec4 far = frame.skyFromClip * clip;
+        glm::vec3 d = glm::vec3(far) / far.w;
+        // GL's cube map face selection: the major axis picks the face, the other two give its coordinates
+        glm::vec3 a = glm::abs(d);
+        int face;
+        float sc, tc, ma;
+        if (a.x >= a.y && a.x >= a.z)
+        {
+            face = d.x > 0.0f ? 0 : 1;
+            sc = d.x > 0.0f ? -d.z : d.z;
+            tc = -d.y;
+            ma = a.x;
+        }
+        else if (a.y >= a.z)
+        {
+            face = d.y > 0.0f ? 2 : 3;
+            sc = d.x;
+            tc = d.y > 0.0f ? d.z : -d.z;
+            ma = a.y;
+        }
+        else
+        {
+            face = d.z > 0.0f ? 4 : 5;
+            sc = d.z > 0.0f ? d.x : -d.x;
+            tc = -d.y;
+            ma = a.z;
+        }
+        return skyFaces[face].sample((sc / ma + 1.0f) * 0.5f, (tc / ma + 1.0f) * 0.5f, false);
+    }
+};
+#endif
@@ -0,0 +1,160 @@
+#ifndef TEXTURE_ARRAY_H
+#define TEXTURE_ARRAY_H
+
+#include <glad/glad.h>
+
+#include "gl_handles.h"
+#include "shader.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+// Bilinearly resizes an 8 bit RGB image, wrapping around the edges since the room's textures tile
+inline void resampleWrapped(const unsigned char* texels, int width, int height, int outWidth, int outHeight, std::vector<unsigned char>& out)
+{
+    out.resize((size_t)outWidth * outHeight * 3);
+    for (int y = 0; y < outHeight; y++)
+    {
+        float sy = (y + 0.5f) * height / outHeight - 0.5f;
+        int y0 = (int)std::floor(sy);
+        float fy = sy - y0;
+        int row0 = ((y0 % height) + height) % height, row1 = (row0 + 1) % height;
+        for (int x = 0; x < outWidth; x++)
+        {
+            float sx = (x + 0.5f) * width / outWidth - 0.5f;
+            int x0 = (int)std::floor(sx);
+            float fx = sx - x0;
+            int column0 = ((x0 % width) + width) % width, column1 = (column0 + 1) % width;
+            const unsigned char* a = &texels[((size_t)row0 * width + column0) * 3];
+            const unsigned char* b = &texels[((size_t)row0 * width + column1) * 3];
+            const unsigned char* c = &texels[((size_t)row1 * width + column0) * 3];
+            const unsigned char* d = &texels[((size_t)row1 * width + column1) * 3];
+            for (int k = 0; k < 3; k++)
+            {
+                float top = a[k] + (b[k] - a[k]) * fx, bottom = c[k] + (d[k] - c[k]) * fx;
+                out[((size_t)y * outWidth + x) * 3 + k] = (unsigned char)(top + (bottom - top) * fy + 0.5f);
+            }
+        }
+    }
+}
+
+// Several textures packed as the layers of one GL_TEXTURE_2D_ARRAY, so geometry using any of them draws with a
+// single binding and picks its layer per vertex (a float attribute at location 4). Layers all have the same
+// size: images are resampled to the largest width and height among them. Each layer has its own mip chain, so
+// tiling and filtering never bleed from one image into another the way they would in an atlas.
+class TextureArray
+{
+public:
+    GlTexture texture;
+    int width, height;
+
+    TextureArray() : width(0), height(0) {}
+
+    // Keeps a copy of an 8 bit RGB image for upload(), rows pitch bytes apart, and returns its layer. bgr is
+    // for images with their channels the other way round (FreeImage's on little endian machines).
+    int add(const unsigned char* pixels, int imageWidth, int imageHeight, int pitch, bool bgr)
+    {
+        Layer layer;
+        layer.width = imageWidth;
+        layer.height = imageHeight;
+        layer.texels.resize((size_t)imageWidth * imageHeight * 3);
+        for (int y = 0; y < imageHeight; y++)
+        {
+            const unsigned char* row = pixels + (size_t)y * pitch;
+            unsigned char* out = &layer.texels[(size_t)y * imageWidth * 3];
+            for (int x = 0; x < imageWidth; x++)
+            {
+                out[x * 3 + 0] = row[x * 3 + (bgr ? 2 : 0)];
+                out[x * 3 + 1] = row[x * 3 + 1];
+                out[x * 3 + 2] = row[x * 3 + (bgr ? 0 : 2)];
+            }
+        }
+        layers.push_back(layer);
+        return (int)layers.size() - 1;
+    }
+
+    // a layer of one flat color, standing in for an image that failed to load so the layers after it keep their index
+    int addColor(unsigned char r, unsigned char g, unsigned char b)
+    {
+        const unsigned char texel[3] = { r, g, b };
+        return add(texel, 1, 1, 3, false);
+    }
+
+    // resamples the layers to a common size no larger than maxSize, uploads them with mipmaps and frees the copies
+    void upload(int maxSize = 2048)
+    {
+        if (layers.empty())
+            return;
+        width = height = 1;
+        for (const Layer& layer : layers)
+        {
+            width = std::max(width, layer.width);
+            height = std::max(height, layer.height);
+        }
+        width = std::min(width, maxSize);
+        height = std::min(height, maxSize);
+
+        if (!texture)
+            texture = GlTexture::create();
+        glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGB8, width, height, (GLsizei)layers.size(), 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        std::vector<unsigned char> resampled;
+        for (size_t i = 0; i < layers.size(); i++)
+        {
+            const Layer& layer = layers[i];
+            const unsigned char* texels = &layer.texels[0];
+            if (layer.width != width || layer.height != height)
+            {
+                resampleWrapped(&layer.texels[0], layer.width, layer.height, width, height, resampled);
+                texels = &resampled[0];
+            }
+            glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, (GLint)i, width, height, 1, GL_RGB, GL_UNSIGNED_BYTE, texels);
+        }
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+        std::cout << "TEXTURE_ARRAY:: " << layers.size() << " layers of " << width << "x" << height << std::endl;
+        layers.clear();
+    }
+
+    // gives every vertex of an existing VAO the same layer
+    void attachLayer(unsigned int VAO, int vertexCount, int layer)
+    {
+        if (vertexCount <= 0)
+            return;
+        std::vector<float> layerOfVertex(vertexCount, (float)layer);
+        GlBuffer VBO = GlBuffer::create();
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferData(GL_ARRAY_BUFFER, layerOfVertex.size() * sizeof(float), &layerOfVertex[0], GL_STATIC_DRAW);
+        glEnableVertexAttribArray(4);
+        glVertexAttribPointer(4, 1, GL_FLOAT, GL_FALSE, sizeof(float), (void*)0);
+        glBindVertexArray(0);
+        layerBuffers.push_back(std::move(VBO));
+    }
+
+    void bind(Shader& shader, int unit, const char* sampler)
+    {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+        shader.setInt(sampler, unit);
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+private:
+    struct Layer {
+        int width, height;
+        std::vector<unsigned char> texels;
+    };
+
+    std::vector<Layer> layers;
+    std::vector<GlBuffer> layerBuffers;
+};
+#endif
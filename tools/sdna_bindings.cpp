@@ -0,0 +1,228 @@
+// Generates compile-time bindings for Blender structs from an SDNA dump like dna.txt: for every struct a
+// namespace scope type holding its size, and a nested type per field with the field's C++ type, offset, size
+// and element count, plus the field table BlendFile::matches() checks a file against before trusting them.
+//
+//   cl /EHsc /O2 tools\sdna_bindings.cpp
+//   sdna_bindings dna.txt blend_dna.h [Struct ...]
+//
+// Without struct names every struct in the dump is written; blend_dna.h holds the ones BlendImporter reads.
+// The dump sizes "(*name)()" pointers by the type they point to; they are written as the 8 byte pointers they
+// are, and offsets behind them (and the sizes of structs that embed them) follow.
+
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct DumpField {
+    std::string type;
+    std::string name;
+    int offset;
+    int size;
+};
+
+struct DumpStruct {
+    std::string name;
+    int size;
+    std::vector<DumpField> fields;
+};
+
+static bool isFunctionPointer(const std::string& name)
+{
+    return name.compare(0, 2, "(*") == 0;
+}
+
+static bool isPointer(const std::string& name)
+{
+    return name[0] == '*' || isFunctionPointer(name);
+}
+
+// "*mvert" -> "mvert", "(*bindfunc)()" -> "bindfunc"
+static std::string identifier(const std::string& name)
+{
+    std::string result;
+    for (char c : name)
+    {
+        if (c == '*' || c == '(')
+            continue;
+        if (c == ')' || c == '[')
+            break;
+        result += c;
+    }
+    return result;
+}
+
+static const char* scalarType(const std::string& type)
+{
+    static const std::map<std::string, const char*> types = {
+        { "char", "char" }, { "uchar", "unsigned char" }, { "short", "int16_t" }, { "ushort", "uint16_t" },
+        { "int", "int32_t" }, { "long", "int32_t" }, { "ulong", "uint32_t" }, { "float", "float" },
+        { "double", "double" }, { "int64_t", "int64_t" }, { "uint64_t", "uint64_t" },
+    };
+    auto found = types.find(type);
+    return found == types.end() ? nullptr : found->second;
+}
+
+static std::vector<DumpStruct> readDump(const char* path)
+{
+    std::vector<DumpStruct> structs;
+    std::ifstream dump(path);
+    std::string line;
+    while (std::getline(dump, line))
+    {
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        if (line.empty() || line.compare(0, 6, "Field ") == 0 || line.compare(0, 10, "Structure ") == 0)
+            continue;
+        std::istringstream words(line);
+        if (line[0] == '\t')
+        {
+            DumpField field;
+            if (!structs.empty() && words >> field.type >> field.name >> field.offset >> field.size)
+                structs.back().fields.push_back(field);
+        }
+        else
+        {
+            DumpStruct s;
+            if (words >> s.name >> s.size)
+                structs.push_back(s);
+        }
+    }
+    return structs;
+}
+
+// sizes function pointers as pointers and lays every struct out again, until embedded struct sizes settle
+static std::vector<std::string> correctLayout(std::vector<DumpStruct>& structs)
+{
+    std::set<std::string> corrected;
+    for (bool changed = true; changed;)
+    {
+        changed = false;
+        for (DumpStruct& s : structs)
+        {
+            int offset = 0;
+            for (DumpField& field : s.fields)
+            {
+                int size = isFunctionPointer(field.name) ? 8 : field.size;
+                if (field.offset != offset || field.size != size)
+                {
+                    field.offset = offset;
+                    field.size = size;
+                    corrected.insert(s.name);
+                    changed = true;
+                }
+                offset += size;
+            }
+            if (offset != s.size)
+            {
+                // embedding structs pick the new size up on the next round
+                for (DumpStruct& other : structs)
+                    for (DumpField& field : other.fields)
+                        if (field.type == s.name && !isPointer(field.name) && s.size > 0)
+                            field.size = field.size / s.size * offset;
+                s.size = offset;
+                corrected.insert(s.name);
+                changed = true;
+            }
+        }
+    }
+    return std::vector<std::string>(corrected.begin(), corrected.end());
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 3)
+    {
+        std::cout << "usage: sdna_bindings dna.txt output.h [Struct ...]" << std::endl;
+        return 1;
+    }
+    std::vector<DumpStruct> structs = readDump(argv[1]);
+    if (structs.empty())
+    {
+        std::cout << "ERROR::SDNA_BINDINGS::DUMP_NOT_READ: " << argv[1] << std::endl;
+        return 1;
+    }
+    std::vector<std::string> corrected = correctLayout(structs);
+
+    std::set<std::string> wanted(argv + 3, argv + argc);
+    for (const std::string& name : wanted)
+    {
+        bool found = false;
+        for (const DumpStruct& s : structs)
+            found = found || s.name == name;
+        if (!found)
+        {
+            std::cout << "ERROR::SDNA_BINDINGS::NO_SUCH_STRUCT: " << name << std::endl;
+            return 1;
+        }
+    }
+
+    std::ostringstream out;
+    out << "// Generated by tools/sdna_bindings.cpp from " << argv[1] << ", do not edit. Regenerate with\n//   sdna_bindings";
+    for (int i = 1; i < argc; i++)
+        out << " " << argv[i];
+    out << "\n//\n"
+        << "// Layouts of a 64 bit .blend. Before reading a file through these, check that the file agrees with them\n"
+        << "// (BlendFile::matches<dna::Mesh>() and so on); files from other versions need the runtime offsets instead.\n"
+        << "#ifndef BLEND_DNA_H\n#define BLEND_DNA_H\n\n#include <cstddef>\n#include <cstdint>\n#include <cstring>\n\nnamespace dna\n{\n"
+        << "struct Field {\n    const char* name;\n    int offset;\n    int size;\n};\n\n"
+        << "// a scalar field, or element `index` of an array field, of the struct at base: one unaligned load\n"
+        << "template <class F>\ninline typename F::TYPE get(const char* base, int index = 0)\n{\n"
+        << "    typename F::TYPE value;\n    std::memcpy(&value, base + F::OFFSET + index * sizeof(value), sizeof(value));\n    return value;\n}\n\n"
+        << "// where a field starts, to step into an embedded struct or walk an array\n"
+        << "template <class F>\ninline const char* at(const char* base)\n{\n    return base + F::OFFSET;\n}\n\n"
+        << "// the struct at `index` in a block of S\n"
+        << "template <class S>\ninline const char* element(const char* block, size_t index)\n{\n    return block + index * S::SIZE;\n}\n";
+
+    for (const DumpStruct& s : structs)
+    {
+        if (!wanted.empty() && !wanted.count(s.name))
+            continue;
+        out << "\nstruct " << s.name << " {\n";
+        out << "    static constexpr int SIZE = " << s.size << ";\n";
+        out << "    static constexpr int FIELD_COUNT = " << s.fields.size() << ";\n";
+        out << "    static const char* TYPE_NAME() { return \"" << s.name << "\"; }\n";
+        out << "    static const Field* FIELDS()\n    {\n        static const Field fields[] = {\n";
+        for (const DumpField& field : s.fields)
+            out << "            { \"" << identifier(field.name) << "\", " << field.offset << ", " << field.size << " },\n";
+        if (s.fields.empty())
+            out << "            { \"\", 0, 0 },\n";
+        out << "        };\n        return fields;\n    }\n";
+        for (const DumpField& field : s.fields)
+        {
+            std::string name = identifier(field.name);
+            if (name == s.name || name == "SIZE" || name == "FIELD_COUNT" || name == "TYPE_NAME" || name == "FIELDS")
+                name += "_";
+            bool pointer = isPointer(field.name);
+            const char* scalar = scalarType(field.type);
+            // pointers are the old address they held, embedded structs raw bytes to step into with at()
+            std::string type = pointer ? "uint64_t" : (scalar ? scalar : "char");
+            int elementSize = pointer ? 8 : (scalar ? (type == "char" || type == "unsigned char" ? 1 : (type == "int16_t" || type == "uint16_t" ? 2 : (type == "double" || type == "int64_t" || type == "uint64_t" ? 8 : 4))) : 1);
+            int count = elementSize ? field.size / elementSize : 0;
+            out << "    // " << field.type << " " << field.name << "\n";
+            out << "    struct " << name << " {\n        typedef " << type << " TYPE;\n"
+                << "        static constexpr int OFFSET = " << field.offset << ";\n"
+                << "        static constexpr int SIZE = " << field.size << ";\n"
+                << "        static constexpr int COUNT = " << count << ";\n"
+                << "        static constexpr bool POINTER = " << (pointer ? "true" : "false") << ";\n    };\n";
+        }
+        out << "};\n";
+    }
+    out << "}\n#endif\n";
+
+    std::ofstream header(argv[2], std::ios::binary);
+    header << out.str();
+    if (!header)
+    {
+        std::cout << "ERROR::SDNA_BINDINGS::FILE_NOT_WRITTEN: " << argv[2] << std::endl;
+        return 1;
+    }
+    std::cout << "SDNA_BINDINGS:: " << (wanted.empty() ? structs.size() : wanted.size()) << " structs written to " << argv[2];
+    if (!corrected.empty())
+        std::cout << ", " << corrected.size() << " laid out again around function pointers";
+    std::cout << std::endl;
+    return 0;
+}
@@ -0,0 +1,925 @@
+#ifndef VULKAN_DEVICE_H
+#define VULKAN_DEVICE_H
+
+// The Vulkan backend needs the Vulkan SDK's headers and loader (vulkan-1.lib): it is only compiled with
+// RENDER_VULKAN defined. Its shaders are room_vk.vert and room_vk.frag compiled to SPIR-V next to them:
+//   glslangValidator -V room_vk.vert -o room_vk.vert.spv
+//   glslangValidator -V room_vk.frag -o room_vk.frag.spv
+
+#include <string>
+
+struct VulkanDeviceSettings {
+    // pick a CPU implementation (Mesa's lavapipe) over any GPU, for headless machines and CI
+    bool preferCpu = false;
+    // threads recording the draw list, each into its own secondary command buffer; 0 = one per core
+    int recordThreads = 0;
+    // frames the CPU may record ahead of the device
+    int framesInFlight = 2;
+    std::string pipelineCachePath = "vulkan.pipelinecache";
+};
+
+#ifdef RENDER_VULKAN
+
+#include <vulkan/vulkan.h>
+
+#include <glm/glm.hpp>
+
+#include "render_device.h"
+#include "texture_array.h"
+#include "worker_pool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Draws the room offscreen with Vulkan 1.2, no window or surface involved. The pipeline is built through a
+// VkPipelineCache kept on disk between runs, the per frame constants and the texture array are reached through
+// descriptor sets, and the draw list is split over several threads that each record a secondary command buffer
+// from their own pool. Frames in flight are tracked with a single timeline semaphore: every submit signals the
+// next value, and a frame slot is reused once the value it signalled has been reached.
+// Lighting is Fragment.fs without clusters, shadows, the sun or the lightmap: ambient plus every point light.
+class VulkanRenderDevice : public RenderDevice
+{
+public:
+    // point lights the per frame uniform buffer holds, later ones are dropped
+    static const int MAX_LIGHTS = 64;
+
+    // time spent recording the last frame's command buffers, across all threads
+    double recordMs = 0.0;
+
+    VulkanRenderDevice() {}
+    VulkanRenderDevice(const VulkanRenderDevice&) = delete;
+    VulkanRenderDevice& operator=(const VulkanRenderDevice&) = delete;
+    ~VulkanRenderDevice() { release(); }
+
+    const char* name() const override { return deviceName.c_str(); }
+
+    // creates the device and the render targets of the given size
+    bool init(int targetWidth, int targetHeight, const VulkanDeviceSettings& deviceSettings = VulkanDeviceSettings())
+    {
+        settings = deviceSettings;
+        settings.framesInFlight = std::max(1, settings.framesInFlight);
+        if (settings.recordThreads <= 0)
+            settings.recordThreads = std::max(1, (int)std::thread::hardware_concurrency());
+        width = targetWidth;
+        height = targetHeight;
+        // started once, so a frame's recording time doesn't include creating and joining threads
+        pool.reset(new WorkerPool(settings.recordThreads));
+        return createDevice() && createTargets() && createPipeline() && createFrames();
+    }
+
+    // surfaces in draw list order, 8 floats a vertex (position, normal, uv) like the room's arrays
+    void addSurface(const float* vertices, int vertexCount, int layer)
+    {
+        surfaceFirst.push_back((uint32_t)(surfaceVertices.size() / 8));
+        surfaceLayers.push_back(layer);
+        surfaceVertices.insert(surfaceVertices.end(), vertices, vertices + (size_t)vertexCount * 8);
+    }
+
+    // 8 bit RGB, the row at v = 0 first as with the GL texture array
+    void addTextureLayer(const unsigned char* rgb, int layerWidth, int layerHeight)
+    {
+        PendingLayer layer;
+        layer.width = layerWidth;
+        layer.height = layerHeight;
+        layer.texels.assign(rgb, rgb + (size_t)layerWidth * layerHeight * 3);
+        pendingLayers.push_back(layer);
+    }
+
+    // copies the surfaces and layers to device local memory
+    bool upload(int maxTextureSize = 2048)
+    {
+        if (!device || surfaceVertices.empty() || pendingLayers.empty())
+            return false;
+        VkDeviceSize vertexBytes = surfaceVertices.size() * sizeof(float);
+        if (!createBuffer(vertexBytes, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, vertexBuffer)
+            || !uploadBuffer(&surfaceVertices[0], vertexBytes, vertexBuffer.buffer))
+            return false;
+        return uploadTextureArray(maxTextureSize) && writeDescriptors();
+    }
+
+    void drawRoom(const FrameSnapshot& frame) override
+    {
+        Frame& slot = frames[frameNumber % frames.size()];
+        frameNumber++;
+        // the slot's command buffers and uniforms are free again once the device got past its last submit
+        waitTimeline(slot.submitted);
+
+        FrameConstants* constants = (FrameConstants*)slot.uniforms.mapped;
+        constants->view = frame.view;
+        constants->projection = frame.projection;
+        constants->viewPosAmbient = glm::vec4(frame.cameraPos, 0.15f);
+        int lightCount = std::min(frame.lighting.lightCount(), (int)MAX_LIGHTS);
+        constants->lightCount[0] = lightCount;
+        std::copy(frame.lighting.lights.begin(), frame.lighting.lights.begin() + lightCount * 2, constants->lights);
+
+        auto start = std::chrono::steady_clock::now();
+        std::vector<size_t> visible;
+        for (size_t i = 0; i < frame.drawList.size() && i < surfaceFirst.size(); i++)
+            if (!(frame.drawList[i].flags & (DRAW_NOT_VISIBLE | DRAW_SHADOW_ONLY)))
+                visible.push_back(i);
+        size_t threads = std::max<size_t>(1, std::min(slot.recorders.size(), visible.size()));
+        pool->run([&](int thread) {
+            size_t t = (size_t)thread;
+            if (t < threads)
+                recordRange(slot, t, frame, visible, visible.size() * t / threads, visible.size() * (t + 1) / threads);
+        });
+
+        vkResetCommandPool(device, slot.pool, 0);
+        VkCommandBufferBeginInfo begin = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+        begin.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        vkBeginCommandBuffer(slot.primary, &begin);
+        VkClearValue clears[2];
+        clears[0].color = { { 0.1f, 0.1f, 0.1f, 1.0f } };
+        clears[1].depthStencil = { 1.0f, 0 };
+        VkRenderPassBeginInfo pass = { VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO };
+        pass.renderPass = renderPass;
+        pass.framebuffer = framebuffer;
+        pass.renderArea.extent = { (uint32_t)width, (uint32_t)height };
+        pass.clearValueCount = 2;
+        pass.pClearValues = clears;
+        vkCmdBeginRenderPass(slot.primary, &pass, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+        std::vector<VkCommandBuffer> secondaries;
+        for (size_t t = 0; t < threads; t++)
+            secondaries.push_back(slot.recorders[t].commands);
+        vkCmdExecuteCommands(slot.primary, (uint32_t)secondaries.size(), &secondaries[0]);
+        vkCmdEndRenderPass(slot.primary);
+        // the render pass leaves the color target ready to be copied out
+        VkBufferImageCopy copy = {};
+        copy.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+        copy.imageExtent = { (uint32_t)width, (uint32_t)height, 1 };
+        vkCmdCopyImageToBuffer(slot.primary, color.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, readbackBuffer.buffer, 1, &copy);
+        vkEndCommandBuffer(slot.primary);
+        recordMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        slot.submitted = submit(slot.primary);
+    }
+
+    // waits until the device has finished every frame submitted so far
+    bool finish() { return waitTimeline(timelineValue); }
+
+    bool readback(RgbImage& image) override
+    {
+        if (!device || timelineValue == 0 || !waitTimeline(timelineValue))
+            return false;
+        image = RgbImage(width, height);
+        const unsigned char* rgba = (const unsigned char*)readbackBuffer.mapped;
+        // the viewport is flipped, so rows already come top to bottom
+        for (size_t i = 0; i < (size_t)width * height; i++)
+            std::copy(rgba + i * 4, rgba + i * 4 + 3, &image.pixels[i * 3]);
+        return true;
+    }
+
+    // waits for the device to finish, saves the pipeline cache and frees everything
+    void release()
+    {
+        if (!device)
+        {
+            if (instance)
+                vkDestroyInstance(instance, nullptr);
+            instance = VK_NULL_HANDLE;
+            return;
+        }
+        vkDeviceWaitIdle(device);
+        savePipelineCache();
+        for (Frame& frame : frames)
+        {
+            for (Recorder& recorder : frame.recorders)
+                vkDestroyCommandPool(device, recorder.pool, nullptr);
+            vkDestroyCommandPool(device, frame.pool, nullptr);
+            destroyBuffer(frame.uniforms);
+        }
+        frames.clear();
+        destroyBuffer(readbackBuffer);
+        destroyBuffer(vertexBuffer);
+        destroyImage(textures);
+        destroyImage(color);
+        destroyImage(depth);
+        vkDestroySampler(device, sampler, nullptr);
+        vkDestroyDescriptorPool(device, descriptorPool, nullptr);
+        vkDestroyPipeline(device, pipeline, nullptr);
+        vkDestroyPipelineCache(device, pipelineCache, nullptr);
+        vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
+        vkDestroyDescriptorSetLayout(device, setLayout, nullptr);
+        vkDestroyFramebuffer(device, framebuffer, nullptr);
+        vkDestroyRenderPass(device, renderPass, nullptr);
+        vkDestroyCommandPool(device, uploadPool, nullptr);
+        vkDestroySemaphore(device, timeline, nullptr);
+        vkDestroyDevice(device, nullptr);
+        vkDestroyInstance(instance, nullptr);
+        device = VK_NULL_HANDLE;
+        instance = VK_NULL_HANDLE;
+    }
+
+private:
+    // the uniform buffer of one frame, std140
+    struct FrameConstants {
+        glm::mat4 view;
+        glm::mat4 projection;
+        // camera position, ambient strength
+        glm::vec4 viewPosAmbient;
+        int lightCount[4];
+        // two per light like ClusteredLightList: (position, radius), (color * intensity, 0)
+        glm::vec4 lights[MAX_LIGHTS * 2];
+    };
+
+    // push constants of one draw: the model matrix and the normal matrix's columns, the surface's layer in the
+    // first column's w
+    struct DrawConstants {
+        glm::mat4 model;
+        glm::vec4 normalMatrix[3];
+    };
+
+    struct Buffer {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        void* mapped = nullptr;
+    };
+
+    struct Image {
+        VkImage image = VK_NULL_HANDLE;
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VkImageView view = VK_NULL_HANDLE;
+    };
+
+    // command pools are externally synchronized, so each recording thread has its own per frame slot
+    struct Recorder {
+        VkCommandPool pool = VK_NULL_HANDLE;
+        VkCommandBuffer commands = VK_NULL_HANDLE;
+    };
+
+    struct Frame {
+        VkCommandPool pool = VK_NULL_HANDLE;
+        VkCommandBuffer primary = VK_NULL_HANDLE;
+        std::vector<Recorder> recorders;
+        Buffer uniforms;
+        VkDescriptorSet descriptors = VK_NULL_HANDLE;
+        // timeline value the last submit from this slot signals
+        uint64_t submitted = 0;
+    };
+
+    struct PendingLayer {
+        int width, height;
+        std::vector<unsigned char> texels;
+    };
+
+    VulkanDeviceSettings settings;
+    // the recording threads, one per recorder of a frame slot
+    std::unique_ptr<WorkerPool> pool;
+    std::string deviceName = "Vulkan";
+    int width = 0, height = 0;
+    VkInstance instance = VK_NULL_HANDLE;
+    VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+    VkDevice device = VK_NULL_HANDLE;
+    VkQueue queue = VK_NULL_HANDLE;
+    uint32_t queueFamily = 0;
+    VkSemaphore timeline = VK_NULL_HANDLE;
+    uint64_t timelineValue = 0;
+    VkCommandPool uploadPool = VK_NULL_HANDLE;
+    Image color, depth, textures;
+    VkRenderPass renderPass = VK_NULL_HANDLE;
+    VkFramebuffer framebuffer = VK_NULL_HANDLE;
+    VkDescriptorSetLayout setLayout = VK_NULL_HANDLE;
+    VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+    VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+    VkPipelineCache pipelineCache = VK_NULL_HANDLE;
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    VkSampler sampler = VK_NULL_HANDLE;
+    Buffer vertexBuffer, readbackBuffer;
+    std::vector<Frame> frames;
+    uint64_t frameNumber = 0;
+    std::vector<float> surfaceVertices;
+    std::vector<uint32_t> surfaceFirst;
+    std::vector<int> surfaceLayers;
+    std::vector<PendingLayer> pendingLayers;
+
+    static bool check(VkResult result, const char* what)
+    {
+        if (result == VK_SUCCESS)
+            return true;
+        std::cout << "ERROR::VULKAN::" << what << ": VkResult " << result << std::endl;
+        return false;
+    }
+
+    bool createDevice()
+    {
+        VkApplicationInfo application = { VK_STRUCTURE_TYPE_APPLICATION_INFO };
+        application.pApplicationName = "Room";
+        application.apiVersion = VK_API_VERSION_1_2;
+        VkInstanceCreateInfo instanceInfo = { VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO };
+        instanceInfo.pApplicationInfo = &application;
+        if (!check(vkCreateInstance(&instanceInfo, nullptr, &instance), "INSTANCE"))
+            return false;
+
+        uint32_t count = 0;
+        vkEnumeratePhysicalDevices(instance, &count, nullptr);
+        std::vector<VkPhysicalDevice> candidates(count);
+        if (count)
+            vkEnumeratePhysicalDevices(instance, &count, &candidates[0]);
+        VkPhysicalDeviceProperties chosenProperties = {};
+        for (VkPhysicalDevice candidate : candidates)
+        {
+            VkPhysicalDeviceProperties properties;
+            vkGetPhysicalDeviceProperties(candidate, &properties);
+            VkPhysicalDeviceVulkan12Features features12 = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES };
+            VkPhysicalDeviceFeatures2 features = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2 };
+            features.pNext = &features12;
+            vkGetPhysicalDeviceFeatures2(candidate, &features);
+            if (properties.apiVersion < VK_API_VERSION_1_2 || !features12.timelineSemaphore || !findQueueFamily(candidate))
+                continue;
+            bool cpu = properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_CPU;
+            bool chosenCpu = physicalDevice && chosenProperties.deviceType == VK_PHYSICAL_DEVICE_TYPE_CPU;
+            if (!physicalDevice || (settings.preferCpu && cpu && !chosenCpu))
+            {
+                physicalDevice = candidate;
+                chosenProperties = properties;
+            }
+        }
+        if (!physicalDevice)
+        {
+            std::cout << "ERROR::VULKAN::NO_DEVICE: no Vulkan 1.2 device with timeline semaphores" << std::endl;
+            return false;
+        }
+        findQueueFamily(physicalDevice);
+        deviceName = std::string("Vulkan (") + chosenProperties.deviceName + ")";
+
+        float priority = 1.0f;
+        VkDeviceQueueCreateInfo queueInfo = { VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO };
+        queueInfo.queueFamilyIndex = queueFamily;
+        queueInfo.queueCount = 1;
+        queueInfo.pQueuePriorities = &priority;
+        VkPhysicalDeviceVulkan12Features features12 = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES };
+        features12.timelineSemaphore = VK_TRUE;
+        VkDeviceCreateInfo deviceInfo = { VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO };
+        deviceInfo.pNext = &features12;
+        deviceInfo.queueCreateInfoCount = 1;
+        deviceInfo.pQueueCreateInfos = &queueInfo;
+        if (!check(vkCreateDevice(physicalDevice, &deviceInfo, nullptr, &device), "DEVICE"))
+            return false;
+        vkGetDeviceQueue(device, queueFamily, 0, &queue);
+
+        VkSemaphoreTypeCreateInfo semaphoreType = { VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO };
+        semaphoreType.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+        semaphoreType.initialValue = 0;
+        VkSemaphoreCreateInfo semaphoreInfo = { VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO };
+        semaphoreInfo.pNext = &semaphoreType;
+        VkCommandPoolCreateInfo poolInfo = { VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO };
+        poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+        poolInfo.queueFamilyIndex = queueFamily;
+        std::cout << "VULKAN::DEVICE:: " << chosenProperties.deviceName << std::endl;
+        return check(vkCreateSemaphore(device, &semaphoreInfo, nullptr, &timeline), "TIMELINE_SEMAPHORE")
+            && check(vkCreateCommandPool(device, &poolInfo, nullptr, &uploadPool), "COMMAND_POOL");
+    }
+
+    bool findQueueFamily(VkPhysicalDevice candidate)
+    {
+        uint32_t count = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(candidate, &count, nullptr);
+        std::vector<VkQueueFamilyProperties> families(count);
+        if (count)
+            vkGetPhysicalDeviceQueueFamilyProperties(candidate, &count, &families[0]);
+        for (uint32_t i = 0; i < count; i++)
+            if (families[i].queueFlags & VK_QUEUE_GRAPHICS_BIT)
+            {
+                queueFamily = i;
+                return true;
+            }
+        return false;
+    }
+
+    bool findMemoryType(uint32_t typeBits, VkMemoryPropertyFlags properties, uint32_t& type) const
+    {
+        VkPhysicalDeviceMemoryProperties memory;
+        vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memory);
+        for (uint32_t i = 0; i < memory.memoryTypeCount; i++)
+            if ((typeBits & (1u << i)) && (memory.memoryTypes[i].propertyFlags & properties) == properties)
+            {
+                type = i;
+                return true;
+            }
+        std::cout << "ERROR::VULKAN::NO_MEMORY_TYPE: " << properties << std::endl;
+        return false;
+    }
+
+    bool allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, VkDeviceMemory& memory)
+    {
+        VkMemoryAllocateInfo allocation = { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
+        allocation.allocationSize = requirements.size;
+        return findMemoryType(requirements.memoryTypeBits, properties, allocation.memoryTypeIndex)
+            && check(vkAllocateMemory(device, &allocation, nullptr, &memory), "ALLOCATE");
+    }
+
+    // host visible buffers stay mapped for their whole life
+    bool createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, Buffer& buffer)
+    {
+        VkBufferCreateInfo info = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
+        info.size = size;
+        info.usage = usage;
+        info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        if (!check(vkCreateBuffer(device, &info, nullptr, &buffer.buffer), "BUFFER"))
+            return false;
+        VkMemoryRequirements requirements;
+        vkGetBufferMemoryRequirements(device, buffer.buffer, &requirements);
+        if (!allocate(requirements, properties, buffer.memory))
+            return false;
+        vkBindBufferMemory(device, buffer.buffer, buffer.memory, 0);
+        if (properties & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+            return check(vkMapMemory(device, buffer.memory, 0, VK_WHOLE_SIZE, 0, &buffer.mapped), "MAP");
+        return true;
+    }
+
+    void destroyBuffer(Buffer& buffer)
+    {
+        vkDestroyBuffer(device, buffer.buffer, nullptr);
+        vkFreeMemory(device, buffer.memory, nullptr);
+        buffer = Buffer();
+    }
+
+    bool createImage(VkImageType type, VkImageViewType viewType, VkFormat format, uint32_t imageWidth, uint32_t imageHeight, uint32_t layers, VkImageUsageFlags usage, VkImageAspectFlags aspect, Image& image)
+    {
+        VkImageCreateInfo info = { VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO };
+        info.imageType = type;
+        info.format = format;
+        info.extent = { imageWidth, imageHeight, 1 };
+        info.mipLevels = 1;
+        info.arrayLayers = layers;
+        info.samples = VK_SAMPLE_COUNT_1_BIT;
+        info.tiling = VK_IMAGE_TILING_OPTIMAL;
+        info.usage = usage;
+        info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        if (!check(vkCreateImage(device, &info, nullptr, &image.image), "IMAGE"))
+            return false;
+        VkMemoryRequirements requirements;
+        vkGetImageMemoryRequirements(device, image.image, &requirements);
+        if (!allocate(requirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image.memory))
+            return false;
+        vkBindImageMemory(device, image.image, image.memory, 0);
+        VkImageViewCreateInfo viewInfo = { VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO };
+        viewInfo.image = image.image;
+        viewInfo.viewType = viewType;
+        viewInfo.format = format;
+        viewInfo.subresourceRange = { aspect, 0, 1, 0, layers };
+        return check(vkCreateImageView(device, &viewInfo, nullptr, &image.view), "IMAGE_VIEW");
+    }
+
+    void destroyImage(Image& image)
+    {
+        vkDestroyImageView(device, image.view, nullptr);
+        vkDestroyImage(device, image.image, nullptr);
+        vkFreeMemory(device, image.memory, nullptr);
+        image = Image();
+    }
+
+    bool createTargets()
+    {
+        const VkFormat colorFormat = VK_FORMAT_R8G8B8A8_UNORM, depthFormat = VK_FORMAT_D32_SFLOAT;
+        if (!createImage(VK_IMAGE_TYPE_2D, VK_IMAGE_VIEW_TYPE_2D, colorFormat, width, height, 1, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, VK_IMAGE_ASPECT_COLOR_BIT, color)
+            || !createImage(VK_IMAGE_TYPE_2D, VK_IMAGE_VIEW_TYPE_2D, depthFormat, width, height, 1, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, VK_IMAGE_ASPECT_DEPTH_BIT, depth))
+            return false;
+
+        VkAttachmentDescription attachments[2] = {};
+        attachments[0].format = colorFormat;
+        attachments[0].samples = VK_SAMPLE_COUNT_1_BIT;
+        attachments[0].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+        attachments[0].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+        attachments[0].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        attachments[0].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        attachments[0].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        attachments[0].finalLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        attachments[1] = attachments[0];
+        attachments[1].format = depthFormat;
+        attachments[1].storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        attachments[1].finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+        VkAttachmentReference colorReference = { 0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+        VkAttachmentReference depthReference = { 1, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL };
+        VkSubpassDescription subpass = {};
+        subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+        subpass.colorAttachmentCount = 1;
+        subpass.pColorAttachments = &colorReference;
+        subpass.pDepthStencilAttachment = &depthReference;
+        // the targets are shared by all frames in flight: a frame's clears wait for the previous frame's writes and
+        // its copy out, and the copy out waits for the color writes
+        VkSubpassDependency dependencies[2] = {};
+        dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+        dependencies[0].dstSubpass = 0;
+        dependencies[0].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT;
+        dependencies[0].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+        dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT;
+        dependencies[1].srcSubpass = 0;
+        dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+        dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+        dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+        dependencies[1].dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+        dependencies[1].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        VkRenderPassCreateInfo passInfo = { VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO };
+        passInfo.attachmentCount = 2;
+        passInfo.pAttachments = attachments;
+        passInfo.subpassCount = 1;
+        passInfo.pSubpasses = &subpass;
+        passInfo.dependencyCount = 2;
+        passInfo.pDependencies = dependencies;
+        if (!check(vkCreateRenderPass(device, &passInfo, nullptr, &renderPass), "RENDER_PASS"))
+            return false;
+
+        VkImageView views[2] = { color.view, depth.view };
+        VkFramebufferCreateInfo framebufferInfo = { VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO };
+        framebufferInfo.renderPass = renderPass;
+        framebufferInfo.attachmentCount = 2;
+        framebufferInfo.pAttachments = views;
+        framebufferInfo.width = width;
+        framebufferInfo.height = height;
+        framebufferInfo.layers = 1;
+        return check(vkCreateFramebuffer(device, &framebufferInfo, nullptr, &framebuffer), "FRAMEBUFFER")
+            && createBuffer((VkDeviceSize)width * height * 4, VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, readbackBuffer);
+    }
+
+    bool loadShader(const char* path, VkShaderModule& module)
+    {
+        std::ifstream file(path, std::ios::binary);
+        std::vector<char> code((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        if (code.empty() || code.size() % 4 != 0)
+        {
+            std::cout << "ERROR::VULKAN::SHADER_NOT_FOUND: " << path << " (compile it with glslangValidator -V)" << std::endl;
+            return false;
+        }
+        std::vector<uint32_t> words(code.size() / 4);
+        std::memcpy(&words[0], &code[0], code.size());
+        VkShaderModuleCreateInfo info = { VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO };
+        info.codeSize = code.size();
+        info.pCode = &words[0];
+        return check(vkCreateShaderModule(device, &info, nullptr, &module), "SHADER_MODULE");
+    }
+
+    // an invalid or foreign cache file is simply not used: drivers check the header and start from an empty cache
+    void loadPipelineCache()
+    {
+        std::ifstream file(settings.pipelineCachePath, std::ios::binary);
+        std::vector<char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        VkPipelineCacheCreateInfo info = { VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO };
+        info.initialDataSize = data.size();
+        info.pInitialData = data.empty() ? nullptr : &data[0];
+        if (vkCreatePipelineCache(device, &info, nullptr, &pipelineCache) != VK_SUCCESS)
+        {
+            info.initialDataSize = 0;
+            info.pInitialData = nullptr;
+            vkCreatePipelineCache(device, &info, nullptr, &pipelineCache);
+        }
+    }
+
+    void savePipelineCache()
+    {
+        size_t size = 0;
+        if (!pipelineCache || settings.pipelineCachePath.empty() || vkGetPipelineCacheData(device, pipelineCache, &size, nullptr) != VK_SUCCESS || size == 0)
+            return;
+        std::vector<char> data(size);
+        if (vkGetPipelineCacheData(device, pipelineCache, &size, &data[0]) == VK_SUCCESS)
+            std::ofstream(settings.pipelineCachePath, std::ios::binary).write(&data[0], size);
+    }
+
+    bool createPipeline()
+    {
+        VkDescriptorSetLayoutBinding bindings[2] = {};
+        bindings[0].binding = 0;
+        bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        bindings[0].descriptorCount = 1;
+        bindings[0].stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+        bindings[1].binding = 1;
+        bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        bindings[1].descriptorCount = 1;
+        bindings[1].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+        VkDescriptorSetLayoutCreateInfo setInfo = { VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO };
+        setInfo.bindingCount = 2;
+        setInfo.pBindings = bindings;
+        if (!check(vkCreateDescriptorSetLayout(device, &setInfo, nullptr, &setLayout), "DESCRIPTOR_SET_LAYOUT"))
+            return false;
+        VkPushConstantRange pushRange = { VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(DrawConstants) };
+        VkPipelineLayoutCreateInfo layoutInfo = { VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO };
+        layoutInfo.setLayoutCount = 1;
+        layoutInfo.pSetLayouts = &setLayout;
+        layoutInfo.pushConstantRangeCount = 1;
+        layoutInfo.pPushConstantRanges = &pushRange;
+        if (!check(vkCreatePipelineLayout(device, &layoutInfo, nullptr, &pipelineLayout), "PIPELINE_LAYOUT"))
+            return false;
+
+        VkShaderModule vertexShader = VK_NULL_HANDLE, fragmentShader = VK_NULL_HANDLE;
+        if (!loadShader("room_vk.vert.spv", vertexShader) || !loadShader("room_vk.frag.spv", fragmentShader))
+        {
+            vkDestroyShaderModule(device, vertexShader, nullptr);
+            return false;
+        }
+        VkPipelineShaderStageCreateInfo stages[2] = {};
+        stages[0].sType = stages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+        stages[0].module = vertexShader;
+        stages[0].pName = "main";
+        stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+        stages[1].module = fragmentShader;
+        stages[1].pName = "main";
+
+        VkVertexInputBindingDescription binding = { 0, 8 * sizeof(float), VK_VERTEX_INPUT_RATE_VERTEX };
+        VkVertexInputAttributeDescription attributes[3] = {
+            { 0, 0, VK_FORMAT_R32G32B32_SFLOAT, 0 },
+            { 1, 0, VK_FORMAT_R32G32B32_SFLOAT, 3 * sizeof(float) },
+            { 2, 0, VK_FORMAT_R32G32_SFLOAT, 6 * sizeof(float) },
+        };
+        VkPipelineVertexInputStateCreateInfo vertexInput = { VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO };
+        vertexInput.vertexBindingDescriptionCount = 1;
+        vertexInput.pVertexBindingDescriptions = &binding;
+        vertexInput.vertexAttributeDescriptionCount = 3;
+        vertexInput.pVertexAttributeDescriptions = attributes;
+        VkPipelineInputAssemblyStateCreateInfo assembly = { VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO };
+        assembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+        // a negative height flips y, so the GL projection matrices work unchanged and rows come out top first
+        VkViewport viewport = { 0.0f, (float)height, (float)width, -(float)height, 0.0f, 1.0f };
+        VkRect2D scissor = { { 0, 0 }, { (uint32_t)width, (uint32_t)height } };
+        VkPipelineViewportStateCreateInfo viewportState = { VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO };
+        viewportState.viewportCount = 1;
+        viewportState.pViewports = &viewport;
+        viewportState.scissorCount = 1;
+        viewportState.pScissors = &scissor;
+        // both sides, the room's triangles don't agree on a winding
+        VkPipelineRasterizationStateCreateInfo rasterization = { VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO };
+        rasterization.polygonMode = VK_POLYGON_MODE_FILL;
+        rasterization.cullMode = VK_CULL_MODE_NONE;
+        rasterization.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+        rasterization.lineWidth = 1.0f;
+        VkPipelineMultisampleStateCreateInfo multisample = { VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO };
+        multisample.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+        VkPipelineDepthStencilStateCreateInfo depthState = { VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO };
+        depthState.depthTestEnable = VK_TRUE;
+        depthState.depthWriteEnable = VK_TRUE;
+        depthState.depthCompareOp = VK_COMPARE_OP_LESS;
+        VkPipelineColorBlendAttachmentState blend = {};
+        blend.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+        VkPipelineColorBlendStateCreateInfo blendState = { VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO };
+        blendState.attachmentCount = 1;
+        blendState.pAttachments = &blend;
+
+        VkGraphicsPipelineCreateInfo pipelineInfo = { VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO };
+        pipelineInfo.stageCount = 2;
+        pipelineInfo.pStages = stages;
+        pipelineInfo.pVertexInputState = &vertexInput;
+        pipelineInfo.pInputAssemblyState = &assembly;
+        pipelineInfo.pViewportState = &viewportState;
+        pipelineInfo.pRasterizationState = &rasterization;
+        pipelineInfo.pMultisampleState = &multisample;
+        pipelineInfo.pDepthStencilState = &depthState;
+        pipelineInfo.pColorBlendState = &blendState;
+        pipelineInfo.layout = pipelineLayout;
+        pipelineInfo.renderPass = renderPass;
+        pipelineInfo.subpass = 0;
+        loadPipelineCache();
+        auto start = std::chrono::steady_clock::now();
+        bool created = check(vkCreateGraphicsPipelines(device, pipelineCache, 1, &pipelineInfo, nullptr, &pipeline), "PIPELINE");
+        std::cout << "VULKAN::PIPELINE:: built in " << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() << " ms" << std::endl;
+        vkDestroyShaderModule(device, vertexShader, nullptr);
+        vkDestroyShaderModule(device, fragmentShader, nullptr);
+        return created;
+    }
+
+    bool createFrames()
+    {
+        VkDescriptorPoolSize sizes[2] = {
+            { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, (uint32_t)settings.framesInFlight },
+            { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, (uint32_t)settings.framesInFlight },
+        };
+        VkDescriptorPoolCreateInfo poolInfo = { VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO };
+        poolInfo.maxSets = settings.framesInFlight;
+        poolInfo.poolSizeCount = 2;
+        poolInfo.pPoolSizes = sizes;
+        if (!check(vkCreateDescriptorPool(device, &poolInfo, nullptr, &descriptorPool), "DESCRIPTOR_POOL"))
+            return false;
+
+        frames.resize(settings.framesInFlight);
+        for (Frame& frame : frames)
+        {
+            VkCommandPoolCreateInfo commandPoolInfo = { VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO };
+            commandPoolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+            commandPoolInfo.queueFamilyIndex = queueFamily;
+            if (!check(vkCreateCommandPool(device, &commandPoolInfo, nullptr, &frame.pool), "COMMAND_POOL")
+                || !allocateCommands(frame.pool, VK_COMMAND_BUFFER_LEVEL_PRIMARY, frame.primary))
+                return false;
+            frame.recorders.resize(settings.recordThreads);
+            for (Recorder& recorder : frame.recorders)
+                if (!check(vkCreateCommandPool(device, &commandPoolInfo, nullptr, &recorder.pool), "COMMAND_POOL")
+                    || !allocateCommands(recorder.pool, VK_COMMAND_BUFFER_LEVEL_SECONDARY, recorder.commands))
+                    return false;
+            if (!createBuffer(sizeof(FrameConstants), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, frame.uniforms))
+                return false;
+            VkDescriptorSetAllocateInfo setInfo = { VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
+            setInfo.descriptorPool = descriptorPool;
+            setInfo.descriptorSetCount = 1;
+            setInfo.pSetLayouts = &setLayout;
+            if (!check(vkAllocateDescriptorSets(device, &setInfo, &frame.descriptors), "DESCRIPTOR_SET"))
+                return false;
+        }
+        return true;
+    }
+
+    bool allocateCommands(VkCommandPool pool, VkCommandBufferLevel level, VkCommandBuffer& commands)
+    {
+        VkCommandBufferAllocateInfo info = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO };
+        info.commandPool = pool;
+        info.level = level;
+        info.commandBufferCount = 1;
+        return check(vkAllocateCommandBuffers(device, &info, &commands), "COMMAND_BUFFER");
+    }
+
+    // submits and returns the timeline value that signals its completion
+    uint64_t submit(VkCommandBuffer commands)
+    {
+        uint64_t signal = ++timelineValue;
+        VkTimelineSemaphoreSubmitInfo timelineInfo = { VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO };
+        timelineInfo.signalSemaphoreValueCount = 1;
+        timelineInfo.pSignalSemaphoreValues = &signal;
+        VkSubmitInfo info = { VK_STRUCTURE_TYPE_SUBMIT_INFO };
+        info.pNext = &timelineInfo;
+        info.commandBufferCount = 1;
+        info.pCommandBuffers = &commands;
+        info.signalSemaphoreCount = 1;
+        info.pSignalSemaphores = &timeline;
+        check(vkQueueSubmit(queue, 1, &info, VK_NULL_HANDLE), "SUBMIT");
+        return signal;
+    }
+
+    bool waitTimeline(uint64_t value)
+    {
+        if (value == 0)
+            return true;
+        VkSemaphoreWaitInfo info = { VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO };
+        info.semaphoreCount = 1;
+        info.pSemaphores = &timeline;
+        info.pValues = &value;
+        return check(vkWaitSemaphores(device, &info, UINT64_MAX), "WAIT");
+    }
+
+    // records one-off transfer commands, submits them and waits
+    template <class Record>
+    bool runOnce(Record record)
+    {
+        VkCommandBuffer commands;
+        if (!allocateCommands(uploadPool, VK_COMMAND_BUFFER_LEVEL_PRIMARY, commands))
+            return false;
+        VkCommandBufferBeginInfo begin = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+        begin.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        vkBeginCommandBuffer(commands, &begin);
+        record(commands);
+        vkEndCommandBuffer(commands);
+        bool done = waitTimeline(submit(commands));
+        vkFreeCommandBuffers(device, uploadPool, 1, &commands);
+        return done;
+    }
+
+    bool uploadBuffer(const void* data, VkDeviceSize size, VkBuffer destination)
+    {
+        Buffer staging;
+        if (!createBuffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, staging))
+            return false;
+        std::memcpy(staging.mapped, data, (size_t)size);
+        bool done = runOnce([&](VkCommandBuffer commands) {
+            VkBufferCopy region = { 0, 0, size };
+            vkCmdCopyBuffer(commands, staging.buffer, destination, 1, &region);
+        });
+        destroyBuffer(staging);
+        return done;
+    }
+
+    // one RGBA8 layer per image, all resampled to the largest size like TextureArray does; no mipmaps
+    bool uploadTextureArray(int maxTextureSize)
+    {
+        int layerWidth = 1, layerHeight = 1;
+        for (const PendingLayer& layer : pendingLayers)
+        {
+            layerWidth = std::max(layerWidth, layer.width);
+            layerHeight = std::max(layerHeight, layer.height);
+        }
+        layerWidth = std::min(layerWidth, maxTextureSize);
+        layerHeight = std::min(layerHeight, maxTextureSize);
+        uint32_t layerCount = (uint32_t)pendingLayers.size();
+        size_t layerBytes = (size_t)layerWidth * layerHeight * 4;
+
+        Buffer staging;
+        if (!createBuffer(layerBytes * layerCount, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, staging))
+            return false;
+        std::vector<unsigned char> resampled;
+        for (uint32_t i = 0; i < layerCount; i++)
+        {
+            const PendingLayer& layer = pendingLayers[i];
+            const unsigned char* rgb = &layer.texels[0];
+            if (layer.width != layerWidth || layer.height != layerHeight)
+            {
+                resampleWrapped(rgb, layer.width, layer.height, layerWidth, layerHeight, resampled);
+                rgb = &resampled[0];
+            }
+            unsigned char* rgba = (unsigned char*)staging.mapped + layerBytes * i;
+            for (size_t t = 0; t < (size_t)layerWidth * layerHeight; t++)
+            {
+                std::copy(rgb + t * 3, rgb + t * 3 + 3, rgba + t * 4);
+                rgba[t * 4 + 3] = 255;
+            }
+        }
+        pendingLayers.clear();
+
+        if (!createImage(VK_IMAGE_TYPE_2D, VK_IMAGE_VIEW_TYPE_2D_ARRAY, VK_FORMAT_R8G8B8A8_UNORM, layerWidth, layerHeight, layerCount, VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT, VK_IMAGE_ASPECT_COLOR_BIT, textures))
+        {
+            destroyBuffer(staging);
+            return false;
+        }
+        bool done = runOnce([&](VkCommandBuffer commands) {
+            VkImageMemoryBarrier barrier = { VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
+            barrier.srcQueueFamilyIndex = barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.image = textures.image;
+            barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, layerCount };
+            barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            vkCmdPipelineBarrier(commands, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+            VkBufferImageCopy region = {};
+            region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, layerCount };
+            region.imageExtent = { (uint32_t)layerWidth, (uint32_t)layerHeight, 1 };
+            vkCmdCopyBufferToImage(commands, staging.buffer, textures.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+            barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+            vkCmdPipelineBarrier(commands, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+        });
+        destroyBuffer(staging);
+        std::cout << "VULKAN::TEXTURE_ARRAY:: " << layerCount << " layers of " << layerWidth << "x" << layerHeight << std::endl;
+
+        VkSamplerCreateInfo samplerInfo = { VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO };
+        samplerInfo.magFilter = samplerInfo.minFilter = VK_FILTER_LINEAR;
+        samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+        samplerInfo.addressModeU = samplerInfo.addressModeV = samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+        samplerInfo.maxLod = 0.0f;
+        return done && check(vkCreateSampler(device, &samplerInfo, nullptr, &sampler), "SAMPLER");
+    }
+
+    bool writeDescriptors()
+    {
+        for (Frame& frame : frames)
+        {
+            VkDescriptorBufferInfo bufferInfo = { frame.uniforms.buffer, 0, sizeof(FrameConstants) };
+            VkDescriptorImageInfo imageInfo = { sampler, textures.view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+            VkWriteDescriptorSet writes[2] = {};
+            writes[0].sType = writes[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writes[0].dstSet = writes[1].dstSet = frame.descriptors;
+            writes[0].dstBinding = 0;
+            writes[0].descriptorCount = 1;
+            writes[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+            writes[0].pBufferInfo = &bufferInfo;
+            writes[1].dstBinding = 1;
+            writes[1].descriptorCount = 1;
+            writes[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            writes[1].pImageInfo = &imageInfo;
+            vkUpdateDescriptorSets(device, 2, writes, 0, nullptr);
+        }
+        return true;
+    }
+
+    // records visible[begin, end) into the thread's secondary command buffer
+    void recordRange(Frame& slot, size_t thread, const FrameSnapshot& frame, const std::vector<size_t>& visible, size_t begin, size_t end)
+    {
+        Recorder& recorder = slot.recorders[thread];
+        vkResetCommandPool(device, recorder.pool, 0);
+        VkCommandBufferInheritanceInfo inheritance = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO };
+        inheritance.renderPass = renderPass;
+        inheritance.subpass = 0;
+        inheritance.framebuffer = framebuffer;
+        VkCommandBufferBeginInfo beginInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+        beginInfo.pInheritanceInfo = &inheritance;
+        vkBeginCommandBuffer(recorder.commands, &beginInfo);
+        vkCmdBindPipeline(recorder.commands, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+        vkCmdBindDescriptorSets(recorder.commands, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &slot.descriptors, 0, nullptr);
+        VkDeviceSize offset = 0;
+        vkCmdBindVertexBuffers(recorder.commands, 0, 1, &vertexBuffer.buffer, &offset);
+        for (size_t v = begin; v < end; v++)
+        {
+            size_t i = visible[v];
+            const DrawItem& item = frame.drawList[i];
+            DrawConstants constants;
+            constants.model = frame.transforms[item.transform];
+            const glm::mat3& normalMatrix = frame.normalMatrices[item.transform];
+            for (int c = 0; c < 3; c++)
+                constants.normalMatrix[c] = glm::vec4(normalMatrix[c], 0.0f);
+            constants.normalMatrix[0].w = (float)surfaceLayers[i];
+            vkCmdPushConstants(recorder.commands, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(constants), &constants);
+            vkCmdDraw(recorder.commands, (uint32_t)item.count, 1, surfaceFirst[i] + (uint32_t)item.first, 0);
+        }
+        vkEndCommandBuffer(recorder.commands);
+    }
+};
+
+#endif
+#endif
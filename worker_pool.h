@@ -0,0 +1,92 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Threads started once and kept until the pool is destroyed, so handing them work every frame costs a wake-up
+// instead of creating and joining threads. run() calls the work on every thread, the calling one as thread 0,
+// and returns once all of them are done with it; one run at a time.
+class WorkerPool
+{
+public:
+    explicit WorkerPool(int threads) : threadCount(std::max(1, threads)), work(nullptr), generation(0), pending(0), stopping(false)
+    {
+        for (int t = 1; t < threadCount; t++)
+            workers.emplace_back(&WorkerPool::serve, this, t);
+    }
+
+    ~WorkerPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread& worker : workers)
+            worker.join();
+    }
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    int size() const { return threadCount; }
+
+    void run(const std::function<void(int)>& function)
+    {
+        if (threadCount == 1)
+        {
+            function(0);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            work = &function;
+            pending = threadCount - 1;
+            generation++;
+        }
+        wake.notify_all();
+        function(0);
+        std::unique_lock<std::mutex> lock(mutex);
+        finished.wait(lock, [this]() { return pending == 0; });
+        work = nullptr;
+    }
+
+private:
+    int threadCount;
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable finished;
+    const std::function<void(int)>* work;
+    // counts the runs, a worker takes the work of every run once
+    unsigned long long generation;
+    int pending;
+    bool stopping;
+
+    void serve(int thread)
+    {
+        unsigned long long served = 0;
+        for (;;)
+        {
+            const std::function<void(int)>* function;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&]() { return stopping || generation != served; });
+                if (stopping)
+                    return;
+                served = generation;
+                function = work;
+            }
+            (*function)(thread);
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--pending == 0)
+                finished.notify_one();
+        }
+    }
+};
+#endif